@@ -21,17 +21,42 @@
 //=========================================================================
 
 #include "AudioEngineFactory.h"
+#include "FileAudioEngine.h"
+#if defined(AUDIO_ENGINE_JACK_ENABLE)
+#include "JackAudioEngine.h"
+#endif // defined(AUDIO_ENGINE_JACK_ENABLE)
 #if defined(AUDIO_ENGINE_PULSEAUDIO_ENABLE)
 #include "PulseAudioEngine.h"
 #else
 #include "PortAudioEngine.h"
 #endif // defined(AUDIO_ENGINE_PULSEAUDIO_ENABLE)
 
+AudioEngineFactory::EngineType AudioEngineFactory::EngineType_ = AudioEngineFactory::ENGINE_SYSTEM;
 std::shared_ptr<IAudioEngine> AudioEngineFactory::SystemEngine_;
 
+void AudioEngineFactory::SetEngineType(EngineType type)
+{
+    EngineType_ = type;
+}
+
 std::shared_ptr<IAudioEngine> AudioEngineFactory::GetAudioEngine()
 {
-    if (!SystemEngine_)
+#if defined(AUDIO_ENGINE_JACK_ENABLE)
+    if (!SystemEngine_ && EngineType_ == ENGINE_JACK)
+    {
+        SystemEngine_ = std::shared_ptr<IAudioEngine>(new JackAudioEngine());
+    }
+#endif // defined(AUDIO_ENGINE_JACK_ENABLE)
+
+    if (!SystemEngine_ && (EngineType_ == ENGINE_FILE_REALTIME || EngineType_ == ENGINE_FILE_VIRTUAL))
+    {
+        SystemEngine_ = std::shared_ptr<IAudioEngine>(
+            new FileAudioEngine(
+                EngineType_ == ENGINE_FILE_VIRTUAL ? 
+                FileAudioEngine::PACE_VIRTUAL : 
+                FileAudioEngine::PACE_REALTIME));
+    }
+    else if (!SystemEngine_)
     {
 #if defined(AUDIO_ENGINE_PULSEAUDIO_ENABLE)
         SystemEngine_ = std::shared_ptr<IAudioEngine>(new PulseAudioEngine());
@@ -28,6 +28,17 @@
 class AudioEngineFactory
 {
 public:
+    enum EngineType 
+    { 
+        ENGINE_SYSTEM,          // PulseAudio or PortAudio, depending on the build
+        ENGINE_FILE_REALTIME,   // FileAudioEngine paced to the wall clock
+        ENGINE_FILE_VIRTUAL,    // FileAudioEngine running as fast as possible
+        ENGINE_JACK,            // JackAudioEngine (if built with USE_JACK)
+    };
+
+    // Must be called before the first GetAudioEngine().
+    static void SetEngineType(EngineType type);
+
     static std::shared_ptr<IAudioEngine> GetAudioEngine();
     
 private:
@@ -35,6 +46,7 @@ private:
     AudioEngineFactory(const AudioEngineFactory&) = delete;
     ~AudioEngineFactory() = delete;
     
+    static EngineType EngineType_;
     static std::shared_ptr<IAudioEngine> SystemEngine_;
 };
 
@@ -0,0 +1,165 @@
+//=========================================================================
+// Name:            FileAudioDevice.cpp
+// Purpose:         Audio device backed by a WAV/raw file or pipe.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include <cstring>
+#include "FileAudioDevice.h"
+#include "FileAudioEngine.h"
+
+FileAudioDevice::FileAudioDevice(FileAudioEngine* engine, wxString devName, IAudioEngine::AudioDirection direction, int sampleRate, int numChannels)
+    : framesProcessed_(0)
+    , engine_(engine)
+    , devName_(devName)
+    , direction_(direction)
+    , sampleRate_(sampleRate)
+    , numChannels_(numChannels)
+    , file_(nullptr)
+    , endOfFile_(false)
+    , isRunning_(false)
+{
+    // Input files are opened straight away as they determine the sample
+    // rate and channels. Output files are only created once started.
+    if (direction_ == IAudioEngine::AUDIO_ENGINE_IN && devName_ != FILE_AUDIO_NULL_DEVICE)
+    {
+        openFile_();
+    }
+}
+
+FileAudioDevice::~FileAudioDevice()
+{
+    if (isRunning_)
+    {
+        stop();
+    }
+
+    if (file_ != nullptr)
+    {
+        sf_close(file_);
+    }
+}
+
+bool FileAudioDevice::openFile_()
+{
+    std::string path = (const char*)devName_.ToUTF8();
+    bool isRaw = path == "-" || (path.size() > 4 && path.compare(path.size() - 4, 4, ".raw") == 0);
+
+    SF_INFO sfInfo;
+    memset(&sfInfo, 0, sizeof(sfInfo));
+    if (isRaw)
+    {
+        sfInfo.format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+        sfInfo.samplerate = sampleRate_;
+        sfInfo.channels = numChannels_;
+    }
+    else if (direction_ == IAudioEngine::AUDIO_ENGINE_OUT)
+    {
+        sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+        sfInfo.samplerate = sampleRate_;
+        sfInfo.channels = numChannels_;
+    }
+
+    file_ = sf_open(path.c_str(), direction_ == IAudioEngine::AUDIO_ENGINE_IN ? SFM_READ : SFM_WRITE, &sfInfo);
+    if (file_ == nullptr)
+    {
+        fprintf(stderr, "FileAudioDevice: could not open %s: %s\n", path.c_str(), sf_strerror(nullptr));
+        return false;
+    }
+
+    // Input files dictate the format; the app adopts whatever we report.
+    sampleRate_ = sfInfo.samplerate;
+    numChannels_ = sfInfo.channels;
+    return true;
+}
+
+void FileAudioDevice::start()
+{
+    if (devName_ != FILE_AUDIO_NULL_DEVICE && file_ == nullptr && !openFile_())
+    {
+        if (onAudioErrorFunction)
+        {
+            onAudioErrorFunction(*this, "Could not open " + std::string(devName_.ToUTF8()), onAudioErrorState);
+        }
+        return;
+    }
+
+    // Opening an input file may have changed the format.
+    allocateConversionBuffer_();
+
+    isRunning_ = true;
+    engine_->addDevice_(this);
+}
+
+void FileAudioDevice::stop()
+{
+    engine_->removeDevice_(this);
+    isRunning_ = false;
+
+    if (file_ != nullptr && direction_ == IAudioEngine::AUDIO_ENGINE_OUT)
+    {
+        // Makes the WAV header valid even if we're never closed cleanly.
+        sf_write_sync(file_);
+    }
+}
+
+bool FileAudioDevice::isRunning()
+{
+    return isRunning_;
+}
+
+void FileAudioDevice::process_(int numFrames)
+{
+    size_t numSamples = numFrames * numChannels_;
+    if (buffer_.size() < numSamples)
+    {
+        buffer_.resize(numSamples);
+    }
+    short* buffer = &buffer_[0];
+    memset(buffer, 0, numSamples * sizeof(short));
+
+    if (direction_ == IAudioEngine::AUDIO_ENGINE_IN)
+    {
+        if (file_ != nullptr && !endOfFile_)
+        {
+            sf_count_t numRead = sf_readf_short(file_, buffer, numFrames);
+            if (numRead < numFrames)
+            {
+                // Remainder stays silent from here on.
+                endOfFile_ = true;
+                fprintf(stderr, "FileAudioDevice: end of %s after %lld ms\n", (const char*)devName_.ToUTF8(), (long long)engine_->getElapsedMs());
+            }
+        }
+        processInputData_(buffer, numFrames);
+    }
+    else
+    {
+        processOutputData_(buffer, numFrames);
+        if (file_ != nullptr && sf_writef_short(file_, buffer, numFrames) != numFrames)
+        {
+            // e.g. the reader of a pipe went away. Keep the clock running
+            // but stop writing.
+            fprintf(stderr, "FileAudioDevice: could not write %s: %s\n", (const char*)devName_.ToUTF8(), sf_strerror(file_));
+            sf_close(file_);
+            file_ = nullptr;
+        }
+    }
+
+    framesProcessed_ += numFrames;
+}
@@ -0,0 +1,77 @@
+//=========================================================================
+// Name:            FileAudioDevice.h
+// Purpose:         Audio device backed by a WAV/raw file or pipe.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef FILE_AUDIO_DEVICE_H
+#define FILE_AUDIO_DEVICE_H
+
+#include <vector>
+#include <atomic>
+#include <wx/string.h>
+#include <sndfile.h>
+#include "IAudioEngine.h"
+#include "IAudioDevice.h"
+#include "FileAudioEngine.h"
+
+class FileAudioDevice : public IAudioDevice
+{
+public:
+    virtual ~FileAudioDevice();
+    
+    virtual int getNumChannels() override { return numChannels_; }
+    virtual int getSampleRate() const override { return sampleRate_; }
+    
+    virtual void start() override;
+    virtual void stop() override;
+
+    virtual bool isRunning() override;
+    
+protected:
+    // FileAudioDevice cannot be created directly, only via FileAudioEngine.
+    friend class FileAudioEngine;
+    
+    FileAudioDevice(FileAudioEngine* engine, wxString devName, IAudioEngine::AudioDirection direction, int sampleRate, int numChannels);
+
+    // True unless this is an input file that could not be opened.
+    bool isValid_() const { return file_ != nullptr || devName_ == FILE_AUDIO_NULL_DEVICE || direction_ == IAudioEngine::AUDIO_ENGINE_OUT; }
+
+    // Called by the engine's clock thread with the number of frames due.
+    void process_(int numFrames);
+
+    // Frames processed since start(), only touched by the clock thread.
+    int64_t framesProcessed_;
+    
+private:
+    FileAudioEngine* engine_;
+    wxString devName_;
+    IAudioEngine::AudioDirection direction_;
+    int sampleRate_;
+    int numChannels_;
+
+    SNDFILE* file_;
+    bool endOfFile_;
+    std::atomic<bool> isRunning_;
+    std::vector<short> buffer_;
+
+    bool openFile_();
+};
+
+#endif // FILE_AUDIO_DEVICE_H
@@ -0,0 +1,299 @@
+//=========================================================================
+// Name:            FileAudioEngine.cpp
+// Purpose:         Audio engine whose devices are WAV/raw files or pipes.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+
+#include "FileAudioEngine.h"
+#include "FileAudioDevice.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+// How long to wait before re-checking a closed clock gate.
+#define FILE_AUDIO_GATE_RETRY_MS 1
+
+FileAudioEngine::FileAudioEngine(PacingMode pacingMode)
+    : pacingMode_(pacingMode)
+    , clockThread_(nullptr)
+    , endOfInputTick_(-1)
+    , endOfInput_(false)
+    , clockThreadActive_(false)
+    , tick_(0)
+{
+    // empty
+}
+
+FileAudioEngine::~FileAudioEngine()
+{
+    stop();
+}
+
+void FileAudioEngine::start()
+{
+    if (clockThread_ != nullptr)
+    {
+        return;
+    }
+
+    tick_ = 0;
+    endOfInputTick_ = -1;
+    endOfInput_ = false;
+    clockThreadActive_ = true;
+    clockThread_ = new std::thread(std::bind(&FileAudioEngine::clockThreadEntry_, this));
+}
+
+void FileAudioEngine::stop()
+{
+    if (clockThread_ == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lk(clockMutex_);
+        clockThreadActive_ = false;
+    }
+    clockCV_.notify_one();
+    clockThread_->join();
+    delete clockThread_;
+    clockThread_ = nullptr;
+}
+
+std::vector<AudioDeviceSpecification> FileAudioEngine::getAudioDeviceList(AudioDirection direction)
+{
+    // Files can't be enumerated; only the null device is listed and
+    // anything else has to be configured by path.
+    std::vector<AudioDeviceSpecification> result;
+    result.push_back(getDefaultAudioDevice(direction));
+    return result;
+}
+
+AudioDeviceSpecification FileAudioEngine::getDefaultAudioDevice(AudioDirection direction)
+{
+    AudioDeviceSpecification device;
+    device.deviceId = 0;
+    device.name = FILE_AUDIO_NULL_DEVICE;
+    device.apiName = "File";
+    device.defaultSampleRate = 48000;
+    device.minChannels = 1;
+    device.maxChannels = 2;
+    return device;
+}
+
+std::vector<int> FileAudioEngine::getSupportedSampleRates(wxString deviceName, AudioDirection direction)
+{
+    std::vector<int> result;
+    
+    int index = 0;
+    while (IAudioEngine::StandardSampleRates[index] != -1)
+    {
+        result.push_back(IAudioEngine::StandardSampleRates[index]);
+        index++;
+    }
+    
+    return result;
+}
+
+std::shared_ptr<IAudioDevice> FileAudioEngine::getAudioDevice(wxString deviceName, AudioDirection direction, int sampleRate, int numChannels)
+{
+    if (deviceName == "" || deviceName == "none")
+    {
+        return nullptr;
+    }
+
+    if (sampleRate <= 0)
+    {
+        sampleRate = getDefaultAudioDevice(direction).defaultSampleRate;
+    }
+    numChannels = std::min(std::max(numChannels, 1), 2);
+
+    auto devObj = new FileAudioDevice(this, deviceName, direction, sampleRate, numChannels);
+    if (!devObj->isValid_())
+    {
+        // e.g. the input file doesn't exist; treat like a missing device.
+        delete devObj;
+        return nullptr;
+    }
+    return std::shared_ptr<IAudioDevice>(devObj);
+}
+
+void FileAudioEngine::setClockGate(std::function<bool()> fn)
+{
+    std::unique_lock<std::mutex> lk(devicesMutex_);
+    clockGate_ = fn;
+}
+
+void FileAudioEngine::setOnEndOfInput(std::function<void()> fn)
+{
+    std::unique_lock<std::mutex> lk(devicesMutex_);
+    onEndOfInput_ = fn;
+}
+
+void FileAudioEngine::addDevice_(FileAudioDevice* device)
+{
+    {
+        std::unique_lock<std::mutex> lk(devicesMutex_);
+
+        // Line the new device up with the current time so it doesn't try to
+        // catch up on everything since the engine started.
+        device->framesProcessed_ = tick_ * device->getSampleRate() * FILE_AUDIO_PERIOD_MS / 1000;
+        devices_.push_back(device);
+        endOfInputTick_ = -1;
+    }
+
+    // Restarts a virtual clock stopped at the end of the last input.
+    {
+        std::unique_lock<std::mutex> lk(clockMutex_);
+        endOfInput_ = false;
+    }
+    clockCV_.notify_one();
+}
+
+void FileAudioEngine::removeDevice_(FileAudioDevice* device)
+{
+    std::unique_lock<std::mutex> lk(devicesMutex_);
+    devices_.erase(std::remove(devices_.begin(), devices_.end(), device), devices_.end());
+}
+
+bool FileAudioEngine::checkEndOfInput_(int64_t tick)
+{
+    if (endOfInput_)
+    {
+        return false;
+    }
+
+    // The null device never ends, so only files count.
+    bool anyInput = false;
+    bool allEnded = true;
+    for (auto& device : devices_)
+    {
+        if (device->direction_ == IAudioEngine::AUDIO_ENGINE_IN && device->devName_ != FILE_AUDIO_NULL_DEVICE)
+        {
+            anyInput = true;
+            allEnded = allEnded && device->endOfFile_;
+        }
+    }
+    if (!anyInput || !allEnded)
+    {
+        endOfInputTick_ = -1;
+        return false;
+    }
+
+    if (endOfInputTick_ < 0)
+    {
+        endOfInputTick_ = tick;
+    }
+    if ((tick - endOfInputTick_) * FILE_AUDIO_PERIOD_MS < FILE_AUDIO_END_TAIL_MS)
+    {
+        return false;
+    }
+
+    endOfInput_ = true;
+    return true;
+}
+
+void FileAudioEngine::clockThreadEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV FileClk");
+#endif // defined(__linux__)
+
+    auto period = std::chrono::milliseconds(FILE_AUDIO_PERIOD_MS);
+    auto nextTick = std::chrono::steady_clock::now();
+
+    while (clockThreadActive_)
+    {
+        if (pacingMode_ == PACE_REALTIME)
+        {
+            std::unique_lock<std::mutex> lk(clockMutex_);
+            clockCV_.wait_until(lk, nextTick, [&]() { return !clockThreadActive_; });
+            if (!clockThreadActive_)
+            {
+                break;
+            }
+
+            // If we fall far behind (e.g. the machine was suspended), skip
+            // ahead rather than delivering a burst of audio.
+            auto now = std::chrono::steady_clock::now();
+            nextTick = std::max(nextTick + period, now - 10 * period);
+        }
+
+        bool endOfInput = false;
+        std::function<void()> onEndOfInput;
+        {
+            std::unique_lock<std::mutex> lk(devicesMutex_);
+            if (pacingMode_ == PACE_VIRTUAL && clockGate_ && !clockGate_())
+            {
+                lk.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(FILE_AUDIO_GATE_RETRY_MS));
+                continue;
+            }
+
+            // Devices are ticked in the order they started. Frame counts are
+            // derived from the total elapsed time so rates that aren't a
+            // multiple of 100 Hz don't drift.
+            int64_t tick = ++tick_;
+            for (auto& device : devices_)
+            {
+                int64_t due = tick * device->getSampleRate() * FILE_AUDIO_PERIOD_MS / 1000;
+                int numFrames = due - device->framesProcessed_;
+                if (numFrames > 0)
+                {
+                    device->process_(numFrames);
+                }
+            }
+
+            endOfInput = checkEndOfInput_(tick);
+            if (endOfInput)
+            {
+                onEndOfInput = onEndOfInput_;
+            }
+        }
+
+        if (endOfInput)
+        {
+            fprintf(stderr, "FileAudioEngine: end of input after %lld ms\n", (long long)getElapsedMs());
+            if (onEndOfInput)
+            {
+                onEndOfInput();
+            }
+
+            if (pacingMode_ == PACE_VIRTUAL)
+            {
+                // Nothing left to run as fast as we can.
+                std::unique_lock<std::mutex> lk(clockMutex_);
+                clockCV_.wait(lk, [&]() { return !clockThreadActive_ || !endOfInput_; });
+                continue;
+            }
+        }
+
+        if (pacingMode_ == PACE_VIRTUAL)
+        {
+            // Give the threads consuming our audio a chance to run.
+            std::this_thread::yield();
+        }
+    }
+}
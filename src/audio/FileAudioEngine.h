@@ -0,0 +1,127 @@
+//=========================================================================
+// Name:            FileAudioEngine.h
+// Purpose:         Audio engine whose devices are WAV/raw files or pipes.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef FILE_AUDIO_ENGINE_H
+#define FILE_AUDIO_ENGINE_H
+
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include "IAudioEngine.h"
+
+class FileAudioDevice;
+
+// Length of audio handed to each running device per clock tick.
+#define FILE_AUDIO_PERIOD_MS 10
+
+// Name of the device that reads silence/discards everything.
+#define FILE_AUDIO_NULL_DEVICE "null"
+
+// Audio time played after the last input file ends before that's
+// reported, so what's still in the pipeline reaches the outputs.
+#define FILE_AUDIO_END_TAIL_MS 2000
+
+// Audio engine for running without sound hardware. Device names are file
+// paths (opened with libsndfile):
+//
+// * Input: any format libsndfile can read, at the file's own sample rate
+//   and channel count. Silence is supplied once the file ends (see
+//   setOnEndOfInput()).
+// * Output: 16 bit WAV at the requested rate and channels.
+// * "-" (stdin/stdout) and names ending in .raw are headerless 16 bit
+//   native endian PCM at the requested rate/channels, so pipes work too.
+// * FILE_AUDIO_NULL_DEVICE reads silence and discards output.
+//
+// A single clock thread drives all running devices in lock step, paced
+// either to the wall clock or to a virtual clock that advances as fast as
+// the CPU (and the optional clock gate) allows.
+class FileAudioEngine : public IAudioEngine
+{
+public:
+    enum PacingMode { PACE_REALTIME, PACE_VIRTUAL };
+
+    explicit FileAudioEngine(PacingMode pacingMode);
+    virtual ~FileAudioEngine();
+    
+    virtual void start();
+    virtual void stop();
+    virtual std::vector<AudioDeviceSpecification> getAudioDeviceList(AudioDirection direction);
+    virtual AudioDeviceSpecification getDefaultAudioDevice(AudioDirection direction);
+    virtual std::shared_ptr<IAudioDevice> getAudioDevice(wxString deviceName, AudioDirection direction, int sampleRate, int numChannels);
+    virtual std::vector<int> getSupportedSampleRates(wxString deviceName, AudioDirection direction);
+
+    PacingMode getPacingMode() const { return pacingMode_; }
+
+    // PACE_VIRTUAL only: called before every tick, which is held off
+    // while it returns false. Used to keep the virtual clock from running
+    // ahead of whatever consumes the input (e.g. to keep FIFOs from
+    // overflowing). Called from the clock thread.
+    void setClockGate(std::function<bool()> fn);
+
+    // Called once every running input file has ended (and a further
+    // FILE_AUDIO_END_TAIL_MS has been played). With PACE_VIRTUAL the
+    // clock then stops until another device is started, rather than
+    // feeding silence as fast as it can. Called from the clock thread,
+    // so it mustn't start or stop devices itself.
+    void setOnEndOfInput(std::function<void()> fn);
+    bool isEndOfInput() const { return endOfInput_; }
+
+    // Audio time elapsed since start().
+    int64_t getElapsedMs() const { return tick_ * FILE_AUDIO_PERIOD_MS; }
+    
+protected:
+    // Only used by FileAudioDevice::start()/stop().
+    friend class FileAudioDevice;
+    void addDevice_(FileAudioDevice* device);
+    void removeDevice_(FileAudioDevice* device);
+
+private:
+    PacingMode pacingMode_;
+    std::function<bool()> clockGate_;
+    std::function<void()> onEndOfInput_;
+
+    // Held while ticking, so a device is never called after removeDevice_()
+    // returns.
+    std::mutex devicesMutex_;
+    std::vector<FileAudioDevice*> devices_;
+
+    // Tick at which the last input file ended, -1 while there's input
+    // left. Protected by devicesMutex_.
+    int64_t endOfInputTick_;
+    std::atomic<bool> endOfInput_;
+
+    std::thread* clockThread_;
+    std::atomic<bool> clockThreadActive_;
+    std::mutex clockMutex_;
+    std::condition_variable clockCV_;
+    std::atomic<int64_t> tick_;
+
+    // Called with devicesMutex_ held after each tick. True once, when the
+    // end of input should be reported.
+    bool checkEndOfInput_(int64_t tick);
+
+    void clockThreadEntry_();
+};
+
+#endif // FILE_AUDIO_ENGINE_H
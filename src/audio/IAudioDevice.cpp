@@ -20,6 +20,14 @@
 //
 //=========================================================================
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif // defined(__SSE2__)
+
 #include "IAudioDevice.h"
 
 void IAudioDevice::setDescription(std::string desc)
@@ -55,4 +63,271 @@ void IAudioDevice::setOnAudioDeviceChanged(AudioDeviceChangedCallbackFn fn, void
 {
     onAudioDeviceChangedFunction = fn;
     onAudioDeviceChangedState = state;
-}
\ No newline at end of file
+}
+void IAudioDevice::setAudioDataFormat(const AudioDataFormat& format)
+{
+    audioDataFormat_ = format;
+    allocateConversionBuffer_();
+}
+
+// Full scale for float samples, the same both ways so that int16 -> float
+// -> int16 gets back what it started with.
+#define INT16_FULL_SCALE 32768.0f
+#define INT16_TO_FLOAT (1.0f / INT16_FULL_SCALE)
+
+// Copies one channel out of interleaved int16 (srcStride samples per frame)
+// into dest, which has destStride elements per frame. The common stereo to
+// planar/mono case is done 8 frames at a time with SSE2 where available.
+//
+// src points at the wanted channel within the first frame, so for channel
+// 1 there's one sample less after it than 2 * numFrames. The vector loops
+// therefore stop a frame early, so their last load ends on or before the
+// last sample of the buffer rather than reading one past it.
+static void ExtractChannelInt16_(const short* src, int srcStride, short* dest, int destStride, size_t numFrames)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (srcStride == 2 && destStride == 1)
+    {
+        for (; i + 8 < numFrames; i += 8)
+        {
+            // Four frames per register; sign extend the wanted half of each
+            // 32 bit frame, then pack back down to 16 bits.
+            __m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(src + 2 * i + 8));
+            a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+            b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+            _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(a, b));
+        }
+    }
+#endif // defined(__SSE2__)
+
+    for (; i < numFrames; i++)
+    {
+        dest[i * destStride] = src[i * srcStride];
+    }
+}
+
+static void ExtractChannelFloat_(const short* src, int srcStride, float* dest, int destStride, size_t numFrames)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (srcStride == 2 && destStride == 1)
+    {
+        const __m128 scale = _mm_set1_ps(INT16_TO_FLOAT);
+        for (; i + 4 < numFrames; i += 4)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+            a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        }
+    }
+    else if (srcStride == 1 && destStride == 1)
+    {
+        const __m128 scale = _mm_set1_ps(INT16_TO_FLOAT);
+        for (; i + 8 <= numFrames; i += 8)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+    }
+#endif // defined(__SSE2__)
+
+    for (; i < numFrames; i++)
+    {
+        dest[i * destStride] = src[i * srcStride] * INT16_TO_FLOAT;
+    }
+}
+
+static void InsertChannelInt16_(const short* src, int srcStride, short* dest, int destStride, size_t numFrames)
+{
+    for (size_t i = 0; i < numFrames; i++)
+    {
+        dest[i * destStride] = src[i * srcStride];
+    }
+}
+
+static void InsertChannelFloat_(const float* src, int srcStride, short* dest, int destStride, size_t numFrames)
+{
+    for (size_t i = 0; i < numFrames; i++)
+    {
+        float sample = src[i * srcStride] * INT16_FULL_SCALE;
+        sample = sample > 32767.0f ? 32767.0f : (sample < -32768.0f ? -32768.0f : sample);
+        dest[i * destStride] = (short)sample;
+    }
+}
+
+int IAudioDevice::getCallbackChannels_()
+{
+    return audioDataFormat_.numChannels > 0 ? audioDataFormat_.numChannels : getNumChannels();
+}
+
+bool IAudioDevice::isNativeFormat_()
+{
+    int numChannels = getCallbackChannels_();
+    if (audioDataFormat_.sampleFormat != SAMPLE_FORMAT_INT16 ||
+        numChannels != getNumChannels() ||
+        (audioDataFormat_.planar && numChannels > 1))
+    {
+        return false;
+    }
+
+    for (size_t index = 0; index < audioDataFormat_.channelMap.size(); index++)
+    {
+        if (audioDataFormat_.channelMap[index] != (int)index)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IAudioDevice::allocateConversionBuffer_()
+{
+    if (isNativeFormat_())
+    {
+        // Never used.
+        std::vector<char>().swap(conversionBuffer_);
+        return;
+    }
+
+    size_t sampleSize = audioDataFormat_.sampleFormat == SAMPLE_FORMAT_INT16 ? sizeof(short) : sizeof(float);
+    size_t maxFrames = (size_t)getSampleRate() * AUDIO_CONVERSION_MAX_MS / 1000;
+    conversionBuffer_.resize(maxFrames * getCallbackChannels_() * sampleSize);
+}
+
+char* IAudioDevice::getConversionBuffer_(size_t numFrames)
+{
+    size_t sampleSize = audioDataFormat_.sampleFormat == SAMPLE_FORMAT_INT16 ? sizeof(short) : sizeof(float);
+    size_t numBytes = numFrames * getCallbackChannels_() * sampleSize;
+    if (conversionBuffer_.empty() || conversionBuffer_.size() < numBytes)
+    {
+        // Longer than allocateConversionBuffer_() allowed for.
+        return nullptr;
+    }
+    return &conversionBuffer_[0];
+}
+
+int64_t IAudioDevice::GetTimeUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void IAudioDevice::processInputData_(const short* inputData, size_t numFrames, int latencyUs)
+{
+    if (!onAudioDataFunction)
+    {
+        return;
+    }
+
+    callbackTiming_.bufferTimeUs = GetTimeUs() - latencyUs;
+    callbackTiming_.latencyUs = latencyUs;
+
+    if (isNativeFormat_())
+    {
+        onAudioDataFunction(*this, const_cast<short*>(inputData), numFrames, onAudioDataState);
+        return;
+    }
+
+    int deviceChannels = getNumChannels();
+    int numChannels = getCallbackChannels_();
+    char* buffer = getConversionBuffer_(numFrames);
+    if (buffer == nullptr)
+    {
+        // Lost, so the same as not having been read in time.
+        numOversizeBuffers_.fetch_add(1, std::memory_order_relaxed);
+        if (onAudioOverflowFunction)
+        {
+            onAudioOverflowFunction(*this, onAudioOverflowState);
+        }
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        int deviceChannel = 
+            channel < (int)audioDataFormat_.channelMap.size() ? 
+            audioDataFormat_.channelMap[channel] : 
+            channel;
+        deviceChannel = std::min(std::max(deviceChannel, 0), deviceChannels - 1);
+
+        // Planar: channels are consecutive blocks, interleaved: every
+        // numChannels'th sample.
+        size_t offset = audioDataFormat_.planar ? channel * numFrames : channel;
+        int stride = audioDataFormat_.planar ? 1 : numChannels;
+        if (audioDataFormat_.sampleFormat == SAMPLE_FORMAT_INT16)
+        {
+            ExtractChannelInt16_(inputData + deviceChannel, deviceChannels, (short*)buffer + offset, stride, numFrames);
+        }
+        else
+        {
+            ExtractChannelFloat_(inputData + deviceChannel, deviceChannels, (float*)buffer + offset, stride, numFrames);
+        }
+    }
+
+    onAudioDataFunction(*this, buffer, numFrames, onAudioDataState);
+}
+
+void IAudioDevice::processOutputData_(short* outputData, size_t numFrames, int latencyUs)
+{
+    if (!onAudioDataFunction)
+    {
+        return;
+    }
+
+    callbackTiming_.bufferTimeUs = GetTimeUs() + latencyUs;
+    callbackTiming_.latencyUs = latencyUs;
+
+    if (isNativeFormat_())
+    {
+        onAudioDataFunction(*this, outputData, numFrames, onAudioDataState);
+        return;
+    }
+
+    int deviceChannels = getNumChannels();
+    int numChannels = getCallbackChannels_();
+    size_t sampleSize = audioDataFormat_.sampleFormat == SAMPLE_FORMAT_INT16 ? sizeof(short) : sizeof(float);
+    char* buffer = getConversionBuffer_(numFrames);
+    if (buffer == nullptr)
+    {
+        // outputData is already silent, as if nothing had been ready.
+        numOversizeBuffers_.fetch_add(1, std::memory_order_relaxed);
+        if (onAudioUnderflowFunction)
+        {
+            onAudioUnderflowFunction(*this, onAudioUnderflowState);
+        }
+        return;
+    }
+
+    // Silence unless the callback provides something.
+    memset(buffer, 0, numFrames * numChannels * sampleSize);
+    onAudioDataFunction(*this, buffer, numFrames, onAudioDataState);
+
+    for (int deviceChannel = 0; deviceChannel < deviceChannels; deviceChannel++)
+    {
+        int channel = 
+            deviceChannel < (int)audioDataFormat_.channelMap.size() ? 
+            audioDataFormat_.channelMap[deviceChannel] : 
+            std::min(deviceChannel, numChannels - 1);
+        if (channel < 0 || channel >= numChannels)
+        {
+            // Left zeroed.
+            continue;
+        }
+
+        size_t offset = audioDataFormat_.planar ? channel * numFrames : channel;
+        int stride = audioDataFormat_.planar ? 1 : numChannels;
+        if (audioDataFormat_.sampleFormat == SAMPLE_FORMAT_INT16)
+        {
+            InsertChannelInt16_((short*)buffer + offset, stride, outputData + deviceChannel, deviceChannels, numFrames);
+        }
+        else
+        {
+            InsertChannelFloat_((float*)buffer + offset, stride, outputData + deviceChannel, deviceChannels, numFrames);
+        }
+    }
+}
@@ -25,9 +25,16 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <atomic>
 #include <functional>
 #include "AudioDeviceSpecification.h"
 
+// Longest callback buffer that can be converted to or from a non-native
+// AudioDataFormat. The conversion buffer is sized for this up front, as
+// allocating from a realtime callback could stall it.
+#define AUDIO_CONVERSION_MAX_MS 500
+
 class IAudioDevice
 {
 public:
@@ -37,6 +44,61 @@ public:
     typedef std::function<void(IAudioDevice&, std::string, void*)> AudioErrorCallbackFn;
     typedef std::function<void(IAudioDevice&, std::string, void*)> AudioDeviceChangedCallbackFn;
     
+    enum SampleFormat
+    {
+        SAMPLE_FORMAT_INT16,
+        SAMPLE_FORMAT_FLOAT32,  // -1.0 ... 1.0
+    };
+
+    // What the onAudioData callback sees. The default (int16, interleaved,
+    // all device channels) is what the device natively produces/consumes
+    // and costs nothing; anything else is converted by the device.
+    struct AudioDataFormat
+    {
+        AudioDataFormat()
+            : sampleFormat(SAMPLE_FORMAT_INT16)
+            , planar(false)
+            , numChannels(0)
+        {
+        }
+
+        SampleFormat sampleFormat;
+
+        // Planar buffers hold all of channel 0, then all of channel 1 etc.
+        bool planar;
+
+        // Channels in the callback buffer (0 = same as the device).
+        int numChannels;
+
+        // Input: device channel for each callback channel.
+        // Output: callback channel for each device channel (-1 = silence).
+        // Missing entries default to the same channel number, clamped to
+        // the available channels, so e.g. a mono output is replicated to
+        // every device channel.
+        std::vector<int> channelMap;
+    };
+
+    // When the buffer passed to the onAudioData callback meets the outside
+    // world, in GetTimeUs() time.
+    struct AudioTiming
+    {
+        AudioTiming()
+            : bufferTimeUs(0)
+            , latencyUs(0)
+        {
+        }
+
+        // Input: when the first frame was captured by the hardware.
+        // Output: when the first frame will be played by the hardware.
+        int64_t bufferTimeUs;
+
+        // Device latency included in bufferTimeUs (0 if not known).
+        int latencyUs;
+    };
+
+    // Monotonic clock used for AudioTiming, in microseconds.
+    static int64_t GetTimeUs();
+
     virtual int getNumChannels() = 0;
     virtual int getSampleRate() const = 0;
     
@@ -55,6 +117,16 @@ public:
     //    3. Size of buffer.
     //    4. Pointer to user-provided state object (typically onAudioDataState, defined below).
     void setOnAudioData(AudioDataCallbackFn fn, void* state);
+
+    // Sets the format of the buffer passed to the onAudioData callback
+    // (whose size parameter is then in frames of that format). Must be
+    // called before start().
+    void setAudioDataFormat(const AudioDataFormat& format);
+
+    // Buffers dropped because they were longer than
+    // AUDIO_CONVERSION_MAX_MS and needed converting (see above). Each one
+    // is also reported as an overflow (input) or underflow (output).
+    uint64_t getNumOversizeBuffers() const { return numOversizeBuffers_.load(std::memory_order_relaxed); }
     
     // Set overflow callback.
     // Callback must take the following parameters:
@@ -81,10 +153,29 @@ public:
     //    2. String representing the new name of the device.
     //    3. Pointer to user-provided state object (typically onAudioDeviceChangedState, defined below).
     void setOnAudioDeviceChanged(AudioDeviceChangedCallbackFn fn, void* state);
+
+    // Timing of the current buffer. Only valid from within the onAudioData
+    // callback.
+    const AudioTiming& getCallbackTiming() const { return callbackTiming_; }
     
 protected:
     std::string description;
 
+    // For use by implementations from their realtime callbacks. Both take
+    // interleaved int16 buffers in the device's channel count, convert to
+    // or from the requested AudioDataFormat if needed and call
+    // onAudioDataFunction. outputData must already be zeroed. latencyUs is
+    // the time between the hardware and the buffer (capture to now for
+    // input, now to playback for output), if the implementation knows it.
+    void processInputData_(const short* inputData, size_t numFrames, int latencyUs = 0);
+    void processOutputData_(short* outputData, size_t numFrames, int latencyUs = 0);
+
+    // Sizes the conversion buffer for the current format, so that the
+    // callbacks above never allocate. setAudioDataFormat() does this too;
+    // implementations whose sample rate or channel count can change
+    // before they're started should call it again from start().
+    void allocateConversionBuffer_();
+
     AudioDataCallbackFn onAudioDataFunction;
     void* onAudioDataState;
     
@@ -99,6 +190,18 @@ protected:
     
     AudioDeviceChangedCallbackFn onAudioDeviceChangedFunction;
     void* onAudioDeviceChangedState;
+
+private:
+    AudioDataFormat audioDataFormat_;
+    AudioTiming callbackTiming_;
+
+    // Scratch space for conversions, sized by allocateConversionBuffer_().
+    std::vector<char> conversionBuffer_;
+    std::atomic<uint64_t> numOversizeBuffers_ { 0 };
+
+    int getCallbackChannels_();
+    bool isNativeFormat_();
+    char* getConversionBuffer_(size_t numFrames);
 };
 
 #endif // I_AUDIO_DEVICE_H
@@ -0,0 +1,241 @@
+//=========================================================================
+// Name:            JackAudioDevice.cpp
+// Purpose:         Defines the interface to a JACK device.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include "JackAudioDevice.h"
+
+JackAudioDevice::JackAudioDevice(wxString devName, IAudioEngine::AudioDirection direction, int sampleRate, int numChannels, std::vector<std::string> portNames)
+    : devName_(devName)
+    , direction_(direction)
+    , sampleRate_(sampleRate)
+    , numChannels_(numChannels)
+    , portNames_(portNames)
+    , client_(nullptr)
+    , isRunning_(false)
+{
+    // empty
+}
+
+JackAudioDevice::~JackAudioDevice()
+{
+    if (client_ != nullptr)
+    {
+        stop();
+    }
+}
+
+void JackAudioDevice::start()
+{
+    allocateConversionBuffer_();
+
+    std::string error;
+
+    // JACK makes the name unique if there's more than one of us.
+    jack_status_t status;
+    client_ = jack_client_open(
+        direction_ == IAudioEngine::AUDIO_ENGINE_IN ? "FreeDV in" : "FreeDV out", 
+        JackNoStartServer, &status);
+    if (client_ == nullptr)
+    {
+        if (onAudioErrorFunction)
+        {
+            onAudioErrorFunction(*this, "Could not connect to the JACK server", onAudioErrorState);
+        }
+        return;
+    }
+
+    jack_set_process_callback(client_, &JackAudioDevice::ProcessCallback_, this);
+    jack_set_buffer_size_callback(client_, &JackAudioDevice::BufferSizeCallback_, this);
+    jack_set_xrun_callback(client_, &JackAudioDevice::XrunCallback_, this);
+    jack_on_shutdown(client_, &JackAudioDevice::ShutdownCallback_, this);
+
+    for (int index = 0; index < numChannels_; index++)
+    {
+        char portName[32];
+        snprintf(portName, sizeof(portName), "%s_%d", direction_ == IAudioEngine::AUDIO_ENGINE_IN ? "in" : "out", index + 1);
+        jack_port_t* port = jack_port_register(
+            client_, portName, JACK_DEFAULT_AUDIO_TYPE, 
+            direction_ == IAudioEngine::AUDIO_ENGINE_IN ? JackPortIsInput : JackPortIsOutput, 0);
+        if (port == nullptr)
+        {
+            error = "Could not register JACK port";
+            break;
+        }
+        ports_.push_back(port);
+    }
+
+    buffer_.resize(jack_get_buffer_size(client_) * numChannels_);
+
+    if (error == "" && jack_activate(client_) != 0)
+    {
+        error = "Could not activate JACK client";
+    }
+
+    // Ports can only be connected once we're active.
+    for (size_t index = 0; error == "" && index < ports_.size(); index++)
+    {
+        const char* ourPort = jack_port_name(ports_[index]);
+        const char* theirPort = portNames_[index % portNames_.size()].c_str();
+        int rv = direction_ == IAudioEngine::AUDIO_ENGINE_IN ? 
+            jack_connect(client_, theirPort, ourPort) :
+            jack_connect(client_, ourPort, theirPort);
+        if (rv != 0 && rv != EEXIST)
+        {
+            error = "Could not connect to JACK port " + std::string(theirPort);
+        }
+    }
+
+    if (error != "")
+    {
+        closeClient_();
+        if (onAudioErrorFunction)
+        {
+            onAudioErrorFunction(*this, error, onAudioErrorState);
+        }
+        return;
+    }
+
+    isRunning_ = true;
+}
+
+void JackAudioDevice::stop()
+{
+    closeClient_();
+}
+
+void JackAudioDevice::closeClient_()
+{
+    isRunning_ = false;
+    if (client_ != nullptr)
+    {
+        // Deactivating waits for any in-progress process callback and
+        // drops our connections.
+        jack_deactivate(client_);
+        jack_client_close(client_);
+        client_ = nullptr;
+    }
+    ports_.clear();
+}
+
+bool JackAudioDevice::isRunning()
+{
+    return isRunning_;
+}
+
+int JackAudioDevice::ProcessCallback_(jack_nframes_t nframes, void* arg)
+{
+    JackAudioDevice* thisObj = static_cast<JackAudioDevice*>(arg);
+    int numChannels = thisObj->ports_.size();
+    if (thisObj->buffer_.size() < nframes * numChannels)
+    {
+        // Shouldn't happen (BufferSizeCallback_ runs first), but never
+        // allocate here.
+        return 0;
+    }
+    short* buffer = &thisObj->buffer_[0];
+
+    // Latency of the connections to the hardware, as reported by the
+    // server. All our ports are connected alike so the first one will do.
+    jack_latency_range_t range = { 0, 0 };
+    if (numChannels > 0)
+    {
+        jack_port_get_latency_range(
+            thisObj->ports_[0], 
+            thisObj->direction_ == IAudioEngine::AUDIO_ENGINE_IN ? JackCaptureLatency : JackPlaybackLatency, 
+            &range);
+    }
+    int latencyUs = (int64_t)1000000 * range.max / thisObj->sampleRate_;
+
+    if (thisObj->direction_ == IAudioEngine::AUDIO_ENGINE_IN)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            const jack_default_audio_sample_t* in = 
+                (const jack_default_audio_sample_t*)jack_port_get_buffer(thisObj->ports_[channel], nframes);
+            for (jack_nframes_t index = 0; index < nframes; index++)
+            {
+                float sample = in[index] * 32767.0f;
+                sample = sample > 32767.0f ? 32767.0f : (sample < -32768.0f ? -32768.0f : sample);
+                buffer[index * numChannels + channel] = (short)sample;
+            }
+        }
+
+        thisObj->processInputData_(buffer, nframes, latencyUs);
+    }
+    else
+    {
+        memset(buffer, 0, nframes * numChannels * sizeof(short));
+        thisObj->processOutputData_(buffer, nframes, latencyUs);
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            jack_default_audio_sample_t* out = 
+                (jack_default_audio_sample_t*)jack_port_get_buffer(thisObj->ports_[channel], nframes);
+            for (jack_nframes_t index = 0; index < nframes; index++)
+            {
+                out[index] = buffer[index * numChannels + channel] * (1.0f / 32768.0f);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int JackAudioDevice::BufferSizeCallback_(jack_nframes_t nframes, void* arg)
+{
+    JackAudioDevice* thisObj = static_cast<JackAudioDevice*>(arg);
+    thisObj->buffer_.resize(nframes * thisObj->numChannels_);
+    return 0;
+}
+
+int JackAudioDevice::XrunCallback_(void* arg)
+{
+    // JACK doesn't say which direction was affected, so report what would
+    // matter for this device.
+    JackAudioDevice* thisObj = static_cast<JackAudioDevice*>(arg);
+    if (thisObj->direction_ == IAudioEngine::AUDIO_ENGINE_IN)
+    {
+        if (thisObj->onAudioOverflowFunction)
+        {
+            thisObj->onAudioOverflowFunction(*thisObj, thisObj->onAudioOverflowState);
+        }
+    }
+    else if (thisObj->onAudioUnderflowFunction)
+    {
+        thisObj->onAudioUnderflowFunction(*thisObj, thisObj->onAudioUnderflowState);
+    }
+    return 0;
+}
+
+void JackAudioDevice::ShutdownCallback_(void* arg)
+{
+    // The client is unusable from here on, but still has to be closed by
+    // stop().
+    JackAudioDevice* thisObj = static_cast<JackAudioDevice*>(arg);
+    thisObj->isRunning_ = false;
+    if (thisObj->onAudioErrorFunction)
+    {
+        thisObj->onAudioErrorFunction(*thisObj, "JACK server shut down", thisObj->onAudioErrorState);
+    }
+}
@@ -0,0 +1,78 @@
+//=========================================================================
+// Name:            JackAudioDevice.h
+// Purpose:         Defines the interface to a JACK device.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef JACK_AUDIO_DEVICE_H
+#define JACK_AUDIO_DEVICE_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <wx/string.h>
+#include <jack/jack.h>
+#include "IAudioEngine.h"
+#include "IAudioDevice.h"
+
+class JackAudioDevice : public IAudioDevice
+{
+public:
+    virtual ~JackAudioDevice();
+    
+    virtual int getNumChannels() override { return numChannels_; }
+    virtual int getSampleRate() const override { return sampleRate_; }
+    
+    virtual void start() override;
+    virtual void stop() override;
+
+    virtual bool isRunning() override;
+    
+protected:
+    // JackAudioDevice cannot be created directly, only via JackAudioEngine.
+    friend class JackAudioEngine;
+    
+    JackAudioDevice(wxString devName, IAudioEngine::AudioDirection direction, int sampleRate, int numChannels, std::vector<std::string> portNames);
+    
+private:
+    wxString devName_;
+    IAudioEngine::AudioDirection direction_;
+    int sampleRate_;
+    int numChannels_;
+
+    // Ports of devName_ to connect to, one per channel.
+    std::vector<std::string> portNames_;
+
+    jack_client_t* client_;
+    std::vector<jack_port_t*> ports_;
+    std::atomic<bool> isRunning_;
+
+    // Interleaved int16 for processInputData_()/processOutputData_(),
+    // sized for the current period outside of the process callback.
+    std::vector<short> buffer_;
+
+    void closeClient_();
+
+    static int ProcessCallback_(jack_nframes_t nframes, void* arg);
+    static int BufferSizeCallback_(jack_nframes_t nframes, void* arg);
+    static int XrunCallback_(void* arg);
+    static void ShutdownCallback_(void* arg);
+};
+
+#endif // JACK_AUDIO_DEVICE_H
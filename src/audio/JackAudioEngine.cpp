@@ -0,0 +1,200 @@
+//=========================================================================
+// Name:            JackAudioEngine.cpp
+// Purpose:         Defines the interface to the JACK audio engine.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include "JackAudioDevice.h"
+#include "JackAudioEngine.h"
+
+// Our own clients (see JackAudioDevice::start()) aren't offered as devices.
+#define JACK_OWN_CLIENT_PREFIX "FreeDV"
+
+JackAudioEngine::JackAudioEngine()
+    : initialized_(false)
+    , periodFrames_(0)
+    , client_(nullptr)
+{
+    // empty
+}
+
+JackAudioEngine::~JackAudioEngine()
+{
+    if (initialized_)
+    {
+        stop();
+    }
+}
+
+void JackAudioEngine::start()
+{
+    if (initialized_)
+    {
+        return;
+    }
+
+    jack_status_t status;
+    client_ = jack_client_open(JACK_OWN_CLIENT_PREFIX " control", JackNoStartServer, &status);
+    if (client_ == nullptr)
+    {
+        if (onAudioErrorFunction)
+        {
+            onAudioErrorFunction(*this, "Could not connect to the JACK server. Is jackd running?", onAudioErrorState);
+        }
+        return;
+    }
+
+    if (periodFrames_ > 0 && (int)jack_get_buffer_size(client_) != periodFrames_ &&
+        jack_set_buffer_size(client_, periodFrames_) != 0)
+    {
+        // Not fatal, we just keep the server's period.
+        fprintf(stderr, "JackAudioEngine: could not set period to %d frames (using %d)\n", periodFrames_, (int)jack_get_buffer_size(client_));
+    }
+
+    initialized_ = true;
+}
+
+void JackAudioEngine::stop()
+{
+    if (initialized_)
+    {
+        jack_client_close(client_);
+        client_ = nullptr;
+        initialized_ = false;
+    }
+}
+
+std::vector<std::string> JackAudioEngine::getPortNames_(const std::string& clientName, AudioDirection direction)
+{
+    std::vector<std::string> result;
+    if (!initialized_)
+    {
+        return result;
+    }
+
+    // We capture from their outputs and play back to their inputs.
+    const char** ports = jack_get_ports(
+        client_, nullptr, JACK_DEFAULT_AUDIO_TYPE, 
+        direction == AUDIO_ENGINE_IN ? JackPortIsOutput : JackPortIsInput);
+    for (int index = 0; ports != nullptr && ports[index] != nullptr; index++)
+    {
+        std::string portName = ports[index];
+        std::string portClient = portName.substr(0, portName.find(':'));
+        if (portClient.compare(0, strlen(JACK_OWN_CLIENT_PREFIX), JACK_OWN_CLIENT_PREFIX) == 0)
+        {
+            continue;
+        }
+
+        if (clientName == "" || portClient == clientName)
+        {
+            result.push_back(portName);
+        }
+    }
+    jack_free(ports);
+
+    return result;
+}
+
+std::vector<AudioDeviceSpecification> JackAudioEngine::getAudioDeviceList(AudioDirection direction)
+{
+    std::vector<AudioDeviceSpecification> result;
+    int sampleRate = initialized_ ? jack_get_sample_rate(client_) : 0;
+
+    // One device per client, in the order the server lists them.
+    for (auto& portName : getPortNames_("", direction))
+    {
+        wxString clientName = wxString::FromUTF8(portName.substr(0, portName.find(':')).c_str());
+        auto iter = std::find_if(result.begin(), result.end(), [&](AudioDeviceSpecification& dev) { 
+            return dev.name == clientName; 
+        });
+        if (iter != result.end())
+        {
+            iter->maxChannels++;
+            continue;
+        }
+
+        AudioDeviceSpecification device;
+        device.deviceId = result.size();
+        device.name = clientName;
+        device.apiName = "JACK";
+        device.maxChannels = 1;
+        device.minChannels = 1;
+        device.defaultSampleRate = sampleRate;
+        result.push_back(device);
+    }
+
+    return result;
+}
+
+std::vector<int> JackAudioEngine::getSupportedSampleRates(wxString deviceName, AudioDirection direction)
+{
+    // Clients can't change the server's rate.
+    std::vector<int> result;
+    if (initialized_)
+    {
+        result.push_back(jack_get_sample_rate(client_));
+    }
+    return result;
+}
+
+AudioDeviceSpecification JackAudioEngine::getDefaultAudioDevice(AudioDirection direction)
+{
+    // Prefer the hardware ("system" unless renamed).
+    const char** ports = initialized_ ? jack_get_ports(
+        client_, nullptr, JACK_DEFAULT_AUDIO_TYPE, 
+        JackPortIsPhysical | (direction == AUDIO_ENGINE_IN ? JackPortIsOutput : JackPortIsInput)) : nullptr;
+    wxString physicalName;
+    if (ports != nullptr && ports[0] != nullptr)
+    {
+        std::string portName = ports[0];
+        physicalName = wxString::FromUTF8(portName.substr(0, portName.find(':')).c_str());
+    }
+    jack_free(ports);
+
+    auto devices = getAudioDeviceList(direction);
+    for (auto& device : devices)
+    {
+        if (device.name == physicalName)
+        {
+            return device;
+        }
+    }
+
+    return devices.size() > 0 ? devices[0] : AudioDeviceSpecification::GetInvalidDevice();
+}
+
+std::shared_ptr<IAudioDevice> JackAudioEngine::getAudioDevice(wxString deviceName, AudioDirection direction, int sampleRate, int numChannels)
+{
+    std::vector<std::string> portNames = getPortNames_((const char*)deviceName.ToUTF8(), direction);
+    if (portNames.size() == 0)
+    {
+        return nullptr;
+    }
+
+    // Cap number of channels to allowed range.
+    numChannels = std::max(numChannels, 1);
+    numChannels = std::min(numChannels, (int)portNames.size());
+
+    // Always the server's rate; callers pick up getSampleRate().
+    auto devObj = new JackAudioDevice(deviceName, direction, jack_get_sample_rate(client_), numChannels, portNames);
+    return std::shared_ptr<IAudioDevice>(devObj);
+}
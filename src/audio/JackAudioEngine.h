@@ -0,0 +1,62 @@
+//=========================================================================
+// Name:            JackAudioEngine.h
+// Purpose:         Defines the interface to the JACK audio engine.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef JACK_AUDIO_ENGINE_H
+#define JACK_AUDIO_ENGINE_H
+
+#include <string>
+#include <jack/jack.h>
+#include "IAudioEngine.h"
+
+// Each JACK client with audio ports (e.g. "system") is listed as a device
+// with one channel per port; devices connect to the ports in the order the
+// server lists them. The sample rate is always the server's.
+class JackAudioEngine : public IAudioEngine
+{
+public:
+    JackAudioEngine();
+    virtual ~JackAudioEngine();
+    
+    virtual void start();
+    virtual void stop();
+    virtual std::vector<AudioDeviceSpecification> getAudioDeviceList(AudioDirection direction);
+    virtual AudioDeviceSpecification getDefaultAudioDevice(AudioDirection direction);
+    virtual std::shared_ptr<IAudioDevice> getAudioDevice(wxString deviceName, AudioDirection direction, int sampleRate, int numChannels);
+    virtual std::vector<int> getSupportedSampleRates(wxString deviceName, AudioDirection direction);
+
+    // Period (frames per process callback) to request from the server on
+    // start(), 0 to leave it alone. Note that this applies to all JACK
+    // clients, not just ours.
+    void setPeriodFrames(int periodFrames) { periodFrames_ = periodFrames; }
+    
+private:
+    bool initialized_;
+    int periodFrames_;
+
+    // Used for enumerating ports and server settings only; each device has
+    // its own client so it gets its own process callback.
+    jack_client_t* client_;
+
+    std::vector<std::string> getPortNames_(const std::string& clientName, AudioDirection direction);
+};
+
+#endif // JACK_AUDIO_ENGINE_H
@@ -23,6 +23,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstring>
+#include <cmath>
 #include "PortAudioDevice.h"
 #include "portaudio.h"
 
@@ -36,6 +37,7 @@ PortAudioDevice::PortAudioDevice(int deviceId, IAudioEngine::AudioDirection dire
     , sampleRate_(sampleRate)
     , numChannels_(numChannels)
     , deviceStream_(nullptr)
+    , streamLatencyUs_(0)
 {
     auto deviceInfo = Pa_GetDeviceInfo(deviceId_);
     std::string hostApiName = Pa_GetHostApiInfo(deviceInfo->hostApi)->name;
@@ -72,6 +74,8 @@ bool PortAudioDevice::isRunning()
 
 void PortAudioDevice::start()
 {
+    allocateConversionBuffer_();
+
     PaStreamParameters streamParameters;
     auto deviceInfo = Pa_GetDeviceInfo(deviceId_);
 
@@ -94,6 +98,15 @@ void PortAudioDevice::start()
         
     if (error == paNoError)
     {
+        auto streamInfo = Pa_GetStreamInfo(deviceStream_);
+        if (streamInfo != nullptr)
+        {
+            streamLatencyUs_ = 1000000 * (
+                direction_ == IAudioEngine::AUDIO_ENGINE_IN ? 
+                streamInfo->inputLatency : 
+                streamInfo->outputLatency);
+        }
+
         error = Pa_StartStream(deviceStream_);
         if (error != paNoError)
         {
@@ -185,9 +198,24 @@ int PortAudioDevice::OnPortAudioStreamCallback_(const void *input, void *output,
         memset(dataPtr, 0, sizeof(short) * thisObj->getNumChannels() * frameCount);
     }
 
-    if (thisObj->onAudioDataFunction)
+    // The ADC/DAC times are 0 if the host API doesn't support them.
+    double bufferTime = 
+        thisObj->direction_ == IAudioEngine::AUDIO_ENGINE_IN ? 
+        timeInfo->inputBufferAdcTime : 
+        timeInfo->outputBufferDacTime;
+    int latencyUs = thisObj->streamLatencyUs_;
+    if (bufferTime > 0 && timeInfo->currentTime > 0)
+    {
+        latencyUs = 1000000 * std::abs(timeInfo->currentTime - bufferTime);
+    }
+
+    if (thisObj->direction_ == IAudioEngine::AUDIO_ENGINE_OUT)
+    {
+        thisObj->processOutputData_((short*)dataPtr, frameCount, latencyUs);
+    }
+    else
     {
-        thisObj->onAudioDataFunction(*thisObj, dataPtr, frameCount, thisObj->onAudioDataState);
+        thisObj->processInputData_((const short*)dataPtr, frameCount, latencyUs);
     }
     
     return paContinue;
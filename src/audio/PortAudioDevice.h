@@ -52,6 +52,10 @@ private:
     int sampleRate_;
     int numChannels_;
     PaStream* deviceStream_;
+
+    // Latency reported by Pa_GetStreamInfo(), for host APIs that don't
+    // provide callback timestamps.
+    int streamLatencyUs_;
     
     static int OnPortAudioStreamCallback_(const void *input, void *output, unsigned long frameCount, const PaStreamCallbackTimeInfo *timeInfo, PaStreamCallbackFlags statusFlags, void *userData);
 };
@@ -21,13 +21,20 @@
 //=========================================================================
 
 #include <sstream>
+#include <cstring>
+#include <algorithm>
 #include <wx/string.h>
 #include "portaudio.h"
 #include "PortAudioDevice.h"
 #include "PortAudioEngine.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
 PortAudioEngine::PortAudioEngine()
     : initialized_(false)
+    , cancelRefresh_(false)
 {
     // empty
 }
@@ -62,96 +69,233 @@ void PortAudioEngine::start()
     else
     {
         initialized_ = true;
+
+        waitForRefresh_();
+        pruneCache_();
+        cancelRefresh_ = false;
+        refreshThread_ = std::thread(&PortAudioEngine::refreshEntry_, this);
     }
 }
 
 void PortAudioEngine::stop()
 {
+    // Must not be probing when PortAudio goes away.
+    cancelRefresh_ = true;
+    waitForRefresh_();
+
     Pa_Terminate();
     initialized_ = false;
 }
 
-std::vector<AudioDeviceSpecification> PortAudioEngine::getAudioDeviceList(AudioDirection direction)
+bool PortAudioEngine::isDeviceUsable_(int index, AudioDirection direction)
+{
+    const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(index);
+    
+    std::string hostApiName = Pa_GetHostApiInfo(deviceInfo->hostApi)->name;
+    if (hostApiName.find("DirectSound") != std::string::npos ||
+        hostApiName.find("surround") != std::string::npos ||
+        //hostApiName.find("Windows WASAPI") != std::string::npos ||
+        hostApiName.find("MME") != std::string::npos ||
+        hostApiName.find("Windows WDM-KS") != std::string::npos)
+    {
+        // Skip non-MME/Core Audio devices as that was the old behavior.
+        // Note: DirectSound in particular hasn't been shown 
+        //       due to poor real-time performance.
+        return false;
+    }
+    
+    return 
+        (direction == AUDIO_ENGINE_IN && deviceInfo->maxInputChannels > 0) || 
+        (direction == AUDIO_ENGINE_OUT && deviceInfo->maxOutputChannels > 0);
+}
+
+std::string PortAudioEngine::getCacheKey_(int index, AudioDirection direction)
+{
+    // Device indices change when devices come and go, so identify devices by
+    // what they are. Channels and default rate are in there so that e.g. a
+    // different device model plugged into the same port isn't mistaken for
+    // the old one.
+    const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(index);
+    std::stringstream ss;
+    ss << Pa_GetHostApiInfo(deviceInfo->hostApi)->name << "\n"
+       << deviceInfo->name << "\n"
+       << (direction == AUDIO_ENGINE_IN ? "in" : "out") << "\n"
+       << (direction == AUDIO_ENGINE_IN ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels) << "\n"
+       << deviceInfo->defaultSampleRate;
+    return ss.str();
+}
+
+PortAudioEngine::DeviceCapabilities PortAudioEngine::getCapabilities_(int index, AudioDirection direction)
+{
+    std::string key = getCacheKey_(index, direction);
+    {
+        std::unique_lock<std::mutex> lk(cacheMutex_);
+        auto iter = capabilityCache_.find(key);
+        if (iter != capabilityCache_.end())
+        {
+            return iter->second;
+        }
+    }
+    
+    auto caps = probeDevice_(index, direction);
+    
+    std::unique_lock<std::mutex> lk(cacheMutex_);
+    capabilityCache_[key] = caps;
+    return caps;
+}
+
+PortAudioEngine::DeviceCapabilities PortAudioEngine::probeDevice_(int index, AudioDirection direction)
 {
+    std::unique_lock<std::mutex> lk(probeMutex_);
+    const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(index);
+    DeviceCapabilities caps;
+    
+    // Detect the minimum number of channels available as PortAudio doesn't
+    // provide this info. This should in theory be 1 but at least one device 
+    // (Focusrite Scarlett) will not accept anything less than 4 channels 
+    // on Windows.
+    PaStreamParameters streamParameters;
+    streamParameters.device = index;
+    streamParameters.channelCount = 1; 
+    streamParameters.sampleFormat = paInt16;
+    streamParameters.suggestedLatency = deviceInfo->defaultHighInputLatency;
+    streamParameters.hostApiSpecificStreamInfo = NULL;
+
+    int maxChannels = direction == AUDIO_ENGINE_IN ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels;
+    while (streamParameters.channelCount < maxChannels)
+    {
+        PaError err = Pa_IsFormatSupported(
+            direction == AUDIO_ENGINE_IN ? &streamParameters : NULL, 
+            direction == AUDIO_ENGINE_OUT ? &streamParameters : NULL, 
+            deviceInfo->defaultSampleRate);
+    
+        if (err == paFormatIsSupported)
+        {
+            break;
+        }
+
+        streamParameters.channelCount++;
+    }
+    caps.minChannels = streamParameters.channelCount;
+    
+    int rateIndex = 0;
+    while (IAudioEngine::StandardSampleRates[rateIndex] != -1)
+    {
+        PaError err = Pa_IsFormatSupported(
+            direction == AUDIO_ENGINE_IN ? &streamParameters : NULL, 
+            direction == AUDIO_ENGINE_OUT ? &streamParameters : NULL, 
+            IAudioEngine::StandardSampleRates[rateIndex]);
+
+        if (err == paFormatIsSupported)
+        {
+            caps.sampleRates.push_back(IAudioEngine::StandardSampleRates[rateIndex]);
+        }
+        
+        rateIndex++;
+    }
+
+    // If we can't find a supported sample rate, just assume that the
+    // default sample rate is supported. If that can't actually be used,
+    // we can deal with it later.
+    if (caps.sampleRates.size() == 0)
+    {
+        caps.sampleRates.push_back(deviceInfo->defaultSampleRate);
+    }
+    
+    return caps;
+}
+
+void PortAudioEngine::pruneCache_()
+{
+    std::map<std::string, DeviceCapabilities> current;
     int numDevices = Pa_GetDeviceCount();
-    std::vector<AudioDeviceSpecification> result;
     
+    std::unique_lock<std::mutex> lk(cacheMutex_);
     for (int index = 0; index < numDevices; index++)
     {
-        const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(index);
-        
-        std::string hostApiName = Pa_GetHostApiInfo(deviceInfo->hostApi)->name;
-        if (hostApiName.find("DirectSound") != std::string::npos ||
-            hostApiName.find("surround") != std::string::npos ||
-            //hostApiName.find("Windows WASAPI") != std::string::npos ||
-            hostApiName.find("MME") != std::string::npos ||
-            hostApiName.find("Windows WDM-KS") != std::string::npos)
+        for (auto direction : { AUDIO_ENGINE_IN, AUDIO_ENGINE_OUT })
+        {
+            auto iter = capabilityCache_.find(getCacheKey_(index, direction));
+            if (iter != capabilityCache_.end())
+            {
+                current.insert(*iter);
+            }
+        }
+    }
+    capabilityCache_.swap(current);
+}
+
+void PortAudioEngine::refreshEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV PAProbe");
+#endif // defined(__linux__)
+
+    // Probe anything new so that the device dialogs find it in the cache.
+    int numDevices = Pa_GetDeviceCount();
+    for (int index = 0; index < numDevices && !cancelRefresh_; index++)
+    {
+        if (IsDeviceWhitelisted_(Pa_GetDeviceInfo(index)->name))
         {
-            // Skip non-MME/Core Audio devices as that was the old behavior.
-            // Note: DirectSound in particular hasn't been shown 
-            //       due to poor real-time performance.
             continue;
         }
         
-        if ((direction == AUDIO_ENGINE_IN && deviceInfo->maxInputChannels > 0) || 
-            (direction == AUDIO_ENGINE_OUT && deviceInfo->maxOutputChannels > 0))
+        for (auto direction : { AUDIO_ENGINE_IN, AUDIO_ENGINE_OUT })
         {
-            // Detect the minimum number of channels available as PortAudio doesn't
-            // provide this info. This should in theory be 1 but at least one device 
-            // (Focusrite Scarlett) will not accept anything less than 4 channels 
-            // on Windows.
-            PaStreamParameters streamParameters;
-            streamParameters.device = index;
-            streamParameters.channelCount = 1; 
-            streamParameters.sampleFormat = paInt16;
-            streamParameters.suggestedLatency = Pa_GetDeviceInfo(index)->defaultHighInputLatency;
-            streamParameters.hostApiSpecificStreamInfo = NULL;
-
-            // On Linux, the below logic causes the device lookup process to take MUCH	
-            // longer than it does on other platforms, mainly because of the special devices	
-            // it provides to PortAudio. For these, we're just going to assume the minimum	
-            // valid channels is 1.            
-            int maxChannels = direction == AUDIO_ENGINE_IN ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels;
-            bool isDeviceWithKnownMinimum = IsDeviceWhitelisted_(deviceInfo->name);
-            if (!isDeviceWithKnownMinimum)
+            if (!cancelRefresh_ && isDeviceUsable_(index, direction))
             {
-                while (streamParameters.channelCount < maxChannels)
-                {
-                    PaError err = Pa_IsFormatSupported(
-                        direction == AUDIO_ENGINE_IN ? &streamParameters : NULL, 
-                        direction == AUDIO_ENGINE_OUT ? &streamParameters : NULL, 
-                        deviceInfo->defaultSampleRate);
-                
-                    if (err == paFormatIsSupported)
-                    {
-                        break;
-                    }
-
-                    streamParameters.channelCount++;
-                }
+                getCapabilities_(index, direction);
             }
+        }
+    }
+}
 
-            // Add information about this device to the result array.
-            AudioDeviceSpecification device;
-            device.deviceId = index;
-            device.name = wxString::FromUTF8(deviceInfo->name);
-            device.apiName = hostApiName;
+void PortAudioEngine::waitForRefresh_()
+{
+    if (refreshThread_.joinable())
+    {
+        refreshThread_.join();
+    }
+}
 
-            // For "whitelisted" devices, also assume channel counts
-            if (IsDeviceWhitelisted_(deviceInfo->name))
-            {
-                device.maxChannels = 2;
-            }
-            else
-            {
-                device.minChannels = streamParameters.channelCount;
-                device.maxChannels = 
-                    direction == AUDIO_ENGINE_IN ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels;
-            }
-            device.defaultSampleRate = deviceInfo->defaultSampleRate;
-            
-            result.push_back(device);
+std::vector<AudioDeviceSpecification> PortAudioEngine::getAudioDeviceList(AudioDirection direction)
+{
+    int numDevices = Pa_GetDeviceCount();
+    std::vector<AudioDeviceSpecification> result;
+    
+    for (int index = 0; index < numDevices; index++)
+    {
+        if (!isDeviceUsable_(index, direction))
+        {
+            continue;
+        }
+        
+        const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(index);
+
+        // Add information about this device to the result array.
+        AudioDeviceSpecification device;
+        device.deviceId = index;
+        device.name = wxString::FromUTF8(deviceInfo->name);
+        device.apiName = Pa_GetHostApiInfo(deviceInfo->hostApi)->name;
+
+        // On Linux, probing causes the device lookup process to take MUCH	
+        // longer than it does on other platforms, mainly because of the special devices	
+        // it provides to PortAudio. For these, we're just going to assume 1-2 channels	
+        // and that every standard sample rate works.
+        if (IsDeviceWhitelisted_(deviceInfo->name))
+        {
+            device.minChannels = 1;
+            device.maxChannels = 2;
         }
+        else
+        {
+            device.minChannels = getCapabilities_(index, direction).minChannels;
+            device.maxChannels = 
+                direction == AUDIO_ENGINE_IN ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels;
+        }
+        device.defaultSampleRate = deviceInfo->defaultSampleRate;
+        
+        result.push_back(device);
     }
     
     return result;
@@ -166,42 +310,18 @@ std::vector<int> PortAudioEngine::getSupportedSampleRates(wxString deviceName, A
     {
         if (device.name.IsSameAs(deviceName))
         {
-            PaStreamParameters streamParameters;
-            
-            streamParameters.device = device.deviceId;
-            streamParameters.channelCount = device.minChannels;
-            streamParameters.sampleFormat = paInt16;
-            streamParameters.suggestedLatency = Pa_GetDeviceInfo(device.deviceId)->defaultHighInputLatency;
-            streamParameters.hostApiSpecificStreamInfo = NULL;
-            
-            int rateIndex = 0;
-            while (IAudioEngine::StandardSampleRates[rateIndex] != -1)
+            if (IsDeviceWhitelisted_(deviceName))
             {
-                PaError err = paFormatIsSupported;
-
-                bool isDeviceWithKnownMinimum = IsDeviceWhitelisted_(deviceName);
-                if (!isDeviceWithKnownMinimum)
+                int rateIndex = 0;
+                while (IAudioEngine::StandardSampleRates[rateIndex] != -1)
                 {
-                    err = Pa_IsFormatSupported(
-                        direction == AUDIO_ENGINE_IN ? &streamParameters : NULL, 
-                        direction == AUDIO_ENGINE_OUT ? &streamParameters : NULL, 
-                        IAudioEngine::StandardSampleRates[rateIndex]);
+                    result.push_back(IAudioEngine::StandardSampleRates[rateIndex++]);
                 }
-
-                if (err == paFormatIsSupported)
-                {
-                    result.push_back(IAudioEngine::StandardSampleRates[rateIndex]);
-                }
-                
-                rateIndex++;
             }
-
-            // If we can't find a supported sample rate, just assume that the
-            // default sample rate is supported. If that can't actually be used,
-            // we can deal with it later.
-            if (result.size() == 0)
+            else
             {
-                result.push_back(device.defaultSampleRate);
+                auto caps = getCapabilities_(device.deviceId, direction);
+                result.insert(result.end(), caps.sampleRates.begin(), caps.sampleRates.end());
             }
         }
     }
@@ -231,38 +351,56 @@ AudioDeviceSpecification PortAudioEngine::getDefaultAudioDevice(AudioDirection d
 
 std::shared_ptr<IAudioDevice> PortAudioEngine::getAudioDevice(wxString deviceName, AudioDirection direction, int sampleRate, int numChannels)
 {
-    auto deviceList = getAudioDeviceList(direction);
-    
-    auto supportedSampleRates = getSupportedSampleRates(deviceName, direction);
-    bool found = false;
-    for (auto& rate : supportedSampleRates)
+    // Don't open a stream while the background refresh may be probing, but
+    // don't wait for it to get through every device either. Anything it
+    // hadn't reached is probed by the device dialogs when they need it.
+    cancelRefresh_ = true;
+    waitForRefresh_();
+
+    // Only the requested device is probed (if it isn't cached already).
+    int numDevices = Pa_GetDeviceCount();
+    for (int index = 0; index < numDevices; index++)
     {
-        if (rate == sampleRate)
+        const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(index);
+        if (!isDeviceUsable_(index, direction) || !wxString::FromUTF8(deviceInfo->name).IsSameAs(deviceName))
         {
-            found = true;
-            break;
+            continue;
         }
-    }
 
-    if (!found)
-    {
-        // Zero out the input sample rate. The device object will use the default sample rate
-        // instead.
-        sampleRate = 0;
-    }
-    
-    for (auto& dev : deviceList)
-    {
-        if (dev.name.IsSameAs(deviceName))
+        // Same assumptions for the special Linux devices as
+        // getAudioDeviceList() and getSupportedSampleRates().
+        int minChannels = 1;
+        int maxChannels = 2;
+        std::vector<int> supportedSampleRates;
+        if (IsDeviceWhitelisted_(deviceInfo->name))
+        {
+            for (int rateIndex = 0; IAudioEngine::StandardSampleRates[rateIndex] != -1; rateIndex++)
+            {
+                supportedSampleRates.push_back(IAudioEngine::StandardSampleRates[rateIndex]);
+            }
+        }
+        else
         {
-            // Ensure that the passed-in number of channels is within the allowed range.
-            numChannels = std::max(numChannels, dev.minChannels);
-            numChannels = std::min(numChannels, dev.maxChannels);
+            auto caps = getCapabilities_(index, direction);
+            minChannels = caps.minChannels;
+            maxChannels = direction == AUDIO_ENGINE_IN ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels;
+            supportedSampleRates = caps.sampleRates;
+        }
 
-            // Create device object.
-            auto devObj = new PortAudioDevice(dev.deviceId, direction, sampleRate, numChannels);
-            return std::shared_ptr<IAudioDevice>(devObj);
+        if (std::find(supportedSampleRates.begin(), supportedSampleRates.end(), sampleRate) == supportedSampleRates.end())
+        {
+            // Zero out the input sample rate. The device object will use the default sample rate
+            // instead.
+            sampleRate = 0;
         }
+
+        // Ensure that the passed-in number of channels is within the allowed range.
+        numChannels = std::max(numChannels, minChannels);
+        numChannels = std::min(numChannels, maxChannels);
+
+        // Create device object.
+        auto devObj = new PortAudioDevice(index, direction, sampleRate, numChannels);
+        return std::shared_ptr<IAudioDevice>(devObj);
     }
 
     return nullptr;
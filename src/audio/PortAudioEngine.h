@@ -23,8 +23,19 @@
 #ifndef PORT_AUDIO_ENGINE_H
 #define PORT_AUDIO_ENGINE_H
 
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include "IAudioEngine.h"
 
+// Probing devices with Pa_IsFormatSupported() can take seconds on machines
+// with many devices, so the results (minimum channels and sample rates) are
+// cached for the life of the engine, keyed by host API and device identity.
+// PortAudio only rescans devices in Pa_Initialize(), so start() is where
+// hot-plugged devices show up: entries for devices that have gone are
+// dropped and new devices are probed on a background thread. Opening a
+// device cancels that and only probes the device being opened.
 class PortAudioEngine : public IAudioEngine
 {
 public:
@@ -39,8 +50,30 @@ public:
     virtual std::vector<int> getSupportedSampleRates(wxString deviceName, AudioDirection direction);
     
 private:
+    struct DeviceCapabilities
+    {
+        int minChannels;
+        std::vector<int> sampleRates;
+    };
+
     bool initialized_;
 
+    std::mutex cacheMutex_;
+    std::map<std::string, DeviceCapabilities> capabilityCache_;
+
+    // Only one probe at a time, whichever thread it's on.
+    std::mutex probeMutex_;
+    std::thread refreshThread_;
+    std::atomic<bool> cancelRefresh_;
+
+    bool isDeviceUsable_(int index, AudioDirection direction);
+    std::string getCacheKey_(int index, AudioDirection direction);
+    DeviceCapabilities getCapabilities_(int index, AudioDirection direction);
+    DeviceCapabilities probeDevice_(int index, AudioDirection direction);
+    void pruneCache_();
+    void refreshEntry_();
+    void waitForRefresh_();
+
     static bool IsDeviceWhitelisted_(const char* devName);
 };
 
@@ -23,21 +23,29 @@
 #include <cstring>
 #include <cstdio>
 
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
 #include "PulseAudioDevice.h"
 
 // Optimal settings based on ones used for PortAudio.
 #define PULSE_FPB 256
 #define PULSE_TARGET_LATENCY_US 20000
 
+// Playback ring size. Must comfortably exceed twice the largest write
+// request PulseAudio makes (normally around PULSE_TARGET_LATENCY_US).
+#define PULSE_OUTPUT_RING_MS 500
+
 PulseAudioDevice::PulseAudioDevice(pa_threaded_mainloop *mainloop, pa_context* context, wxString devName, IAudioEngine::AudioDirection direction, int sampleRate, int numChannels)
     : context_(context)
     , mainloop_(mainloop)
     , stream_(nullptr)
-    , outputPending_(nullptr)
-    , outputPendingLength_(0)
     , outputPendingThreadActive_(false)
+    , outputRequested_(false)
     , outputPendingThread_(nullptr)
     , targetOutputPendingLength_(PULSE_FPB * numChannels * 2)
+    , streamLatencyUs_(0)
     , devName_(devName)
     , direction_(direction)
     , sampleRate_(sampleRate)
@@ -62,6 +70,8 @@ bool PulseAudioDevice::isRunning()
 
 void PulseAudioDevice::start()
 {
+    allocateConversionBuffer_();
+
     pa_sample_spec sample_specification;
     sample_specification.format = PA_SAMPLE_S16LE;
     sample_specification.rate = sampleRate_;
@@ -83,9 +93,7 @@ void PulseAudioDevice::start()
     pa_stream_set_overflow_callback(stream_, &PulseAudioDevice::StreamOverflowCallback_, this);
     pa_stream_set_moved_callback(stream_, &PulseAudioDevice::StreamMovedCallback_, this);
     pa_stream_set_state_callback(stream_, &PulseAudioDevice::StreamStateCallback_, this);
-#if 0
     pa_stream_set_latency_update_callback(stream_, &PulseAudioDevice::StreamLatencyCallback_, this);
-#endif // 0
 
     // recommended settings, i.e. server uses sensible values
     pa_buffer_attr buffer_attr; 
@@ -141,63 +149,17 @@ void PulseAudioDevice::start()
         // is necessary in order to ensure that we can 
         // provide data to PulseAudio at a rate expected
         // for the actual latency of the sound device.
-        outputPending_ = nullptr;
-        outputPendingLength_ = 0;
         targetOutputPendingLength_ = PULSE_FPB * getNumChannels() * 2;
-        outputPendingThreadActive_ = true;
         if (direction_ == IAudioEngine::AUDIO_ENGINE_OUT)
         {
-            outputPendingThread_ = new std::thread([&]() {
-#if defined(__linux__)
-                pthread_setname_np(pthread_self(), "FreeDV PAOut");
-#endif // defined(__linux__)
-
-                while(outputPendingThreadActive_)
-                {
-                    auto currentTime = std::chrono::steady_clock::now();
-                    int currentLength = 0;
-
-                    {
-                        std::unique_lock<std::mutex> lk(outputPendingMutex_);
-                        currentLength = outputPendingLength_;
-                    }
-
-                    if (currentLength < targetOutputPendingLength_)
-                    {                        
-                        short data[PULSE_FPB * getNumChannels()];
-                        memset(data, 0, sizeof(data));
-                        
-                        if (onAudioDataFunction)
-                        {
-                            onAudioDataFunction(*this, data, PULSE_FPB, onAudioDataState);
-                        }
-    
-                        {
-                            std::unique_lock<std::mutex> lk(outputPendingMutex_);
-                            short* temp = new short[outputPendingLength_ + PULSE_FPB * getNumChannels()];
-                            assert(temp != nullptr);
-    
-                            if (outputPendingLength_ > 0)
-                            {
-                                memcpy(temp, outputPending_, outputPendingLength_ * sizeof(short));
-    
-                                delete[] outputPending_;
-                                outputPending_ = nullptr;
-                            }
-                            memcpy(temp + outputPendingLength_, data, sizeof(data));
-    
-                            outputPending_ = temp;
-                            outputPendingLength_ += PULSE_FPB * getNumChannels();
-                        }
-                    }
-
-                    // Sleep the required amount of time to ensure we call onAudioDataFunction
-                    // every PULSE_FPB samples.
-                    int sleepTimeMilliseconds = ((double)PULSE_FPB)/((double)sampleRate_) * 1000.0;
-                    std::this_thread::sleep_until(currentTime + 
-                        std::chrono::milliseconds(sleepTimeMilliseconds));
-                }
-            });
+            outputPending_.reset(new SpscRingBuffer<short>(
+                sampleRate_ * PULSE_OUTPUT_RING_MS / 1000 * getNumChannels()));
+            {
+                std::unique_lock<std::mutex> outputLock(outputPendingMutex_);
+                outputRequested_ = true;
+                outputPendingThreadActive_ = true;
+            }
+            outputPendingThread_ = new std::thread(&PulseAudioDevice::outputThreadEntry_, this);
             assert(outputPendingThread_ != nullptr);
         }
     }
@@ -221,17 +183,19 @@ void PulseAudioDevice::stop()
 
         stream_ = nullptr;
 
-        outputPendingThreadActive_ = false;
         if (outputPendingThread_ != nullptr)
         {
+            {
+                std::unique_lock<std::mutex> outputLock(outputPendingMutex_);
+                outputPendingThreadActive_ = false;
+            }
+            outputPendingCV_.notify_one();
             outputPendingThread_->join();
 
-            delete[] outputPending_;
-            outputPending_ = nullptr;
-            outputPendingLength_ = 0;
-
             delete outputPendingThread_;
             outputPendingThread_ = nullptr;
+
+            outputPending_.reset();
         }
     }
 }
@@ -241,6 +205,10 @@ void PulseAudioDevice::StreamReadCallback_(pa_stream *s, size_t length, void *us
     const void* data = nullptr;
     PulseAudioDevice* thisObj = static_cast<PulseAudioDevice*>(userdata);
 
+    // For recording this includes what's waiting for us to read, i.e. it
+    // dates the oldest data.
+    int latencyUs = GetStreamLatencyUs_(s);
+
     do
     {
         pa_stream_peek(s, &data, &length);
@@ -249,46 +217,116 @@ void PulseAudioDevice::StreamReadCallback_(pa_stream *s, size_t length, void *us
             break;
         }
 
-        if (thisObj->onAudioDataFunction)
-        {
-            thisObj->onAudioDataFunction(*thisObj, (void*)data, length / thisObj->getNumChannels() / sizeof(short), thisObj->onAudioDataState);
-        }
+        size_t numFrames = length / thisObj->getNumChannels() / sizeof(short);
+        thisObj->processInputData_((const short*)data, numFrames, latencyUs);
+        latencyUs = std::max(0, latencyUs - (int)(1000000 * numFrames / thisObj->sampleRate_));
 
         pa_stream_drop(s);
     } while (pa_stream_readable_size(s) > 0);
 }
 
-void PulseAudioDevice::StreamWriteCallback_(pa_stream *s, size_t length, void *userdata)
+void PulseAudioDevice::outputThreadEntry_()
 {
-    if (length > 0)
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV PAOut");
+#endif // defined(__linux__)
+
+    const int samplesPerBlock = PULSE_FPB * getNumChannels();
+    short tmp[samplesPerBlock];
+
+    while (outputPendingThreadActive_)
     {
-        // Note that PulseAudio gives us lengths in terms of number of bytes, not samples.
-        int numSamples = length / sizeof(short);
-        short data[numSamples];
-        memset(data, 0, sizeof(data));
+        {
+            std::unique_lock<std::mutex> lk(outputPendingMutex_);
+            outputPendingCV_.wait(lk, [&]() {
+                return !outputPendingThreadActive_ || outputRequested_.exchange(false);
+            });
+        }
 
-        PulseAudioDevice* thisObj = static_cast<PulseAudioDevice*>(userdata);
+        // Top the ring back up in PULSE_FPB frame blocks, rendering in place
+        // whenever the free space doesn't wrap.
+        while (outputPendingThreadActive_ && 
+               (int)outputPending_->numUsed() < targetOutputPendingLength_ &&
+               (int)outputPending_->numFree() >= samplesPerBlock)
         {
-            std::unique_lock<std::mutex> lk(thisObj->outputPendingMutex_);
-            if (thisObj->outputPendingLength_ >= numSamples)
+            short* block = nullptr;
+            bool inPlace = (int)outputPending_->getWriteSpan(&block) >= samplesPerBlock;
+            if (!inPlace)
             {
-                memcpy(data, thisObj->outputPending_, sizeof(data));
+                block = tmp;
+            }
 
-                short* tmp = new short[thisObj->outputPendingLength_ - numSamples];
-                assert(tmp != nullptr);
+            // Everything already queued plays first.
+            int latencyUs = streamLatencyUs_ + 
+                (int64_t)1000000 * outputPending_->numUsed() / getNumChannels() / sampleRate_;
 
-                thisObj->outputPendingLength_ -= numSamples;
-                memcpy(tmp, thisObj->outputPending_ + numSamples, sizeof(short) * thisObj->outputPendingLength_);
+            memset(block, 0, samplesPerBlock * sizeof(short));
+            processOutputData_(block, PULSE_FPB, latencyUs);
 
-                delete[] thisObj->outputPending_;
-                thisObj->outputPending_ = tmp;
+            if (inPlace)
+            {
+                outputPending_->commitWrite(samplesPerBlock);
+            }
+            else
+            {
+                outputPending_->write(tmp, samplesPerBlock);
             }
+        }
+    }
+}
+
+void PulseAudioDevice::StreamWriteCallback_(pa_stream *s, size_t length, void *userdata)
+{
+    PulseAudioDevice* thisObj = static_cast<PulseAudioDevice*>(userdata);
+    if (length == 0 || !thisObj->outputPending_)
+    {
+        return;
+    }
+
+    // Note that PulseAudio gives us lengths in terms of number of bytes, not samples.
+    const size_t frameBytes = sizeof(short) * thisObj->getNumChannels();
+    int requestedSamples = length / sizeof(short);
+    int newTarget = std::max((int)thisObj->targetOutputPendingLength_, 2 * requestedSamples);
+    newTarget = std::min(newTarget, (int)thisObj->outputPending_->capacity());
+    thisObj->targetOutputPendingLength_ = newTarget;
+
+    while (length >= frameBytes)
+    {
+        // Write directly into the server's buffer, no intermediate copies.
+        void* buffer = nullptr;
+        size_t bufferBytes = length;
+        if (pa_stream_begin_write(s, &buffer, &bufferBytes) < 0 || buffer == nullptr)
+        {
+            break;
+        }
+        bufferBytes = std::min(bufferBytes, length);
+        bufferBytes -= bufferBytes % frameBytes;
+        if (bufferBytes == 0)
+        {
+            pa_stream_cancel_write(s);
+            break;
+        }
 
-            thisObj->targetOutputPendingLength_ = std::max(thisObj->targetOutputPendingLength_, 2 * numSamples);
+        // Anything we don't have yet is sent as silence.
+        size_t numSamples = bufferBytes / sizeof(short);
+        size_t numRead = thisObj->outputPending_->read((short*)buffer, numSamples);
+        if (numRead < numSamples)
+        {
+            memset((short*)buffer + numRead, 0, (numSamples - numRead) * sizeof(short));
         }
 
-        pa_stream_write(s, &data[0], length, NULL, 0LL, PA_SEEK_RELATIVE);
+        pa_stream_write(s, buffer, bufferBytes, NULL, 0LL, PA_SEEK_RELATIVE);
+        length -= bufferBytes;
     }
+
+    // PulseAudio's requests drive the output thread. The flag is set under
+    // the lock so it can't land between the thread's check and its wait;
+    // the thread only holds it for that check.
+    {
+        std::unique_lock<std::mutex> lk(thisObj->outputPendingMutex_);
+        thisObj->outputRequested_ = true;
+    }
+    thisObj->outputPendingCV_.notify_one();
 }
 
 void PulseAudioDevice::StreamStateCallback_(pa_stream *p, void *userdata)
@@ -343,15 +381,21 @@ void PulseAudioDevice::StreamMovedCallback_(pa_stream *p, void *userdata)
     }
 }
 
-#if 0
 void PulseAudioDevice::StreamLatencyCallback_(pa_stream *p, void *userdata)
 {
     PulseAudioDevice* thisObj = static_cast<PulseAudioDevice*>(userdata);
-    pa_usec_t latency;
-    int isNeg;
+    thisObj->streamLatencyUs_ = GetStreamLatencyUs_(p);
+}
 
-    pa_stream_get_latency(p, &latency, &isNeg);
+int PulseAudioDevice::GetStreamLatencyUs_(pa_stream *p)
+{
+    pa_usec_t latency = 0;
+    int isNeg = 0;
 
-    fprintf(stderr, "Current target buffer size for %s: %d\n", (const char*)thisObj->devName_.ToUTF8(), thisObj->targetOutputPendingLength_);
+    // Fails until the first timing update arrives.
+    if (pa_stream_get_latency(p, &latency, &isNeg) < 0 || isNeg)
+    {
+        return 0;
+    }
+    return latency;
 }
-#endif // 0
@@ -25,11 +25,14 @@
 
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <memory>
 #include <condition_variable>
 #include <wx/string.h>
 #include <pulse/pulseaudio.h>
 #include "IAudioEngine.h"
 #include "IAudioDevice.h"
+#include "../util/SpscRingBuffer.h"
 
 class PulseAudioDevice : public IAudioDevice
 {
@@ -54,12 +57,24 @@ private:
     pa_context* context_;
     pa_threaded_mainloop* mainloop_;
     pa_stream* stream_;
-    short* outputPending_;
-    int outputPendingLength_;
-    bool outputPendingThreadActive_;
+
+    // Playback: the output thread renders PULSE_FPB frames at a time into
+    // outputPending_ until it holds targetOutputPendingLength_ samples;
+    // StreamWriteCallback_ copies from it straight into PulseAudio's
+    // buffer and then wakes the output thread to top it back up.
+    std::unique_ptr<SpscRingBuffer<short>> outputPending_;
+    std::atomic<bool> outputPendingThreadActive_;
+    std::atomic<bool> outputRequested_;
     std::mutex outputPendingMutex_;
+    std::condition_variable outputPendingCV_;
     std::thread* outputPendingThread_;
-    int targetOutputPendingLength_;
+    std::atomic<int> targetOutputPendingLength_;
+
+    // Server side latency as of the last timing update, for the output
+    // thread (which can't query it without locking the mainloop).
+    std::atomic<int> streamLatencyUs_;
+
+    void outputThreadEntry_();
 
     wxString devName_;
     IAudioEngine::AudioDirection direction_;
@@ -74,9 +89,9 @@ private:
     static void StreamOverflowCallback_(pa_stream *p, void *userdata);
     static void StreamMovedCallback_(pa_stream *p, void *userdata);
     static void StreamStateCallback_(pa_stream *p, void *userdata);
-#if 0
     static void StreamLatencyCallback_(pa_stream *p, void *userdata);
-#endif // 0
+
+    static int GetStreamLatencyUs_(pa_stream *p);
 };
 
 #endif // PULSE_AUDIO_DEVICE_H
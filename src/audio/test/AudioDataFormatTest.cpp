@@ -0,0 +1,198 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // defined(__linux__) || defined(__APPLE__)
+#include "TestAudioDevice.h"
+#include "../pipeline/test/PipelineTestCommon.h"
+
+#define TEST_MAX_FRAMES 67
+
+// Space for numShorts that ends exactly at the end of a page, with the
+// next page inaccessible, so reading even one sample past the end
+// crashes the test rather than going unnoticed.
+class GuardedBuffer
+{
+public:
+    GuardedBuffer(size_t numShorts)
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        pageSize_ = sysconf(_SC_PAGESIZE);
+        mapSize_ = ((numShorts * sizeof(short) + pageSize_ - 1) / pageSize_ + 1) * pageSize_;
+        map_ = (char*)mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(map_ != MAP_FAILED);
+        mprotect(map_ + mapSize_ - pageSize_, pageSize_, PROT_NONE);
+        data_ = (short*)(map_ + mapSize_ - pageSize_) - numShorts;
+#else
+        storage_.resize(numShorts);
+        data_ = &storage_[0];
+#endif // defined(__linux__) || defined(__APPLE__)
+    }
+
+    ~GuardedBuffer()
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        munmap(map_, mapSize_);
+#endif // defined(__linux__) || defined(__APPLE__)
+    }
+
+    short* get() { return data_; }
+
+private:
+    short* data_;
+#if defined(__linux__) || defined(__APPLE__)
+    char* map_;
+    size_t mapSize_;
+    size_t pageSize_;
+#else
+    std::vector<short> storage_;
+#endif // defined(__linux__) || defined(__APPLE__)
+};
+
+static short testSample(int channel, size_t frame)
+{
+    return (short)((channel ? -1000 : 1000) - (int)frame * 7);
+}
+
+// As the dual RX format in main.cpp: one device channel at a time out of
+// a stereo device, into a planar buffer.
+static bool extractChannel(IAudioDevice::SampleFormat sampleFormat, int deviceChannel)
+{
+    TestAudioDevice device(2);
+    IAudioDevice::AudioDataFormat format;
+    format.sampleFormat = sampleFormat;
+    format.numChannels = 1;
+    format.planar = true;
+    format.channelMap.push_back(deviceChannel);
+    device.setAudioDataFormat(format);
+
+    bool ok = true;
+    size_t numFrames = 0;
+    device.setOnAudioData([&](IAudioDevice&, void* data, size_t size, void*) {
+        for (size_t frame = 0; frame < size; frame++)
+        {
+            float expected = testSample(deviceChannel, frame);
+            float actual = sampleFormat == IAudioDevice::SAMPLE_FORMAT_INT16 ?
+                ((short*)data)[frame] :
+                ((float*)data)[frame] * 32768.0f;
+            if (actual != expected)
+            {
+                std::cerr << "[frame " << frame << " of " << size << ": got " << actual << ", expected " << expected << "]...";
+                ok = false;
+                return;
+            }
+        }
+        numFrames = size;
+    }, nullptr);
+
+    // Every length, so the vector loops end at every possible offset.
+    for (size_t size = 1; ok && size <= TEST_MAX_FRAMES; size++)
+    {
+        GuardedBuffer buffer(size * 2);
+        for (size_t frame = 0; frame < size; frame++)
+        {
+            buffer.get()[frame * 2] = testSample(0, frame);
+            buffer.get()[frame * 2 + 1] = testSample(1, frame);
+        }
+        device.input(buffer.get(), size);
+        ok = ok && numFrames == size;
+    }
+    return ok;
+}
+
+bool extractChannel1Int16()
+{
+    return extractChannel(IAudioDevice::SAMPLE_FORMAT_INT16, 1);
+}
+
+bool extractChannel1Float()
+{
+    return extractChannel(IAudioDevice::SAMPLE_FORMAT_FLOAT32, 1);
+}
+
+bool extractChannel0Float()
+{
+    return extractChannel(IAudioDevice::SAMPLE_FORMAT_FLOAT32, 0);
+}
+
+// int16 -> float on input and float -> int16 on output should give back
+// exactly what went in, full scale included.
+bool floatRoundTrip()
+{
+    const short samples[] = { -32768, -32767, -12345, -1, 0, 1, 12345, 32766, 32767 };
+    const size_t numFrames = sizeof(samples) / sizeof(samples[0]);
+
+    TestAudioDevice device(1);
+    IAudioDevice::AudioDataFormat format;
+    format.sampleFormat = IAudioDevice::SAMPLE_FORMAT_FLOAT32;
+    device.setAudioDataFormat(format);
+
+    std::vector<float> captured;
+    device.setOnAudioData([&](IAudioDevice&, void* data, size_t size, void*) {
+        captured.assign((float*)data, (float*)data + size);
+    }, nullptr);
+    device.input(samples, numFrames);
+
+    device.setOnAudioData([&](IAudioDevice&, void* data, size_t size, void*) {
+        memcpy(data, &captured[0], size * sizeof(float));
+    }, nullptr);
+    short output[numFrames] = {0};
+    device.output(output, numFrames);
+
+    for (size_t frame = 0; frame < numFrames; frame++)
+    {
+        if (output[frame] != samples[frame])
+        {
+            std::cerr << "[" << samples[frame] << " came back as " << output[frame] << "]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Conversions never allocate in the callback, so anything longer than
+// the conversion buffer is dropped and reported instead.
+bool oversizeBufferDropped()
+{
+    TestAudioDevice device(2);
+    IAudioDevice::AudioDataFormat format;
+    format.sampleFormat = IAudioDevice::SAMPLE_FORMAT_FLOAT32;
+    format.numChannels = 1;
+    device.setAudioDataFormat(format);
+
+    int numCallbacks = 0;
+    int numOverflows = 0;
+    int numUnderflows = 0;
+    device.setOnAudioData([&](IAudioDevice&, void*, size_t, void*) { numCallbacks++; }, nullptr);
+    device.setOnAudioOverflow([&](IAudioDevice&, void*) { numOverflows++; }, nullptr);
+    device.setOnAudioUnderflow([&](IAudioDevice&, void*) { numUnderflows++; }, nullptr);
+
+    size_t maxFrames = (size_t)device.getSampleRate() * AUDIO_CONVERSION_MAX_MS / 1000;
+    std::vector<short> buffer(2 * (maxFrames + 1), 1234);
+    device.input(&buffer[0], maxFrames);
+    device.input(&buffer[0], maxFrames + 1);
+    device.output(&buffer[0], maxFrames);
+    std::fill(buffer.begin(), buffer.end(), 0);
+    device.output(&buffer[0], maxFrames + 1);
+
+    if (numCallbacks != 2 || numOverflows != 1 || numUnderflows != 1 || device.getNumOversizeBuffers() != 2)
+    {
+        std::cerr << "[" << numCallbacks << " callbacks, " << numOverflows << " overflows, " << numUnderflows << " underflows]...";
+        return false;
+    }
+
+    // The dropped output is left silent.
+    return std::all_of(buffer.begin(), buffer.end(), [](short sample) { return sample == 0; });
+}
+
+int main()
+{
+    TEST_CASE(extractChannel1Int16);
+    TEST_CASE(extractChannel1Float);
+    TEST_CASE(extractChannel0Float);
+    TEST_CASE(floatRoundTrip);
+    TEST_CASE(oversizeBufferDropped);
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sndfile.h>
+#include "FileAudioEngine.h"
+#include "IAudioDevice.h"
+#include "../pipeline/test/PipelineTestCommon.h"
+
+#define TEST_SAMPLE_RATE 8000
+#define TEST_FILE_MS 500
+#define TEST_FILE_FRAMES (TEST_SAMPLE_RATE * TEST_FILE_MS / 1000)
+
+// Not a multiple of 100 Hz, so each tick is a fractional number of frames.
+#define TEST_OUTPUT_SAMPLE_RATE 11025
+
+static std::string testPath(const char* name)
+{
+    const char* tmpDir = getenv("TMPDIR");
+    return std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/" + name;
+}
+
+// Never zero, so the file can be told apart from the silence after it.
+static short fileSample(int n)
+{
+    return (short)(n % 1000 + 1);
+}
+
+static std::string writeTestFile()
+{
+    std::string path = testPath("FileAudioEngineTest.wav");
+
+    SF_INFO sfInfo;
+    memset(&sfInfo, 0, sizeof(sfInfo));
+    sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    sfInfo.samplerate = TEST_SAMPLE_RATE;
+    sfInfo.channels = 1;
+    SNDFILE* file = sf_open(path.c_str(), SFM_WRITE, &sfInfo);
+    assert(file != nullptr);
+
+    std::vector<short> samples(TEST_FILE_FRAMES);
+    for (int n = 0; n < TEST_FILE_FRAMES; n++)
+    {
+        samples[n] = fileSample(n);
+    }
+    sf_writef_short(file, &samples[0], TEST_FILE_FRAMES);
+    sf_close(file);
+    return path;
+}
+
+// Checks that what came out of an input device was the test file followed
+// by silence.
+static bool checkInputSamples(const std::vector<short>& samples)
+{
+    if (samples.size() < TEST_FILE_FRAMES)
+    {
+        std::cerr << "[only " << samples.size() << " samples]...";
+        return false;
+    }
+    for (size_t n = 0; n < samples.size(); n++)
+    {
+        short expected = n < TEST_FILE_FRAMES ? fileSample(n) : 0;
+        if (samples[n] != expected)
+        {
+            std::cerr << "[sample " << n << " is " << samples[n] << ", expected " << expected << "]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Waits up to timeoutMs of wall clock time for flag to be set.
+static bool waitFor(std::atomic<bool>& flag, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!flag && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return flag;
+}
+
+bool fileEngineVirtualEndOfInput()
+{
+    std::string path = writeTestFile();
+    FileAudioEngine engine(FileAudioEngine::PACE_VIRTUAL);
+
+    std::atomic<bool> ended(false);
+    std::atomic<int64_t> endedMs(0);
+    engine.setOnEndOfInput([&]() {
+        endedMs = engine.getElapsedMs();
+        ended = true;
+    });
+
+    auto device = engine.getAudioDevice(wxString::FromUTF8(path.c_str()), IAudioEngine::AUDIO_ENGINE_IN, 0, 1);
+    if (!device || device->getSampleRate() != TEST_SAMPLE_RATE || device->getNumChannels() != 1)
+    {
+        std::cerr << "[could not open " << path << "]...";
+        return false;
+    }
+
+    // Only read here once the device has stopped.
+    std::vector<short> samples;
+    device->setOnAudioData([&](IAudioDevice&, void* data, size_t size, void*) {
+        short* audio = (short*)data;
+        samples.insert(samples.end(), audio, audio + size);
+    }, nullptr);
+
+    // Started before the clock so the file lines up with time zero.
+    auto startTime = std::chrono::steady_clock::now();
+    device->start();
+    engine.start();
+    bool gotEnd = waitFor(ended, 10000);
+    auto wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    if (!gotEnd)
+    {
+        std::cerr << "[no end of input after " << engine.getElapsedMs() << " ms]...";
+        return false;
+    }
+
+    // The file ends on the tick after its last sample, then the tail plays.
+    int64_t expectedMs = TEST_FILE_MS + FILE_AUDIO_PERIOD_MS + FILE_AUDIO_END_TAIL_MS;
+    if (endedMs != expectedMs)
+    {
+        std::cerr << "[ended after " << endedMs << " ms, expected " << expectedMs << "]...";
+        return false;
+    }
+    if (wallMs >= expectedMs)
+    {
+        std::cerr << "[took " << wallMs << " ms, no faster than real time]...";
+        return false;
+    }
+
+    // The clock should now have stopped rather than spinning on silence.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (engine.getElapsedMs() != endedMs || !engine.isEndOfInput())
+    {
+        std::cerr << "[clock ran on to " << engine.getElapsedMs() << " ms]...";
+        return false;
+    }
+
+    device->stop();
+    if ((int64_t)samples.size() != endedMs * TEST_SAMPLE_RATE / 1000 || !checkInputSamples(samples))
+    {
+        std::cerr << "[" << samples.size() << " samples in " << endedMs << " ms]...";
+        return false;
+    }
+
+    // Starting another device gets it going again.
+    auto nullDevice = engine.getAudioDevice(FILE_AUDIO_NULL_DEVICE, IAudioEngine::AUDIO_ENGINE_IN, TEST_SAMPLE_RATE, 1);
+    nullDevice->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool restarted = engine.getElapsedMs() > endedMs && !engine.isEndOfInput();
+    nullDevice->stop();
+
+    engine.stop();
+    remove(path.c_str());
+    return restarted;
+}
+
+bool fileEngineVirtualOutputLength()
+{
+    std::string inputPath = writeTestFile();
+    std::string outputPath = testPath("FileAudioEngineTest-out.wav");
+    FileAudioEngine engine(FileAudioEngine::PACE_VIRTUAL);
+
+    std::atomic<bool> ended(false);
+    engine.setOnEndOfInput([&]() { ended = true; });
+
+    auto input = engine.getAudioDevice(wxString::FromUTF8(inputPath.c_str()), IAudioEngine::AUDIO_ENGINE_IN, 0, 1);
+    auto output = engine.getAudioDevice(wxString::FromUTF8(outputPath.c_str()), IAudioEngine::AUDIO_ENGINE_OUT, TEST_OUTPUT_SAMPLE_RATE, 1);
+    if (!input || !output)
+    {
+        std::cerr << "[could not open devices]...";
+        return false;
+    }
+    output->setOnAudioData([&](IAudioDevice&, void* data, size_t size, void*) {
+        short* audio = (short*)data;
+        std::fill(audio, audio + size, 1234);
+    }, nullptr);
+
+    output->start();
+    input->start();
+    engine.start();
+    bool gotEnd = waitFor(ended, 10000);
+    int64_t elapsedMs = engine.getElapsedMs();
+    input->stop();
+    output->stop();
+    engine.stop();
+    output.reset();
+    input.reset();
+    if (!gotEnd)
+    {
+        std::cerr << "[no end of input]...";
+        return false;
+    }
+
+    SF_INFO sfInfo;
+    memset(&sfInfo, 0, sizeof(sfInfo));
+    SNDFILE* file = sf_open(outputPath.c_str(), SFM_READ, &sfInfo);
+    if (file == nullptr)
+    {
+        std::cerr << "[could not read back " << outputPath << "]...";
+        return false;
+    }
+    std::vector<short> samples(sfInfo.frames);
+    sf_readf_short(file, &samples[0], sfInfo.frames);
+    sf_close(file);
+    remove(outputPath.c_str());
+    remove(inputPath.c_str());
+
+    int64_t expectedFrames = elapsedMs * TEST_OUTPUT_SAMPLE_RATE / 1000;
+    if (sfInfo.samplerate != TEST_OUTPUT_SAMPLE_RATE || sfInfo.frames != expectedFrames)
+    {
+        std::cerr << "[" << sfInfo.frames << " frames at " << sfInfo.samplerate << " Hz, expected " << expectedFrames << "]...";
+        return false;
+    }
+    return std::all_of(samples.begin(), samples.end(), [](short sample) { return sample == 1234; });
+}
+
+bool fileEngineRealtimePacing()
+{
+    std::string path = writeTestFile();
+    FileAudioEngine engine(FileAudioEngine::PACE_REALTIME);
+
+    auto device = engine.getAudioDevice(wxString::FromUTF8(path.c_str()), IAudioEngine::AUDIO_ENGINE_IN, 0, 1);
+    if (!device)
+    {
+        std::cerr << "[could not open " << path << "]...";
+        return false;
+    }
+
+    // Only read here once the device has stopped.
+    std::vector<short> samples;
+    std::vector<int64_t> timesUs;
+    device->setOnAudioData([&](IAudioDevice&, void* data, size_t size, void*) {
+        short* audio = (short*)data;
+        samples.insert(samples.end(), audio, audio + size);
+        timesUs.push_back(IAudioDevice::GetTimeUs());
+    }, nullptr);
+
+    // Twice the length of the file, to see it end without the clock
+    // getting any faster.
+    auto startTime = std::chrono::steady_clock::now();
+    device->start();
+    engine.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * TEST_FILE_MS));
+    device->stop();
+    auto wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    engine.stop();
+    remove(path.c_str());
+
+    if (!checkInputSamples(samples))
+    {
+        return false;
+    }
+
+    // Allow for scheduling on a busy machine.
+    int64_t expectedSamples = wallMs * TEST_SAMPLE_RATE / 1000;
+    if ((int64_t)samples.size() < expectedSamples * 8 / 10 || (int64_t)samples.size() > expectedSamples * 12 / 10)
+    {
+        std::cerr << "[" << samples.size() << " samples in " << wallMs << " ms]...";
+        return false;
+    }
+
+    std::vector<int64_t> intervalsUs;
+    for (size_t index = 1; index < timesUs.size(); index++)
+    {
+        intervalsUs.push_back(timesUs[index] - timesUs[index - 1]);
+    }
+    std::sort(intervalsUs.begin(), intervalsUs.end());
+    int64_t medianUs = intervalsUs[intervalsUs.size() / 2];
+    int64_t periodUs = 1000 * FILE_AUDIO_PERIOD_MS;
+    if (medianUs < periodUs * 3 / 4 || medianUs > periodUs * 5 / 4)
+    {
+        std::cerr << "[median interval " << medianUs << " us, expected " << periodUs << "]...";
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    TEST_CASE(fileEngineVirtualEndOfInput);
+    TEST_CASE(fileEngineVirtualOutputLength);
+    TEST_CASE(fileEngineRealtimePacing);
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <jack/jack.h>
+#include "JackAudioEngine.h"
+#include "IAudioDevice.h"
+#include "../pipeline/test/PipelineTestCommon.h"
+
+// ctest's SKIP_RETURN_CODE for this test, used when jackd isn't installed.
+#define TEST_SKIPPED 77
+
+#define TEST_SERVER_NAME "freedv-test"
+#define TEST_SAMPLE_RATE 48000
+#define TEST_SERVER_PERIOD 1024
+#define TEST_PERIOD 256
+#define TEST_RUN_SECS 2
+
+static pid_t jackdPid = -1;
+
+// Starts a private jackd on the dummy backend (no hardware needed) and
+// waits until a client can connect. Returns false if jackd couldn't be
+// run at all.
+static bool startJackd()
+{
+    // Our clients (and the engine's) connect to this server only.
+    setenv("JACK_DEFAULT_SERVER", TEST_SERVER_NAME, 1);
+
+    std::string rate = std::to_string(TEST_SAMPLE_RATE);
+    std::string period = std::to_string(TEST_SERVER_PERIOD);
+    jackdPid = fork();
+    if (jackdPid == 0)
+    {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+        execlp("jackd", "jackd", "-n", TEST_SERVER_NAME, "-d", "dummy",
+            "-r", rate.c_str(), "-p", period.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (jackdPid > 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        int status;
+        if (waitpid(jackdPid, &status, WNOHANG) == jackdPid)
+        {
+            // Not installed (or couldn't start at all).
+            jackdPid = -1;
+            return false;
+        }
+
+        jack_status_t jackStatus;
+        jack_client_t* client = jack_client_open("FreeDV test probe", JackNoStartServer, &jackStatus);
+        if (client != nullptr)
+        {
+            jack_client_close(client);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+static void stopJackd()
+{
+    if (jackdPid > 0)
+    {
+        kill(jackdPid, SIGTERM);
+        waitpid(jackdPid, nullptr, 0);
+        jackdPid = -1;
+    }
+}
+
+// Runs a device for a while and checks that every callback was for the
+// period the engine asked for and that they came at that rate.
+static bool checkCallbacks(JackAudioEngine& engine, IAudioEngine::AudioDirection direction)
+{
+    auto spec = engine.getDefaultAudioDevice(direction);
+    auto device = spec.isValid() ? engine.getAudioDevice(spec.name, direction, TEST_SAMPLE_RATE, 2) : nullptr;
+    if (!device)
+    {
+        std::cerr << "[no dummy device]...";
+        return false;
+    }
+
+    // Only read by this thread once the device has stopped.
+    std::vector<size_t> sizes;
+    std::vector<int64_t> timesUs;
+    sizes.reserve(10 * TEST_RUN_SECS * TEST_SAMPLE_RATE / TEST_PERIOD);
+    timesUs.reserve(sizes.capacity());
+    device->setOnAudioData([&](IAudioDevice&, void*, size_t size, void*) {
+        if (sizes.size() < sizes.capacity())
+        {
+            sizes.push_back(size);
+            timesUs.push_back(IAudioDevice::GetTimeUs());
+        }
+    }, nullptr);
+
+    device->start();
+    std::this_thread::sleep_for(std::chrono::seconds(TEST_RUN_SECS));
+    device->stop();
+
+    for (auto size : sizes)
+    {
+        if (size != TEST_PERIOD)
+        {
+            std::cerr << "[callback for " << size << " frames]...";
+            return false;
+        }
+    }
+
+    // The dummy backend sleeps between periods, so allow for scheduling.
+    int expected = TEST_RUN_SECS * TEST_SAMPLE_RATE / TEST_PERIOD;
+    if ((int)sizes.size() < expected * 8 / 10 || (int)sizes.size() > expected * 12 / 10)
+    {
+        std::cerr << "[" << sizes.size() << " callbacks, expected about " << expected << "]...";
+        return false;
+    }
+
+    std::vector<int64_t> intervalsUs;
+    for (size_t index = 1; index < timesUs.size(); index++)
+    {
+        intervalsUs.push_back(timesUs[index] - timesUs[index - 1]);
+    }
+    std::sort(intervalsUs.begin(), intervalsUs.end());
+    int64_t medianUs = intervalsUs[intervalsUs.size() / 2];
+    int64_t periodUs = 1000000LL * TEST_PERIOD / TEST_SAMPLE_RATE;
+    if (medianUs < periodUs * 3 / 4 || medianUs > periodUs * 5 / 4)
+    {
+        std::cerr << "[median interval " << medianUs << " us, expected " << periodUs << "]...";
+        return false;
+    }
+    return true;
+}
+
+static JackAudioEngine* engine = nullptr;
+
+bool jackPeriodFromSettings()
+{
+    jack_status_t status;
+    jack_client_t* client = jack_client_open("FreeDV test probe", JackNoStartServer, &status);
+    int period = client != nullptr ? (int)jack_get_buffer_size(client) : 0;
+    if (client != nullptr)
+    {
+        jack_client_close(client);
+    }
+    return period == TEST_PERIOD;
+}
+
+bool jackInputCallbacks()
+{
+    return checkCallbacks(*engine, IAudioEngine::AUDIO_ENGINE_IN);
+}
+
+bool jackOutputCallbacks()
+{
+    return checkCallbacks(*engine, IAudioEngine::AUDIO_ENGINE_OUT);
+}
+
+int main()
+{
+    if (!startJackd())
+    {
+        std::cout << "jackd not available, skipping" << std::endl;
+        stopJackd();
+        return TEST_SKIPPED;
+    }
+
+    // The server starts with a different period, so the engine has to
+    // change it.
+    engine = new JackAudioEngine();
+    engine->setPeriodFrames(TEST_PERIOD);
+    engine->start();
+
+    // Failures exit() from TEST_CASE, so make sure jackd goes with us.
+    atexit(stopJackd);
+
+    TEST_CASE(jackPeriodFromSettings);
+    TEST_CASE(jackInputCallbacks);
+    TEST_CASE(jackOutputCallbacks);
+
+    engine->stop();
+    delete engine;
+    return 0;
+}
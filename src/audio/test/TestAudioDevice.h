@@ -0,0 +1,28 @@
+#ifndef TEST_AUDIO_DEVICE_H
+#define TEST_AUDIO_DEVICE_H
+
+#include "../IAudioDevice.h"
+
+// Calls processInputData_/processOutputData_ as a real device's callback
+// would.
+class TestAudioDevice : public IAudioDevice
+{
+public:
+    TestAudioDevice(int numChannels) : numChannels_(numChannels) {}
+    virtual ~TestAudioDevice() = default;
+
+    virtual int getNumChannels() override { return numChannels_; }
+    virtual int getSampleRate() const override { return 48000; }
+
+    virtual void start() override {}
+    virtual void stop() override {}
+    virtual bool isRunning() override { return true; }
+
+    void input(const short* inputData, size_t numFrames) { processInputData_(inputData, numFrames); }
+    void output(short* outputData, size_t numFrames) { processOutputData_(outputData, numFrames); }
+
+private:
+    int numChannels_;
+};
+
+#endif // TEST_AUDIO_DEVICE_H
@@ -0,0 +1,258 @@
+/*
+   codecframelog.cpp
+
+   Codec frame log: while FreeDV is running, optionally logs what's
+   received as modem frame payloads plus sync/SNR (see codecFrameLogEnable)
+   instead of audio, so whole days can be archived. Tools > Replay Codec
+   Frame Log turns a log back into speech.
+*/
+
+#include <map>
+#include <vector>
+
+#include "main.h"
+#include "pipeline/CodecFrameLogger.h"
+
+// Longest silence put between overs on replay, however far apart they
+// were on the air.
+#define REPLAY_MAX_GAP_MS 1000
+
+// Fed by the RX pipeline (CodecFrameLogStep). Only replaced while the RX
+// thread isn't running, and under g_mutexProtectingCallbackData.
+CodecFrameLogger*   g_codecFrameLogger = nullptr;
+
+extern FreeDVInterface freedvInterface;
+extern wxMutex      g_mutexProtectingCallbackData;
+
+// Re-synthesizes the speech in the log at logPath, writing it to wavPath.
+// Codec 2 modes only; frames in other modes (e.g. 2020, which needs
+// LPCNet) are counted and skipped. Returns a summary for the status bar.
+static wxString ReplayCodecFrameLog(wxString logPath, wxString wavPath, std::atomic<bool>* cancel)
+{
+    CodecFrameLogReader reader;
+    std::string error;
+    if (!reader.open(logPath.ToStdString(), &error))
+    {
+        return wxString::Format(wxT("Couldn't read %s: %s"), logPath, wxString(error));
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // One decoder per mode, made as each is first seen. nullptr for modes
+    // that can't be replayed.
+    std::map<int, struct freedv*> decoders;
+    SNDFILE* file = nullptr;
+    SF_INFO sfInfo;
+    sfInfo.samplerate = 0;
+
+    size_t numFrames = 0;
+    size_t numSkipped = 0;
+    size_t numOvers = 0;
+    sf_count_t numSamplesOut = 0;
+    uint32_t outputEndMs = 0;
+    bool inOver = false;
+
+    CodecFrameLogRecord record;
+    while (!*cancel && reader.read(&record))
+    {
+        if (record.payload.size() == 0 || !record.sync)
+        {
+            // Sync lost (or a frame from a trial sync, which is as likely
+            // to be noise).
+            inOver = false;
+            continue;
+        }
+
+        if (decoders.find(record.mode) == decoders.end())
+        {
+            struct freedv* dv = freedv_open(record.mode);
+            if (dv != nullptr && freedv_get_codec2(dv) == nullptr)
+            {
+                freedv_close(dv);
+                dv = nullptr;
+            }
+            decoders[record.mode] = dv;
+        }
+
+        struct freedv* dv = decoders[record.mode];
+        int bitsPerModemFrame = dv != nullptr ? freedv_get_bits_per_modem_frame(dv) : 0;
+        if (dv == nullptr ||
+            record.payload.size() != (size_t)(bitsPerModemFrame + 7) / 8 ||
+            (file != nullptr && freedv_get_speech_sample_rate(dv) != sfInfo.samplerate))
+        {
+            numSkipped++;
+            continue;
+        }
+
+        if (file == nullptr)
+        {
+            sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+            sfInfo.channels = 1;
+            sfInfo.samplerate = freedv_get_speech_sample_rate(dv);
+            file = sf_open(wavPath.ToStdString().c_str(), SFM_WRITE, &sfInfo);
+            if (file == nullptr)
+            {
+                error = sf_strerror(nullptr);
+                break;
+            }
+        }
+
+        struct CODEC2* c2 = freedv_get_codec2(dv);
+        int numCodecFrames = bitsPerModemFrame / freedv_get_bits_per_codec_frame(dv);
+        int bytesPerCodecFrame = codec2_bytes_per_frame(c2);
+        int samplesPerCodecFrame = codec2_samples_per_frame(c2);
+
+        // A short silence where there was a gap on the air.
+        uint32_t frameMs = (uint32_t)(1000LL * numCodecFrames * samplesPerCodecFrame / sfInfo.samplerate);
+        uint32_t frameStartMs = record.timeMs > frameMs ? record.timeMs - frameMs : 0;
+        if (numSamplesOut > 0 && frameStartMs > outputEndMs)
+        {
+            uint32_t gapMs = std::min(frameStartMs - outputEndMs, (uint32_t)REPLAY_MAX_GAP_MS);
+            std::vector<short> silence((size_t)sfInfo.samplerate * gapMs / 1000, 0);
+            if (silence.size() > 0)
+            {
+                numSamplesOut += sf_write_short(file, &silence[0], silence.size());
+            }
+        }
+        outputEndMs = record.timeMs;
+
+        std::vector<unsigned char> codecFrames(numCodecFrames * bytesPerCodecFrame);
+        std::vector<short> speech(samplesPerCodecFrame);
+        freedv_codec_frames_from_rawdata(dv, &codecFrames[0], &record.payload[0]);
+        for (int index = 0; index < numCodecFrames; index++)
+        {
+            codec2_decode(c2, &speech[0], &codecFrames[index * bytesPerCodecFrame]);
+            numSamplesOut += sf_write_short(file, &speech[0], samplesPerCodecFrame);
+        }
+
+        numFrames++;
+        if (!inOver)
+        {
+            numOvers++;
+            inOver = true;
+        }
+    }
+
+    double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (file != nullptr)
+    {
+        sf_close(file);
+    }
+    for (auto& decoder : decoders)
+    {
+        if (decoder.second != nullptr)
+        {
+            freedv_close(decoder.second);
+        }
+    }
+
+    if (error != "")
+    {
+        return wxString::Format(wxT("Couldn't replay to %s: %s"), wavPath, wxString(error));
+    }
+    if (numFrames == 0)
+    {
+        return wxString::Format(wxT("Nothing in %s could be replayed (%u frames in modes without Codec 2)"),
+            logPath, (unsigned)numSkipped);
+    }
+    return wxString::Format(
+        wxT("Replayed %u overs (%.0f s) from %s to %s in %.1f s, %u frames skipped"),
+        (unsigned)numOvers, (double)numSamplesOut / sfInfo.samplerate, logPath, wavPath, elapsedSec,
+        (unsigned)numSkipped);
+}
+
+//-------------------------------------------------------------------------
+// startCodecFrameLog_(): before the RX thread is started
+//-------------------------------------------------------------------------
+void MainFrame::startCodecFrameLog_(int sampleRate)
+{
+    if (!wxGetApp().appConfiguration.codecFrameLogEnable)
+    {
+        return;
+    }
+
+    auto currentTime = wxDateTime::Now().Format(_("%Y%m%d-%H%M%S"));
+    wxFileName filePath(wxGetApp().appConfiguration.quickRecordPath, wxString::Format(_("FreeDV_Frames_%s.fdvlog"), currentTime));
+
+    // The same modes as the main receiver.
+    CodecFrameLogger* logger = new CodecFrameLogger(
+        filePath.GetFullPath().ToStdString(), sampleRate, freedvInterface.getRxModes());
+    if (!logger->open())
+    {
+        // Not worth stopping FreeDV for.
+        wxString error = wxString::Format(wxT("Couldn't create codec frame log %s: %s"),
+            filePath.GetFullPath(), wxString(logger->getError()));
+        CallAfter([this, error]() { SetStatusText(error, 0); });
+        delete logger;
+        return;
+    }
+
+    g_mutexProtectingCallbackData.Lock();
+    g_codecFrameLogger = logger;
+    g_mutexProtectingCallbackData.Unlock();
+}
+
+//-------------------------------------------------------------------------
+// stopCodecFrameLog_(): after the RX thread has stopped
+//-------------------------------------------------------------------------
+void MainFrame::stopCodecFrameLog_()
+{
+    g_mutexProtectingCallbackData.Lock();
+    CodecFrameLogger* logger = g_codecFrameLogger;
+    g_codecFrameLogger = nullptr;
+    g_mutexProtectingCallbackData.Unlock();
+
+    if (logger != nullptr)
+    {
+        // Not under the lock, as this finishes demodulating what's queued.
+        logger->close();
+        fprintf(stderr, "Codec frame log closed: %llu frames, %llu bytes, %llu samples dropped\n",
+            (unsigned long long)logger->getNumFramesWritten(), (unsigned long long)logger->getNumBytesWritten(),
+            (unsigned long long)logger->getNumSamplesDropped());
+        delete logger;
+    }
+}
+
+//-------------------------------------------------------------------------
+// OnReplayCodecFrameLog()
+//-------------------------------------------------------------------------
+void MainFrame::OnReplayCodecFrameLog(wxCommandEvent& event)
+{
+    wxUnusedVar(event);
+
+    if (m_flightRecorderBusy)
+    {
+        wxMessageBox(wxT("Still saving the last request, please try again shortly."), wxT("Replay Codec Frame Log"), wxOK);
+        return;
+    }
+
+    wxFileDialog openFileDialog(
+        this,
+        wxT("Replay Codec Frame Log"),
+        wxGetApp().appConfiguration.quickRecordPath,
+        wxEmptyString,
+        wxT("Codec frame logs (*.fdvlog)|*.fdvlog|")
+        wxT("All files (*.*)|*.*"),
+        wxFD_OPEN | wxFD_FILE_MUST_EXIST
+        );
+    if (openFileDialog.ShowModal() == wxID_CANCEL)
+    {
+        return;
+    }
+
+    // Alongside the log, e.g. FreeDV_Frames_20240101-000000.wav.
+    wxString logPath = openFileDialog.GetPath();
+    wxFileName filePath(logPath);
+    filePath.SetExt(wxT("wav"));
+    wxString wavPath = filePath.GetFullPath();
+
+    SetStatusText(wxString::Format(wxT("Replaying %s to %s"), logPath, wavPath), 0);
+
+    // Shares the flight recorder's thread, as it's the same sort of job.
+    runFlightRecorderTask_([this, logPath, wavPath]()
+    {
+        wxString status = ReplayCodecFrameLog(logPath, wavPath, &m_flightRecorderCancel);
+        CallAfter([this, status]() { SetStatusText(status, 0); });
+    });
+}
@@ -69,6 +69,14 @@ const char* AudioConfiguration::AudioDeviceConfigName<2, AudioConfiguration::DIR
     return "/Audio/soundCard2OutSampleRate";
 }
 
+AudioConfiguration::AudioConfiguration()
+    : jackPeriodFrames("/Audio/JackPeriodFrames", 0)
+    , driftCorrectionEnable("/Audio/DriftCorrection", true)
+    , driftCorrectionTargetMs("/Audio/DriftCorrectionTargetMs", 60)
+{
+    // empty
+}
+
 void AudioConfiguration::load(wxConfigBase* config)
 {
     // Migration -- grab old sample rates from older FreeDV configuration
@@ -83,6 +91,10 @@ void AudioConfiguration::load(wxConfigBase* config)
     soundCard1Out.load(config);
     soundCard2In.load(config);
     soundCard2Out.load(config);
+
+    load_(config, jackPeriodFrames);
+    load_(config, driftCorrectionEnable);
+    load_(config, driftCorrectionTargetMs);
 }
 
 void AudioConfiguration::save(wxConfigBase* config)
@@ -91,4 +103,8 @@ void AudioConfiguration::save(wxConfigBase* config)
     soundCard1Out.save(config);
     soundCard2In.save(config);
     soundCard2Out.save(config);
+
+    save_(config, jackPeriodFrames);
+    save_(config, driftCorrectionEnable);
+    save_(config, driftCorrectionTargetMs);
 }
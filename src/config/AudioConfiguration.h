@@ -52,13 +52,23 @@ public:
         virtual void save(wxConfigBase* config) override;
     };
     
-    AudioConfiguration() = default;
+    AudioConfiguration();
     virtual ~AudioConfiguration() = default;
     
     SoundDevice<1, Direction::DIR_IN> soundCard1In;
     SoundDevice<1, Direction::DIR_OUT> soundCard1Out;
     SoundDevice<2, Direction::DIR_IN> soundCard2In;
     SoundDevice<2, Direction::DIR_OUT> soundCard2Out;
+
+    // JACK engine only: frames per period to request from the server
+    // (0 = use the server's setting).
+    ConfigurationDataElement<int> jackPeriodFrames;
+
+    // Two sound card setups only: resample to compensate for the clock
+    // drift between the cards, holding the FIFOs to the headset at
+    // driftCorrectionTargetMs of audio.
+    ConfigurationDataElement<bool> driftCorrectionEnable;
+    ConfigurationDataElement<int> driftCorrectionTargetMs;
     
     virtual void load(wxConfigBase* config) override;
     virtual void save(wxConfigBase* config) override;
@@ -81,8 +81,14 @@ FreeDVConfiguration::FreeDVConfiguration()
     , halfDuplexMode("/Rig/HalfDuplex", true)
     , multipleReceiveEnabled("/Rig/MultipleRx", true)
     , multipleReceiveOnSingleThread("/Rig/SingleRxThread", true)
+    , dualReceiverEnabled("/Rig/DualRx", false)
         
     , quickRecordPath("/QuickRecord/SavePath", _(""))
+    , recordingRotateMinutes("/QuickRecord/RotateMinutes", 0)
+    , recordingRotateMegabytes("/QuickRecord/RotateMegabytes", 0)
+    , flightRecorderMinutes("/QuickRecord/FlightRecorderMinutes", 5)
+    , recordingFormat("/QuickRecord/Format", 0)
+    , codecFrameLogEnable("/QuickRecord/CodecFrameLog", false)
         
     , freedv700Clip("/FreeDV700/txClip", true)
     , freedv700TxBPF("/FreeDV700/txBPF", true)
@@ -102,6 +108,13 @@ FreeDVConfiguration::FreeDVConfiguration()
     , currentFreeDVMode("/Audio/mode", 4)
         
     , currentSpectrumAveraging("/Plot/Spectrum/CurrentAveraging", 0)
+    , currentSpectrumFftSize("/Plot/Spectrum/FftSize", 1024)
+    , waterfallHistoryHours("/Plot/Waterfall/HistoryHours", 4)
+    , waterfallHistoryFile("/Plot/Waterfall/HistoryFile", _(""))
+    , spectrumExportPath("/Plot/Export/Path", _(""))
+    , spectrumExportFormats("/Plot/Export/Formats", 1)
+    , spectrumExportIntervalMs("/Plot/Export/IntervalMs", 1000)
+    , plotSoftwareRendering("/Plot/SoftwareRendering", false)
     
     , experimentalFeatures("/ExperimentalFeatures", false)
     , tabLayout("/MainFrame/TabLayout", _(""))
@@ -207,6 +220,7 @@ void FreeDVConfiguration::load(wxConfigBase* config)
     load_(config, halfDuplexMode);
     load_(config, multipleReceiveEnabled);
     load_(config, multipleReceiveOnSingleThread);
+    load_(config, dualReceiverEnabled);
     
     load_(config, freedv700Clip);
     load_(config, freedv700TxBPF);
@@ -226,6 +240,13 @@ void FreeDVConfiguration::load(wxConfigBase* config)
     load_(config, currentFreeDVMode);
     
     load_(config, currentSpectrumAveraging);
+    load_(config, currentSpectrumFftSize);
+    load_(config, waterfallHistoryHours);
+    load_(config, waterfallHistoryFile);
+    load_(config, spectrumExportPath);
+    load_(config, spectrumExportFormats);
+    load_(config, spectrumExportIntervalMs);
+    load_(config, plotSoftwareRendering);
     
     load_(config, monitorVoiceKeyerAudio);
     load_(config, monitorTxAudio);
@@ -234,6 +255,11 @@ void FreeDVConfiguration::load(wxConfigBase* config)
     
     quickRecordPath.setDefaultVal(documentsDir);
     load_(config, quickRecordPath);
+    load_(config, recordingRotateMinutes);
+    load_(config, recordingRotateMegabytes);
+    load_(config, flightRecorderMinutes);
+    load_(config, recordingFormat);
+    load_(config, codecFrameLogEnable);
     
     load_(config, experimentalFeatures);
     load_(config, tabLayout);
@@ -296,8 +322,14 @@ void FreeDVConfiguration::save(wxConfigBase* config)
     save_(config, halfDuplexMode);
     save_(config, multipleReceiveEnabled);
     save_(config, multipleReceiveOnSingleThread);
+    save_(config, dualReceiverEnabled);
     
     save_(config, quickRecordPath);
+    save_(config, recordingRotateMinutes);
+    save_(config, recordingRotateMegabytes);
+    save_(config, flightRecorderMinutes);
+    save_(config, recordingFormat);
+    save_(config, codecFrameLogEnable);
     
     save_(config, freedv700Clip);
     save_(config, freedv700TxBPF);
@@ -317,6 +349,13 @@ void FreeDVConfiguration::save(wxConfigBase* config)
     save_(config, currentFreeDVMode);
     
     save_(config, currentSpectrumAveraging);
+    save_(config, currentSpectrumFftSize);
+    save_(config, waterfallHistoryHours);
+    save_(config, waterfallHistoryFile);
+    save_(config, spectrumExportPath);
+    save_(config, spectrumExportFormats);
+    save_(config, spectrumExportIntervalMs);
+    save_(config, plotSoftwareRendering);
     
     save_(config, experimentalFeatures);
     save_(config, tabLayout);
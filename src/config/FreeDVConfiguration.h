@@ -92,8 +92,14 @@ public:
     ConfigurationDataElement<bool> halfDuplexMode;
     ConfigurationDataElement<bool> multipleReceiveEnabled;
     ConfigurationDataElement<bool> multipleReceiveOnSingleThread;
+    ConfigurationDataElement<bool> dualReceiverEnabled;
     
     ConfigurationDataElement<wxString> quickRecordPath;
+    ConfigurationDataElement<int> recordingRotateMinutes;
+    ConfigurationDataElement<int> recordingRotateMegabytes;
+    ConfigurationDataElement<int> flightRecorderMinutes;
+    ConfigurationDataElement<int> recordingFormat; // 0 = WAV, 1 = FLAC, 2 = Opus
+    ConfigurationDataElement<bool> codecFrameLogEnable;
     
     ConfigurationDataElement<bool> freedv700Clip;
     ConfigurationDataElement<bool> freedv700TxBPF;
@@ -113,6 +119,19 @@ public:
     ConfigurationDataElement<int> currentFreeDVMode;
     
     ConfigurationDataElement<int> currentSpectrumAveraging;
+    ConfigurationDataElement<int> currentSpectrumFftSize;
+    ConfigurationDataElement<int> waterfallHistoryHours;
+    ConfigurationDataElement<wxString> waterfallHistoryFile;
+    
+    // Unattended spectrum/waterfall export (disabled if path is empty).
+    // Formats is a bitmask of SPECTRUM_EXPORT_PNG and SPECTRUM_EXPORT_RAW.
+    ConfigurationDataElement<wxString> spectrumExportPath;
+    ConfigurationDataElement<int> spectrumExportFormats;
+    ConfigurationDataElement<int> spectrumExportIntervalMs;
+    
+    // Draw the scalar and spectrum plots with PlotRaster instead of
+    // wxGraphicsContext paths.
+    ConfigurationDataElement<bool> plotSoftwareRendering;
     
     ConfigurationDataElement<bool> experimentalFeatures;
     ConfigurationDataElement<wxString> tabLayout;
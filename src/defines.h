@@ -37,6 +37,8 @@
 #define STEP_MINOR_F_HZ     100     // minor (ticks) freq step on Waterfall and Spectrum graticule
 #define WATERFALL_SECS_Y    30      // number of seconds represented by y axis of waterfall
 #define WATERFALL_SECS_STEP 5       // graticule y axis steps of waterfall
+#define WATERFALL_HISTORY_BINS     512 // width of waterfall scrollback rows (0 ... MAX_F_HZ)
+#define WATERFALL_HISTORY_ROW_SECS 1   // seconds peak-held into each waterfall scrollback row
 #define DT                  0.10    // time between real time graphing updates
 #define FS                  8000    // FDMDV modem sample rate
 
@@ -53,6 +55,7 @@
 #define WAVEFORM_PLOT_FS    400                            // sample rate (points/s) of waveform plotted to screen
 #define WAVEFORM_PLOT_TIME  5                              // length or entire waveform on screen
 #define WAVEFORM_PLOT_BUF   ((int)(DT*WAVEFORM_PLOT_FS))   // number of new samples we plot per DT
+#define WAVEFORM_PLOT_HISTORY 60                           // seconds of waveform kept for zooming out
 
 // sample rate I/O & conversion constants
 
@@ -0,0 +1,290 @@
+/*
+   flightrecorder.cpp
+
+   Flight recorder: keeps the last few minutes of radio audio in memory
+   (see flightRecorderMinutes) so a transmission can be saved or decoded
+   after it's been missed.
+*/
+
+#include <cstring>
+
+#include "main.h"
+#include "pipeline/IPipelineStep.h"
+
+// Fed by the RX pipeline (FlightRecorderStep). Only replaced while the
+// RX thread isn't running, and under g_mutexProtectingCallbackData so
+// the UI can take recordings at any time.
+FlightRecorder*     g_flightRecorder = nullptr;
+
+extern FreeDVInterface freedvInterface;
+extern wxMutex      g_mutexProtectingCallbackData;
+extern int          g_mode;
+extern int          g_freedv_verbose;
+extern int          g_SquelchActive;
+extern float        g_SquelchLevel;
+
+// Runs recording through its own set of demodulators as fast as it'll
+// go, writing the decoded audio to path. configureFn starts decoder
+// with the same settings as the main receiver. Returns a summary for
+// the status bar.
+static wxString DecodeFlightRecording(
+    std::shared_ptr<FlightRecording> recording, std::function<void(FreeDVInterface&)> configureFn,
+    wxString path, std::atomic<bool>* cancel)
+{
+    FreeDVInterface decoder;
+    configureFn(decoder);
+
+    int sampleRate = recording->getSampleRate();
+    int rxState = 0;
+    float sigPwrAvg = 0.0;
+    std::shared_ptr<IPipelineStep> demodulator(decoder.createReceivePipeline(
+        sampleRate, sampleRate,
+        [&]() { return &rxState; },
+        []() { return 0; },
+        []() { return 0; },
+        []() { return 0.0f; },
+        [&]() { return &sigPwrAvg; }));
+
+    SF_INFO sfInfo;
+    sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    sfInfo.channels = 1;
+    sfInfo.samplerate = sampleRate;
+    SNDFILE* file = sf_open(path.ToStdString().c_str(), SFM_WRITE, &sfInfo);
+    if (file == nullptr)
+    {
+        wxString error = wxString::Format(wxT("Couldn't decode to %s: %s"), path, sf_strerror(nullptr));
+        demodulator = nullptr;
+        decoder.stop();
+        return error;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    int nsam = (int)(sampleRate * FRAME_DURATION);
+    size_t numFrames = 0;
+    size_t numSyncFrames = 0;
+    size_t position = 0;
+    while (position < recording->getNumSamples() && !*cancel)
+    {
+        std::shared_ptr<short> input(new short[nsam], std::default_delete<short[]>());
+        size_t count = recording->read(position, input.get(), nsam);
+        memset(input.get() + count, 0, (nsam - count) * sizeof(short));
+        position += count;
+
+        int nout = 0;
+        auto output = demodulator->execute(input, nsam, &nout);
+        if (nout > 0)
+        {
+            sf_write_short(file, output.get(), nout);
+        }
+
+        numFrames++;
+        numSyncFrames += decoder.getSync() ? 1 : 0;
+    }
+
+    double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    double audioSec = (double)position / sampleRate;
+
+    sf_close(file);
+    demodulator = nullptr;
+    decoder.stop();
+
+    return wxString::Format(
+        wxT("Decoded %.0f s from radio to %s in %.1f s (%.0fx realtime), in sync %.0f%% of the time"),
+        audioSec, path, elapsedSec, elapsedSec > 0 ? audioSec / elapsedSec : 0.0,
+        numFrames > 0 ? 100.0 * numSyncFrames / numFrames : 0.0);
+}
+
+//-------------------------------------------------------------------------
+// startFlightRecorder_(): before the RX thread is started
+//-------------------------------------------------------------------------
+void MainFrame::startFlightRecorder_(int sampleRate)
+{
+    // A fresh one each time, so recordings don't span a gap or a change
+    // of sound card.
+    int minutes = wxGetApp().appConfiguration.flightRecorderMinutes;
+    FlightRecorder* recorder = nullptr;
+    if (minutes > 0)
+    {
+        recorder = new FlightRecorder(sampleRate, minutes * 60);
+        fprintf(stderr, "Flight recorder: keeping %d minutes at %d Hz (up to %.1f MB)\n",
+            minutes, sampleRate, (minutes * 60.0 + 2) * sampleRate * sizeof(short) / 1e6);
+    }
+
+    g_mutexProtectingCallbackData.Lock();
+    FlightRecorder* oldRecorder = g_flightRecorder;
+    g_flightRecorder = recorder;
+    g_mutexProtectingCallbackData.Unlock();
+
+    delete oldRecorder;
+}
+
+//-------------------------------------------------------------------------
+// takeFlightRecording_(): what the flight recorder has right now, or
+// nullptr (after telling the user why). *sizeBytes is the memory the
+// recorder is using.
+//-------------------------------------------------------------------------
+std::shared_ptr<FlightRecording> MainFrame::takeFlightRecording_(size_t* sizeBytes)
+{
+    if (m_flightRecorderBusy)
+    {
+        wxMessageBox(wxT("Still saving the last request, please try again shortly."), wxT("Flight Recorder"), wxOK);
+        return nullptr;
+    }
+
+    std::shared_ptr<FlightRecording> recording;
+    *sizeBytes = 0;
+
+    g_mutexProtectingCallbackData.Lock();
+    if (g_flightRecorder != nullptr)
+    {
+        recording = g_flightRecorder->snapshot();
+        *sizeBytes = g_flightRecorder->getSizeBytes();
+    }
+    g_mutexProtectingCallbackData.Unlock();
+
+    if (recording == nullptr || recording->getNumSamples() == 0)
+    {
+        wxMessageBox(
+            wxT("Nothing has been received yet. The flight recorder runs while FreeDV is started, if enabled in Tools > Options."),
+            wxT("Flight Recorder"), wxOK);
+        return nullptr;
+    }
+
+    fprintf(stderr, "Flight recorder: took %.1f s of audio, recorder using %.1f MB\n",
+        (double)recording->getNumSamples() / recording->getSampleRate(), *sizeBytes / 1e6);
+    return recording;
+}
+
+//-------------------------------------------------------------------------
+// runFlightRecorderTask_(): runs fn on the flight recorder thread
+//-------------------------------------------------------------------------
+void MainFrame::runFlightRecorderTask_(std::function<void()> fn)
+{
+    // Only one at a time; takeFlightRecording_() checks for that.
+    if (m_flightRecorderThread.joinable())
+    {
+        m_flightRecorderThread.join();
+    }
+
+    m_flightRecorderBusy = true;
+    m_flightRecorderCancel = false;
+    m_flightRecorderThread = std::thread([this, fn]()
+    {
+#if defined(__linux__)
+        pthread_setname_np(pthread_self(), "FreeDV replay");
+#endif // defined(__linux__)
+
+        fn();
+        m_flightRecorderBusy = false;
+    });
+}
+
+//-------------------------------------------------------------------------
+// stopFlightRecorderTask_(): on exit
+//-------------------------------------------------------------------------
+void MainFrame::stopFlightRecorderTask_()
+{
+    m_flightRecorderCancel = true;
+    if (m_flightRecorderThread.joinable())
+    {
+        m_flightRecorderThread.join();
+    }
+}
+
+//-------------------------------------------------------------------------
+// OnSaveFlightRecording()
+//-------------------------------------------------------------------------
+void MainFrame::OnSaveFlightRecording(wxCommandEvent& event)
+{
+    wxUnusedVar(event);
+
+    size_t sizeBytes;
+    auto recording = takeFlightRecording_(&sizeBytes);
+    if (recording == nullptr)
+    {
+        return;
+    }
+
+    auto currentTime = wxDateTime::Now().Format(_("%Y%m%d-%H%M%S"));
+    wxFileName filePath(wxGetApp().appConfiguration.quickRecordPath, wxString::Format(_("FreeDV_LastFromRadio_%s.wav"), currentTime));
+    wxString path = filePath.GetFullPath();
+
+    // The recording is already taken, so the file can be written at
+    // leisure.
+    SetStatusText(wxString::Format(wxT("Saving last %.0f s from radio to %s (flight recorder using %.1f MB)"),
+        (double)recording->getNumSamples() / recording->getSampleRate(), path, sizeBytes / 1e6), 0);
+    runFlightRecorderTask_([this, recording, path]()
+    {
+        std::string error;
+        wxString status;
+        if (recording->save(path.ToStdString(), &error))
+        {
+            status = wxString::Format(wxT("Saved last %.0f s from radio to %s"),
+                (double)recording->getNumSamples() / recording->getSampleRate(), path);
+        }
+        else
+        {
+            status = wxString::Format(wxT("Couldn't save to %s: %s"), path, wxString(error));
+        }
+        CallAfter([this, status]() { SetStatusText(status, 0); });
+    });
+}
+
+//-------------------------------------------------------------------------
+// OnDecodeFlightRecording()
+//-------------------------------------------------------------------------
+void MainFrame::OnDecodeFlightRecording(wxCommandEvent& event)
+{
+    wxUnusedVar(event);
+
+    size_t sizeBytes;
+    auto recording = takeFlightRecording_(&sizeBytes);
+    if (recording == nullptr)
+    {
+        return;
+    }
+
+    // Whatever the main receiver is set up for, but on one thread so the
+    // live receiver isn't starved.
+    std::deque<int> modes = freedvInterface.getRxModes();
+    if (modes.size() == 0)
+    {
+        modes.push_back(g_mode);
+    }
+    int mainMode = std::find(modes.begin(), modes.end(), g_mode) != modes.end() ? g_mode : modes.front();
+    auto& filterConfig = wxGetApp().appConfiguration.filterConfiguration;
+    int fifoSizeMs = wxGetApp().appConfiguration.fifoSizeMs;
+    bool eqEnable = filterConfig.enable700CEqualizer;
+    bool postFilterEnable = filterConfig.codec2LPCPostFilterEnable;
+    bool postFilterBassBoost = filterConfig.codec2LPCPostFilterBassBoost;
+    float postFilterBeta = filterConfig.codec2LPCPostFilterBeta;
+    float postFilterGamma = filterConfig.codec2LPCPostFilterGamma;
+    bool squelchActive = g_SquelchActive;
+    float squelchLevel = g_SquelchLevel;
+    
+    auto configureFn = [=](FreeDVInterface& decoder)
+    {
+        for (auto mode : modes)
+        {
+            decoder.addRxMode(mode);
+        }
+        decoder.start(mainMode, fifoSizeMs, true, false);
+        decoder.setEq(eqEnable);
+        decoder.setVerbose(g_freedv_verbose);
+        decoder.setLpcPostFilter(postFilterEnable, postFilterBassBoost, postFilterBeta, postFilterGamma);
+        decoder.setSquelch(squelchActive, squelchLevel);
+    };
+
+    auto currentTime = wxDateTime::Now().Format(_("%Y%m%d-%H%M%S"));
+    wxFileName filePath(wxGetApp().appConfiguration.quickRecordPath, wxString::Format(_("FreeDV_LastDecoded_%s.wav"), currentTime));
+    wxString path = filePath.GetFullPath();
+
+    SetStatusText(wxString::Format(wxT("Decoding last %.0f s from radio to %s (flight recorder using %.1f MB)"),
+        (double)recording->getNumSamples() / recording->getSampleRate(), path, sizeBytes / 1e6), 0);
+    runFlightRecorderTask_([this, recording, configureFn, path]()
+    {
+        wxString status = DecodeFlightRecording(recording, configureFn, path, &m_flightRecorderCancel);
+        CallAfter([this, status]() { SetStatusText(status, 0); });
+    });
+}
@@ -81,6 +81,7 @@ public:
     void setTextCallbackFn(void (*rxFunc)(void *, char), char (*txFunc)(void *));
     
     void addRxMode(int mode) { enabledModes_.push_back(mode); }
+    const std::deque<int>& getRxModes() const { return enabledModes_; }
     
     int getTxModemSampleRate() const;
     int getTxSpeechSampleRate() const;
@@ -20,9 +20,14 @@
 //==========================================================================
 #include <string.h>
 #include <algorithm>
+#include <chrono>
 #include "plot.h"
 #include <wx/graphics.h>
 
+long long PlotPanel::s_paintTimeUs = 0;
+int       PlotPanel::s_numPaints = 0;
+bool      PlotPanel::s_softwareRendering = false;
+
 BEGIN_EVENT_TABLE(PlotPanel, wxPanel)
     EVT_PAINT           (PlotPanel::OnPaint)
     EVT_MOTION          (PlotPanel::OnMouseMove)
@@ -54,6 +59,10 @@ PlotPanel::PlotPanel(wxWindow* parent, const char* plotName) : wxPanel(parent, w
     m_use_bitmap        = true;
     m_rubberBand        = false;
     m_mouseDown         = false;
+    m_rasterLayerValid  = false;
+    m_dirty             = true;
+    m_minRefreshIntervalMs = 0;
+    m_lastRefreshMs     = 0;
     m_penShortDash      = wxPen(wxColor(0xA0, 0xA0, 0xA0), 1, wxPENSTYLE_SHORT_DASH);
     m_penDotDash        = wxPen(wxColor(0xD0, 0xD0, 0xD0), 1, wxPENSTYLE_DOT_DASH);
     m_penSolid          = wxPen(wxColor(0x00, 0x00, 0x00), 1, wxPENSTYLE_SOLID);
@@ -92,6 +101,148 @@ void PlotPanel::OnShow(wxShowEvent& event)
     this->Refresh();
 }
 
+//-------------------------------------------------------------------------
+// isOnScreen()
+//
+// IsShownOnScreen() covers hidden notebook pages (wxAuiNotebook hides
+// every page but the selected one) but not a minimised main window.
+//-------------------------------------------------------------------------
+bool PlotPanel::isOnScreen()
+{
+    if (!IsShownOnScreen())
+    {
+        return false;
+    }
+
+    wxTopLevelWindow* topLevel = wxDynamicCast(wxGetTopLevelParent(this), wxTopLevelWindow);
+    return topLevel == nullptr || !topLevel->IsIconized();
+}
+
+//-------------------------------------------------------------------------
+// refreshIfDue()
+//
+// Returns true if a repaint was requested.
+//-------------------------------------------------------------------------
+bool PlotPanel::refreshIfDue()
+{
+    if (!m_dirty || !isOnScreen())
+    {
+        return false;
+    }
+
+    wxLongLong now = wxGetLocalTimeMillis();
+    if (m_minRefreshIntervalMs > 0 && (now - m_lastRefreshMs) < m_minRefreshIntervalMs)
+    {
+        // Stay dirty and try again on the next tick.
+        return false;
+    }
+
+    m_dirty = false;
+    m_lastRefreshMs = now;
+    Refresh();
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// strokeTrace()
+//-------------------------------------------------------------------------
+void PlotPanel::strokeTrace(wxGraphicsContext* ctx, const wxColour& colour)
+{
+    if (m_trace.empty())
+    {
+        return;
+    }
+
+    if (s_softwareRendering)
+    {
+        m_raster.setColour(colour.Red(), colour.Green(), colour.Blue());
+        for (size_t i = 1; i < m_trace.size(); i++)
+        {
+            if (!m_trace[i].move)
+            {
+                m_raster.drawLine(m_trace[i - 1].x, m_trace[i - 1].y, m_trace[i].x, m_trace[i].y);
+            }
+        }
+    }
+    else
+    {
+        wxGraphicsPath path = ctx->CreatePath();
+        for (auto& point : m_trace)
+        {
+            if (point.move)
+                path.MoveToPoint(point.x, point.y);
+            else
+                path.AddLineToPoint(point.x, point.y);
+        }
+        ctx->SetPen(wxPen(colour, 1));
+        ctx->StrokePath(path);
+    }
+}
+
+//-------------------------------------------------------------------------
+// beginRaster()
+//-------------------------------------------------------------------------
+void PlotPanel::beginRaster()
+{
+    wxSize size = GetClientSize();
+    if (m_rasterLayerValid && size.GetWidth() == m_raster.width() && size.GetHeight() == m_raster.height())
+    {
+        m_raster.clear();
+        return;
+    }
+
+    m_raster.resize(size.GetWidth(), size.GetHeight());
+    if (size.GetWidth() <= 0 || size.GetHeight() <= 0)
+    {
+        return;
+    }
+
+    // Render the static parts once with the normal back end and keep the
+    // pixels.
+    wxBitmap layer(size.GetWidth(), size.GetHeight(), 24);
+    {
+        wxMemoryDC dc(layer);
+        dc.SetBackground(wxBrush(GetBackgroundColour()));
+        dc.Clear();
+
+        wxGraphicsContext* gc = wxGraphicsContext::Create(dc);
+        gc->SetInterpolationQuality(wxINTERPOLATION_NONE);
+        drawRasterLayer(gc);
+        delete gc;
+
+        dc.SelectObject(wxNullBitmap);
+    }
+
+    wxImage image = layer.ConvertToImage();
+    memcpy(m_raster.data(), image.GetData(), 3 * size.GetWidth() * size.GetHeight());
+    m_raster.saveBackground();
+    m_rasterLayerValid = true;
+}
+
+//-------------------------------------------------------------------------
+// endRaster()
+//-------------------------------------------------------------------------
+void PlotPanel::endRaster(wxGraphicsContext* ctx)
+{
+    if (m_raster.width() <= 0 || m_raster.height() <= 0)
+    {
+        return;
+    }
+
+    // static_data: the image just borrows our buffer.
+    wxImage image(m_raster.width(), m_raster.height(), m_raster.data(), true);
+    ctx->DrawBitmap(wxBitmap(image), 0, 0, m_raster.width(), m_raster.height());
+}
+
+//-------------------------------------------------------------------------
+// GetPaintStats()
+//-------------------------------------------------------------------------
+void PlotPanel::GetPaintStats(long long* paintTimeUs, int* numPaints)
+{
+    *paintTimeUs = s_paintTimeUs;
+    *numPaints = s_numPaints;
+}
+
 //-------------------------------------------------------------------------
 // OnErase()
 //-------------------------------------------------------------------------
@@ -211,10 +362,12 @@ void PlotPanel::drawGraticule(wxGraphicsContext* ctx)
 //-------------------------------------------------------------------------
 void PlotPanel::OnPaint(wxPaintEvent & evt)
 {
+    auto paintStart = std::chrono::steady_clock::now();
     wxAutoBufferedPaintDC dc(this);
 
     // TBD -- move to wxGraphicsContext?
     dc.Clear();
+    drawBitmaps(dc);
     
     wxGraphicsContext *gc = wxGraphicsContext::Create( dc );
     gc->SetInterpolationQuality(wxINTERPOLATION_NONE);
@@ -222,5 +375,9 @@ void PlotPanel::OnPaint(wxPaintEvent & evt)
     draw(gc);
     
     delete gc;
+
+    s_paintTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - paintStart).count();
+    s_numPaints++;
 }
 
@@ -22,6 +22,7 @@
 #define __FDMDV2_PLOT__
 
 #include <deque>
+#include <vector>
 
 #include <wx/wx.h>
 #include <wx/aui/auibook.h>
@@ -29,6 +30,8 @@
 #include <wx/image.h>
 #include <wx/dcbuffer.h>
 
+#include "plot_raster.h"
+
 #define MAX_ZOOM            7
 #define MAX_BMP_X           (400 * MAX_ZOOM)
 #define MAX_BMP_Y           (400 * MAX_ZOOM)
@@ -124,6 +127,9 @@ class PlotPanel : public wxPanel
         //void OnUpdateUI( wxUpdateUIEvent& event ){ event.Skip(); }
 
         void            paintEvent(wxPaintEvent & evt);
+        // Called with the paint DC before draw(), for blitting native
+        // bitmaps that the graphics context would otherwise have to copy.
+        virtual void    drawBitmaps(wxDC& dc) {}
         virtual void    draw(wxGraphicsContext* ctx) = 0;
         virtual void    drawGraticule(wxGraphicsContext* ctx);
         virtual double  SetZoomFactor(double zf);
@@ -132,6 +138,25 @@ class PlotPanel : public wxPanel
         virtual double  GetLabelSize();
         virtual void    SetLabelSize(double size);
         
+        // Refresh scheduling, driven by MainFrame::OnTimer(). Plots on a hidden
+        // notebook tab (or in a minimised window) are neither fed new data nor
+        // repainted; visible ones are repainted at most once every
+        // setMinRefreshIntervalMs() and only after markDirty().
+        bool            isOnScreen();
+        void            markDirty() { m_dirty = true; }
+        void            setMinRefreshIntervalMs(int ms) { m_minRefreshIntervalMs = ms; }
+        bool            refreshIfDue();
+
+        // Total time spent painting plots, for UI thread CPU accounting.
+        static void     GetPaintStats(long long* paintTimeUs, int* numPaints);
+
+        // Optional software rendering back end for plots that support it
+        // (PlotScalar, PlotSpectrum): traces are rasterized into m_raster
+        // on top of a cached background/graticule layer and the result is
+        // drawn with a single DrawBitmap() per paint.
+        static void     SetSoftwareRendering(bool enabled) { s_softwareRendering = enabled; }
+        static bool     IsSoftwareRendering() { return s_softwareRendering; }
+
         void setSync(bool sync) { sync_ = sync; }
         void addOffset(float offset)
         {
@@ -163,6 +188,35 @@ class PlotPanel : public wxPanel
         
         std::deque<float> rxOffsets_;
         bool        sync_;
+
+        // Trace built up by draw() and then stroked by either back end. A
+        // point with move set starts a new polyline.
+        struct TracePoint
+        {
+            int  x;
+            int  y;
+            bool move;
+        };
+        std::vector<TracePoint> m_trace;
+        void            strokeTrace(wxGraphicsContext* ctx, const wxColour& colour);
+
+        // Software rendering. beginRaster() (re)renders the layer with
+        // drawRasterLayer() if the panel was resized or the layer was
+        // invalidated, then starts a new frame from it. endRaster() blits.
+        PlotRaster      m_raster;
+        bool            m_rasterLayerValid;
+        virtual void    drawRasterLayer(wxGraphicsContext* ctx) {}
+        void            invalidateRasterLayer() { m_rasterLayerValid = false; }
+        void            beginRaster();
+        void            endRaster(wxGraphicsContext* ctx);
+
+        bool            m_dirty;
+        int             m_minRefreshIntervalMs;
+        wxLongLong      m_lastRefreshMs;
+
+        static long long s_paintTimeUs;
+        static int       s_numPaints;
+        static bool      s_softwareRendering;
         
     DECLARE_EVENT_TABLE()
 };
@@ -0,0 +1,194 @@
+//==========================================================================
+// Name:            plot_raster.cpp
+// Purpose:         Minimal software rasterizer for drawing plot traces
+//                  into an RGB buffer.
+// Created:         October 19, 2026
+// Authors:         Mooneer Salem
+//
+// License:
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//==========================================================================
+#include <algorithm>
+#include <cstdlib>
+#include "plot_raster.h"
+
+// num / den rounded to the nearest integer (halves away from zero), den > 0.
+static int RoundDiv_(int num, int den)
+{
+    return num >= 0 ? (2 * num + den) / (2 * den) : -((-2 * num + den) / (2 * den));
+}
+
+PlotRaster::PlotRaster()
+    : m_width(0)
+    , m_height(0)
+    , m_clipLeft(0)
+    , m_clipTop(0)
+    , m_clipRight(0)
+    , m_clipBottom(0)
+{
+    m_colour[0] = m_colour[1] = m_colour[2] = 0xFF;
+}
+
+//----------------------------------------------------------------
+// resize()
+//----------------------------------------------------------------
+void PlotRaster::resize(int width, int height)
+{
+    m_width = std::max(width, 0);
+    m_height = std::max(height, 0);
+    m_pixels.assign(3 * m_width * m_height, 0);
+    m_background.clear();
+    setClip(0, 0, m_width, m_height);
+}
+
+//----------------------------------------------------------------
+// saveBackground()
+//----------------------------------------------------------------
+void PlotRaster::saveBackground()
+{
+    m_background = m_pixels;
+}
+
+//----------------------------------------------------------------
+// clear()
+//----------------------------------------------------------------
+void PlotRaster::clear()
+{
+    if (m_background.size() == m_pixels.size())
+    {
+        std::copy(m_background.begin(), m_background.end(), m_pixels.begin());
+    }
+    else
+    {
+        std::fill(m_pixels.begin(), m_pixels.end(), 0);
+    }
+}
+
+//----------------------------------------------------------------
+// setClip()
+//----------------------------------------------------------------
+void PlotRaster::setClip(int x, int y, int width, int height)
+{
+    m_clipLeft = std::max(x, 0);
+    m_clipTop = std::max(y, 0);
+    m_clipRight = std::min(x + width, m_width);
+    m_clipBottom = std::min(y + height, m_height);
+}
+
+//----------------------------------------------------------------
+// setColour()
+//----------------------------------------------------------------
+void PlotRaster::setColour(unsigned char r, unsigned char g, unsigned char b)
+{
+    m_colour[0] = r;
+    m_colour[1] = g;
+    m_colour[2] = b;
+}
+
+//----------------------------------------------------------------
+// drawVerticalSpan()
+//----------------------------------------------------------------
+void PlotRaster::drawVerticalSpan(int x, int y0, int y1)
+{
+    if (y0 > y1) std::swap(y0, y1);
+    if (x < m_clipLeft || x >= m_clipRight) return;
+    y0 = std::max(y0, m_clipTop);
+    y1 = std::min(y1, m_clipBottom - 1);
+    if (y0 > y1) return;
+
+    const int stride = 3 * m_width;
+    const unsigned char r = m_colour[0], g = m_colour[1], b = m_colour[2];
+    unsigned char* p = &m_pixels[0] + stride * y0 + 3 * x;
+    for (int y = y0; y <= y1; y++, p += stride)
+    {
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+}
+
+//----------------------------------------------------------------
+// drawHorizontalSpan()
+//----------------------------------------------------------------
+void PlotRaster::drawHorizontalSpan(int y, int x0, int x1)
+{
+    if (x0 > x1) std::swap(x0, x1);
+    if (y < m_clipTop || y >= m_clipBottom) return;
+    x0 = std::max(x0, m_clipLeft);
+    x1 = std::min(x1, m_clipRight - 1);
+    if (x0 > x1) return;
+
+    const unsigned char r = m_colour[0], g = m_colour[1], b = m_colour[2];
+    unsigned char* p = &m_pixels[0] + 3 * (m_width * y + x0);
+    for (int x = x0; x <= x1; x++, p += 3)
+    {
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+}
+
+//----------------------------------------------------------------
+// drawLine()
+//----------------------------------------------------------------
+void PlotRaster::drawLine(int x0, int y0, int x1, int y1)
+{
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+
+    if (std::abs(dy) >= std::abs(dx))
+    {
+        // Steep (or a single point): one vertical run per column, split
+        // half way between columns.
+        if (dx == 0)
+        {
+            drawVerticalSpan(x0, y0, y1);
+            return;
+        }
+        if (dx < 0)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+            dx = -dx;
+            dy = -dy;
+        }
+
+        int runStart = y0;
+        for (int i = 0; i <= dx; i++)
+        {
+            int runEnd = (i == dx) ? y1 : y0 + RoundDiv_((2 * i + 1) * dy, 2 * dx);
+            drawVerticalSpan(x0 + i, runStart, runEnd);
+            runStart = runEnd;
+        }
+    }
+    else
+    {
+        // Shallow: one horizontal run per row.
+        if (dy < 0)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+            dx = -dx;
+            dy = -dy;
+        }
+
+        int runStart = x0;
+        for (int i = 0; i <= dy; i++)
+        {
+            int runEnd = (i == dy) ? x1 : x0 + RoundDiv_((2 * i + 1) * dx, 2 * dy);
+            drawHorizontalSpan(y0 + i, runStart, runEnd);
+            runStart = runEnd;
+        }
+    }
+}
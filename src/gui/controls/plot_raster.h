@@ -0,0 +1,81 @@
+//==========================================================================
+// Name:            plot_raster.h
+// Purpose:         Minimal software rasterizer for drawing plot traces
+//                  into an RGB buffer.
+// Created:         October 19, 2026
+// Authors:         Mooneer Salem
+//
+// License:
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//==========================================================================
+#ifndef __FDMDV2_PLOT_RASTER__
+#define __FDMDV2_PLOT_RASTER__
+
+#include <vector>
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
+// Class PlotRaster
+//
+// 24 bit RGB image (rows top to bottom, same layout as wxImage) with a
+// saved background layer and 1 pixel wide, non antialiased lines.
+//
+// Lines are split into runs, one vertical run per column for steep lines
+// and one horizontal run per row otherwise, so the inner loops are plain
+// strided stores with no per pixel error term or clip test. A plot trace
+// with one point per pixel column is then just a vertical span per column.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
+class PlotRaster
+{
+    public:
+        PlotRaster();
+
+        // Discards the contents and background and resets the clip
+        // rectangle to the whole image.
+        void resize(int width, int height);
+
+        int  width() const { return m_width; }
+        int  height() const { return m_height; }
+        unsigned char* data() { return m_pixels.empty() ? nullptr : &m_pixels[0]; }
+
+        // Remembers the current contents; clear() goes back to them.
+        void saveBackground();
+        void clear();
+
+        // Drawing outside this rectangle is discarded.
+        void setClip(int x, int y, int width, int height);
+
+        void setColour(unsigned char r, unsigned char g, unsigned char b);
+
+        // Both end points are drawn.
+        void drawLine(int x0, int y0, int x1, int y1);
+        void drawPoint(int x, int y) { drawVerticalSpan(x, y, y); }
+        void drawVerticalSpan(int x, int y0, int y1);
+        void drawHorizontalSpan(int y, int x0, int x1);
+
+    private:
+        std::vector<unsigned char> m_pixels;
+        std::vector<unsigned char> m_background;
+        int m_width;
+        int m_height;
+
+        // Clip rectangle, right/bottom exclusive.
+        int m_clipLeft;
+        int m_clipTop;
+        int m_clipRight;
+        int m_clipBottom;
+
+        unsigned char m_colour[3];
+};
+
+#endif //__FDMDV2_PLOT_RASTER__
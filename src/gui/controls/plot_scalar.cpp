@@ -19,6 +19,7 @@
 //
 //==========================================================================
 #include <string.h>
+#include <algorithm>
 
 #include <wx/wx.h>
 #include <wx/graphics.h>
@@ -49,12 +50,11 @@ PlotScalar::PlotScalar(wxWindow* parent,
                        const char* plotName)
     : PlotPanel(parent, plotName)
 {
-    int i;
-
     m_rCtrl = GetClientRect();
 
     m_channels = channels;
     m_t_secs = t_secs;
+    m_base_t_secs = t_secs;
     m_sample_period_secs = sample_period_secs;
     m_a_min = a_min;
     m_a_max = a_max;
@@ -70,11 +70,8 @@ PlotScalar::PlotScalar(wxWindow* parent,
     // work out number of samples we will store and allocate storage
 
     m_samples = m_t_secs/m_sample_period_secs;
-    m_mem = new float[m_samples*m_channels];
-    for(i = 0; i < m_samples*m_channels; i++)
-    {
-        m_mem[i] = 0.0;
-    }
+    m_history_samples = m_samples;
+    m_mem.assign(m_channels, PlotScalarHistory(m_history_samples));
 }
 
 //----------------------------------------------------------------
@@ -82,7 +79,20 @@ PlotScalar::PlotScalar(wxWindow* parent,
 //----------------------------------------------------------------
 PlotScalar::~PlotScalar()
 {
-    delete[] m_mem;
+}
+
+//----------------------------------------------------------------
+// setHistorySecs()
+//----------------------------------------------------------------
+void PlotScalar::setHistorySecs(float history_secs)
+{
+    int history_samples = history_secs/m_sample_period_secs;
+    m_history_samples = std::max(history_samples, (int)(m_base_t_secs/m_sample_period_secs));
+    m_mem.assign(m_channels, PlotScalarHistory(m_history_samples));
+
+    m_t_secs = m_base_t_secs;
+    m_samples = m_t_secs/m_sample_period_secs;
+    invalidateRasterLayer();
 }
 
 //----------------------------------------------------------------
@@ -90,16 +100,9 @@ PlotScalar::~PlotScalar()
 //----------------------------------------------------------------
 void PlotScalar::add_new_sample(int channel, float sample)
 {
-    int offset = channel*m_samples;
-
     assert(channel < m_channels);
 
-    for(int i = 0; i < m_samples-1; i++)
-    {
-        m_mem[offset+i] = m_mem[offset+i+1];
-    }
-    
-    m_mem[offset+m_samples-1] = sample;
+    m_mem[channel].append(sample);
 }
 
 //----------------------------------------------------------------
@@ -107,16 +110,11 @@ void PlotScalar::add_new_sample(int channel, float sample)
 //----------------------------------------------------------------
 void  PlotScalar::add_new_samples(int channel, float samples[], int length)
 {
-    int i;
-    int offset = channel*m_samples;
-
     assert(channel < m_channels);
 
-    for(i = 0; i < m_samples-length; i++)
-        m_mem[offset+i] = m_mem[offset+i+length];
-    
-    for(i = m_samples-length; i < m_samples; i++)
-        m_mem[offset+i] = *samples++;
+    PlotScalarHistory& history = m_mem[channel];
+    for(int i = 0; i < length; i++)
+        history.append(samples[i]);
 }
 
 //----------------------------------------------------------------
@@ -124,16 +122,11 @@ void  PlotScalar::add_new_samples(int channel, float samples[], int length)
 //----------------------------------------------------------------
 void  PlotScalar::add_new_short_samples(int channel, short samples[], int length, float scale_factor)
 {
-    int i;
-    int offset = channel*m_samples;
-
     assert(channel < m_channels);
 
-    for(i = 0; i < m_samples-length; i++)
-            m_mem[offset+i] = m_mem[offset+i+length];
-    
-    for(i = m_samples-length; i < m_samples; i++)
-        m_mem[offset+i] = (float)*samples++/scale_factor;
+    PlotScalarHistory& history = m_mem[channel];
+    for(int i = 0; i < length; i++)
+        history.append((float)samples[i]/scale_factor);
 }
 
 //----------------------------------------------------------------
@@ -143,9 +136,7 @@ void PlotScalar::draw(wxGraphicsContext* ctx)
 {
     float index_to_px;
     float a_to_py;
-    int   i;
-    int   prev_x, prev_y;
-    float a;
+    int   i, x;
 
     m_rCtrl = GetClientRect();
     m_rGrid = m_rCtrl;
@@ -163,92 +154,130 @@ void PlotScalar::draw(wxGraphicsContext* ctx)
     plotWidth = m_rGrid.GetWidth();
     plotHeight = m_rGrid.GetHeight();
         
-    wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
-    ctx->SetBrush(ltGraphBkgBrush);
-    ctx->SetPen(wxPen(BLACK_COLOR, 0));
-    ctx->DrawRectangle(plotX, plotY, plotWidth, plotHeight);
+    bool software = IsSoftwareRendering();
+    if (software)
+    {
+        beginRaster();
+        m_raster.setClip(plotX, plotY, plotWidth + 1, plotHeight + 1);
+    }
+    else
+    {
+        drawBackground_(ctx);
+    }
     
-    index_to_px = (float)plotWidth/m_samples;
     a_to_py = (float)plotHeight/(m_a_max - m_a_min);
 
-    wxPen pen;
-    pen.SetColour(DARK_GREEN_COLOR);
-    pen.SetWidth(1);
-    ctx->SetPen(pen);
-    
-    // draw all samples
+    // With more samples than pixels, each pixel column shows the min/max
+    // of the samples behind it. Either way the cost is bounded by the plot
+    // width rather than the amount of history kept.
 
-    prev_x = prev_y = 0; // stop warning
+    int bins = std::max(1, std::min(m_samples, plotWidth));
+    index_to_px = (float)plotWidth/bins;
+    m_bin_min.resize(bins);
+    m_bin_max.resize(bins);
+
+    int xoffset = 0, yoffset = 0;
+    if (!m_mini) {
+        xoffset = PLOT_BORDER + XLEFT_OFFSET;
+        yoffset = PLOT_BORDER;
+    }
 
-    // plot each channel     
-    int offset, x, y;
-    for(offset=0; offset<m_channels*m_samples; offset+=m_samples) {
+    auto amplitudeToY = [&](float a) {
+        if (a < m_a_min) a = m_a_min;
+        if (a > m_a_max) a = m_a_max;
 
-        for(i = 0; i < m_samples; i++) {
-            a = m_mem[offset + i];
-            if (a < m_a_min) a = m_a_min;
-            if (a > m_a_max) a = m_a_max;
+        if (m_bar_graph && m_logy) {
 
-            // invert y axis and offset by minimum
+            // can't take log(0)
 
-            y = plotHeight - a_to_py * a + m_a_min*a_to_py;
+            assert(m_a_min > 0.0); 
+            assert(m_a_max > 0.0);
 
-            // regular point-point line graph
+            float norm = (log10(a) - log10(m_a_min))/(log10(m_a_max) - log10(m_a_min));
+            return (int)(plotHeight*(1.0 - norm));
+        }
 
-            x = index_to_px * i;
+        // invert y axis and offset by minimum
 
-            // put inside plot window
+        return (int)(plotHeight - a_to_py * a + m_a_min*a_to_py);
+    };
 
-            if (!m_mini) {
-                x += PLOT_BORDER + XLEFT_OFFSET;
-                y += PLOT_BORDER;
-            }
-            
-            if (m_bar_graph) {
+    // plot each channel, all line segments for a channel are stroked at once
 
-                if (m_logy) {
+    for(int channel = 0; channel < m_channels; channel++) {
 
-                    // can't take log(0)
+        m_mem[channel].getMinMax(m_samples, bins, &m_bin_min[0], &m_bin_max[0]);
 
-                    assert(m_a_min > 0.0); 
-                    assert(m_a_max > 0.0);
+        m_trace.clear();
+        for(i = 0; i < bins; i++) {
 
-                    float norm = (log10(a) - log10(m_a_min))/(log10(m_a_max) - log10(m_a_min));
-                    y = plotHeight*(1.0 - norm);
-                } else {
-                    y = plotHeight - a_to_py * a + m_a_min*a_to_py;
-                }
+            if (m_bar_graph) {
 
                 // use points to make a bar graph
 
-                int x1, x2, y1;
+                int x1, x2, y, y1;
 
-                x1 = index_to_px * ((float)i - 0.5);
-                x2 = index_to_px * ((float)i + 0.5);
-                y1 = plotHeight;
-                x1 += PLOT_BORDER + XLEFT_OFFSET; x2 += PLOT_BORDER + XLEFT_OFFSET;
-                y1 += PLOT_BORDER;
+                y = amplitudeToY(m_bin_max[i]) + yoffset;
+                x1 = index_to_px * ((float)i - 0.5) + PLOT_BORDER + XLEFT_OFFSET;
+                x2 = index_to_px * ((float)i + 0.5) + PLOT_BORDER + XLEFT_OFFSET;
+                y1 = plotHeight + PLOT_BORDER;
 
-                wxGraphicsPath path = ctx->CreatePath();
-                path.MoveToPoint(x1, y1);
-                path.AddLineToPoint(x1, y);
-                path.AddLineToPoint(x2, y);
-                path.AddLineToPoint(x2, y1);
-                ctx->StrokePath(path);
+                m_trace.push_back({x1, y1, true});
+                m_trace.push_back({x1, y, false});
+                m_trace.push_back({x2, y, false});
+                m_trace.push_back({x2, y1, false});
             }
             else {
-                if (i)
-                {
-                    wxGraphicsPath path = ctx->CreatePath();
-                    path.MoveToPoint(x, y);
-                    path.AddLineToPoint(prev_x, prev_y);
-                    ctx->StrokePath(path);
-                }
-                prev_x = x; prev_y = y;
+
+                // regular point-point line graph, plus a vertical span
+                // for columns covering more than one sample
+
+                x = index_to_px * i + xoffset;
+                int y_max = amplitudeToY(m_bin_max[i]) + yoffset;
+                int y_min = amplitudeToY(m_bin_min[i]) + yoffset;
+
+                m_trace.push_back({x, y_max, i == 0});
+                if (y_min != y_max)
+                    m_trace.push_back({x, y_min, false});
             }
         }
+        strokeTrace(ctx, DARK_GREEN_COLOR);
     }
     
+    if (software)
+        endRaster(ctx);
+    else
+        drawGraticule(ctx);
+}
+
+//-------------------------------------------------------------------------
+// drawBackground_()
+//-------------------------------------------------------------------------
+void PlotScalar::drawBackground_(wxGraphicsContext* ctx)
+{
+    // black background
+    int plotX = 0, plotY = 0;
+    if (!m_mini)
+    {
+        plotX = PLOT_BORDER + XLEFT_OFFSET;
+        plotY = PLOT_BORDER;
+    }
+
+    wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
+    ctx->SetBrush(ltGraphBkgBrush);
+    ctx->SetPen(wxPen(BLACK_COLOR, 0));
+    ctx->DrawRectangle(plotX, plotY, m_rGrid.GetWidth(), m_rGrid.GetHeight());
+}
+
+//-------------------------------------------------------------------------
+// drawRasterLayer()
+//
+// With software rendering the graticule goes underneath the traces
+// rather than on top.
+//-------------------------------------------------------------------------
+void PlotScalar::drawRasterLayer(wxGraphicsContext* ctx)
+{
+    drawBackground_(ctx);
     drawGraticule(ctx);
 }
 
@@ -279,6 +308,9 @@ void PlotScalar::drawGraticule(wxGraphicsContext* ctx)
     ctx->SetFont(tmpFont);
     
     sec_to_px = (float)plotWidth/m_t_secs;
+
+    // keep the same number of vertical gridlines when zoomed out
+    float t_step = m_graticule_t_step*m_t_secs/m_base_t_secs;
     a_to_py = (float)plotHeight/(m_a_max - m_a_min);
 
     // upper LH coords of plot area are (PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER)
@@ -288,7 +320,7 @@ void PlotScalar::drawGraticule(wxGraphicsContext* ctx)
     // Vertical gridlines
 
     ctx->SetPen(m_penShortDash);
-    for(t=0; t<=m_t_secs; t+=m_graticule_t_step) {
+    for(t=0; t<=m_t_secs; t+=t_step) {
     x = t*sec_to_px;
     if (m_mini) {
             ctx->StrokeLine(x, plotHeight, x, 0);
@@ -344,7 +376,10 @@ void PlotScalar::drawGraticule(wxGraphicsContext* ctx)
 
 void PlotScalar::clearSamples()
 {
-    memset(m_mem, 0, sizeof(float) * m_samples);
+    for (auto& history : m_mem)
+    {
+        history.clear();
+    }
 }
 
 //----------------------------------------------------------------
@@ -360,3 +395,29 @@ void PlotScalar::OnSize(wxSizeEvent& event)
 void PlotScalar::OnShow(wxShowEvent& event)
 {
 }
+
+//----------------------------------------------------------------
+// OnMouseWheelMoved()
+//----------------------------------------------------------------
+void PlotScalar::OnMouseWheelMoved(wxMouseEvent& event)
+{
+    float history_secs = m_history_samples*m_sample_period_secs;
+    if (history_secs <= m_base_t_secs)
+    {
+        // no extra history to show
+        return;
+    }
+
+    if (event.GetWheelRotation() < 0)
+    {
+        m_t_secs = std::min(m_t_secs*2, history_secs);
+    }
+    else if (event.GetWheelRotation() > 0)
+    {
+        m_t_secs = std::max(m_t_secs/2, m_base_t_secs);
+    }
+
+    m_samples = std::min((int)(m_t_secs/m_sample_period_secs), m_history_samples);
+    invalidateRasterLayer();
+    Refresh();
+}
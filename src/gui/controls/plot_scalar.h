@@ -21,9 +21,11 @@
 #ifndef __FDMDV2_PLOT_SCALAR__
 #define __FDMDV2_PLOT_SCALAR__
 
+#include <vector>
 #include <wx/graphics.h>
 
 #include "plot.h"
+#include "plot_scalar_history.h"
 #include "defines.h"
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
@@ -50,14 +52,19 @@ class PlotScalar: public PlotPanel
          void add_new_samples(int channel, float samples[], int length);
          void add_new_short_samples(int channel, short samples[], int length, float scale_factor);
          void setBarGraph(int bar_graph) { m_bar_graph = bar_graph; }
-         void setLogY(int logy) { m_logy = logy; }
+         void setLogY(int logy) { m_logy = logy; invalidateRasterLayer(); }
+
+         // Retain history_secs of samples (at least t_secs). The mouse wheel
+         // then zooms the time axis out to show up to this much history.
+         void setHistorySecs(float history_secs);
 
          void clearSamples();
          
     protected:
 
          int      m_channels;
-         float    m_t_secs;
+         float    m_t_secs;                    // time currently displayed
+         float    m_base_t_secs;               // time displayed when fully zoomed in
          float    m_sample_period_secs;
          float    m_a_min;
          float    m_a_max;
@@ -65,15 +72,21 @@ class PlotScalar: public PlotPanel
          float    m_graticule_a_step;
          char     m_a_fmt[15];
          int      m_mini;
-         int      m_samples;
-         float   *m_mem;   
+         int      m_samples;                   // number of samples currently displayed
+         int      m_history_samples;           // number of samples retained
+         std::vector<PlotScalarHistory> m_mem;
+         std::vector<float> m_bin_min;         // per pixel scratch used by draw()
+         std::vector<float> m_bin_max;
          int      m_bar_graph;                 // non zero to plot bar graphs 
          int      m_logy;                      // plot graph on log scale
          
          void draw(wxGraphicsContext* ctx);
          void drawGraticule(wxGraphicsContext* ctx);
+         void drawRasterLayer(wxGraphicsContext* ctx);
+         void drawBackground_(wxGraphicsContext* ctx);
          void OnSize(wxSizeEvent& event);
          void OnShow(wxShowEvent& event);
+         void OnMouseWheelMoved(wxMouseEvent& event);
 
          DECLARE_EVENT_TABLE()
 };
@@ -0,0 +1,175 @@
+//==========================================================================
+// Name:            plot_scalar_history.cpp
+// Purpose:         Circular sample store with a min/max pyramid for fast
+//                  decimated drawing of scalar plots.
+// Created:         October 19, 2026
+// Authors:         Mooneer Salem
+// 
+// License:
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//==========================================================================
+#include <algorithm>
+#include <cassert>
+
+#include "plot_scalar_history.h"
+
+//----------------------------------------------------------------
+// PlotScalarHistory()
+//----------------------------------------------------------------
+PlotScalarHistory::PlotScalarHistory(int capacity)
+    : m_capacity(capacity)
+{
+    assert(capacity > 0);
+
+    // Level k needs enough blocks to cover capacity samples even when the
+    // oldest and newest blocks are only partially inside the window.
+    for (int blockSize = 1; ; blockSize <<= 1)
+    {
+        Level level;
+        int numBlocks = capacity / blockSize + 2;
+        level.min.resize(numBlocks);
+        level.max.resize(numBlocks);
+        m_levels.push_back(level);
+
+        if (blockSize >= capacity)
+        {
+            break;
+        }
+    }
+
+    clear();
+}
+
+//----------------------------------------------------------------
+// clear()
+//----------------------------------------------------------------
+void PlotScalarHistory::clear()
+{
+    for (auto& level : m_levels)
+    {
+        std::fill(level.min.begin(), level.min.end(), 0.0f);
+        std::fill(level.max.begin(), level.max.end(), 0.0f);
+    }
+
+    // Zeroed blocks are valid min/max summaries of all-zero history. Round
+    // up to a top level block boundary so no level starts mid-block.
+    int64_t topBlockSize = (int64_t)1 << (m_levels.size() - 1);
+    m_written = ((m_capacity + topBlockSize - 1) / topBlockSize) * topBlockSize;
+}
+
+//----------------------------------------------------------------
+// append()
+//----------------------------------------------------------------
+void PlotScalarHistory::append(float sample)
+{
+    for (size_t k = 0; k < m_levels.size(); k++)
+    {
+        Level& level = m_levels[k];
+        int64_t block = m_written >> k;
+        size_t slot = block % level.min.size();
+
+        if ((m_written & (((int64_t)1 << k) - 1)) == 0)
+        {
+            // First sample of a new block.
+            level.min[slot] = sample;
+            level.max[slot] = sample;
+        }
+        else
+        {
+            level.min[slot] = std::min(level.min[slot], sample);
+            level.max[slot] = std::max(level.max[slot], sample);
+        }
+    }
+
+    m_written++;
+}
+
+//----------------------------------------------------------------
+// get()
+//----------------------------------------------------------------
+float PlotScalarHistory::get(int numSamples, int index) const
+{
+    assert(numSamples <= m_capacity);
+    assert(index >= 0 && index < numSamples);
+
+    const Level& level = m_levels[0];
+    int64_t pos = m_written - numSamples + index;
+    return level.min[pos % level.min.size()];
+}
+
+//----------------------------------------------------------------
+// getMinMax()
+//----------------------------------------------------------------
+void PlotScalarHistory::getMinMax(int numSamples, int numBins, float* minOut, float* maxOut) const
+{
+    assert(numSamples <= m_capacity);
+    assert(numBins > 0);
+
+    int64_t start = m_written - numSamples;
+    for (int bin = 0; bin < numBins; bin++)
+    {
+        int64_t binStart = start + (int64_t)numSamples * bin / numBins;
+        int64_t binEnd = start + (int64_t)numSamples * (bin + 1) / numBins;
+
+        // Bins narrower than one sample borrow their neighbour's sample.
+        if (binEnd <= binStart)
+        {
+            binEnd = binStart + 1;
+        }
+
+        rangeMinMax_(binStart, binEnd, &minOut[bin], &maxOut[bin]);
+    }
+}
+
+//----------------------------------------------------------------
+// rangeMinMax_()
+//----------------------------------------------------------------
+void PlotScalarHistory::rangeMinMax_(int64_t start, int64_t end, float* minOut, float* maxOut) const
+{
+    float minVal = 0;
+    float maxVal = 0;
+    bool first = true;
+
+    // Greedily take the largest aligned block that fits in what's left.
+    int topLevel = m_levels.size() - 1;
+    while (start < end)
+    {
+        int k = 0;
+        while (k < topLevel && 
+               (start & (((int64_t)2 << k) - 1)) == 0 && 
+               start + ((int64_t)2 << k) <= end)
+        {
+            k++;
+        }
+
+        const Level& level = m_levels[k];
+        size_t slot = (start >> k) % level.min.size();
+        if (first)
+        {
+            minVal = level.min[slot];
+            maxVal = level.max[slot];
+            first = false;
+        }
+        else
+        {
+            minVal = std::min(minVal, level.min[slot]);
+            maxVal = std::max(maxVal, level.max[slot]);
+        }
+
+        start += (int64_t)1 << k;
+    }
+
+    *minOut = minVal;
+    *maxOut = maxVal;
+}
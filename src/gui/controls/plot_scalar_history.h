@@ -0,0 +1,71 @@
+//==========================================================================
+// Name:            plot_scalar_history.h
+// Purpose:         Circular sample store with a min/max pyramid for fast
+//                  decimated drawing of scalar plots.
+// Created:         October 19, 2026
+// Authors:         Mooneer Salem
+// 
+// License:
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//==========================================================================
+#ifndef __FDMDV2_PLOT_SCALAR_HISTORY__
+#define __FDMDV2_PLOT_SCALAR_HISTORY__
+
+#include <vector>
+#include <cstdint>
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
+// Class PlotScalarHistory
+//
+// Keeps the last N samples of one channel in a ring. Level k of the
+// pyramid holds the min/max of each aligned block of 2^k samples, so
+// appending costs O(log N) per sample (no shifting) and the min/max of any
+// range can be found by combining O(log N) blocks.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
+class PlotScalarHistory
+{
+    public:
+        PlotScalarHistory(int capacity);
+
+        int  capacity() const { return m_capacity; }
+
+        void append(float sample);
+        void clear();
+
+        // Sample at position index of the most recent numSamples samples
+        // (0 = oldest). numSamples must not exceed capacity().
+        float get(int numSamples, int index) const;
+
+        // Splits the most recent numSamples samples into numBins equally
+        // sized bins (bin 0 = oldest) and returns the min and max of each.
+        void getMinMax(int numSamples, int numBins, float* minOut, float* maxOut) const;
+
+    private:
+        struct Level
+        {
+            std::vector<float> min;
+            std::vector<float> max;
+        };
+
+        int                 m_capacity;
+        std::vector<Level>  m_levels;
+
+        // Absolute index of the next sample to be written. Starts at
+        // m_capacity so that unwritten history reads back as zero.
+        int64_t             m_written;
+
+        void rangeMinMax_(int64_t start, int64_t end, float* minOut, float* maxOut) const;
+};
+
+#endif // __FDMDV2_PLOT_SCALAR_HISTORY__
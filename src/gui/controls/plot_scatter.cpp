@@ -19,6 +19,9 @@
 //
 //==========================================================================
 #include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 #include <wx/wx.h>
 #include <wx/graphics.h>
@@ -38,15 +41,23 @@ BEGIN_EVENT_TABLE(PlotScatter, PlotPanel)
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
 PlotScatter::PlotScatter(wxWindow* parent) : PlotPanel(parent)
 {
-    clearCurrentSamples();
-
+    m_densityWidth = 0;
+    m_densityHeight = 0;
+    m_densityMode = PLOT_SCATTER_MODE_SCATTER;
+    m_densityNcol = 0;
+    m_densityScale = 0;
+    m_densityValid = false;
+    
     // defaults so we start off with something sensible
 
     Nsym = 14+1;
     scatterMemSyms = ((int)(SCATTER_MEM_SECS*(Nsym/DT)));
     assert(scatterMemSyms <= SCATTER_MEM_SYMS_MAX);
 
+    clearCurrentSamples();
+
     Ncol = 0;
+    m_eyeNext = 0;
     memset(eye_mem, 0, sizeof(eye_mem));
 
     mode = PLOT_SCATTER_MODE_SCATTER;
@@ -54,10 +65,18 @@ PlotScatter::PlotScatter(wxWindow* parent) : PlotPanel(parent)
 
 // changing number of carriers changes number of symbols to plot
 void PlotScatter::setNc(int Nc) {
+    if (Nc == Nsym)
+    {
+        return;
+    }
+    
     Nsym = Nc;
     assert(Nsym <= (MODEM_STATS_NC_MAX+1));
     scatterMemSyms = ((int)(SCATTER_MEM_SECS*(Nsym/DT)));
     assert(scatterMemSyms <= SCATTER_MEM_SYMS_MAX);
+    
+    // The ring length changed, so start it again.
+    clearCurrentSamples();
 }
 
 void PlotScatter::clearCurrentSamples() {
@@ -67,6 +86,8 @@ void PlotScatter::clearCurrentSamples() {
         m_mem[i].real = 0.0;
         m_mem[i].imag = 0.0;
     }
+    m_memNext = 0;
+    m_densityValid = false;
 }
 
 //----------------------------------------------------------------
@@ -74,11 +95,7 @@ void PlotScatter::clearCurrentSamples() {
 //----------------------------------------------------------------
 void PlotScatter::draw(wxGraphicsContext* ctx)
 {
-    float x_scale;
-    float y_scale;
     int   i,j;
-    int   x;
-    int   y;
 
     m_rCtrl = GetClientRect();
     m_rGrid = m_rCtrl;
@@ -91,9 +108,6 @@ void PlotScatter::draw(wxGraphicsContext* ctx)
     ctx->SetPen(wxPen(BLACK_COLOR, 0));
     ctx->DrawRectangle(PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER, m_rGrid.GetWidth(), m_rGrid.GetHeight());
  
-    wxPen pen;
-    pen.SetWidth(1); // note this is ignored by DrawPoint
-
     if (mode == PLOT_SCATTER_MODE_SCATTER) {
 
         // automatically scale, first measure the maximum magnitude, in other words
@@ -127,38 +141,16 @@ void PlotScatter::draw(wxGraphicsContext* ctx)
 
         float quant_m_filter_max_xy = exp(floor(0.5+log(m_filter_max_xy)));
 
-        x_scale = (float)m_rGrid.GetWidth()/quant_m_filter_max_xy;
-        y_scale = (float)m_rGrid.GetHeight()/quant_m_filter_max_xy;
-
-        // draw all samples
-
-        for(i = 0; i < scatterMemSyms; i++) {
-            x = x_scale * m_mem[i].real + m_rGrid.GetWidth()/2;
-            y = y_scale * m_mem[i].imag + m_rGrid.GetHeight()/2;
-            x += PLOT_BORDER + XLEFT_OFFSET;
-            y += PLOT_BORDER;
-            
-            if (pointsInBounds_(x, y))
-            {
-                pen.SetColour(DARK_GREEN_COLOR);
-                ctx->SetPen(pen);
-                wxGraphicsPath path = ctx->CreatePath();
-                path.AddCircle(x, y, 1);
-                // Uncomment to show boundaries of plot:
-                // path.AddCircle(PLOT_BORDER+XLEFT_OFFSET, PLOT_BORDER, 2); 
-                // path.AddCircle(m_rGrid.GetWidth()+PLOT_BORDER+XLEFT_OFFSET, m_rGrid.GetHeight()+PLOT_BORDER, 2);
-                ctx->DrawPath(path);
-            }
+        if (!m_densityValid || m_densityMode != mode || m_densityScale != quant_m_filter_max_xy ||
+            m_densityWidth != m_rGrid.GetWidth() || m_densityHeight != m_rGrid.GetHeight())
+        {
+            m_densityMode = mode;
+            rebuildDensity_(m_rGrid.GetWidth(), m_rGrid.GetHeight(), quant_m_filter_max_xy);
         }
     }
 
     if (mode == PLOT_SCATTER_MODE_EYE) {
 
-        // The same color will be used for all eye traces
-        pen.SetColour(DARK_GREEN_COLOR);
-        pen.SetWidth(1);
-        ctx->SetPen(pen);
-
         // automatically scale, first measure the maximum Y value
 
         float max_y = 1E-12;
@@ -186,34 +178,16 @@ void PlotScatter::draw(wxGraphicsContext* ctx)
         float quant_m_filter_max_y = exp(floor(0.5+log(m_filter_max_y)));
         //printf("min_y: %4.3f max_y: %4.3f quant_m_filter_max_y: %4.3f\n", min_y, max_y, quant_m_filter_max_y);
 
-        x_scale = (float)m_rGrid.GetWidth()/Ncol;
-        y_scale = (float)m_rGrid.GetHeight()/quant_m_filter_max_y;
-        //printf("GetWidth(): %d GetHeight(): %d\n", m_rGrid.GetWidth(), m_rGrid.GetHeight());
-
-        // plot eye traces row by row
-
-        int prev_x, prev_y;
-        prev_x = prev_y = 0;
-        for(i=0; i<SCATTER_EYE_MEM_ROWS; i++) {
-            //printf("row: ");
-            for(j=0; j<Ncol; j++) {
-                x = x_scale * j;
-                y = m_rGrid.GetHeight()*0.75 - y_scale * eye_mem[i][j];
-               //printf("%4d,%4d  ", x, y);
-                x += PLOT_BORDER + XLEFT_OFFSET;
-                y += PLOT_BORDER;
-                
-                if (pointsInBounds_(x,y) && pointsInBounds_(prev_x, prev_y))
-                {
-                    if (j)
-                        ctx->StrokeLine(x, y, prev_x, prev_y);
-                }
-                prev_x = x; prev_y = y;
-            }
-            //printf("\n");
+        if (!m_densityValid || m_densityMode != mode || m_densityScale != quant_m_filter_max_y ||
+            m_densityNcol != Ncol ||
+            m_densityWidth != m_rGrid.GetWidth() || m_densityHeight != m_rGrid.GetHeight())
+        {
+            m_densityMode = mode;
+            rebuildDensity_(m_rGrid.GetWidth(), m_rGrid.GetHeight(), quant_m_filter_max_y);
         }
-        
     }
+    
+    drawDensity_(ctx);
 }
 
 //----------------------------------------------------------------
@@ -221,19 +195,19 @@ void PlotScatter::draw(wxGraphicsContext* ctx)
 //----------------------------------------------------------------
 void PlotScatter::add_new_samples_scatter(COMP samples[])
 {
-    int i,j;
-
-    // shift memory
-
-    for(i = 0; i < scatterMemSyms - Nsym; i++)
-    {
-        m_mem[i] = m_mem[i+Nsym];
-    }
+    bool updateDensity = m_densityValid && m_densityMode == PLOT_SCATTER_MODE_SCATTER;
     
-    // new samples
-    for(j=0; i < scatterMemSyms; i++,j++)
+    // overwrite the oldest Nsym symbols
+    for(int j = 0; j < Nsym; j++)
     {
-        m_mem[i] = samples[j];
+        if (updateDensity)
+        {
+            addScatterDensity_(m_mem[m_memNext], -1);
+            addScatterDensity_(samples[j], 1);
+        }
+        
+        m_mem[m_memNext] = samples[j];
+        m_memNext = (m_memNext + 1) % scatterMemSyms;
     }
 }
 
@@ -241,25 +215,166 @@ void PlotScatter::add_new_samples_scatter(COMP samples[])
 
 void PlotScatter::add_new_samples_eye(float samples[], int n)
 {
-    int i,j;
+    int j;
 
     Ncol = n; /* this should be constant for a given modem config */
 
     assert(n <= PLOT_SCATTER_EYE_MAX_SAMPLES_ROW);
 
-    // eye traces are arrnaged in rows, shift memory of traces
+    // eye traces are arranged in rows, overwrite the oldest one
+
+    bool updateDensity = m_densityValid && m_densityMode == PLOT_SCATTER_MODE_EYE && m_densityNcol == Ncol;
+    if (updateDensity)
+    {
+        addEyeDensity_(eye_mem[m_eyeNext], -1);
+        addEyeDensity_(samples, 1);
+    }
+
+    for(j=0; j<Ncol; j++) {
+        eye_mem[m_eyeNext][j] = samples[j];
+    }
+    m_eyeNext = (m_eyeNext + 1) % SCATTER_EYE_MEM_ROWS;
+}
 
-    for(i=0; i<SCATTER_EYE_MEM_ROWS-1; i++) {
-        for(j=0; j<Ncol; j++) {
-            eye_mem[i][j] = eye_mem[i+1][j];
+//----------------------------------------------------------------
+// rebuildDensity_()
+//----------------------------------------------------------------
+void PlotScatter::rebuildDensity_(int width, int height, float scale)
+{
+    m_densityWidth = std::max(width, 1);
+    m_densityHeight = std::max(height, 1);
+    m_densityScale = scale;
+    m_densityNcol = Ncol;
+    m_density.assign(m_densityWidth * m_densityHeight, 0);
+    
+    if (m_densityMode == PLOT_SCATTER_MODE_SCATTER)
+    {
+        for (int i = 0; i < scatterMemSyms; i++)
+        {
+            addScatterDensity_(m_mem[i], 1);
         }
     }
+    else
+    {
+        for (int i = 0; i < SCATTER_EYE_MEM_ROWS; i++)
+        {
+            addEyeDensity_(eye_mem[i], 1);
+        }
+    }
+    
+    m_densityValid = true;
+}
 
-    // new samples in last row
+//----------------------------------------------------------------
+// addDensity_()
+//----------------------------------------------------------------
+void PlotScatter::addDensity_(int x, int y, int delta)
+{
+    if (x >= 0 && x < m_densityWidth && y >= 0 && y < m_densityHeight)
+    {
+        m_density[y * m_densityWidth + x] += delta;
+    }
+}
 
-    for(j=0; j<Ncol; j++) {
-        eye_mem[SCATTER_EYE_MEM_ROWS-1][j] = samples[j];
+//----------------------------------------------------------------
+// addScatterDensity_()
+//----------------------------------------------------------------
+void PlotScatter::addScatterDensity_(COMP sample, int delta)
+{
+    float x_scale = (float)m_densityWidth/m_densityScale;
+    float y_scale = (float)m_densityHeight/m_densityScale;
+    int x = x_scale * sample.real + m_densityWidth/2;
+    int y = y_scale * sample.imag + m_densityHeight/2;
+    
+    // Small cross, roughly the size of the circles we used to draw.
+    addDensity_(x, y, delta);
+    addDensity_(x - 1, y, delta);
+    addDensity_(x + 1, y, delta);
+    addDensity_(x, y - 1, delta);
+    addDensity_(x, y + 1, delta);
+}
+
+//----------------------------------------------------------------
+// addEyeDensity_()
+//----------------------------------------------------------------
+void PlotScatter::addEyeDensity_(const float* row, int delta)
+{
+    if (m_densityNcol <= 0)
+    {
+        return;
+    }
+    
+    float x_scale = (float)m_densityWidth/m_densityNcol;
+    float y_scale = (float)m_densityHeight/m_densityScale;
+    
+    int prev_x = 0;
+    int prev_y = 0;
+    for (int j = 0; j < m_densityNcol; j++)
+    {
+        int x = x_scale * j;
+        int y = m_densityHeight*0.75 - y_scale * row[j];
+        
+        if (j)
+        {
+            // Walk the segment one pixel at a time. The end point is left
+            // to the next segment so shared points are only counted once.
+            int dx = x - prev_x;
+            int dy = y - prev_y;
+            int steps = std::max(abs(dx), abs(dy));
+            for (int k = 0; k < steps; k++)
+            {
+                addDensity_(prev_x + dx * k / steps, prev_y + dy * k / steps, delta);
+            }
+        }
+        prev_x = x; prev_y = y;
     }
+    addDensity_(prev_x, prev_y, delta);
+}
+
+//----------------------------------------------------------------
+// drawDensity_()
+//----------------------------------------------------------------
+void PlotScatter::drawDensity_(wxGraphicsContext* ctx)
+{
+    if (!m_densityValid)
+    {
+        return;
+    }
+    
+    if (!m_densityImage.IsOk() || m_densityImage.GetWidth() != m_densityWidth || m_densityImage.GetHeight() != m_densityHeight)
+    {
+        m_densityImage.Create(m_densityWidth, m_densityHeight, false);
+    }
+    
+    unsigned maxCount = 1;
+    for (auto count : m_density)
+    {
+        maxCount = std::max(maxCount, count);
+    }
+    
+    // Brightness follows log(hits) so single hits stay visible next to
+    // heavily used constellation points.
+    wxColour colour = DARK_GREEN_COLOR;
+    float invLogMax = 1.0 / log1p((float)maxCount);
+    unsigned char* out = m_densityImage.GetData();
+    for (auto count : m_density)
+    {
+        if (count == 0)
+        {
+            out[0] = out[1] = out[2] = 0;
+        }
+        else
+        {
+            float level = 0.4 + 0.6 * log1p((float)count) * invLogMax;
+            out[0] = colour.Red() * level;
+            out[1] = colour.Green() * level;
+            out[2] = colour.Blue() * level;
+        }
+        out += 3;
+    }
+    
+    wxGraphicsBitmap bmp = ctx->CreateBitmapFromImage(m_densityImage);
+    ctx->DrawBitmap(bmp, PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER, m_densityWidth, m_densityHeight);
 }
 
 //----------------------------------------------------------------
@@ -276,19 +391,3 @@ void PlotScatter::OnSize(wxSizeEvent& event)
 void PlotScatter::OnShow(wxShowEvent& event)
 {
 }
-
-/*----------------------------------------------------------------
-  Ensure that points stay within the bounding box:
-    upper LH bounding point (PLOT_BORDER+XLEFT_OFFSET, PLOT_BORDER)
-    lower RH bounding point (PLOT_BORDER+XLEFT_OFFSET + GetWidth(), PLOT_BORDER + GetHeight())
-----------------------------------------------------------------*/
-bool PlotScatter::pointsInBounds_(int x, int y)
-{
-    bool inBounds;
-    inBounds = x >= PLOT_BORDER + XLEFT_OFFSET;
-    inBounds = inBounds && x <= PLOT_BORDER + XLEFT_OFFSET + m_rGrid.GetWidth();
-    inBounds = inBounds && y >= PLOT_BORDER;
-    inBounds = inBounds && y <= PLOT_BORDER + m_rGrid.GetHeight();
-    
-    return inBounds;
-}
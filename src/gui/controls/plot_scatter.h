@@ -21,6 +21,7 @@
 #ifndef __FDMDV2_PLOT_SCATTER__
 #define __FDMDV2_PLOT_SCATTER__
 
+#include <vector>
 #include <wx/graphics.h>
 
 #include "comp.h"
@@ -47,6 +48,9 @@ class PlotScatter : public PlotPanel
 
     protected:
         int  mode;
+
+        // Ring buffers of the most recent symbols/eye traces. The oldest
+        // entry is the one about to be overwritten (m_memNext, m_eyeNext).
         COMP m_mem[SCATTER_MEM_SYMS_MAX];
         COMP m_new_samples[MODEM_STATS_NC_MAX+1];
         float eye_mem[SCATTER_EYE_MEM_ROWS][PLOT_SCATTER_EYE_MAX_SAMPLES_ROW];
@@ -61,9 +65,28 @@ class PlotScatter : public PlotPanel
         int   Nsym;
         int   Ncol;
         int   scatterMemSyms;
+        int   m_memNext;
+        int   m_eyeNext;
         float m_filter_max_xy, m_filter_max_y;
 
-        bool pointsInBounds_(int x, int y);
+        // Per-pixel hit counts of everything currently in the active ring,
+        // updated as entries are added and overwritten and only rebuilt
+        // when the plot size, mode or (quantised) scaling changes. Drawing
+        // is then a single image, however many symbols are retained.
+        std::vector<unsigned> m_density;
+        int   m_densityWidth;
+        int   m_densityHeight;
+        int   m_densityMode;
+        int   m_densityNcol;
+        float m_densityScale;
+        bool  m_densityValid;
+        wxImage m_densityImage;
+
+        void rebuildDensity_(int width, int height, float scale);
+        void addDensity_(int x, int y, int delta);
+        void addScatterDensity_(COMP sample, int delta);
+        void addEyeDensity_(const float* row, int delta);
+        void drawDensity_(wxGraphicsContext* ctx);
 };
 
 #endif //__FDMDV2_PLOT_SCATTER__
@@ -93,6 +93,35 @@ PlotSpectrum::~PlotSpectrum()
     m_nextPrevMagDB = nullptr;
 }
 
+//----------------------------------------------------------------
+// setSpectrum()
+//----------------------------------------------------------------
+void PlotSpectrum::setSpectrum(float *magdB, int n_magdB)
+{
+    m_magdB = magdB;
+    
+    if (n_magdB != m_n_magdB)
+    {
+        // Averaging history is for the old bin layout, so just start again.
+        delete[] m_prevMagDB;
+        delete[] m_nextPrevMagDB;
+        
+        m_prevMagDB = new float[n_magdB];
+        assert(m_prevMagDB != nullptr);
+        
+        m_nextPrevMagDB = new float[n_magdB];
+        assert(m_nextPrevMagDB != nullptr);
+        
+        for (int index = 0; index < n_magdB; index++)
+        {
+            m_prevMagDB[index] = magdB[index];
+            m_nextPrevMagDB[index] = magdB[index];
+        }
+        
+        m_n_magdB = n_magdB;
+    }
+}
+
 //----------------------------------------------------------------
 // OnSize()
 //----------------------------------------------------------------
@@ -121,30 +150,31 @@ void PlotSpectrum::draw(wxGraphicsContext* ctx)
     m_rGrid  = m_rCtrl;
     m_rGrid = m_rGrid.Deflate(PLOT_BORDER + (XLEFT_OFFSET/2), (PLOT_BORDER + (YBOTTOM_OFFSET/2)));
 
-    // black background
-
-    wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
-    ctx->SetBrush(ltGraphBkgBrush);
-    ctx->SetPen(wxPen(BLACK_COLOR, 0));
-    ctx->DrawRectangle(PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER, m_rGrid.GetWidth(), m_rGrid.GetHeight());
+    bool software = IsSoftwareRendering();
+    if (software)
+    {
+        beginRaster();
+        m_raster.setClip(PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER, m_rGrid.GetWidth() + 1, m_rGrid.GetHeight() + 1);
+    }
+    else
+    {
+        drawBackground_(ctx);
+    }
 
     // draw spectrum
 
-    int   x, y, prev_x, prev_y, index;
+    int   x, y, index;
     float index_to_px, mag_dB_to_py, mag;
 
     m_newdata = false;
 
-    wxPen pen;
-    pen.SetColour(DARK_GREEN_COLOR);
-    pen.SetWidth(1);
-    ctx->SetPen(pen);
-
     index_to_px = (float)m_rGrid.GetWidth()/m_n_magdB;
     mag_dB_to_py = (float)m_rGrid.GetHeight()/(m_max_mag_db - m_min_mag_db);
 
-    prev_x = PLOT_BORDER + XLEFT_OFFSET;
-    prev_y = PLOT_BORDER;
+    // One polyline for the whole trace, there can be thousands of bins at
+    // larger FFT sizes.
+    m_trace.clear();
+    
     for(index = 0; index < m_n_magdB; index++)
     {
         x = index*index_to_px;
@@ -175,15 +205,43 @@ void PlotSpectrum::draw(wxGraphicsContext* ctx)
         x += PLOT_BORDER + XLEFT_OFFSET;
         y += PLOT_BORDER;
 
-        if (index)
-            ctx->StrokeLine(x, y, prev_x, prev_y);
-        prev_x = x; prev_y = y;
+        m_trace.push_back({x, y, index == 0});
     }
+    strokeTrace(ctx, DARK_GREEN_COLOR);
 
     // and finally draw Graticule
 
-    drawGraticule(ctx);
+    if (software)
+        endRaster(ctx);
+    else
+        drawGraticule(ctx);
 
+    drawRxTuning_(ctx);
+}
+
+//-------------------------------------------------------------------------
+// drawBackground_()
+//-------------------------------------------------------------------------
+void PlotSpectrum::drawBackground_(wxGraphicsContext* ctx)
+{
+    // black background
+
+    wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
+    ctx->SetBrush(ltGraphBkgBrush);
+    ctx->SetPen(wxPen(BLACK_COLOR, 0));
+    ctx->DrawRectangle(PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER, m_rGrid.GetWidth(), m_rGrid.GetHeight());
+}
+
+//-------------------------------------------------------------------------
+// drawRasterLayer()
+//
+// With software rendering the graticule goes underneath the trace rather
+// than on top. The tuning lines move, so they're always drawn separately.
+//-------------------------------------------------------------------------
+void PlotSpectrum::drawRasterLayer(wxGraphicsContext* ctx)
+{
+    drawBackground_(ctx);
+    drawGraticule(ctx);
 }
 
 //-------------------------------------------------------------------------
@@ -264,6 +322,16 @@ void PlotSpectrum::drawGraticule(wxGraphicsContext* ctx)
             ctx->DrawText(buf, PLOT_BORDER + XLEFT_OFFSET - text_w - XLEFT_TEXT_OFFSET, y-text_h/2);
     }
 
+}
+
+//-------------------------------------------------------------------------
+// drawRxTuning_()
+//-------------------------------------------------------------------------
+void PlotSpectrum::drawRxTuning_(wxGraphicsContext* ctx)
+{
+    int   x;
+    float freq_hz_to_px = (float)m_rGrid.GetWidth()/(MAX_F_HZ-MIN_F_HZ);
+
     // red rx tuning line
     
     if (m_rxFreq != 0.0) {
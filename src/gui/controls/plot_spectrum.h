@@ -35,15 +35,30 @@ class PlotSpectrum : public PlotPanel
     PlotSpectrum(wxWindow* parent, float *magdB, int n_magdB, 
                  float min_mag_db=MIN_MAG_DB, float max_mag_db=MAX_MAG_DB, bool clickTune=true);
         ~PlotSpectrum();
-        void setRxFreq(float rxFreq) { m_rxFreq = rxFreq; }
-        void setFreqScale(int n_magdB) { m_n_magdB = n_magdB; }
+        void setRxFreq(float rxFreq) 
+        { 
+            if (rxFreq != m_rxFreq) 
+            {
+                m_rxFreq = rxFreq;
+                markDirty();
+            }
+        }
+        void setSpectrum(float *magdB, int n_magdB);
 
-        void setNumAveraging(int n) { m_numSampleAveraging = n; }
+        void setNumAveraging(int n) 
+        { 
+            if (n != m_numSampleAveraging)
+            {
+                m_numSampleAveraging = n;
+                markDirty();
+            }
+        }
         
     protected:
         void        OnSize(wxSizeEvent& event);
         void        OnShow(wxShowEvent& event);
         void        drawGraticule(wxGraphicsContext* ctx);
+        void        drawRasterLayer(wxGraphicsContext* ctx);
         void        draw(wxGraphicsContext* ctx);
         void        OnMouseLeftDoubleClick(wxMouseEvent& event);
         void        OnMouseRightDoubleClick(wxMouseEvent& event);
@@ -63,6 +78,8 @@ class PlotSpectrum : public PlotPanel
         int         m_numSampleAveraging;
 
         void        OnDoubleClickCommon(wxMouseEvent& event);
+        void        drawBackground_(wxGraphicsContext* ctx);
+        void        drawRxTuning_(wxGraphicsContext* ctx);
         
         DECLARE_EVENT_TABLE()
 };
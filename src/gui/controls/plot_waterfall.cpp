@@ -22,15 +22,16 @@
 #include <algorithm>
 
 #include <wx/wx.h>
+#include <wx/time.h>
 #include "os/os_interface.h"
 
 #include "plot_waterfall.h"
+#include "util/WaterfallColourMap.h"
 #include "codec2_fdmdv.h" // for FDMDV_FCENTRE
 
 // Tweak accordingly
 #define Y_PER_SECOND (30) 
 
-extern float g_avmag[];                 // av mag spec passed in to draw() 
 extern float           g_RxFreqOffsetHz;
 void clickTune(float frequency); // callback to pass new click freq
 
@@ -59,11 +60,6 @@ END_EVENT_TABLE()
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
 PlotWaterfall::PlotWaterfall(wxWindow* parent, bool graticule, int colour): PlotPanel(parent)
 {
-
-    for(int i = 0; i < 255; i++)
-    {
-        m_heatmap_lut[i] = heatmap((float)i, 0.0, 255.0);
-    }
     m_graticule     = graticule;
     m_colour        = colour;
     m_Bufsz         = GetMaxClientSize();
@@ -76,7 +72,16 @@ PlotWaterfall::PlotWaterfall(wxWindow* parent, bool graticule, int colour): Plot
 
     m_max_mag = MAX_MAG_DB;
     m_min_mag = MIN_MAG_DB;
-    m_fullBmp = NULL;
+    m_writeRow = 0;
+    m_imgHeight = 0;
+    m_imgWidth = 0;
+    m_ringRowsPending = 0;
+    m_columnBinRowWidth = 0;
+    m_magdB = nullptr;
+    m_n_magdB = 0;
+    m_scrollback = false;
+    m_scrollbackNewestRow = 0;
+    m_historyImageDirty = false;
     sync_ = false;
 }
 
@@ -84,10 +89,17 @@ PlotWaterfall::PlotWaterfall(wxWindow* parent, bool graticule, int colour): Plot
 // we plot in and allocate a bit map of the correct size
 void PlotWaterfall::OnSize(wxSizeEvent& event) 
 {
-    delete m_fullBmp;
+    resizeRing();
+    m_dT = DT;
     
-    // resize bit map
+    event.Skip();
+}
 
+//----------------------------------------------------------------
+// resizeRing()
+//----------------------------------------------------------------
+void PlotWaterfall::resizeRing()
+{
     m_rCtrl  = GetClientRect();
 
     // m_rGrid is coords of inner window we actually plot to.  We deflate it a bit
@@ -96,78 +108,142 @@ void PlotWaterfall::OnSize(wxSizeEvent& event)
     m_rGrid  = m_rCtrl;
     m_rGrid = m_rGrid.Deflate(PLOT_BORDER + (XLEFT_OFFSET/2), (PLOT_BORDER + (YBOTTOM_OFFSET/2)));
 
-    // we want a bit map the size of m_rGrid
+    // we want an image the size of m_rGrid, this is the only place the
+    // row storage is (re)allocated. wxImage starts out black.
 
     m_imgHeight = std::max(1,m_rGrid.GetHeight());
     m_imgWidth = std::max(1,m_rGrid.GetWidth());
-    m_fullBmp = new wxBitmap(m_imgWidth, m_imgHeight);
-
-    // Reset bitmap to black.   
-    {
-        wxMemoryDC dc(*m_fullBmp);
-        wxGraphicsContext *gc = wxGraphicsContext::Create( dc );
-        
-        wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
-        gc->SetBrush(ltGraphBkgBrush);
-        gc->SetPen(wxPen(BLACK_COLOR, 0));
-        gc->DrawRectangle(0, 0, m_imgWidth, m_imgHeight);  // DC waterfall bitmap starts at origin and spans full width
-        delete gc;
-    }
-
-    m_dT = DT;
+    m_ringImage.Create(m_imgWidth, m_imgHeight, true);
+    m_writeRow = 0;
+    m_ringBitmap = wxNullBitmap;
+    m_ringRowsPending = 0;
     
-    event.Skip();
+    m_columnBin.resize(m_imgWidth);
+    m_columnBinRowWidth = 0;
+    
+    m_historyImageDirty = true;
 }
 
 //----------------------------------------------------------------
-// OnShow()
+// setSpectrum()
 //----------------------------------------------------------------
-void PlotWaterfall::OnShow(wxShowEvent& event)
+void PlotWaterfall::setSpectrum(const float* magdB, int n_magdB)
 {
+    m_magdB = magdB;
+    m_n_magdB = n_magdB;
+    
+    if (m_history)
+    {
+        m_history->append(wxGetUTCTimeMillis().GetValue(), magdB, n_magdB, m_modem_stats_max_f_hz);
+    }
 }
 
 //----------------------------------------------------------------
-// ~PlotWaterfall()
+// enableHistory()
 //----------------------------------------------------------------
-PlotWaterfall::~PlotWaterfall()
+void PlotWaterfall::enableHistory(int maxRows, const std::string& spillFile)
 {
-    delete m_fullBmp;
+    m_scrollback = false;
+    m_history.reset();
+    
+    if (maxRows > 0)
+    {
+        m_history.reset(new WaterfallHistory(
+            WATERFALL_HISTORY_BINS, MAX_F_HZ, maxRows, WATERFALL_HISTORY_ROW_SECS * 1000, spillFile));
+    }
 }
 
 //----------------------------------------------------------------
-// heatmap()
-// map val to a rgb colour
-// from http://eddiema.ca/2011/01/21/c-sharp-heatmaps/
+// scrollHistory()
 //----------------------------------------------------------------
-unsigned PlotWaterfall::heatmap(float val, float min, float max)
+void PlotWaterfall::scrollHistory(int rows)
 {
-    unsigned r = 0;
-    unsigned g = 0;
-    unsigned b = 0;
-
-    val = (val - min) / (max - min);
-    if(val <= 0.2)
+    if (!m_history || m_history->numRows() == 0)
+    {
+        return;
+    }
+    
+    // Positive = further back in time.
+    uint64_t newest = m_history->numRowsWritten() - 1;
+    uint64_t oldest = m_history->numRowsWritten() - m_history->numRows();
+    int64_t pos = (int64_t)(m_scrollback ? m_scrollbackNewestRow : newest) - rows;
+    
+    if (pos >= (int64_t)newest)
+    {
+        // Scrolled forward past the end, back to the live view.
+        m_scrollback = false;
+    }
+    else
     {
-        b = (unsigned)((val / 0.2) * 255);
+        m_scrollback = true;
+        m_scrollbackNewestRow = std::max(pos, (int64_t)oldest);
+        m_historyImageDirty = true;
     }
-    else if(val >  0.2 &&  val <= 0.7)
+    
+    Refresh();
+}
+
+//----------------------------------------------------------------
+// renderHistory()
+//----------------------------------------------------------------
+void PlotWaterfall::renderHistory()
+{
+    if (!m_historyImage.IsOk() || m_historyImage.GetWidth() != m_imgWidth || m_historyImage.GetHeight() != m_imgHeight)
     {
-        b = (unsigned)((1.0 - ((val - 0.2) / 0.5)) * 255);
+        m_historyImage.Create(m_imgWidth, m_imgHeight, true);
     }
-    if(val >= 0.2 &&  val <= 0.6)
+    
+    // Map stored values straight to RGB using the current contrast.
+    const unsigned char (*lut)[3] = WaterfallColourMap(m_colour);
+    float intensity_per_dB = (float)256 / (m_max_mag - m_min_mag);
+    unsigned char rgb[256][3];
+    for (int q = 0; q < 256; q++)
     {
-        g = (unsigned)(((val - 0.2) / 0.4) * 255);
+        float val = intensity_per_dB * (WaterfallHistory::dequantize(q) - m_min_mag);
+        val = std::min(std::max(val, 0.0f), 255.0f);
+        memcpy(rgb[q], lut[(int)val], 3);
     }
-    else if(val >  0.6 &&  val <= 0.9)
+    
+    std::vector<int> columnBin(m_imgWidth);
+    for (int col = 0; col < m_imgWidth; col++)
     {
-        g = (unsigned)((1.0 - ((val - 0.6) / 0.3)) * 255);
+        columnBin[col] = (long)col * m_history->numBins() / m_imgWidth;
     }
-    if(val >= 0.5)
+    
+    int newestAge = m_history->numRowsWritten() - 1 - m_scrollbackNewestRow;
+    unsigned char* imgData = m_historyImage.GetData();
+    for (int y = 0; y < m_imgHeight; y++)
     {
-        r = (unsigned)(((val - 0.5) / 0.5) * 255);
+        unsigned char* out = imgData + y * 3 * m_imgWidth;
+        const uint8_t* row = m_history->getRow(newestAge + y, nullptr);
+        if (row == nullptr)
+        {
+            memset(out, 0, 3 * m_imgWidth * (m_imgHeight - y));
+            break;
+        }
+        
+        for (int col = 0; col < m_imgWidth; col++)
+        {
+            memcpy(out + 3 * col, rgb[row[columnBin[col]]], 3);
+        }
     }
-    //printf("%f %x %x %x\n", val, r, g, b);
-    return  (b << 16) + (g << 8) + r;
+    
+    m_historyBitmap = wxBitmap(m_historyImage);
+    m_historyImageDirty = false;
+}
+
+//----------------------------------------------------------------
+// OnShow()
+//----------------------------------------------------------------
+void PlotWaterfall::OnShow(wxShowEvent& event)
+{
+}
+
+//----------------------------------------------------------------
+// ~PlotWaterfall()
+//----------------------------------------------------------------
+PlotWaterfall::~PlotWaterfall()
+{
 }
 
 bool PlotWaterfall::checkDT(void)
@@ -189,9 +265,45 @@ bool PlotWaterfall::checkDT(void)
 }
 
 //----------------------------------------------------------------
-// draw()
+// updateRingBitmap()
 //----------------------------------------------------------------
-void PlotWaterfall::draw(wxGraphicsContext* gc)
+void PlotWaterfall::updateRingBitmap()
+{
+    if (!m_ringBitmap.IsOk())
+    {
+        m_ringBitmap = wxBitmap(m_ringImage);
+        m_ringRowsPending = 0;
+        return;
+    }
+    if (m_ringRowsPending == 0)
+    {
+        return;
+    }
+    
+    // The new rows are m_writeRow onwards (newest first), wrapping at most
+    // once.
+    wxMemoryDC memDC(m_ringBitmap);
+    int row = m_writeRow;
+    int remaining = m_ringRowsPending;
+    while (remaining > 0)
+    {
+        int numRows = std::min(remaining, m_imgHeight - row);
+        
+        // static_data: the image just borrows the ring's rows.
+        wxImage rows(m_imgWidth, numRows, m_ringImage.GetData() + 3 * m_imgWidth * row, true);
+        memDC.DrawBitmap(wxBitmap(rows), 0, row);
+        
+        remaining -= numRows;
+        row = (row + numRows) % m_imgHeight;
+    }
+    memDC.SelectObject(wxNullBitmap);
+    m_ringRowsPending = 0;
+}
+
+//----------------------------------------------------------------
+// drawBitmaps()
+//----------------------------------------------------------------
+void PlotWaterfall::drawBitmaps(wxDC& dc)
 {
     m_rCtrl  = GetClientRect();
 
@@ -201,26 +313,9 @@ void PlotWaterfall::draw(wxGraphicsContext* gc)
     m_rGrid = m_rCtrl;
     m_rGrid = m_rGrid.Deflate(PLOT_BORDER + (XLEFT_OFFSET/2), (PLOT_BORDER + (YBOTTOM_OFFSET/2)));
 
-    // we want a bit map the size of m_rGrid
-    wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
-    if (m_fullBmp == NULL) 
+    if (!m_ringImage.IsOk()) 
     {
-        // we want a bit map the size of m_rGrid
-        m_imgHeight = m_rGrid.GetHeight();
-        m_imgWidth = m_rGrid.GetWidth();
-        m_fullBmp = new wxBitmap(m_imgWidth, m_imgHeight);
-        
-        // Reset bitmap to black.   
-        {
-            wxMemoryDC dc(*m_fullBmp);
-            wxGraphicsContext *mGc = wxGraphicsContext::Create( dc );
-        
-            wxBrush ltGraphBkgBrush = wxBrush(BLACK_COLOR);
-            mGc->SetBrush(ltGraphBkgBrush);
-            mGc->SetPen(wxPen(BLACK_COLOR, 0));
-            mGc->DrawRectangle(0, 0, m_imgWidth, m_imgHeight); // DC waterfall bitmap starts at origin and spans full width
-            delete mGc;
-        }
+        resizeRing();
     }
 
     if(m_newdata)
@@ -228,11 +323,42 @@ void PlotWaterfall::draw(wxGraphicsContext* gc)
         m_newdata = false;
         plotPixelData();
     } 
-           
-    wxGraphicsBitmap tmpBmp = gc->CreateBitmap(*m_fullBmp);
-    gc->DrawBitmap(tmpBmp, PLOT_BORDER + XLEFT_OFFSET, PLOT_BORDER + YBOTTOM_OFFSET, m_imgWidth, m_imgHeight);
+    
+    int x0 = PLOT_BORDER + XLEFT_OFFSET;
+    int y0 = PLOT_BORDER + YBOTTOM_OFFSET;
     m_dT = DT;
+    
+    if (m_scrollback)
+    {
+        if (m_historyImageDirty)
+        {
+            renderHistory();
+        }
+        
+        dc.DrawBitmap(m_historyBitmap, x0, y0);
+        return;
+    }
+    
+    updateRingBitmap();
+    
+    // Newest rows are at m_writeRow, so the ring is blitted as two slices
+    // rather than being scrolled in place on every update.
+    int topRows = m_imgHeight - m_writeRow;
+    wxMemoryDC memDC(m_ringBitmap);
+    dc.Blit(x0, y0, m_imgWidth, topRows, &memDC, 0, m_writeRow);
+    if (m_writeRow > 0)
+    {
+        dc.Blit(x0, y0 + topRows, m_imgWidth, m_writeRow, &memDC, 0, 0);
+    }
+    memDC.SelectObject(wxNullBitmap);
+}
 
+//----------------------------------------------------------------
+// draw()
+//----------------------------------------------------------------
+void PlotWaterfall::draw(wxGraphicsContext* gc)
+{
+    // The spectrum itself was blitted by drawBitmaps().
     drawGraticule(gc);
 }
 
@@ -306,7 +432,23 @@ void PlotWaterfall::drawGraticule(wxGraphicsContext* ctx)
         if (m_graticule)
             ctx->StrokeLine(PLOT_BORDER + XLEFT_OFFSET, y, 
                         (m_rGrid.GetWidth() + PLOT_BORDER + XLEFT_OFFSET), y);
-        snprintf(buf, STR_LENGTH, "%3.0fs", time);
+        if (m_scrollback)
+        {
+            // Label with the wall clock time of the row at this height.
+            int64_t timestampMs = 0;
+            int age = m_history->numRowsWritten() - 1 - m_scrollbackNewestRow;
+            age += std::max(0, y - (PLOT_BORDER + YBOTTOM_OFFSET));
+            if (m_history->getRow(age, &timestampMs) == nullptr)
+            {
+                continue;
+            }
+            wxString timeStr = wxDateTime((time_t)(timestampMs / 1000)).Format("%H:%M");
+            snprintf(buf, STR_LENGTH, "%s", (const char*)timeStr.ToUTF8());
+        }
+        else
+        {
+            snprintf(buf, STR_LENGTH, "%3.0fs", time);
+        }
 	    GetTextExtent(buf, &text_w, &text_h);
         if (!overlappedText)
             ctx->DrawText(buf, PLOT_BORDER + XLEFT_OFFSET - text_w - XLEFT_TEXT_OFFSET, y-text_h/2);
@@ -341,22 +483,26 @@ void PlotWaterfall::plotPixelData()
 {
     float       intensity_per_dB;
     float       px_per_sec;
-    int         index;
     int         dy;
     int         px;
-    int         intensity;
 
     /*
       Design Notes:
 
       The height in pixels represents WATERFALL_SECS_Y of data.  Every DT
-      seconds we get a vector of MODEM_STATS_NSPEC spectrum samples which we use
+      seconds we get a vector of m_n_magdB spectrum samples which we use
       to update the last row.  The height of each row is dy pixels, which
       maps to DT seconds.  We call each dy high rectangle of pixels a
       block.
 
     */
 
+    if (m_magdB == nullptr || m_n_magdB == 0)
+    {
+        // No spectrum computed yet.
+        return;
+    }
+    
     // determine dy, the height of one "block"
     px_per_sec = Y_PER_SECOND;
     dy = m_dT * px_per_sec;
@@ -364,14 +510,14 @@ void PlotWaterfall::plotPixelData()
     // update min and max amplitude estimates
     float max_mag = MIN_MAG_DB;
 
-    int min_fft_bin=((float)200/m_modem_stats_max_f_hz)*MODEM_STATS_NSPEC;
-    int max_fft_bin=((float)2800/m_modem_stats_max_f_hz)*MODEM_STATS_NSPEC;
+    int min_fft_bin=((float)200/m_modem_stats_max_f_hz)*m_n_magdB;
+    int max_fft_bin=((float)2800/m_modem_stats_max_f_hz)*m_n_magdB;
 
     for(int i=min_fft_bin; i<max_fft_bin; i++) 
     {
-        if (g_avmag[i] > max_mag)
+        if (m_magdB[i] > max_mag)
         {
-            max_mag = g_avmag[i];
+            max_mag = m_magdB[i];
         }
     }
 
@@ -380,60 +526,58 @@ void PlotWaterfall::plotPixelData()
     intensity_per_dB  = (float)256 /(m_max_mag - m_min_mag);
 
     // Draw last line of blocks using latest amplitude data ------------------
-    int baseRowWidthPixels = ((float)MODEM_STATS_NSPEC / (float)m_modem_stats_max_f_hz) * MAX_F_HZ;
-    unsigned char dyImageData[3 * baseRowWidthPixels];
+    int baseRowWidthPixels = ((float)m_n_magdB / (float)m_modem_stats_max_f_hz) * MAX_F_HZ;
+    assert(baseRowWidthPixels <= m_n_magdB);
+    
+    // Straight-line clamp and convert so the compiler can vectorize it.
+    m_intensity.resize(m_n_magdB);
+    unsigned char* intensity = &m_intensity[0];
     for(px = 0; px < baseRowWidthPixels; px++)
     {
-        index = px;
-        assert(index < MODEM_STATS_NSPEC);
-
-        intensity = intensity_per_dB * (g_avmag[index] - m_min_mag);
-        if(intensity > 255) intensity = 255;
-        if (intensity < 0) intensity = 0;
-
-        int pixelPos = (px * 3);
-            
-        switch (m_colour) {
-        case 0:
-            dyImageData[pixelPos] = m_heatmap_lut[intensity] & 0xff;
-            dyImageData[pixelPos + 1] = (m_heatmap_lut[intensity] >> 8) & 0xff;
-            dyImageData[pixelPos + 2] = (m_heatmap_lut[intensity] >> 16) & 0xff;
-            break;
-        case 1:
-            dyImageData[pixelPos] = intensity;
-            dyImageData[pixelPos + 1] = intensity;
-            dyImageData[pixelPos + 2] = intensity;       
-            break;
-        case 2:
-            dyImageData[pixelPos] = intensity;
-            dyImageData[pixelPos + 1] = intensity;
-            if (intensity < 127)
-                dyImageData[pixelPos + 2] = intensity*2;
-            else
-                dyImageData[pixelPos + 2] = 255;
-                    
-            break;
+        float val = intensity_per_dB * (m_magdB[px] - m_min_mag);
+        val = std::min(std::max(val, 0.0f), 255.0f);
+        intensity[px] = (unsigned char)val;
+    }
+    
+    // Nearest neighbour horizontal scaling, same as the StretchBlit this replaces.
+    if (m_columnBinRowWidth != baseRowWidthPixels)
+    {
+        for (int col = 0; col < m_imgWidth; col++)
+        {
+            m_columnBin[col] = (long)col * baseRowWidthPixels / m_imgWidth;
         }
+        m_columnBinRowWidth = baseRowWidthPixels;
     }
     
     // Force main window's color space to be the same as what wxWidgets uses. This only has an effect
     // on macOS due to how it handles color spaces.
     ResetMainWindowColorSpace();
 
+    // Write dy copies of the new row above the previous newest one. Only
+    // the new rows are touched, independent of the window height.
+    dy = std::min(dy, m_imgHeight);
     if (dy > 0)
     {
-        wxImage* tmpImage = new wxImage(baseRowWidthPixels, 1, (unsigned char*)&dyImageData, true);
-        wxBitmap* tmpBmp = new wxBitmap(*tmpImage);
+        const unsigned char (*lut)[3] = WaterfallColourMap(m_colour);
+        unsigned char* imgData = m_ringImage.GetData();
+        int rowBytes = 3 * m_imgWidth;
+        
+        m_writeRow = (m_writeRow + m_imgHeight - 1) % m_imgHeight;
+        unsigned char* firstRow = imgData + m_writeRow * rowBytes;
+        for (int col = 0; col < m_imgWidth; col++)
         {
-            wxMemoryDC fullBmpSourceDC(*m_fullBmp);
-            wxMemoryDC fullBmpDestDC(*m_fullBmp);
-            wxMemoryDC tmpBmpSourceDC(*tmpBmp);
-
-            fullBmpDestDC.Blit(0, dy, m_imgWidth, m_imgHeight - dy, &fullBmpSourceDC, 0, 0);
-            fullBmpDestDC.StretchBlit(0, 0, m_imgWidth, dy, &tmpBmpSourceDC, 0, 0, baseRowWidthPixels, 1);
+            const unsigned char* rgb = lut[intensity[m_columnBin[col]]];
+            firstRow[3*col] = rgb[0];
+            firstRow[3*col + 1] = rgb[1];
+            firstRow[3*col + 2] = rgb[2];
+        }
+        
+        for (int row = 1; row < dy; row++)
+        {
+            m_writeRow = (m_writeRow + m_imgHeight - 1) % m_imgHeight;
+            memcpy(imgData + m_writeRow * rowBytes, firstRow, rowBytes);
         }
-        delete tmpBmp; 
-        delete tmpImage;
+        m_ringRowsPending = std::min(m_ringRowsPending + dy, m_imgHeight);
     }
 }
 
@@ -468,6 +612,13 @@ void PlotWaterfall::OnDoubleClickCommon(wxMouseEvent& event)
 //-------------------------------------------------------------------------
 void PlotWaterfall::OnMouseWheelMoved(wxMouseEvent& event)
 {
+    if (event.ShiftDown())
+    {
+        int rows = std::max(1, m_imgHeight / 10);
+        scrollHistory(event.GetWheelRotation() > 0 ? rows : -rows);
+        return;
+    }
+    
     float currRxFreq = FDMDV_FCENTRE - g_RxFreqOffsetHz;
     float direction = 1.0;
     if (event.GetWheelRotation() < 0)
@@ -503,6 +654,16 @@ void PlotWaterfall::OnKeyDown(wxKeyEvent& event)
         case WXK_UP:
             direction = 1.0;
             break;
+        case WXK_PAGEUP:
+            scrollHistory(m_imgHeight / 2);
+            break;
+        case WXK_PAGEDOWN:
+            scrollHistory(-m_imgHeight / 2);
+            break;
+        case WXK_END:
+            m_scrollback = false;
+            Refresh();
+            break;
     }
     
     if (direction)
@@ -21,9 +21,14 @@
 #ifndef __FDMDV2_PLOT_WATERFALL__
 #define __FDMDV2_PLOT_WATERFALL__
 
+#include <vector>
 #include <wx/graphics.h>
 
+#include <memory>
+#include <string>
+
 #include "plot.h"
+#include "waterfall_history.h"
 #include "../../defines.h"
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
@@ -45,18 +50,29 @@ class PlotWaterfall : public PlotPanel
         void setGreyscale(bool greyscale) { m_greyscale = greyscale; }
         void setRxFreq(float rxFreq) { m_rxFreq = rxFreq; }
         void setFs(int fs) { m_modem_stats_max_f_hz = fs/2; }
+        
+        // magdB has n_magdB bins spanning 0 ... fs/2 and must stay valid
+        // until the next call.
+        void setSpectrum(const float* magdB, int n_magdB);
+        
+        // Keeps up to maxRows rows of WATERFALL_HISTORY_ROW_SECS each for
+        // scrolling back (Page Up/Down, shift + mouse wheel). If spillFile
+        // is non-empty the history is kept in a memory mapped file there.
+        void enableHistory(int maxRows, const std::string& spillFile);
+        // WATERFALL_COLOUR_* (see util/WaterfallColourMap.h).
         void setColor(int color) { m_colour = color; }
         
     protected:
-        unsigned    m_heatmap_lut[256];
-
-        unsigned    heatmap(float val, float min, float max);
-
         void        OnSize(wxSizeEvent& event);
         void        OnShow(wxShowEvent& event);
         void        drawGraticule(wxGraphicsContext* ctx);
+        void        drawBitmaps(wxDC& dc);
         void        draw(wxGraphicsContext* gc);
         void        plotPixelData();
+        void        resizeRing();
+        void        updateRingBitmap();
+        void        renderHistory();
+        void        scrollHistory(int rows);
         void        OnMouseLeftDoubleClick(wxMouseEvent& event);
         void        OnMouseRightDoubleClick(wxMouseEvent& event);
         void        OnMouseMiddleDown(wxMouseEvent& event);
@@ -72,10 +88,38 @@ class PlotWaterfall : public PlotPanel
         int         m_colour;
         int         m_modem_stats_max_f_hz;
 
-        wxBitmap* m_fullBmp;
+        // Circular buffer of RGB rows, m_imgWidth x m_imgHeight. New rows are
+        // written going upwards from m_writeRow so that the visible (newest
+        // at top) image is rows [m_writeRow, m_imgHeight) then [0, m_writeRow).
+        wxImage m_ringImage;
+        int m_writeRow;
         int m_imgHeight;
         int m_imgWidth;
         
+        // Native copy of m_ringImage that gets blitted, so only the rows
+        // written since the last paint (starting at m_writeRow) need
+        // converting.
+        wxBitmap m_ringBitmap;
+        int m_ringRowsPending;
+        
+        // Spectrum bin shown in each pixel column, rebuilt on resize/setFs().
+        std::vector<int> m_columnBin;
+        int m_columnBinRowWidth;
+        
+        // Latest spectrum from the SpectrumEngine and its per-bin intensities.
+        const float* m_magdB;
+        int m_n_magdB;
+        std::vector<unsigned char> m_intensity;
+        
+        // Scrollback. While m_scrollback is set the view shows history rows
+        // (one per pixel row) ending at row number m_scrollbackNewestRow.
+        std::unique_ptr<WaterfallHistory> m_history;
+        bool m_scrollback;
+        uint64_t m_scrollbackNewestRow;
+        bool m_historyImageDirty;
+        wxImage m_historyImage;
+        wxBitmap m_historyBitmap;
+        
         void        OnDoubleClickCommon(wxMouseEvent& event);
 
         DECLARE_EVENT_TABLE()
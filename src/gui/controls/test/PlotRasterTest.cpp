@@ -0,0 +1,216 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "plot_raster.h"
+#include "pipeline/test/PipelineTestCommon.h"
+
+#define TEST_SIZE 12
+
+static bool isSet(PlotRaster& raster, int x, int y)
+{
+    const unsigned char* p = raster.data() + 3 * (raster.width() * y + x);
+    return p[0] != 0 || p[1] != 0 || p[2] != 0;
+}
+
+static int numSet(PlotRaster& raster)
+{
+    int count = 0;
+    for (int y = 0; y < raster.height(); y++)
+    {
+        for (int x = 0; x < raster.width(); x++)
+        {
+            count += isSet(raster, x, y) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// Distance from the centre of pixel (x, y) to the segment.
+static float distanceToLine(int x, int y, int x0, int y0, int x1, int y1)
+{
+    float dx = x1 - x0, dy = y1 - y0;
+    float lengthSq = dx * dx + dy * dy;
+    float t = lengthSq > 0 ? ((x - x0) * dx + (y - y0) * dy) / lengthSq : 0;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    return hypotf(x - (x0 + t * dx), y - (y0 + t * dy));
+}
+
+// True if every set pixel can be reached from (x, y) through set pixels
+// sharing an edge.
+static bool isConnected(PlotRaster& raster, int x, int y)
+{
+    std::vector<bool> seen(raster.width() * raster.height(), false);
+    std::vector<std::pair<int, int>> pending = { { x, y } };
+    int numReached = 0;
+    while (!pending.empty())
+    {
+        auto pos = pending.back();
+        pending.pop_back();
+        if (pos.first < 0 || pos.first >= raster.width() || pos.second < 0 || pos.second >= raster.height() ||
+            seen[pos.second * raster.width() + pos.first] || !isSet(raster, pos.first, pos.second))
+        {
+            continue;
+        }
+        seen[pos.second * raster.width() + pos.first] = true;
+        numReached++;
+        pending.push_back({ pos.first + 1, pos.second });
+        pending.push_back({ pos.first - 1, pos.second });
+        pending.push_back({ pos.first, pos.second + 1 });
+        pending.push_back({ pos.first, pos.second - 1 });
+    }
+    return numReached == numSet(raster);
+}
+
+bool plotRasterLines()
+{
+    PlotRaster raster;
+    raster.resize(TEST_SIZE, TEST_SIZE);
+    raster.setColour(0xFF, 0x80, 0x01);
+    raster.saveBackground();
+
+    // Every line between any two points of the grid.
+    for (int start = 0; start < TEST_SIZE * TEST_SIZE; start++)
+    {
+        for (int end = 0; end < TEST_SIZE * TEST_SIZE; end++)
+        {
+            int x0 = start % TEST_SIZE, y0 = start / TEST_SIZE;
+            int x1 = end % TEST_SIZE, y1 = end / TEST_SIZE;
+            raster.clear();
+            raster.drawLine(x0, y0, x1, y1);
+
+            // Joined up through edges with no more pixels than that needs,
+            // ends included and none further from the ideal line than a
+            // staircase has to be (half a diagonal).
+            bool ok = isSet(raster, x0, y0) && isSet(raster, x1, y1);
+            ok = ok && numSet(raster) == abs(x1 - x0) + abs(y1 - y0) + 1;
+            ok = ok && isConnected(raster, x0, y0);
+            for (int y = 0; ok && y < TEST_SIZE; y++)
+            {
+                for (int x = 0; ok && x < TEST_SIZE; x++)
+                {
+                    ok = !isSet(raster, x, y) || distanceToLine(x, y, x0, y0, x1, y1) <= 0.7072f;
+                }
+            }
+            if (!ok)
+            {
+                std::cerr << "[line (" << x0 << "," << y0 << ")-(" << x1 << "," << y1 << ")]...";
+                return false;
+            }
+
+            // The same pixels whichever way round.
+            std::vector<unsigned char> forward(raster.data(), raster.data() + 3 * TEST_SIZE * TEST_SIZE);
+            raster.clear();
+            raster.drawLine(x1, y1, x0, y0);
+            if (!std::equal(forward.begin(), forward.end(), raster.data()))
+            {
+                std::cerr << "[line (" << x0 << "," << y0 << ")-(" << x1 << "," << y1 << ") differs reversed]...";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool plotRasterSpans()
+{
+    PlotRaster raster;
+    raster.resize(TEST_SIZE, TEST_SIZE);
+    raster.setColour(0x12, 0x34, 0x56);
+    raster.drawVerticalSpan(3, 9, 2);
+    raster.drawHorizontalSpan(10, 1, 1);
+    raster.drawPoint(11, 11);
+
+    for (int y = 0; y < TEST_SIZE; y++)
+    {
+        for (int x = 0; x < TEST_SIZE; x++)
+        {
+            bool expected = (x == 3 && y >= 2 && y <= 9) || (x == 1 && y == 10) || (x == 11 && y == 11);
+            const unsigned char* p = raster.data() + 3 * (TEST_SIZE * y + x);
+            bool ok = expected ? (p[0] == 0x12 && p[1] == 0x34 && p[2] == 0x56) : !isSet(raster, x, y);
+            if (!ok)
+            {
+                std::cerr << "[pixel (" << x << "," << y << ")]...";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool plotRasterClip()
+{
+    PlotRaster clipped;
+    clipped.resize(TEST_SIZE, TEST_SIZE);
+    clipped.setClip(2, 3, 6, 5);
+
+    PlotRaster unclipped;
+    unclipped.resize(TEST_SIZE, TEST_SIZE);
+
+    // Lines from well outside the image to well outside the other side.
+    const int ends[][4] = {
+        { -20, -7, 30, 15 }, { 5, -100, 6, 100 }, { -50, 4, 60, 5 },
+        { 11, 0, 0, 11 }, { -3, -3, -1, -1 }, { 20, 20, 40, 40 },
+    };
+    for (auto& line : ends)
+    {
+        clipped.drawLine(line[0], line[1], line[2], line[3]);
+        unclipped.drawLine(line[0], line[1], line[2], line[3]);
+    }
+    clipped.drawVerticalSpan(-1, 0, TEST_SIZE);
+    clipped.drawHorizontalSpan(TEST_SIZE, 0, TEST_SIZE);
+
+    for (int y = 0; y < TEST_SIZE; y++)
+    {
+        for (int x = 0; x < TEST_SIZE; x++)
+        {
+            bool inClip = x >= 2 && x < 8 && y >= 3 && y < 8;
+            if (isSet(clipped, x, y) != (inClip && isSet(unclipped, x, y)))
+            {
+                std::cerr << "[pixel (" << x << "," << y << ")]...";
+                return false;
+            }
+        }
+    }
+
+    // Nothing drawn at all would also pass the above.
+    return numSet(clipped) > 0;
+}
+
+bool plotRasterBackground()
+{
+    PlotRaster raster;
+    raster.resize(TEST_SIZE, TEST_SIZE);
+    raster.setColour(0x20, 0x20, 0x20);
+    for (int y = 0; y < TEST_SIZE; y++)
+    {
+        raster.drawHorizontalSpan(y, 0, TEST_SIZE - 1);
+    }
+    raster.saveBackground();
+    std::vector<unsigned char> background(raster.data(), raster.data() + 3 * TEST_SIZE * TEST_SIZE);
+
+    raster.setColour(0xFF, 0xFF, 0xFF);
+    raster.drawLine(0, 0, TEST_SIZE - 1, TEST_SIZE - 1);
+    raster.clear();
+    if (!std::equal(background.begin(), background.end(), raster.data()))
+    {
+        std::cerr << "[background not restored]...";
+        return false;
+    }
+
+    // Resizing forgets the background, so clearing goes to black.
+    raster.resize(TEST_SIZE + 1, TEST_SIZE);
+    raster.drawLine(0, 0, TEST_SIZE, TEST_SIZE - 1);
+    raster.clear();
+    return numSet(raster) == 0;
+}
+
+int main()
+{
+    TEST_CASE(plotRasterLines);
+    TEST_CASE(plotRasterSpans);
+    TEST_CASE(plotRasterClip);
+    TEST_CASE(plotRasterBackground);
+    return 0;
+}
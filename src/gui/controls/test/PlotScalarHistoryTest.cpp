@@ -0,0 +1,156 @@
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include "plot_scalar_history.h"
+#include "pipeline/test/PipelineTestCommon.h"
+
+// Plain copy of the last capacity samples, zero filled like the history.
+class ReferenceHistory
+{
+public:
+    ReferenceHistory(int capacity)
+        : samples_(capacity, 0.0f)
+    {
+        // empty
+    }
+
+    void append(float sample)
+    {
+        samples_.pop_front();
+        samples_.push_back(sample);
+    }
+
+    float get(int numSamples, int index) const
+    {
+        return samples_[samples_.size() - numSamples + index];
+    }
+
+    // Same bin edges as PlotScalarHistory::getMinMax().
+    void getMinMax(int numSamples, int numBins, float* minOut, float* maxOut) const
+    {
+        int start = samples_.size() - numSamples;
+        for (int bin = 0; bin < numBins; bin++)
+        {
+            int binStart = start + numSamples * bin / numBins;
+            int binEnd = std::max(binStart + 1, start + numSamples * (bin + 1) / numBins);
+            minOut[bin] = *std::min_element(samples_.begin() + binStart, samples_.begin() + binEnd);
+            maxOut[bin] = *std::max_element(samples_.begin() + binStart, samples_.begin() + binEnd);
+        }
+    }
+
+private:
+    std::deque<float> samples_;
+};
+
+// Compares every sample and a spread of decimations against the reference.
+static bool sameAsReference(const PlotScalarHistory& history, const ReferenceHistory& reference)
+{
+    int capacity = history.capacity();
+    for (int index = 0; index < capacity; index++)
+    {
+        if (history.get(capacity, index) != reference.get(capacity, index))
+        {
+            std::cerr << "[sample " << index << " differs]...";
+            return false;
+        }
+    }
+
+    // Whole and partial windows; more bins than samples, fewer, and ones
+    // that don't divide evenly.
+    const int numSamplesList[] = { capacity, capacity - 1, capacity / 2 + 3, 37, 1 };
+    const int numBinsList[] = { 1, 3, 64, 333, capacity, 2 * capacity };
+    for (int numSamples : numSamplesList)
+    {
+        if (numSamples > capacity)
+        {
+            continue;
+        }
+        for (int numBins : numBinsList)
+        {
+            std::vector<float> minGot(numBins), maxGot(numBins), minExpected(numBins), maxExpected(numBins);
+            history.getMinMax(numSamples, numBins, &minGot[0], &maxGot[0]);
+            reference.getMinMax(numSamples, numBins, &minExpected[0], &maxExpected[0]);
+            if (minGot != minExpected || maxGot != maxExpected)
+            {
+                std::cerr << "[" << numSamples << " samples in " << numBins << " bins differ]...";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool checkRandomHistory(int capacity)
+{
+    PlotScalarHistory history(capacity);
+    ReferenceHistory reference(capacity);
+
+    srand(capacity);
+
+    // Several times round the ring, checking part way through each lap so
+    // the window starts mid-block at every level at some point.
+    for (int lap = 0; lap < 5; lap++)
+    {
+        for (int n = 0; n < capacity + 17; n++)
+        {
+            float sample = (float)(rand() % 2001 - 1000);
+            history.append(sample);
+            reference.append(sample);
+        }
+        if (!sameAsReference(history, reference))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool plotScalarHistoryMatchesBruteForce()
+{
+    return checkRandomHistory(1000) && checkRandomHistory(1024) && checkRandomHistory(7);
+}
+
+bool plotScalarHistoryStartsAtZero()
+{
+    PlotScalarHistory history(100);
+    ReferenceHistory reference(100);
+    for (int n = 0; n < 10; n++)
+    {
+        history.append(n + 1);
+        reference.append(n + 1);
+    }
+    if (!sameAsReference(history, reference))
+    {
+        return false;
+    }
+
+    // The ramp is all in the newest bin; the rest is unwritten history.
+    float minOut[10], maxOut[10];
+    history.getMinMax(100, 10, minOut, maxOut);
+    return minOut[9] == 1 && maxOut[9] == 10 && minOut[0] == 0 && maxOut[0] == 0;
+}
+
+bool plotScalarHistoryClear()
+{
+    PlotScalarHistory history(64);
+    for (int n = 0; n < 100; n++)
+    {
+        history.append(-n);
+    }
+    history.clear();
+    history.append(5);
+
+    ReferenceHistory reference(64);
+    reference.append(5);
+    return sameAsReference(history, reference);
+}
+
+int main()
+{
+    TEST_CASE(plotScalarHistoryMatchesBruteForce);
+    TEST_CASE(plotScalarHistoryStartsAtZero);
+    TEST_CASE(plotScalarHistoryClear);
+    return 0;
+}
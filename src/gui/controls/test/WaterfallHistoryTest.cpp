@@ -0,0 +1,225 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#if !defined(WIN32)
+#include <unistd.h>
+#endif // !defined(WIN32)
+#include "waterfall_history.h"
+#include "pipeline/test/PipelineTestCommon.h"
+
+#define TEST_NUM_BINS 8
+#define TEST_MAX_FREQ_HZ 4000
+#define TEST_CAPACITY 5
+#define TEST_ROW_INTERVAL_MS 100
+
+static std::string testPath(const char* name)
+{
+    const char* tmpDir = getenv("TMPDIR");
+    return std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/" + name;
+}
+
+// Spectrum for row n, different in every bin and every row.
+static std::vector<float> makeSpectrum(int n)
+{
+    std::vector<float> magdB(TEST_NUM_BINS);
+    for (int bin = 0; bin < TEST_NUM_BINS; bin++)
+    {
+        magdB[bin] = -90.0f + 2 * n + 0.5f * bin;
+    }
+    return magdB;
+}
+
+static bool rowIs(const WaterfallHistory& history, int age, int n)
+{
+    int64_t timestampMs = -1;
+    const uint8_t* row = history.getRow(age, &timestampMs);
+    if (row == nullptr || timestampMs != n * TEST_ROW_INTERVAL_MS)
+    {
+        std::cerr << "[row " << age << " is missing or from " << timestampMs << " ms]...";
+        return false;
+    }
+
+    auto magdB = makeSpectrum(n);
+    for (int bin = 0; bin < TEST_NUM_BINS; bin++)
+    {
+        if (row[bin] != WaterfallHistory::quantize(magdB[bin]))
+        {
+            std::cerr << "[row " << age << " bin " << bin << " differs]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes numRows rows, one spectrum per interval, then checks that only
+// the newest TEST_CAPACITY are kept, newest first.
+static bool checkWraparound(WaterfallHistory& history, int numRows)
+{
+    // A row is only stored once the next interval starts.
+    for (int n = 0; n <= numRows; n++)
+    {
+        auto magdB = makeSpectrum(n);
+        history.append(n * TEST_ROW_INTERVAL_MS, &magdB[0], TEST_NUM_BINS, TEST_MAX_FREQ_HZ);
+    }
+
+    int expectedRows = std::min(numRows, TEST_CAPACITY);
+    if (history.numRows() != expectedRows || history.numRowsWritten() != (uint64_t)numRows)
+    {
+        std::cerr << "[" << history.numRows() << " rows, " << history.numRowsWritten() << " written]...";
+        return false;
+    }
+    for (int age = 0; age < expectedRows; age++)
+    {
+        if (!rowIs(history, age, numRows - 1 - age))
+        {
+            return false;
+        }
+    }
+    return history.getRow(expectedRows, nullptr) == nullptr && history.getRow(-1, nullptr) == nullptr;
+}
+
+bool waterfallHistoryWraparound()
+{
+    // Short of full, exactly full, and several times round.
+    for (int numRows : { 3, TEST_CAPACITY, 2 * TEST_CAPACITY + 2, 7 * TEST_CAPACITY })
+    {
+        WaterfallHistory history(TEST_NUM_BINS, TEST_MAX_FREQ_HZ, TEST_CAPACITY, TEST_ROW_INTERVAL_MS);
+        if (history.isFileBacked() || !checkWraparound(history, numRows))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool waterfallHistoryFileBacked()
+{
+    std::string path = testPath("WaterfallHistoryTest.tmp");
+    WaterfallHistory history(TEST_NUM_BINS, TEST_MAX_FREQ_HZ, TEST_CAPACITY, TEST_ROW_INTERVAL_MS, path);
+    if (!history.isFileBacked())
+    {
+        std::cerr << "[not file backed]...";
+        return false;
+    }
+
+#if !defined(WIN32)
+    // Scratch only, so it's gone as soon as it's mapped. (Windows deletes
+    // it on close instead.)
+    if (access(path.c_str(), F_OK) == 0)
+    {
+        std::cerr << "[" << path << " left behind]...";
+        return false;
+    }
+#endif // !defined(WIN32)
+    return checkWraparound(history, 3 * TEST_CAPACITY + 1);
+}
+
+bool waterfallHistoryPeakHold()
+{
+    WaterfallHistory history(TEST_NUM_BINS, TEST_MAX_FREQ_HZ, TEST_CAPACITY, TEST_ROW_INTERVAL_MS);
+
+    // Three spectra in one interval, each the loudest in a different bin.
+    std::vector<float> magdB(TEST_NUM_BINS);
+    for (int n = 0; n < 3; n++)
+    {
+        for (int bin = 0; bin < TEST_NUM_BINS; bin++)
+        {
+            magdB[bin] = bin % 3 == n ? -10.0f : -80.0f;
+        }
+        history.append(30 * n, &magdB[0], TEST_NUM_BINS, TEST_MAX_FREQ_HZ);
+    }
+    if (history.numRows() != 0)
+    {
+        std::cerr << "[row stored early]...";
+        return false;
+    }
+    history.append(TEST_ROW_INTERVAL_MS, &magdB[0], TEST_NUM_BINS, TEST_MAX_FREQ_HZ);
+
+    int64_t timestampMs = -1;
+    const uint8_t* row = history.getRow(0, &timestampMs);
+    if (history.numRows() != 1 || timestampMs != 0)
+    {
+        return false;
+    }
+    for (int bin = 0; bin < TEST_NUM_BINS; bin++)
+    {
+        if (row[bin] != WaterfallHistory::quantize(-10.0f))
+        {
+            std::cerr << "[bin " << bin << " not held]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool waterfallHistoryRebinning()
+{
+    WaterfallHistory history(TEST_NUM_BINS, TEST_MAX_FREQ_HZ, TEST_CAPACITY, TEST_ROW_INTERVAL_MS);
+
+    // Twice as fine over the same span: each bin is the peak of two.
+    std::vector<float> fine(2 * TEST_NUM_BINS);
+    for (size_t index = 0; index < fine.size(); index++)
+    {
+        fine[index] = index % 2 == 0 ? -20.0f - index : -60.0f;
+    }
+    history.append(0, &fine[0], fine.size(), TEST_MAX_FREQ_HZ);
+
+    // Twice as many over twice the span: same bin spacing, and only the
+    // lower half is kept.
+    std::vector<float> wide(2 * TEST_NUM_BINS);
+    for (size_t index = 0; index < wide.size(); index++)
+    {
+        wide[index] = -40.0f - index;
+    }
+    history.append(TEST_ROW_INTERVAL_MS, &wide[0], wide.size(), 2 * TEST_MAX_FREQ_HZ);
+
+    // Half as fine over the same span: each input bin covers two.
+    std::vector<float> coarse(TEST_NUM_BINS / 2);
+    for (size_t index = 0; index < coarse.size(); index++)
+    {
+        coarse[index] = -30.0f - index;
+    }
+    history.append(2 * TEST_ROW_INTERVAL_MS, &coarse[0], coarse.size(), TEST_MAX_FREQ_HZ);
+    history.append(3 * TEST_ROW_INTERVAL_MS, &coarse[0], coarse.size(), TEST_MAX_FREQ_HZ);
+
+    const uint8_t* fineRow = history.getRow(2, nullptr);
+    const uint8_t* wideRow = history.getRow(1, nullptr);
+    const uint8_t* coarseRow = history.getRow(0, nullptr);
+    for (int bin = 0; bin < TEST_NUM_BINS; bin++)
+    {
+        bool ok = fineRow[bin] == WaterfallHistory::quantize(-20.0f - 2 * bin);
+        ok = ok && wideRow[bin] == WaterfallHistory::quantize(-40.0f - bin);
+        ok = ok && coarseRow[bin] == WaterfallHistory::quantize(-30.0f - bin / 2);
+        if (!ok)
+        {
+            std::cerr << "[bin " << bin << " differs]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool waterfallHistoryQuantize()
+{
+    for (float dB = -100.0f; dB <= 27.5f; dB += 0.1f)
+    {
+        if (fabs(WaterfallHistory::dequantize(WaterfallHistory::quantize(dB)) - dB) > 0.25f + 1e-4f)
+        {
+            std::cerr << "[" << dB << " dB out by more than half a step]...";
+            return false;
+        }
+    }
+    return WaterfallHistory::quantize(-200.0f) == 0 && WaterfallHistory::quantize(100.0f) == 255;
+}
+
+int main()
+{
+    TEST_CASE(waterfallHistoryWraparound);
+    TEST_CASE(waterfallHistoryFileBacked);
+    TEST_CASE(waterfallHistoryPeakHold);
+    TEST_CASE(waterfallHistoryRebinning);
+    TEST_CASE(waterfallHistoryQuantize);
+    return 0;
+}
@@ -0,0 +1,272 @@
+//==========================================================================
+// Name:            waterfall_history.cpp
+// Purpose:         Compact long term store of quantized waterfall rows.
+// Created:         October 19, 2026
+// Authors:         Mooneer Salem
+//
+// License:
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//==========================================================================
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <assert.h>
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // defined(WIN32)
+
+#include "waterfall_history.h"
+
+// Quantization range: 0.5 dB steps from -100 to +27.5 dB, which covers
+// the SpectrumEngine's output with plenty of margin either side.
+#define HISTORY_MIN_DB    -100.0f
+#define HISTORY_STEPS_PER_DB 2.0f
+
+//----------------------------------------------------------------
+// WaterfallHistory()
+//----------------------------------------------------------------
+WaterfallHistory::WaterfallHistory(int numBins, float maxFreqHz, int maxRows, int rowIntervalMs, const std::string& spillFile)
+{
+    assert(numBins > 0 && maxRows > 0);
+
+    m_numBins = numBins;
+    m_maxFreqHz = maxFreqHz;
+    m_capacity = maxRows;
+    m_rowIntervalMs = rowIntervalMs;
+    m_rowStride = sizeof(int64_t) + numBins;
+
+    m_storage = nullptr;
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+#if defined(WIN32)
+    m_fileHandle = nullptr;
+    m_mapHandle = nullptr;
+#else
+    m_fd = -1;
+#endif // defined(WIN32)
+
+    size_t size = m_rowStride * m_capacity;
+    if (spillFile != "" && mapFile(spillFile, size))
+    {
+        m_storage = (uint8_t*)m_mapping;
+    }
+    else
+    {
+        m_memory.resize(size);
+        m_storage = &m_memory[0];
+    }
+
+    m_newestRow = m_capacity - 1;
+    m_numRows = 0;
+    m_numRowsWritten = 0;
+
+    m_pending.resize(m_numBins);
+    m_pendingStartMs = 0;
+    m_pendingValid = false;
+}
+
+//----------------------------------------------------------------
+// ~WaterfallHistory()
+//----------------------------------------------------------------
+WaterfallHistory::~WaterfallHistory()
+{
+    unmapFile();
+}
+
+//----------------------------------------------------------------
+// quantize()
+//----------------------------------------------------------------
+uint8_t WaterfallHistory::quantize(float dB)
+{
+    float val = (dB - HISTORY_MIN_DB) * HISTORY_STEPS_PER_DB + 0.5f;
+    return (uint8_t)std::min(std::max(val, 0.0f), 255.0f);
+}
+
+//----------------------------------------------------------------
+// dequantize()
+//----------------------------------------------------------------
+float WaterfallHistory::dequantize(uint8_t value)
+{
+    return HISTORY_MIN_DB + value / HISTORY_STEPS_PER_DB;
+}
+
+//----------------------------------------------------------------
+// append()
+//----------------------------------------------------------------
+void WaterfallHistory::append(int64_t timestampMs, const float* magdB, int numMagdB, float magdBMaxFreqHz)
+{
+    if (numMagdB <= 0 || magdBMaxFreqHz <= 0)
+    {
+        return;
+    }
+
+    if (m_pendingValid && timestampMs - m_pendingStartMs >= m_rowIntervalMs)
+    {
+        commitPending();
+    }
+
+    if (!m_pendingValid)
+    {
+        memset(&m_pending[0], 0, m_numBins);
+        m_pendingStartMs = timestampMs;
+        m_pendingValid = true;
+    }
+
+    // Each stored bin keeps the peak of the input bins it covers, or the
+    // nearest input bin if the input is coarser than the history.
+    float inBinsPerBin = (m_maxFreqHz / m_numBins) * (numMagdB / magdBMaxFreqHz);
+    for (int bin = 0; bin < m_numBins; bin++)
+    {
+        int first = (int)(bin * inBinsPerBin);
+        int last = std::max(first + 1, (int)((bin + 1) * inBinsPerBin));
+        last = std::min(last, numMagdB);
+        if (first >= numMagdB)
+        {
+            break;
+        }
+
+        float peak = magdB[first];
+        for (int index = first + 1; index < last; index++)
+        {
+            peak = std::max(peak, magdB[index]);
+        }
+        m_pending[bin] = std::max(m_pending[bin], quantize(peak));
+    }
+}
+
+//----------------------------------------------------------------
+// getRow()
+//----------------------------------------------------------------
+const uint8_t* WaterfallHistory::getRow(int age, int64_t* timestampMs) const
+{
+    if (age < 0 || age >= m_numRows)
+    {
+        return nullptr;
+    }
+
+    int row = (m_newestRow + m_capacity - age) % m_capacity;
+    const uint8_t* ptr = m_storage + row * m_rowStride;
+    if (timestampMs != nullptr)
+    {
+        memcpy(timestampMs, ptr, sizeof(int64_t));
+    }
+    return ptr + sizeof(int64_t);
+}
+
+//----------------------------------------------------------------
+// commitPending()
+//----------------------------------------------------------------
+void WaterfallHistory::commitPending()
+{
+    m_newestRow = (m_newestRow + 1) % m_capacity;
+    uint8_t* ptr = m_storage + m_newestRow * m_rowStride;
+    memcpy(ptr, &m_pendingStartMs, sizeof(int64_t));
+    memcpy(ptr + sizeof(int64_t), &m_pending[0], m_numBins);
+
+    m_numRows = std::min(m_numRows + 1, m_capacity);
+    m_numRowsWritten++;
+    m_pendingValid = false;
+}
+
+//----------------------------------------------------------------
+// mapFile()
+//----------------------------------------------------------------
+bool WaterfallHistory::mapFile(const std::string& spillFile, size_t size)
+{
+#if defined(WIN32)
+    HANDLE file = CreateFileA(
+        spillFile.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "WaterfallHistory: could not create %s, keeping history in memory\n", spillFile.c_str());
+        return false;
+    }
+
+    HANDLE map = CreateFileMappingA(
+        file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+    void* view = (map != NULL) ? MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, size) : NULL;
+    if (view == NULL)
+    {
+        fprintf(stderr, "WaterfallHistory: could not map %s, keeping history in memory\n", spillFile.c_str());
+        if (map != NULL) CloseHandle(map);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mapHandle = map;
+    m_mapping = view;
+#else
+    int fd = open(spillFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        fprintf(stderr, "WaterfallHistory: could not create %s, keeping history in memory\n", spillFile.c_str());
+        return false;
+    }
+
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+    {
+        view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (view == MAP_FAILED)
+    {
+        fprintf(stderr, "WaterfallHistory: could not map %s, keeping history in memory\n", spillFile.c_str());
+        close(fd);
+        return false;
+    }
+
+    // Only needed as backing store while we're running.
+    unlink(spillFile.c_str());
+
+    m_fd = fd;
+    m_mapping = view;
+#endif // defined(WIN32)
+
+    m_mappingSize = size;
+    return true;
+}
+
+//----------------------------------------------------------------
+// unmapFile()
+//----------------------------------------------------------------
+void WaterfallHistory::unmapFile()
+{
+    if (m_mapping == nullptr)
+    {
+        return;
+    }
+
+#if defined(WIN32)
+    UnmapViewOfFile(m_mapping);
+    CloseHandle((HANDLE)m_mapHandle);
+    CloseHandle((HANDLE)m_fileHandle);
+    m_mapHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap(m_mapping, m_mappingSize);
+    close(m_fd);
+    m_fd = -1;
+#endif // defined(WIN32)
+
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+}
@@ -0,0 +1,97 @@
+//==========================================================================
+// Name:            waterfall_history.h
+// Purpose:         Compact long term store of quantized waterfall rows.
+// Created:         October 19, 2026
+// Authors:         Mooneer Salem
+//
+// License:
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//==========================================================================
+#ifndef __FDMDV2_WATERFALL_HISTORY__
+#define __FDMDV2_WATERFALL_HISTORY__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
+// Class WaterfallHistory
+//
+// Ring of timestamped spectrum rows, each numBins bytes wide spanning
+// 0 ... maxFreqHz. Magnitudes are stored as 0.5 dB steps and every
+// rowIntervalMs worth of incoming spectra is peak-held into a single row,
+// so e.g. 512 bins at one row per second is ~1.8 MB per hour.
+//
+// Storage is either plain memory or, if a spill file is given, a memory
+// mapped file of the same size so the OS can page out older rows. The
+// spill file is scratch space only and is removed when we're done.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
+class WaterfallHistory
+{
+    public:
+        WaterfallHistory(int numBins, float maxFreqHz, int maxRows, int rowIntervalMs, const std::string& spillFile = "");
+        ~WaterfallHistory();
+
+        int  numBins() const { return m_numBins; }
+        int  numRows() const { return m_numRows; }
+        int  capacity() const { return m_capacity; }
+        
+        // Total rows ever stored, for keeping a scrolled-back view anchored
+        // while new rows arrive.
+        uint64_t numRowsWritten() const { return m_numRowsWritten; }
+        bool isFileBacked() const { return m_mapping != nullptr; }
+
+        // magdB has numMagdB bins spanning 0 ... magdBMaxFreqHz.
+        void append(int64_t timestampMs, const float* magdB, int numMagdB, float magdBMaxFreqHz);
+
+        // Row stored age rows ago (0 = newest), or nullptr if age >= numRows().
+        const uint8_t* getRow(int age, int64_t* timestampMs) const;
+
+        static uint8_t quantize(float dB);
+        static float   dequantize(uint8_t value);
+
+    private:
+        int      m_numBins;
+        float    m_maxFreqHz;
+        int      m_capacity;
+        int      m_rowIntervalMs;
+        size_t   m_rowStride;
+
+        // m_storage points either into m_memory or at the mapped file.
+        uint8_t* m_storage;
+        std::vector<uint8_t> m_memory;
+        void*    m_mapping;
+        size_t   m_mappingSize;
+#if defined(WIN32)
+        void*    m_fileHandle;
+        void*    m_mapHandle;
+#else
+        int      m_fd;
+#endif // defined(WIN32)
+
+        int      m_newestRow;
+        int      m_numRows;
+        uint64_t m_numRowsWritten;
+
+        // Peak hold of the spectra received during the current interval.
+        std::vector<uint8_t> m_pending;
+        int64_t  m_pendingStartMs;
+        bool     m_pendingValid;
+
+        bool     mapFile(const std::string& spillFile, size_t size);
+        void     unmapFile();
+        void     commitPending();
+};
+
+#endif //__FDMDV2_WATERFALL_HISTORY__
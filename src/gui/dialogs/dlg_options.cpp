@@ -31,6 +31,10 @@ extern int                 g_infifo1_full;
 extern int                 g_outfifo1_empty;
 extern int                 g_infifo2_full;
 extern int                 g_outfifo2_empty;
+extern float               g_rxDriftPpm;
+extern float               g_txDriftPpm;
+extern float               g_rxLatencyMs;
+extern float               g_txLatencyMs;
 extern int                 g_AEstatus1[4];
 extern int                 g_AEstatus2[4];
 extern wxDatagramSocket    *g_sock;
@@ -394,6 +398,59 @@ OptionsDlg::OptionsDlg(wxWindow* parent, wxWindowID id, const wxString& title, c
     quickRecordSizer->Add(m_buttonChooseQuickRecordPath, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
     
     sbsQuickRecord->Add(quickRecordSizer);
+
+    wxBoxSizer* recordingFormatSizer = new wxBoxSizer(wxHORIZONTAL);
+
+    wxStaticText *staticTextFormat = new wxStaticText(m_keyerTab, wxID_ANY, _("Record as"), wxDefaultPosition, wxDefaultSize, 0);
+    recordingFormatSizer->Add(staticTextFormat, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    m_cbRecordingFormat = new wxComboBox(m_keyerTab, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(200,-1), 0, NULL, wxCB_DROPDOWN | wxCB_READONLY);
+    m_cbRecordingFormat->Append(_("WAV (uncompressed)"));
+    m_cbRecordingFormat->Append(_("FLAC (lossless)"));
+    m_cbRecordingFormat->Append(_("Opus (lossy)"));
+    m_cbRecordingFormat->SetToolTip(_("File format used by Record and Record From Radio. FLAC is about half the size of WAV with no loss. Opus is much smaller but lossy, so FreeDV signals in it may no longer decode, and needs a sound card rate of 8, 12, 16, 24 or 48 kHz."));
+    recordingFormatSizer->Add(m_cbRecordingFormat, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    sbsQuickRecord->Add(recordingFormatSizer);
+
+    wxBoxSizer* recordingRotateSizer = new wxBoxSizer(wxHORIZONTAL);
+
+    wxStaticText *staticTextRotate1 = new wxStaticText(m_keyerTab, wxID_ANY, _("Start a new file every"), wxDefaultPosition, wxDefaultSize, 0);
+    recordingRotateSizer->Add(staticTextRotate1, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    m_txtCtrlRecordingRotateMinutes = new wxTextCtrl(m_keyerTab, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(50,-1), 0);
+    m_txtCtrlRecordingRotateMinutes->SetToolTip(_("Minutes of audio after which recordings from the radio continue in a new file (0 = never)."));
+    recordingRotateSizer->Add(m_txtCtrlRecordingRotateMinutes, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    wxStaticText *staticTextRotate2 = new wxStaticText(m_keyerTab, wxID_ANY, _("minutes or"), wxDefaultPosition, wxDefaultSize, 0);
+    recordingRotateSizer->Add(staticTextRotate2, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    m_txtCtrlRecordingRotateMegabytes = new wxTextCtrl(m_keyerTab, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(50,-1), 0);
+    m_txtCtrlRecordingRotateMegabytes->SetToolTip(_("File size in MB after which recordings from the radio continue in a new file (0 = never)."));
+    recordingRotateSizer->Add(m_txtCtrlRecordingRotateMegabytes, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    wxStaticText *staticTextRotate3 = new wxStaticText(m_keyerTab, wxID_ANY, _("MB"), wxDefaultPosition, wxDefaultSize, 0);
+    recordingRotateSizer->Add(staticTextRotate3, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    sbsQuickRecord->Add(recordingRotateSizer);
+
+    wxBoxSizer* flightRecorderSizer = new wxBoxSizer(wxHORIZONTAL);
+
+    wxStaticText *staticTextFlightRecorder1 = new wxStaticText(m_keyerTab, wxID_ANY, _("Keep the last"), wxDefaultPosition, wxDefaultSize, 0);
+    flightRecorderSizer->Add(staticTextFlightRecorder1, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    m_txtCtrlFlightRecorderMinutes = new wxTextCtrl(m_keyerTab, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(50,-1), 0);
+    m_txtCtrlFlightRecorderMinutes->SetToolTip(_("Minutes of radio audio kept in memory for Tools > Save/Decode Last Minutes From Radio (0 = off). Uses about 5.5 MB per minute at 48 kHz. Takes effect when FreeDV is next started."));
+    flightRecorderSizer->Add(m_txtCtrlFlightRecorderMinutes, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    wxStaticText *staticTextFlightRecorder2 = new wxStaticText(m_keyerTab, wxID_ANY, _("minutes of radio audio in memory"), wxDefaultPosition, wxDefaultSize, 0);
+    flightRecorderSizer->Add(staticTextFlightRecorder2, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+
+    sbsQuickRecord->Add(flightRecorderSizer);
+
+    m_ckboxCodecFrameLog = new wxCheckBox(m_keyerTab, wxID_ANY, _("Log received codec frames"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE);
+    m_ckboxCodecFrameLog->SetToolTip(_("While FreeDV is running, logs what's decoded (with sync and SNR) to a .fdvlog file in the Quick Record location. About 100 bytes per second while a signal is being received and nothing otherwise, so whole days can be kept. Uses a second demodulator while the receiver is in sync, so roughly doubles demodulation CPU then. Replay with Tools > Replay Codec Frame Log. Takes effect when FreeDV is next started."));
+    sbsQuickRecord->Add(m_ckboxCodecFrameLog, 0, wxALL | wxALIGN_LEFT, 5);
     
     sizerKeyer->Add(sbsQuickRecord,0, wxALL | wxEXPAND, 5);
     
@@ -447,6 +504,12 @@ OptionsDlg::OptionsDlg(wxWindow* parent, wxWindowID id, const wxString& title, c
     sbSizer_singleThread->Add(m_ckboxSingleRxThread, 0, wxALL | wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
     sbSizer_multirx->Add(sbSizer_singleThread, 0, wxALIGN_LEFT, 0);
     
+    wxBoxSizer* sbSizer_dualRx = new wxBoxSizer(wxHORIZONTAL);
+    m_ckboxDualRx = new wxCheckBox(m_modemTab, wxID_ANY, _("Decode left and right input channels as separate receivers"), wxDefaultPosition, wxSize(-1,-1), 0);
+    m_ckboxDualRx->SetToolTip(_("For radios with main and sub receivers on the left and right channels. The sub receiver has its own tab and its audio is mixed into the speaker output."));
+    sbSizer_dualRx->Add(m_ckboxDualRx, 0, wxALL | wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+    sbSizer_multirx->Add(sbSizer_dualRx, 0, wxALIGN_LEFT, 0);
+    
     sizerModem->Add(sbSizer_multirx,0, wxALL|wxEXPAND, 5);
     
     wxStaticBox *sb_modemstats = new wxStaticBox(m_modemTab, wxID_ANY, _("Modem Statistics"));
@@ -663,12 +726,20 @@ OptionsDlg::OptionsDlg(wxWindow* parent, wxWindowID id, const wxString& title, c
     m_buttonChooseVoiceKeyerWaveFilePath->MoveBeforeInTabOrder(m_txtCtrlVoiceKeyerRxPause);
     m_txtCtrlVoiceKeyerRxPause->MoveBeforeInTabOrder(m_txtCtrlVoiceKeyerRepeats);
     
+    m_txtCtrlQuickRecordPath->MoveBeforeInTabOrder(m_buttonChooseQuickRecordPath);
+    m_buttonChooseQuickRecordPath->MoveBeforeInTabOrder(m_cbRecordingFormat);
+    m_cbRecordingFormat->MoveBeforeInTabOrder(m_txtCtrlRecordingRotateMinutes);
+    m_txtCtrlRecordingRotateMinutes->MoveBeforeInTabOrder(m_txtCtrlRecordingRotateMegabytes);
+    m_txtCtrlRecordingRotateMegabytes->MoveBeforeInTabOrder(m_txtCtrlFlightRecorderMinutes);
+    m_txtCtrlFlightRecorderMinutes->MoveBeforeInTabOrder(m_ckboxCodecFrameLog);
+    
     m_ckboxFreeDV700txClip->MoveBeforeInTabOrder(m_ckboxFreeDV700Combine);
     m_ckboxFreeDV700Combine->MoveBeforeInTabOrder(m_ckboxFreeDV700txBPF);
     m_ckboxFreeDV700txBPF->MoveBeforeInTabOrder(m_ckHalfDuplex);
     m_ckHalfDuplex->MoveBeforeInTabOrder(m_ckboxMultipleRx);
     m_ckboxMultipleRx->MoveBeforeInTabOrder(m_ckboxSingleRxThread);
-    m_ckboxSingleRxThread->MoveBeforeInTabOrder(m_statsResetTime);
+    m_ckboxSingleRxThread->MoveBeforeInTabOrder(m_ckboxDualRx);
+    m_ckboxDualRx->MoveBeforeInTabOrder(m_statsResetTime);
     
     m_ckboxTestFrame->MoveBeforeInTabOrder(m_ckboxChannelNoise);
     m_ckboxChannelNoise->MoveBeforeInTabOrder(m_txtNoiseSNR);
@@ -839,11 +910,17 @@ void OptionsDlg::ExchangeData(int inout, bool storePersistent)
         m_txtCtrlVoiceKeyerRepeats->SetValue(wxString::Format(wxT("%i"), wxGetApp().appConfiguration.voiceKeyerRepeats.get()));
 
         m_txtCtrlQuickRecordPath->SetValue(wxGetApp().appConfiguration.quickRecordPath);
+        m_cbRecordingFormat->SetSelection(wxGetApp().appConfiguration.recordingFormat);
+        m_txtCtrlRecordingRotateMinutes->SetValue(wxString::Format(wxT("%i"), wxGetApp().appConfiguration.recordingRotateMinutes.get()));
+        m_txtCtrlRecordingRotateMegabytes->SetValue(wxString::Format(wxT("%i"), wxGetApp().appConfiguration.recordingRotateMegabytes.get()));
+        m_txtCtrlFlightRecorderMinutes->SetValue(wxString::Format(wxT("%i"), wxGetApp().appConfiguration.flightRecorderMinutes.get()));
+        m_ckboxCodecFrameLog->SetValue(wxGetApp().appConfiguration.codecFrameLogEnable);
         
         m_ckHalfDuplex->SetValue(wxGetApp().appConfiguration.halfDuplexMode);
 
         m_ckboxMultipleRx->SetValue(wxGetApp().appConfiguration.multipleReceiveEnabled);
         m_ckboxSingleRxThread->SetValue(wxGetApp().appConfiguration.multipleReceiveOnSingleThread);
+        m_ckboxDualRx->SetValue(wxGetApp().appConfiguration.dualReceiverEnabled);
         
         m_ckboxTestFrame->SetValue(wxGetApp().m_testFrames);
 
@@ -994,6 +1071,7 @@ void OptionsDlg::ExchangeData(int inout, bool storePersistent)
         wxGetApp().appConfiguration.halfDuplexMode = m_ckHalfDuplex->GetValue();
         wxGetApp().appConfiguration.multipleReceiveEnabled = m_ckboxMultipleRx->GetValue();
         wxGetApp().appConfiguration.multipleReceiveOnSingleThread = m_ckboxSingleRxThread->GetValue();
+        wxGetApp().appConfiguration.dualReceiverEnabled = m_ckboxDualRx->GetValue();
         
         /* Voice Keyer */
 
@@ -1006,6 +1084,16 @@ void OptionsDlg::ExchangeData(int inout, bool storePersistent)
         wxGetApp().appConfiguration.voiceKeyerRepeats = (int)tmp;
         
         wxGetApp().appConfiguration.quickRecordPath = m_txtCtrlQuickRecordPath->GetValue();
+        if (m_cbRecordingFormat->GetSelection() != wxNOT_FOUND)
+        {
+            wxGetApp().appConfiguration.recordingFormat = m_cbRecordingFormat->GetSelection();
+        }
+        m_txtCtrlRecordingRotateMinutes->GetValue().ToLong(&tmp); if (tmp < 0) tmp = 0; wxGetApp().appConfiguration.recordingRotateMinutes = (int)tmp;
+        m_txtCtrlRecordingRotateMegabytes->GetValue().ToLong(&tmp); if (tmp < 0) tmp = 0; wxGetApp().appConfiguration.recordingRotateMegabytes = (int)tmp;
+        m_txtCtrlFlightRecorderMinutes->GetValue().ToLong(&tmp);
+        if (tmp < 0) {tmp = 0;} if (tmp > 60) {tmp = 60;}
+        wxGetApp().appConfiguration.flightRecorderMinutes = (int)tmp;
+        wxGetApp().appConfiguration.codecFrameLogEnable = m_ckboxCodecFrameLog->GetValue();
         
         wxGetApp().m_testFrames    = m_ckboxTestFrame->GetValue();
 
@@ -1345,12 +1433,14 @@ void OptionsDlg::updateMultipleRxState()
     {
         m_ckboxMultipleRx->Enable(true);
         m_ckboxSingleRxThread->Enable(m_ckboxMultipleRx->GetValue());
+        m_ckboxDualRx->Enable(true);
     }
     else
     {
         // Multi-RX settings cannot be updated during a session.
         m_ckboxMultipleRx->Enable(false);
         m_ckboxSingleRxThread->Enable(false);
+        m_ckboxDualRx->Enable(false);
     }
 }
 
@@ -1398,7 +1488,7 @@ void OptionsDlg::DisplayFifoPACounters() {
     
     char fifo_counters[STR_LENGTH];
 
-    snprintf(fifo_counters, STR_LENGTH, "Fifos: infull1: %d outempty1: %d infull2: %d outempty2: %d", g_infifo1_full, g_outfifo1_empty, g_infifo2_full, g_outfifo2_empty);
+    snprintf(fifo_counters, STR_LENGTH, "Fifos: infull1: %d outempty1: %d infull2: %d outempty2: %d drift rx: %+.0f tx: %+.0f ppm latency rx: %.0f tx: %.0f ms", g_infifo1_full, g_outfifo1_empty, g_infifo2_full, g_outfifo2_empty, g_rxDriftPpm, g_txDriftPpm, g_rxLatencyMs, g_txLatencyMs);
     wxString fifo_counters_string(fifo_counters);
     m_textFifos->SetLabel(fifo_counters_string);
 
@@ -118,6 +118,11 @@ class OptionsDlg : public wxDialog
         /* Quick Record */
         wxButton     *m_buttonChooseQuickRecordPath;
         wxTextCtrl   *m_txtCtrlQuickRecordPath;
+        wxComboBox   *m_cbRecordingFormat;
+        wxTextCtrl   *m_txtCtrlRecordingRotateMinutes;
+        wxTextCtrl   *m_txtCtrlRecordingRotateMegabytes;
+        wxTextCtrl   *m_txtCtrlFlightRecorderMinutes;
+        wxCheckBox   *m_ckboxCodecFrameLog;
         
         /* test frames, other simulated channel impairments */
 
@@ -172,6 +177,7 @@ class OptionsDlg : public wxDialog
 
         wxCheckBox*  m_ckboxMultipleRx;
         wxCheckBox*  m_ckboxSingleRxThread;
+        wxCheckBox*  m_ckboxDualRx;
         wxTextCtrl*  m_statsResetTime;
         
         wxCheckBox*  m_ckbox_use_utc_time;
@@ -36,8 +36,14 @@
 #include "os/os_interface.h"
 #include "freedv_interface.h"
 #include "audio/AudioEngineFactory.h"
+#include "audio/FileAudioEngine.h"
+#if defined(AUDIO_ENGINE_JACK_ENABLE)
+#include "audio/JackAudioEngine.h"
+#endif // defined(AUDIO_ENGINE_JACK_ENABLE)
 #include "codec2_fdmdv.h"
 #include "pipeline/TxRxThread.h"
+#include "pipeline/SpectrumEngine.h"
+#include "pipeline/SpectrumExporter.h"
 #include "reporting/pskreporter.h"
 #include "reporting/FreeDVReporter.h"
 
@@ -84,7 +90,8 @@ short              *g_error_hist, *g_error_histn;
 float               g_tone_phase;
 
 // time averaged magnitude spectrum used for waterfall and spectrum display
-float               g_avmag[MODEM_STATS_NSPEC];
+SpectrumEngine*     g_spectrumEngine = nullptr;
+extern SpectrumEngine* g_spectrumEngineSub;
 
 // TX level for attenuation
 int g_txLevel = 0;
@@ -124,36 +131,46 @@ int                 g_infifo1_full;
 int                 g_outfifo1_empty;
 int                 g_infifo2_full;
 int                 g_outfifo2_empty;
+
+// Estimated clock drift between the sound cards (see ClockDriftCorrector)
+float               g_rxDriftPpm;
+float               g_txDriftPpm;
+
+// Capture to playback latency, radio to speaker and mic to radio (see StreamTimestamp)
+float               g_rxLatencyMs;
+float               g_txLatencyMs;
 int                 g_AEstatus1[4];
 int                 g_AEstatus2[4];
 
 // playing and recording from sound files
 
-extern SNDFILE            *g_sfPlayFile;
+extern PlaybackSource     *g_playSource;
 extern bool                g_playFileToMicIn;
 extern bool                g_loopPlayFileToMicIn;
 extern int                 g_playFileToMicInEventId;
 
-extern SNDFILE            *g_sfRecFile;
+extern RecordingWriter    *g_recWriter;
 extern bool                g_recFileFromRadio;
 extern unsigned int        g_recFromRadioSamples;
 extern int                 g_recFileFromRadioEventId;
 
-extern SNDFILE            *g_sfPlayFileFromRadio;
+extern PlaybackSource     *g_playSourceFromRadio;
 extern bool                g_playFileFromRadio;
 extern int                 g_sfFs;
 extern int                 g_sfTxFs;
 extern bool                g_loopPlayFileFromRadio;
 extern int                 g_playFileFromRadioEventId;
 
-extern SNDFILE            *g_sfRecFileFromModulator;
+extern RecordingWriter    *g_recWriterFromModulator;
 extern bool                g_recFileFromModulator;
 extern int                 g_recFileFromModulatorEventId;
 
-extern SNDFILE            *g_sfRecMicFile;
+extern RecordingWriter    *g_recMicWriter;
 extern bool                g_recFileFromMic;
 extern bool                g_recVoiceKeyerFile;
 
+extern FlightRecorder     *g_flightRecorder;
+
 wxWindow           *g_parent;
 
 // Click to tune rx and tx frequency offset states
@@ -188,6 +205,7 @@ void MainApp::OnInitCmdLine(wxCmdLineParser& parser)
 {
     wxApp::OnInitCmdLine(parser);
     parser.AddOption("f", "config", "Use different configuration file instead of the default.");
+    parser.AddOption("a", "audio-engine", "Audio engine: system (default), jack (if available), file or file-virtual. The file engines treat the configured sound device names as WAV/raw file paths (or \"null\"); file-virtual runs as fast as possible instead of in real time.");
 }
 
 bool MainApp::OnCmdLineParsed(wxCmdLineParser& parser)
@@ -210,6 +228,30 @@ bool MainApp::OnCmdLineParsed(wxCmdLineParser& parser)
         customConfigFileName = fn.GetFullName();
     }
     pConfig->SetRecordDefaults();
+
+    wxString audioEngine;
+    if (parser.Found("a", &audioEngine))
+    {
+        if (audioEngine == "file")
+        {
+            AudioEngineFactory::SetEngineType(AudioEngineFactory::ENGINE_FILE_REALTIME);
+        }
+        else if (audioEngine == "file-virtual")
+        {
+            AudioEngineFactory::SetEngineType(AudioEngineFactory::ENGINE_FILE_VIRTUAL);
+        }
+#if defined(AUDIO_ENGINE_JACK_ENABLE)
+        else if (audioEngine == "jack")
+        {
+            AudioEngineFactory::SetEngineType(AudioEngineFactory::ENGINE_JACK);
+        }
+#endif // defined(AUDIO_ENGINE_JACK_ENABLE)
+        else if (audioEngine != "system")
+        {
+            fprintf(stderr, "Unknown audio engine %s\n", (const char*)audioEngine.ToUTF8());
+            return false;
+        }
+    }
     
     return true;
 }
@@ -672,9 +714,51 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
 
     tools->Append(m_menuItemToolsConfigDelete);
     
+    // Spectrum engine feeding the waterfall and spectrum plots. RX samples
+    // arrive at FS (see ComputeRfSpectrumStep) and are analyzed once per DT.
+    g_spectrumEngine = new SpectrumEngine(FS, wxGetApp().appConfiguration.currentSpectrumFftSize, (int)(DT * 1000));
+    g_spectrumEngine->start();
+    
+    // Optionally also write the spectrum to disk for unattended monitoring.
+    // This runs whether or not the waterfall/spectrum tabs are visible.
+    m_spectrumExporter = nullptr;
+    m_panelSpectrumSub = nullptr;
+    m_textSubRx = nullptr;
+    wxString spectrumExportPath = wxGetApp().appConfiguration.spectrumExportPath;
+    if (spectrumExportPath != "")
+    {
+        m_spectrumExporter = new SpectrumExporter(
+            (const char*)spectrumExportPath.ToUTF8(),
+            wxGetApp().appConfiguration.spectrumExportFormats,
+            wxGetApp().appConfiguration.spectrumExportIntervalMs,
+            wxGetApp().appConfiguration.waterfallColor,
+            g_spectrumEngine->getSampleRate());
+        
+        SpectrumExporter* exporter = m_spectrumExporter;
+        g_spectrumEngine->setSpectrumListener([exporter](const float* magDb, int numBins) {
+            exporter->addSpectrum(magDb, numBins);
+        });
+    }
+    
+    PlotPanel::SetSoftwareRendering(wxGetApp().appConfiguration.plotSoftwareRendering);
+
+#if defined(AUDIO_ENGINE_JACK_ENABLE)
+    auto jackEngine = std::dynamic_pointer_cast<JackAudioEngine>(AudioEngineFactory::GetAudioEngine());
+    if (jackEngine)
+    {
+        jackEngine->setPeriodFrames(wxGetApp().appConfiguration.audioConfiguration.jackPeriodFrames);
+    }
+#endif // defined(AUDIO_ENGINE_JACK_ENABLE)
+
     // Add Waterfall Plot window
     m_panelWaterfall = new PlotWaterfall((wxFrame*) m_auiNbookCtrl, false, 0);
-    m_panelWaterfall->SetToolTip(_("Double click to tune, middle click to re-center"));
+    m_panelWaterfall->SetToolTip(_("Double click to tune, middle click to re-center, Page Up/Down to review history"));
+    
+    // Waterfall scrollback, optionally spilled to a memory mapped file.
+    wxString waterfallHistoryFile = wxGetApp().appConfiguration.waterfallHistoryFile;
+    m_panelWaterfall->enableHistory(
+        wxGetApp().appConfiguration.waterfallHistoryHours * 3600 / WATERFALL_HISTORY_ROW_SECS,
+        (const char*)waterfallHistoryFile.ToUTF8());
     m_auiNbookCtrl->AddPage(m_panelWaterfall, _("Waterfall"), true, wxNullBitmap);
 
     // Add Spectrum Plot window
@@ -686,8 +770,9 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
     spectrumPanelSizer->AddGrowableCol(0);
     
     // Actual Spectrum plot
-    m_panelSpectrum = new PlotSpectrum(spectrumPanel, g_avmag,
-                                       MODEM_STATS_NSPEC*((float)MAX_F_HZ/MODEM_STATS_MAX_F_HZ));
+    m_spectrumMagDB.resize(g_spectrumEngine->getFftSize() / 2, MIN_MAG_DB);
+    m_panelSpectrum = new PlotSpectrum(spectrumPanel, &m_spectrumMagDB[0],
+                                       m_spectrumMagDB.size()*((float)MAX_F_HZ/(FS/2)));
     m_panelSpectrum->SetToolTip(_("Double click to tune, middle click to re-center"));
     spectrumPanelSizer->Add(m_panelSpectrum, 0, wxALL | wxEXPAND, 5);
     
@@ -709,6 +794,20 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
     wxStaticText* labelSamples = new wxStaticText(spectrumPanel, wxID_ANY, wxT("sample(s)"), wxDefaultPosition, wxDefaultSize, 0);
     spectrumPanelControlSizer->Add(labelSamples, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
     
+    wxStaticText* labelFftSize = new wxStaticText(spectrumPanel, wxID_ANY, wxT("FFT size"), wxDefaultPosition, wxDefaultSize, 0);
+    spectrumPanelControlSizer->Add(labelFftSize, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+    
+    wxArrayString fftSizeChoices;
+    for (int fftSize = SPECTRUM_ENGINE_MIN_FFT_SIZE; fftSize <= SPECTRUM_ENGINE_MAX_FFT_SIZE; fftSize <<= 1)
+    {
+        fftSizeChoices.Add(wxString::Format("%d", fftSize));
+    }
+    m_cbxSpectrumFftSize = new wxComboBox(spectrumPanel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, fftSizeChoices, wxCB_DROPDOWN | wxCB_READONLY);
+    m_cbxSpectrumFftSize->SetStringSelection(wxString::Format("%d", g_spectrumEngine->getFftSize()));
+    spectrumPanelControlSizer->Add(m_cbxSpectrumFftSize, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+    
+    m_cbxSpectrumFftSize->Connect(wxEVT_TEXT, wxCommandEventHandler(MainFrame::OnSpectrumFftSizeChange), NULL, this);
+    
     spectrumPanelSizer->Add(spectrumPanelControlSizer, 0, wxALL | wxEXPAND, 5);
     spectrumPanel->SetSizerAndFit(spectrumPanelSizer);
     
@@ -720,16 +819,19 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
 
     // Add Demod Input window
     m_panelDemodIn = new PlotScalar((wxFrame*) m_auiNbookCtrl, 1, WAVEFORM_PLOT_TIME, 1.0/WAVEFORM_PLOT_FS, -1, 1, 1, 0.2, "%2.1f", 0);
+    m_panelDemodIn->setHistorySecs(WAVEFORM_PLOT_HISTORY);
     m_auiNbookCtrl->AddPage(m_panelDemodIn, _("Frm Radio"), true, wxNullBitmap);
     g_plotDemodInFifo = codec2_fifo_create(4*WAVEFORM_PLOT_BUF);
 
     // Add Speech Input window
     m_panelSpeechIn = new PlotScalar((wxFrame*) m_auiNbookCtrl, 1, WAVEFORM_PLOT_TIME, 1.0/WAVEFORM_PLOT_FS, -1, 1, 1, 0.2, "%2.1f", 0);
+    m_panelSpeechIn->setHistorySecs(WAVEFORM_PLOT_HISTORY);
     m_auiNbookCtrl->AddPage(m_panelSpeechIn, _("Frm Mic"), true, wxNullBitmap);
     g_plotSpeechInFifo = codec2_fifo_create(4*WAVEFORM_PLOT_BUF);
 
     // Add Speech Output window
     m_panelSpeechOut = new PlotScalar((wxFrame*) m_auiNbookCtrl, 1, WAVEFORM_PLOT_TIME, 1.0/WAVEFORM_PLOT_FS, -1, 1, 1, 0.2, "%2.1f", 0);
+    m_panelSpeechOut->setHistorySecs(WAVEFORM_PLOT_HISTORY);
     m_auiNbookCtrl->AddPage(m_panelSpeechOut, _("To Spkr/Hdphns"), true, wxNullBitmap);
     g_plotSpeechOutFifo = codec2_fifo_create(4*WAVEFORM_PLOT_BUF);
 
@@ -751,6 +853,19 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
     m_panelTestFrameErrorsHist->setBarGraph(1);
     m_panelTestFrameErrorsHist->setLogY(1);
 
+    // Plots repainted by OnTimer() when visible and changed. The waterfall
+    // paces itself (see PlotWaterfall::checkDT()); the slow moving modem
+    // state plots don't need the full timer rate.
+    m_scheduledPlots = {
+        m_panelWaterfall, m_panelSpectrum, m_panelScatter, m_panelDemodIn,
+        m_panelSpeechIn, m_panelSpeechOut, m_panelTimeOffset, m_panelFreqOffset,
+        m_panelTestFrameErrors, m_panelTestFrameErrorsHist
+    };
+    m_panelTimeOffset->setMinRefreshIntervalMs(PLOT_SLOW_REFRESH_MS);
+    m_panelFreqOffset->setMinRefreshIntervalMs(PLOT_SLOW_REFRESH_MS);
+    m_panelTestFrameErrors->setMinRefreshIntervalMs(PLOT_SLOW_REFRESH_MS);
+    m_panelTestFrameErrorsHist->setMinRefreshIntervalMs(PLOT_SLOW_REFRESH_MS);
+
 //    this->Connect(m_menuItemHelpUpdates->GetId(), wxEVT_UPDATE_UI, wxUpdateUIEventHandler(TopFrame::OnHelpCheckUpdatesUI));
      m_togBtnOnOff->Connect(wxEVT_UPDATE_UI, wxUpdateUIEventHandler(MainFrame::OnTogBtnOnOffUI), NULL, this);
     m_togBtnAnalog->Connect(wxEVT_UPDATE_UI, wxUpdateUIEventHandler(MainFrame::OnTogBtnAnalogClickUI), NULL, this);
@@ -829,26 +944,28 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
     m_txThread = nullptr;
     m_rxThread = nullptr;
     wxGetApp().linkStep = nullptr;
+    m_flightRecorderBusy = false;
+    m_flightRecorderCancel = false;
     
 #ifdef _USE_ONIDLE
     Connect(wxEVT_IDLE, wxIdleEventHandler(MainFrame::OnIdle), NULL, this);
 #endif //_USE_ONIDLE
 
-    g_sfPlayFile = NULL;
+    g_playSource = nullptr;
     g_playFileToMicIn = false;
     g_loopPlayFileToMicIn = false;
 
-    g_sfRecFile = NULL;
+    g_recWriter = nullptr;
     g_recFileFromRadio = false;
 
-    g_sfPlayFileFromRadio = NULL;
+    g_playSourceFromRadio = nullptr;
     g_playFileFromRadio = false;
     g_loopPlayFileFromRadio = false;
 
-    g_sfRecFileFromModulator = NULL;
+    g_recWriterFromModulator = nullptr;
     g_recFileFromModulator = false;
     
-    g_sfRecMicFile = nullptr;
+    g_recMicWriter = nullptr;
     g_recFileFromMic = false;
     g_recVoiceKeyerFile = false;
 
@@ -877,6 +994,9 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
 
     optionsDlg = new OptionsDlg(NULL);
     m_schedule_restore = false;
+    m_uiTimerTimeUs = 0;
+    m_uiPaintTimeUs = 0;
+    m_uiNumPaints = 0;
 
     vk_state = VK_IDLE;
 
@@ -966,6 +1086,7 @@ MainFrame::MainFrame(wxWindow *parent) : TopFrame(parent, wxID_ANY, _("FreeDV ")
 MainFrame::~MainFrame()
 {
     delete voiceKeyerPopupMenu_;
+    stopFlightRecorderTask_();
     
     int x;
     int y;
@@ -1042,6 +1163,7 @@ MainFrame::~MainFrame()
     wxGetApp().appConfiguration.save(pConfig);
 
     m_cbxNumSpectrumAveraging->Disconnect(wxEVT_TEXT, wxCommandEventHandler(MainFrame::OnAveragingChange), NULL, this);
+    m_cbxSpectrumFftSize->Disconnect(wxEVT_TEXT, wxCommandEventHandler(MainFrame::OnSpectrumFftSizeChange), NULL, this);
     m_togBtnOnOff->Disconnect(wxEVT_UPDATE_UI, wxUpdateUIEventHandler(MainFrame::OnTogBtnOnOffUI), NULL, this);
     m_togBtnAnalog->Disconnect(wxEVT_UPDATE_UI, wxUpdateUIEventHandler(MainFrame::OnTogBtnAnalogClickUI), NULL, this);
 
@@ -1049,23 +1171,29 @@ MainFrame::~MainFrame()
     {
         stopRxStream();
     } 
+    stopSubReceiver_();
     sox_biquad_finish();
+    
+    // Only safe once the RX pipeline (which feeds it) is gone.
+    delete g_spectrumEngine;
+    g_spectrumEngine = nullptr;
+    
+    // Flushes any partially written tile.
+    delete m_spectrumExporter;
+    m_spectrumExporter = nullptr;
 
-    if (g_sfPlayFile != NULL)
-    {
-        sf_close(g_sfPlayFile);
-        g_sfPlayFile = NULL;
-    }
-    if (g_sfRecFile != NULL)
-    {
-        sf_close(g_sfRecFile);
-        g_sfRecFile = NULL;
-    }
-    if (g_sfRecFileFromModulator != NULL)
-    {
-        sf_close(g_sfRecFileFromModulator);
-        g_sfRecFileFromModulator = NULL;
-    }
+    delete g_playSource;
+    g_playSource = nullptr;
+    delete g_playSourceFromRadio;
+    g_playSourceFromRadio = nullptr;
+
+    delete g_flightRecorder;
+    g_flightRecorder = nullptr;
+
+    // Both point to the same recording.
+    delete g_recWriter;
+    g_recWriter = nullptr;
+    g_recWriterFromModulator = nullptr;
 #ifdef _USE_TIMER
     if(m_pskReporterTimer.IsRunning())
     {
@@ -1103,6 +1231,19 @@ void MainFrame::OnAveragingChange(wxCommandEvent& event)
     wxGetApp().appConfiguration.currentSpectrumAveraging = m_cbxNumSpectrumAveraging->GetSelection();
 }
 
+void MainFrame::OnSpectrumFftSizeChange(wxCommandEvent& event)
+{
+    long fftSize = SPECTRUM_ENGINE_DEFAULT_FFT_SIZE;
+    m_cbxSpectrumFftSize->GetValue().ToLong(&fftSize);
+    
+    g_spectrumEngine->setFftSize(fftSize);
+    wxGetApp().appConfiguration.currentSpectrumFftSize = g_spectrumEngine->getFftSize();
+    if (g_spectrumEngineSub != nullptr)
+    {
+        g_spectrumEngineSub->setFftSize(fftSize);
+    }
+}
+
 #ifdef _USE_TIMER
 //----------------------------------------------------------------
 // OnTimer()
@@ -1138,25 +1279,43 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
      else
      {         
         int r,c;
+        auto timerStart = std::chrono::steady_clock::now();
 
-        if (m_panelWaterfall->checkDT()) {
+        // Pick up the latest spectrum, if any. Both plots keep drawing the
+        // previous one otherwise. Bins span 0 ... FS/2 regardless of mode.
+        // Always done, as the waterfall history must keep recording while
+        // hidden.
+        if (g_spectrumEngine->getSpectrum(m_spectrumMagDB))
+        {
+            m_panelWaterfall->setFs(g_spectrumEngine->getSampleRate());
+            m_panelWaterfall->setSpectrum(&m_spectrumMagDB[0], m_spectrumMagDB.size());
+            m_panelSpectrum->setSpectrum(
+                &m_spectrumMagDB[0], 
+                m_spectrumMagDB.size()*((float)MAX_F_HZ/(g_spectrumEngine->getSampleRate()/2)));
+            m_panelSpectrum->markDirty();
+        }
+        updateSubReceiver_();
+        
+        if (m_panelWaterfall->isOnScreen() && m_panelWaterfall->checkDT()) {
             m_panelWaterfall->setRxFreq(FDMDV_FCENTRE - g_RxFreqOffsetHz);
             m_panelWaterfall->m_newdata = true;
             m_panelWaterfall->setColor(wxGetApp().appConfiguration.waterfallColor);
             m_panelWaterfall->addOffset(freedvInterface.getCurrentRxModemStats()->foff);
             m_panelWaterfall->setSync(freedvInterface.getSync() ? true : false);
-            m_panelWaterfall->Refresh();
+            m_panelWaterfall->markDirty();
         }
 
-        m_panelSpectrum->setRxFreq(FDMDV_FCENTRE - g_RxFreqOffsetHz);
-        
-        // Note: each element in this combo box is a numeric value starting from 1,
-        // so just incrementing the selected index should get us the correct results.
-        m_panelSpectrum->setNumAveraging(m_cbxNumSpectrumAveraging->GetSelection() + 1);
-        m_panelSpectrum->addOffset(freedvInterface.getCurrentRxModemStats()->foff);
-        m_panelSpectrum->setSync(freedvInterface.getSync() ? true : false);
-        m_panelSpectrum->m_newdata = true;
-        m_panelSpectrum->Refresh();
+        if (m_panelSpectrum->isOnScreen())
+        {
+            m_panelSpectrum->setRxFreq(FDMDV_FCENTRE - g_RxFreqOffsetHz);
+            
+            // Note: each element in this combo box is a numeric value starting from 1,
+            // so just incrementing the selected index should get us the correct results.
+            m_panelSpectrum->setNumAveraging(m_cbxNumSpectrumAveraging->GetSelection() + 1);
+            m_panelSpectrum->addOffset(freedvInterface.getCurrentRxModemStats()->foff);
+            m_panelSpectrum->setSync(freedvInterface.getSync() ? true : false);
+            m_panelSpectrum->m_newdata = true;
+        }
 
         /* update scatter/eye plot ------------------------------------------------------------*/
 
@@ -1172,6 +1331,10 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
                 m_panelScatter->clearCurrentSamples();
             }
             wxGetApp().m_prevMode = currentMode;
+
+            // The stats are only a snapshot, so nothing is lost by not
+            // plotting them while the scatter plot can't be seen.
+            bool scatterOnScreen = m_panelScatter->isOnScreen();
         
             if (currentMode == FREEDV_MODE_800XA) {
 
@@ -1180,7 +1343,7 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
                 /* add samples row by row */
 
                 int i;
-                for (i=0; i<freedvInterface.getCurrentRxModemStats()->neyetr; i++) {
+                for (i=0; scatterOnScreen && i<freedvInterface.getCurrentRxModemStats()->neyetr; i++) {
                     m_panelScatter->add_new_samples_eye(&freedvInterface.getCurrentRxModemStats()->rx_eye[i][0], freedvInterface.getCurrentRxModemStats()->neyesamp);
                 }
             }
@@ -1217,7 +1380,7 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
                 }
             
                 /* PSK Modes - scatter plot -------------------------------------------------------*/
-                for (r=0; r<freedvInterface.getCurrentRxModemStats()->nr; r++) {
+                for (r=0; scatterOnScreen && r<freedvInterface.getCurrentRxModemStats()->nr; r++) {
 
                     if ((currentMode == FREEDV_MODE_1600) ||
                         (currentMode == FREEDV_MODE_700D) ||
@@ -1257,9 +1420,12 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
 
                 }
             }
-        }
 
-        m_panelScatter->Refresh();
+            if (scatterOnScreen)
+            {
+                m_panelScatter->markDirty();
+            }
+        }
 
         // Oscilloscope type speech plots -------------------------------------------------------
 
@@ -1269,28 +1435,45 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
             //fprintf(stderr, "empty!\n");
         }
         m_panelSpeechIn->add_new_short_samples(0, speechInPlotSamples, WAVEFORM_PLOT_BUF, 32767);
-        m_panelSpeechIn->Refresh();
+        if (m_panelSpeechIn->isOnScreen())
+        {
+            m_panelSpeechIn->markDirty();
+        }
 
         short speechOutPlotSamples[WAVEFORM_PLOT_BUF];
         if (codec2_fifo_read(g_plotSpeechOutFifo, speechOutPlotSamples, WAVEFORM_PLOT_BUF))
             memset(speechOutPlotSamples, 0, WAVEFORM_PLOT_BUF*sizeof(short));
         m_panelSpeechOut->add_new_short_samples(0, speechOutPlotSamples, WAVEFORM_PLOT_BUF, 32767);
-        m_panelSpeechOut->Refresh();
+        if (m_panelSpeechOut->isOnScreen())
+        {
+            m_panelSpeechOut->markDirty();
+        }
 
         short demodInPlotSamples[WAVEFORM_PLOT_BUF];
         if (codec2_fifo_read(g_plotDemodInFifo, demodInPlotSamples, WAVEFORM_PLOT_BUF)) {
             memset(demodInPlotSamples, 0, WAVEFORM_PLOT_BUF*sizeof(short));
         }
         m_panelDemodIn->add_new_short_samples(0,demodInPlotSamples, WAVEFORM_PLOT_BUF, 32767);
-        m_panelDemodIn->Refresh();
+        if (m_panelDemodIn->isOnScreen())
+        {
+            m_panelDemodIn->markDirty();
+        }
 
         // Demod states -----------------------------------------------------------------------
 
+        // These get a sample every tick even when hidden so the time axis
+        // stays correct; only their repaints are skipped or throttled.
         m_panelTimeOffset->add_new_sample(0, (float)freedvInterface.getCurrentRxModemStats()->rx_timing/FDMDV_NOM_SAMPLES_PER_FRAME);
-        m_panelTimeOffset->Refresh();
+        if (m_panelTimeOffset->isOnScreen())
+        {
+            m_panelTimeOffset->markDirty();
+        }
 
         m_panelFreqOffset->add_new_sample(0, freedvInterface.getCurrentRxModemStats()->foff);
-        m_panelFreqOffset->Refresh();
+        if (m_panelFreqOffset->isOnScreen())
+        {
+            m_panelFreqOffset->markDirty();
+        }
 
         // SNR text box and gauge ------------------------------------------------------------
 
@@ -1719,8 +1902,8 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
                     m_panelTestFrameErrorsHist->add_new_samples(0, ber, 2*MODEM_STATS_NC_MAX);
                 }
 
-                m_panelTestFrameErrors->Refresh();
-                m_panelTestFrameErrorsHist->Refresh();
+                m_panelTestFrameErrors->markDirty();
+                m_panelTestFrameErrorsHist->markDirty();
             
                 delete[] error_pattern;
             }
@@ -1742,8 +1925,59 @@ void MainFrame::OnTimer(wxTimerEvent &evt)
 
         // Detect Sync state machine
         DetectSyncProcessEvent();
+
+        // Repaint whatever is visible and has changed.
+        for (auto plot : m_scheduledPlots)
+        {
+            plot->refreshIfDue();
+        }
+
+        updateUiLoadStats_(timerStart);
     }
 }
+
+//-------------------------------------------------------------------------
+// updateUiLoadStats_()
+//
+// Accounts for the time spent in the plot timer and in painting plots,
+// and with --verbose periodically reports it as ms of UI thread time per
+// second (i.e. tenths of a percent of one core).
+//-------------------------------------------------------------------------
+void MainFrame::updateUiLoadStats_(std::chrono::steady_clock::time_point timerStart)
+{
+    auto now = std::chrono::steady_clock::now();
+    m_uiTimerTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(now - timerStart).count();
+
+    if (m_uiLoadStatsStart == std::chrono::steady_clock::time_point())
+    {
+        m_uiLoadStatsStart = timerStart;
+    }
+
+    double elapsedSecs = std::chrono::duration<double>(now - m_uiLoadStatsStart).count();
+    if (elapsedSecs < UI_LOAD_REPORT_SECS)
+    {
+        return;
+    }
+
+    long long paintTimeUs;
+    int numPaints;
+    PlotPanel::GetPaintStats(&paintTimeUs, &numPaints);
+
+    if (g_verbose)
+    {
+        fprintf(
+            stderr, 
+            "UI load: timer %.1f ms/s, plot paint %.1f ms/s (%.1f paints/s)\n",
+            m_uiTimerTimeUs / 1000.0 / elapsedSecs,
+            (paintTimeUs - m_uiPaintTimeUs) / 1000.0 / elapsedSecs,
+            (numPaints - m_uiNumPaints) / elapsedSecs);
+    }
+
+    m_uiTimerTimeUs = 0;
+    m_uiPaintTimeUs = paintTimeUs;
+    m_uiNumPaints = numPaints;
+    m_uiLoadStatsStart = now;
+}
 #endif
 
 
@@ -1772,15 +2006,15 @@ void MainFrame::OnExit(wxCommandEvent& event)
     m_plotTimer.Stop();
     m_pskReporterTimer.Stop();
 #endif // _USE_TIMER
-    if(g_sfPlayFile != NULL)
-    {
-        sf_close(g_sfPlayFile);
-        g_sfPlayFile = NULL;
-    }
-    if(g_sfRecFile != NULL)
+    g_mutexProtectingCallbackData.Lock();
+    PlaybackSource* playSource = g_playSource;
+    g_playSource = nullptr;
+    g_playFileToMicIn = false;
+    g_mutexProtectingCallbackData.Unlock();
+    delete playSource;
+    if(g_recWriter != nullptr)
     {
-        sf_close(g_sfRecFile);
-        g_sfRecFile = NULL;
+        StopRecFileFromRadio();
     }
     if(m_RxRunning)
     {
@@ -2038,10 +2272,6 @@ void MainFrame::performFreeDVOn_()
         if (g_verbose) fprintf(stderr, "freedv_get_n_speech_samples(tx): %d\n", freedvInterface.getTxNumSpeechSamples());
         if (g_verbose) fprintf(stderr, "freedv_get_speech_sample_rate(tx): %d\n", freedvInterface.getTxSpeechSampleRate());
     
-        // adjust spectrum and waterfall freq scaling base on mode
-        m_panelSpectrum->setFreqScale(MODEM_STATS_NSPEC*((float)MAX_F_HZ/(freedvInterface.getTxModemSampleRate()/2)));
-        m_panelWaterfall->setFs(freedvInterface.getTxModemSampleRate());
-    
         // Init text msg decoding
         if (!wxGetApp().appConfiguration.reportingConfiguration.reportingEnabled)
             freedvInterface.setTextVaricodeNum(1);
@@ -2054,6 +2284,7 @@ void MainFrame::performFreeDVOn_()
             m_panelScatter->setEyeScatter(PLOT_SCATTER_MODE_SCATTER);
         }
     });
+    startSubReceiver_();
 
     g_State = g_prev_State = 0;
     g_snr = 0.0;
@@ -2259,6 +2490,7 @@ void MainFrame::performFreeDVOff_()
     delete[] g_error_hist;
     delete[] g_error_histn;
     freedvInterface.stop();
+    stopSubReceiver_();
     
     m_newMicInFilter = m_newSpkOutFilter = true;
 
@@ -2434,7 +2666,16 @@ void MainFrame::stopRxStream()
             m_rxThread = nullptr;
         }
 
+        stopCodecFrameLog_();
+
         wxGetApp().linkStep = nullptr;
+
+        auto fileEngine = std::dynamic_pointer_cast<FileAudioEngine>(AudioEngineFactory::GetAudioEngine());
+        if (fileEngine)
+        {
+            fileEngine->setClockGate(nullptr);
+            fileEngine->setOnEndOfInput(nullptr);
+        }
         destroy_fifos();
         
         // Free memory allocated for filters.
@@ -2451,12 +2692,23 @@ void MainFrame::stopRxStream()
 
 void MainFrame::destroy_fifos(void)
 {
-    codec2_fifo_destroy(g_rxUserdata->infifo1);
-    codec2_fifo_destroy(g_rxUserdata->outfifo1);
-    if (g_rxUserdata->infifo2) codec2_fifo_destroy(g_rxUserdata->infifo2);
-    if (g_rxUserdata->outfifo2) codec2_fifo_destroy(g_rxUserdata->outfifo2);
-    codec2_fifo_destroy(g_rxUserdata->rxinfifo);
-    codec2_fifo_destroy(g_rxUserdata->rxoutfifo);
+    g_rxUserdata->infifo1.reset();
+    g_rxUserdata->outfifo1.reset();
+    g_rxUserdata->infifo1Sub.reset();
+    g_rxUserdata->infifo2.reset();
+    g_rxUserdata->outfifo2.reset();
+}
+
+//-------------------------------------------------------------------------
+// updateLatency(): for output callbacks, before reading from fifo
+//-------------------------------------------------------------------------
+static void updateLatency(IAudioDevice& dev, SpscRingBuffer<short>& fifo, const StreamTimestamp& timestamp, float& latencyMs)
+{
+    int64_t captureTimeUs;
+    if (timestamp.getTimeOf(fifo.getReadPosition(), dev.getSampleRate(), &captureTimeUs))
+    {
+        latencyMs = (dev.getCallbackTiming().bufferTimeUs - captureTimeUs) / 1000.0f;
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -2671,6 +2923,18 @@ void MainFrame::startRxStream()
             }
         }
 
+        // The sub receiver decodes the right channel, so a mono radio input
+        // would only give it a copy of what the main receiver is decoding.
+        if (g_spectrumEngineSub != nullptr && rxInSoundDevice->getNumChannels() < 2)
+        {
+            executeOnUiThreadAndWait_([&]() {
+                wxMessageBox(wxString::Format("The sub receiver needs a stereo radio input, but '%s' has only one channel. Only the main receiver will be used.", wxGetApp().appConfiguration.audioConfiguration.soundCard1In.deviceName.get()), wxT("Warning"), wxOK);
+
+                // On the UI thread so OnTimer() isn't using it meanwhile.
+                stopSubReceiver_();
+            });
+        }
+
         // Init call back data structure ----------------------------------------------
 
         g_rxUserdata = new paCallBackData;
@@ -2684,15 +2948,19 @@ void MainFrame::startRxStream()
         int m_fifoSize_ms = wxGetApp().appConfiguration.fifoSizeMs;
         int soundCard1InFifoSizeSamples = m_fifoSize_ms*wxGetApp().appConfiguration.audioConfiguration.soundCard1In.sampleRate/1000;
         int soundCard1OutFifoSizeSamples = m_fifoSize_ms*wxGetApp().appConfiguration.audioConfiguration.soundCard1Out.sampleRate/1000;
-        g_rxUserdata->infifo1 = codec2_fifo_create(soundCard1InFifoSizeSamples);
-        g_rxUserdata->outfifo1 = codec2_fifo_create(soundCard1OutFifoSizeSamples);
+        g_rxUserdata->infifo1.reset(new SpscRingBuffer<short>(soundCard1InFifoSizeSamples));
+        g_rxUserdata->outfifo1.reset(new SpscRingBuffer<short>(soundCard1OutFifoSizeSamples));
+        if (g_spectrumEngineSub != nullptr)
+        {
+            g_rxUserdata->infifo1Sub.reset(new SpscRingBuffer<short>(soundCard1InFifoSizeSamples));
+        }
 
         if (txInSoundDevice && txOutSoundDevice)
         {
             int soundCard2InFifoSizeSamples = m_fifoSize_ms*wxGetApp().appConfiguration.audioConfiguration.soundCard2In.sampleRate/1000;
             int soundCard2OutFifoSizeSamples = m_fifoSize_ms*wxGetApp().appConfiguration.audioConfiguration.soundCard2Out.sampleRate/1000;
-            g_rxUserdata->outfifo2 = codec2_fifo_create(soundCard2OutFifoSizeSamples);
-            g_rxUserdata->infifo2 = codec2_fifo_create(soundCard2InFifoSizeSamples);
+            g_rxUserdata->outfifo2.reset(new SpscRingBuffer<short>(soundCard2OutFifoSizeSamples));
+            g_rxUserdata->infifo2.reset(new SpscRingBuffer<short>(soundCard2InFifoSizeSamples));
         
             if (g_verbose) fprintf(stderr, "fifoSize_ms:  %d infifo2: %d/outfilo2: %d\n",
                 wxGetApp().appConfiguration.fifoSizeMs.get(), soundCard2InFifoSizeSamples, soundCard2OutFifoSizeSamples);
@@ -2701,39 +2969,43 @@ void MainFrame::startRxStream()
         if (g_verbose) fprintf(stderr, "fifoSize_ms: %d infifo1: %d/outfilo1 %d\n",
                 wxGetApp().appConfiguration.fifoSizeMs.get(), soundCard1InFifoSizeSamples, soundCard1OutFifoSizeSamples);
 
+        // With a virtual clock the file engine would otherwise overrun the
+        // input FIFOs immediately; hold it off while they're over half full.
+        auto fileEngine = std::dynamic_pointer_cast<FileAudioEngine>(engine);
+        if (fileEngine)
+        {
+            fileEngine->setClockGate([]() {
+                bool canAdvance = g_rxUserdata->infifo1->numUsed() < g_rxUserdata->infifo1->numFree();
+                if (g_rxUserdata->infifo2)
+                {
+                    canAdvance = canAdvance && g_rxUserdata->infifo2->numUsed() < g_rxUserdata->infifo2->numFree();
+                }
+                return canAdvance;
+            });
+
+            // Once the input files have been played there's nothing more
+            // to do, so stop as if Stop had been pressed.
+            fileEngine->setOnEndOfInput([this]() {
+                CallAfter([this]() {
+                    if (m_RxRunning && m_togBtnOnOff->IsEnabled())
+                    {
+                        m_togBtnOnOff->SetValue(false);
+                        wxCommandEvent event(wxEVT_COMMAND_TOGGLEBUTTON_CLICKED);
+                        OnTogBtnOnOff(event);
+                    }
+                });
+            });
+        }
+
         // reset debug stats for FIFOs
 
         g_infifo1_full = g_outfifo1_empty = g_infifo2_full = g_outfifo2_empty = 0;
         g_infifo1_full = g_outfifo1_empty = g_infifo2_full = g_outfifo2_empty = 0;
+        g_rxLatencyMs = g_txLatencyMs = 0;
         for (int i=0; i<4; i++) {
             g_AEstatus1[i] = g_AEstatus2[i] = 0;
         }
 
-        // These FIFOs interface between the 20ms tx/rxProcessing()
-        // loop and the demodulator, which requires a variable number
-        // of input samples to adjust for timing clock differences
-        // between remote tx and rx.  These FIFOs also help with the
-        // different processing block size of different FreeDV modes.
-
-        // TODO: might be able to tune these on a per waveform basis, or refactor
-        // to a neater design with less layers of FIFOs
-
-        int modem_samplerate, rxInFifoSizeSamples, rxOutFifoSizeSamples;
-        modem_samplerate = freedvInterface.getRxModemSampleRate();
-        rxInFifoSizeSamples = freedvInterface.getRxNumModemSamples();
-        rxOutFifoSizeSamples = freedvInterface.getRxNumSpeechSamples();
-
-        // add an extra 40ms to give a bit of headroom for processing loop adding samples
-        // which operates on 20ms buffers
-
-        rxInFifoSizeSamples += 0.04*modem_samplerate;
-        rxOutFifoSizeSamples += 0.04*modem_samplerate;
-
-        g_rxUserdata->rxinfifo = codec2_fifo_create(rxInFifoSizeSamples);
-        g_rxUserdata->rxoutfifo = codec2_fifo_create(rxOutFifoSizeSamples);
-
-        if (g_verbose) fprintf(stderr, "rxInFifoSizeSamples: %d rxOutFifoSizeSamples: %d\n", rxInFifoSizeSamples, rxOutFifoSizeSamples);
-
         // Init Equaliser Filters ------------------------------------------------------
 
         m_newMicInFilter = m_newSpkOutFilter = true;
@@ -2778,21 +3050,29 @@ void MainFrame::startRxStream()
             });
         };
 
+        // All of the callbacks below deal in mono; the devices extract the
+        // first input channel and replicate output to every channel for us.
+        IAudioDevice::AudioDataFormat monoFormat;
+        monoFormat.numChannels = 1;
+
+        // With the sub receiver, the device splits the two channels for
+        // us instead: all of the left, then all of the right.
+        IAudioDevice::AudioDataFormat rxInFormat = monoFormat;
+        if (g_rxUserdata->infifo1Sub)
+        {
+            rxInFormat.numChannels = 2;
+            rxInFormat.planar = true;
+        }
+
+        rxInSoundDevice->setAudioDataFormat(rxInFormat);
         rxInSoundDevice->setOnAudioData([&](IAudioDevice& dev, void* data, size_t size, void* state) {
             paCallBackData* cbData = static_cast<paCallBackData*>(state);
-            short* audioData = static_cast<short*>(data);
-            short  indata[size];
-            for (size_t i = 0; i < size; i++, audioData += dev.getNumChannels())
-            {
-                indata[i] = audioData[0];
-            }
-            
-            if (codec2_fifo_write(cbData->infifo1, indata, size)) 
+            if (!cbData->writeRadioInput(static_cast<short*>(data), size, dev.getCallbackTiming().bufferTimeUs)) 
             {
                 g_infifo1_full++;
             }
 
-            m_rxThread->notify();
+            m_rxThread->notifyIfReady(cbData->infifo1->numUsed());
         }, g_rxUserdata);
         
         rxInSoundDevice->setOnAudioOverflow([](IAudioDevice& dev, void* state)
@@ -2810,25 +3090,17 @@ void MainFrame::startRxStream()
         
         if (txInSoundDevice && txOutSoundDevice)
         {
+            rxOutSoundDevice->setAudioDataFormat(monoFormat);
             rxOutSoundDevice->setOnAudioData([](IAudioDevice& dev, void* data, size_t size, void* state) {
                 paCallBackData* cbData = static_cast<paCallBackData*>(state);
-                short* audioData = static_cast<short*>(data);
-                short  outdata[size];
- 
-                int result = codec2_fifo_read(cbData->outfifo2, outdata, size);
-                if (result == 0) 
+                if (cbData->outfifo2->numUsed() < size)
                 {
-                    for (size_t i = 0; i < size; i++)
-                    {
-                        for (int j = 0; j < dev.getNumChannels(); j++)
-                        {
-                            *audioData++ = outdata[i];
-                        }
-                    }
+                    g_outfifo2_empty++;
                 }
-                else 
+                else
                 {
-                    g_outfifo2_empty++;
+                    updateLatency(dev, *cbData->outfifo2, cbData->outfifo2Time, g_rxLatencyMs);
+                    cbData->outfifo2->read(static_cast<short*>(data), size);
                 }
             }, g_rxUserdata);
             
@@ -2842,25 +3114,21 @@ void MainFrame::startRxStream()
                 g_AEstatus2[2]++;
             }, nullptr);
             
+            txInSoundDevice->setAudioDataFormat(monoFormat);
             txInSoundDevice->setOnAudioData([&](IAudioDevice& dev, void* data, size_t size, void* state) {
                 paCallBackData* cbData = static_cast<paCallBackData*>(state);
-                short* audioData = static_cast<short*>(data);
-                short  indata[size];
-                
                 if (!endingTx) 
                 {
-                    for(size_t i = 0; i < size; i++, audioData += dev.getNumChannels())
+                    if (cbData->infifo2->numFree() < size) 
                     {
-                        indata[i] = audioData[0];
+                        g_infifo2_full++;
                     }
-                    
-                    if (codec2_fifo_write(cbData->infifo2, indata, size)) 
+                    else
                     {
-                        g_infifo2_full++;
+                        cbData->infifo2Time.set(cbData->infifo2->getWritePosition(), dev.getCallbackTiming().bufferTimeUs);
+                        cbData->infifo2->write(static_cast<short*>(data), size);
                     }
                 }
-
-                m_txThread->notify();
             }, g_rxUserdata);
         
             txInSoundDevice->setOnAudioOverflow([](IAudioDevice& dev, void* state)
@@ -2873,49 +3141,60 @@ void MainFrame::startRxStream()
                 g_AEstatus2[0]++;
             }, nullptr);
             
-            txOutSoundDevice->setOnAudioData([](IAudioDevice& dev, void* data, size_t size, void* state) {
-                paCallBackData* cbData = static_cast<paCallBackData*>(state);
-                short* audioData = static_cast<short*>(data);
-                short  outdata[size];
-
-                int result = codec2_fifo_read(cbData->outfifo1, outdata, size);
-                if (result == 0) {
-
-                    // write signal to all channels if the device can support 2+ channels.
-                    // Otherwise, we assume we're only dealing with one channel and write
-                    // only to that channel.
-                    if (dev.getNumChannels() >= 2)
+            if (g_rxUserdata->leftChannelVoxTone && txOutSoundDevice->getNumChannels() >= 2)
+            {
+                // Planar stereo: VOX tone in the left channel, TX audio in
+                // the right one (and any further channels).
+                IAudioDevice::AudioDataFormat voxFormat;
+                voxFormat.numChannels = 2;
+                voxFormat.planar = true;
+                txOutSoundDevice->setAudioDataFormat(voxFormat);
+
+                txOutSoundDevice->setOnAudioData([&](IAudioDevice& dev, void* data, size_t size, void* state) {
+                    paCallBackData* cbData = static_cast<paCallBackData*>(state);
+                    short* voxData = static_cast<short*>(data);
+                    short* audioData = voxData + size;
+
+                    if (cbData->outfifo1->numUsed() >= size)
                     {
-                        for(size_t i = 0; i < size; i++, audioData += dev.getNumChannels()) 
-                        {
-                            if (cbData->leftChannelVoxTone)
-                            {
-                                cbData->voxTonePhase += 2.0*M_PI*VOX_TONE_FREQ/wxGetApp().appConfiguration.audioConfiguration.soundCard1Out.sampleRate;
-                                cbData->voxTonePhase -= 2.0*M_PI*floor(cbData->voxTonePhase/(2.0*M_PI));
-                                audioData[0] = VOX_TONE_AMP*cos(cbData->voxTonePhase);
-                            }
-                            else
-                                audioData[0] = outdata[i];
+                        updateLatency(dev, *cbData->outfifo1, cbData->outfifo1Time, g_txLatencyMs);
+                        cbData->outfifo1->read(audioData, size);
 
-                            for (auto j = 1; j < dev.getNumChannels(); j++)
-                            {
-                                audioData[j] = outdata[i];
-                            }
+                        for (size_t i = 0; i < size; i++)
+                        {
+                            cbData->voxTonePhase += 2.0*M_PI*VOX_TONE_FREQ/wxGetApp().appConfiguration.audioConfiguration.soundCard1Out.sampleRate;
+                            cbData->voxTonePhase -= 2.0*M_PI*floor(cbData->voxTonePhase/(2.0*M_PI));
+                            voxData[i] = VOX_TONE_AMP*cos(cbData->voxTonePhase);
                         }
                     }
+                    else 
+                    {
+                        g_outfifo1_empty++;
+                    }
+
+                    m_txThread->notifyIfReady(cbData->outfifo1->numFree());
+                }, g_rxUserdata);
+            }
+            else
+            {
+                txOutSoundDevice->setAudioDataFormat(monoFormat);
+                txOutSoundDevice->setOnAudioData([&](IAudioDevice& dev, void* data, size_t size, void* state) {
+                    paCallBackData* cbData = static_cast<paCallBackData*>(state);
+                    if (cbData->outfifo1->numUsed() < size)
+                    {
+                        g_outfifo1_empty++;
+                    }
                     else
                     {
-                        for(size_t i = 0; i < size; i++, audioData++) 
-                        {
-                            audioData[0] = outdata[i];
-                        }
+                        updateLatency(dev, *cbData->outfifo1, cbData->outfifo1Time, g_txLatencyMs);
+                        cbData->outfifo1->read(static_cast<short*>(data), size);
                     }
-                }
-                else 
-                {
-                    g_outfifo1_empty++;
-                }
-            }, g_rxUserdata);
+
+                    // TX runs at the pace of the radio sound card, so this
+                    // is what wakes it up rather than the mic.
+                    m_txThread->notifyIfReady(cbData->outfifo1->numFree());
+                }, g_rxUserdata);
+            }
         
             txOutSoundDevice->setOnAudioOverflow([](IAudioDevice& dev, void* state)
             {
@@ -2932,25 +3211,17 @@ void MainFrame::startRxStream()
         }
         else
         {
+            rxOutSoundDevice->setAudioDataFormat(monoFormat);
             rxOutSoundDevice->setOnAudioData([](IAudioDevice& dev, void* data, size_t size, void* state) {
                 paCallBackData* cbData = static_cast<paCallBackData*>(state);
-                short* audioData = static_cast<short*>(data);
-                short  outdata[size];
-
-                int result = codec2_fifo_read(cbData->outfifo1, outdata, size);
-                if (result == 0) 
+                if (cbData->outfifo1->numUsed() < size)
                 {
-                    for (size_t i = 0; i < size; i++)
-                    {
-                        for (int j = 0; j < dev.getNumChannels(); j++)
-                        {
-                            *audioData++ = outdata[i];
-                        }
-                    }
+                    g_outfifo1_empty++;
                 }
-                else 
+                else
                 {
-                    g_outfifo1_empty++;
+                    updateLatency(dev, *cbData->outfifo1, cbData->outfifo1Time, g_rxLatencyMs);
+                    cbData->outfifo1->read(static_cast<short*>(data), size);
                 }
             }, g_rxUserdata);
             
@@ -3010,6 +3281,9 @@ void MainFrame::startRxStream()
             }
         }
 
+        startFlightRecorder_(rxInSoundDevice->getSampleRate());
+        startCodecFrameLog_(rxInSoundDevice->getSampleRate());
+        
         m_rxThread = new TxRxThread(false, rxInSoundDevice->getSampleRate(), rxOutSoundDevice->getSampleRate(), wxGetApp().linkStep.get());
         if ( m_rxThread->Create() != wxTHREAD_NO_ERROR )
         {
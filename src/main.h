@@ -50,6 +50,9 @@
 #include <samplerate.h>
 
 #include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
 #include <speex/speex_preprocess.h>
 #if defined(__x86_64__) || defined(_M_X64) || defined(__i386) || defined(_M_IX86)
 #include <cpuid.h>
@@ -91,6 +94,9 @@
 #include "config/FreeDVConfiguration.h"
 #include "pipeline/paCallbackData.h"
 #include "pipeline/LinkStep.h"
+#include "pipeline/RecordingWriter.h"
+#include "pipeline/VoiceKeyerCache.h"
+#include "pipeline/FlightRecorder.h"
 
 #define _USE_TIMER              1
 #define _USE_ONIDLE             1
@@ -98,6 +104,13 @@
 //#define _AUDIO_PASSTHROUGH    1
 #define _REFRESH_TIMER_PERIOD   (DT*1000)
 
+// Repaint rate limit for the modem state plots (timing/frequency offset,
+// test frame errors).
+#define PLOT_SLOW_REFRESH_MS    200
+
+// How often UI thread load is reported with --verbose.
+#define UI_LOAD_REPORT_SECS     10
+
 //#define _USE_ABOUT_DIALOG       1
 
 enum {
@@ -263,6 +276,7 @@ private:
 };
 
 class TxRxThread;
+class SpectrumExporter;
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
 // Class MainFrame
@@ -293,11 +307,26 @@ class MainFrame : public TopFrame
         PlotScalar*             m_panelTestFrameErrors;
         PlotScalar*             m_panelTestFrameErrorsHist;
         wxComboBox*             m_cbxNumSpectrumAveraging;
+        wxComboBox*             m_cbxSpectrumFftSize;
+        std::vector<float>      m_spectrumMagDB;
+        SpectrumExporter*       m_spectrumExporter;
+
+        // Sub receiver tab (see subreceiver.cpp), created on first use.
+        PlotSpectrum*           m_panelSpectrumSub;
+        wxStaticText*           m_textSubRx;
+        std::vector<float>      m_spectrumMagDBSub;
+        wxString                m_subRxText;
+        std::vector<PlotPanel*> m_scheduledPlots;
 
         bool                    m_RxRunning;
 
         TxRxThread*             m_txThread;
         TxRxThread*             m_rxThread;
+
+        // Saving/decoding the flight recorder (see flightrecorder.cpp).
+        std::thread             m_flightRecorderThread;
+        std::atomic<bool>       m_flightRecorderBusy;
+        std::atomic<bool>       m_flightRecorderCancel;
         
         bool                    OpenHamlibRig();
 #if defined(WIN32)
@@ -350,6 +379,7 @@ class MainFrame : public TopFrame
         void OnExitClick(wxCommandEvent& event);
         
         void OnAveragingChange(wxCommandEvent& event);
+        void OnSpectrumFftSizeChange(wxCommandEvent& event);
 
         void startTxStream();
         void startRxStream();
@@ -375,6 +405,9 @@ class MainFrame : public TopFrame
 
         void OnRecFileFromRadio( wxCommandEvent& event ) override;
         void OnPlayFileFromRadio( wxCommandEvent& event ) override;
+        void OnSaveFlightRecording( wxCommandEvent& event ) override;
+        void OnDecodeFlightRecording( wxCommandEvent& event ) override;
+        void OnReplayCodecFrameLog( wxCommandEvent& event ) override;
         
         void OnCenterRx(wxCommandEvent& event) override;
 
@@ -494,6 +527,13 @@ class MainFrame : public TopFrame
         
         void loadConfiguration_();
         void resetStats_();
+        
+        // UI thread load accounting, see OnTimer().
+        std::chrono::steady_clock::time_point m_uiLoadStatsStart;
+        long long   m_uiTimerTimeUs;
+        long long   m_uiPaintTimeUs;
+        int         m_uiNumPaints;
+        void updateUiLoadStats_(std::chrono::steady_clock::time_point timerStart);
 
         HamlibRigController::Mode getCurrentMode_();
 
@@ -504,6 +544,18 @@ class MainFrame : public TopFrame
         
         void performFreeDVOn_();
         void performFreeDVOff_();
+
+        void startSubReceiver_();
+        void stopSubReceiver_();
+        void updateSubReceiver_();
+
+        void startFlightRecorder_(int sampleRate);
+        std::shared_ptr<FlightRecording> takeFlightRecording_(size_t* sizeBytes);
+        void runFlightRecorderTask_(std::function<void()> fn);
+        void stopFlightRecorderTask_();
+
+        void startCodecFrameLog_(int sampleRate);
+        void stopCodecFrameLog_();
         
         void executeOnUiThreadAndWait_(std::function<void()> fn);
         
@@ -46,12 +46,12 @@ extern int g_outfifo1_empty;
 extern bool g_voice_keyer_tx;
 extern paCallBackData* g_rxUserdata;
 
-extern SNDFILE            *g_sfRecFileFromModulator;
-extern SNDFILE            *g_sfRecFile;
+extern RecordingWriter    *g_recWriterFromModulator;
+extern RecordingWriter    *g_recWriter;
 extern bool g_recFileFromModulator;
 extern bool g_recFileFromRadio;
 
-extern SNDFILE            *g_sfRecMicFile;
+extern RecordingWriter    *g_recMicWriter;
 
 extern wxMutex g_mutexProtectingCallbackData;
 
@@ -1008,7 +1008,7 @@ void MainFrame::togglePTT(void) {
     m_btnTogPTT->SetBackgroundColour(newTx ? *wxRED : wxNullColour);
     
     // If we're recording, switch to/from modulator and radio.
-    if (g_sfRecFile != nullptr)
+    if (g_recWriter != nullptr)
     {
         if (!newTx)
         {
@@ -1083,16 +1083,10 @@ void MainFrame::OnTogBtnAnalogClick (wxCommandEvent& event)
 {
     if (g_analog == 0) {
         g_analog = 1;
-        m_panelSpectrum->setFreqScale(MODEM_STATS_NSPEC*((float)MAX_F_HZ/(FS/2)));
-        m_panelWaterfall->setFs(FS);
-        
         m_togBtnAnalog->SetLabel(wxT("Di&gital"));
     }
     else {
         g_analog = 0;
-        m_panelSpectrum->setFreqScale(MODEM_STATS_NSPEC*((float)MAX_F_HZ/(freedvInterface.getRxModemSampleRate()/2)));
-        m_panelWaterfall->setFs(freedvInterface.getRxModemSampleRate());
-        
         m_togBtnAnalog->SetLabel(wxT("A&nalog"));
     }
 
@@ -0,0 +1,132 @@
+//=========================================================================
+// Name:            AsyncTapStep.cpp
+// Purpose:         Describes a tap step whose sub-pipeline executes on a
+//                  background thread.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "AsyncTapStep.h"
+
+#include <cstdio>
+#include <functional>
+#include <assert.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+AsyncTapStep::AsyncTapStep(int sampleRate, IPipelineStep* tapStep, int maxQueuedBlocks)
+    : tapStep_(tapStep)
+    , sampleRate_(sampleRate)
+    , blockQueue_(maxQueuedBlocks)
+    , numQueuedBlocks_(0)
+    , numProcessedBlocks_(0)
+    , numDroppedBlocks_(0)
+    , isDestroying_(false)
+{
+    assert(tapStep_->getInputSampleRate() == sampleRate_);
+    
+    // Instantiate thread here rather than the initializer since otherwise
+    // we might not be able to guarantee that the mutex is initialized first.
+    workerThread_ = std::thread(std::bind(&AsyncTapStep::workerLoop_, this));
+}
+
+AsyncTapStep::~AsyncTapStep()
+{
+    {
+        std::unique_lock<std::mutex> lk(workerMutex_);
+        isDestroying_ = true;
+    }
+    workerCV_.notify_one();
+    workerThread_.join();
+    
+    if (numDroppedBlocks_ > 0)
+    {
+        fprintf(
+            stderr, 
+            "AsyncTapStep: dropped %llu of %llu blocks\n", 
+            (unsigned long long)numDroppedBlocks_.load(), 
+            (unsigned long long)(numQueuedBlocks_.load() + numDroppedBlocks_.load()));
+    }
+}
+
+int AsyncTapStep::getInputSampleRate() const
+{
+    return sampleRate_;
+}
+
+int AsyncTapStep::getOutputSampleRate() const
+{
+    return sampleRate_;
+}
+
+std::shared_ptr<short> AsyncTapStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
+{
+    TapBlock block;
+    block.samples = inputSamples;
+    block.numSamples = numInputSamples;
+    
+    if (blockQueue_.push(std::move(block)))
+    {
+        numQueuedBlocks_++;
+        
+        // Only the worker's check of the queue is under the lock, and it's
+        // never held while the tap runs. Passing through it here means the
+        // worker is either yet to check or already waiting, so the notify
+        // can't be lost.
+        {
+            std::unique_lock<std::mutex> lk(workerMutex_);
+        }
+        workerCV_.notify_one();
+    }
+    else
+    {
+        numDroppedBlocks_++;
+    }
+    
+    *numOutputSamples = numInputSamples;
+    return inputSamples;
+}
+
+void AsyncTapStep::workerLoop_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV tapThread");
+#endif // defined(__linux__)
+
+    while (!isDestroying_)
+    {
+        {
+            std::unique_lock<std::mutex> lk(workerMutex_);
+            workerCV_.wait(lk, [&]() {
+                return isDestroying_ || !blockQueue_.empty();
+            });
+        }
+        
+        TapBlock block;
+        while (!isDestroying_ && blockQueue_.pop(block))
+        {
+            int temp = 0;
+            tapStep_->execute(block.samples, block.numSamples, &temp);
+            block.samples = nullptr;
+            
+            numProcessedBlocks_++;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+//=========================================================================
+// Name:            AsyncTapStep.h
+// Purpose:         Describes a tap step whose sub-pipeline executes on a
+//                  background thread.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__ASYNC_TAP_STEP_H
+#define AUDIO_PIPELINE__ASYNC_TAP_STEP_H
+
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "IPipelineStep.h"
+#include "../util/SpscQueue.h"
+
+// Like TapStep, but hands each block (by reference, no copy) to a worker
+// thread instead of executing the tap inline. Intended for consumers that
+// must never delay the modem path (plots, spectrum, etc.). If the worker
+// falls behind by more than maxQueuedBlocks, new blocks are dropped and
+// counted rather than waited on.
+class AsyncTapStep : public IPipelineStep
+{
+public:
+    AsyncTapStep(int inputSampleRate, IPipelineStep* tapStep, int maxQueuedBlocks = 32);
+    virtual ~AsyncTapStep();
+    
+    virtual int getInputSampleRate() const;
+    virtual int getOutputSampleRate() const;
+    virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples);
+    
+    // Statistics. Safe to call from any thread.
+    uint64_t getNumQueuedBlocks() const { return numQueuedBlocks_.load(); }
+    uint64_t getNumProcessedBlocks() const { return numProcessedBlocks_.load(); }
+    uint64_t getNumDroppedBlocks() const { return numDroppedBlocks_.load(); }
+    
+private:
+    struct TapBlock
+    {
+        std::shared_ptr<short> samples;
+        int numSamples;
+        
+        TapBlock()
+            : numSamples(0)
+        {
+            // empty
+        }
+    };
+    
+    std::shared_ptr<IPipelineStep> tapStep_;
+    int sampleRate_;
+    SpscQueue<TapBlock> blockQueue_;
+    
+    std::atomic<uint64_t> numQueuedBlocks_;
+    std::atomic<uint64_t> numProcessedBlocks_;
+    std::atomic<uint64_t> numDroppedBlocks_;
+    
+    std::atomic<bool> isDestroying_;
+    std::mutex workerMutex_;
+    std::condition_variable workerCV_;
+    std::thread workerThread_;
+    
+    void workerLoop_();
+};
+
+#endif // AUDIO_PIPELINE__ASYNC_TAP_STEP_H
@@ -0,0 +1,167 @@
+//=========================================================================
+// Name:            ClockDriftCorrector.cpp
+// Purpose:         Estimates sound card clock drift from FIFO fill levels
+//                  and resamples to compensate.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "ClockDriftCorrector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstdio>
+
+// Time constant of the fill level filter; smooths out the sawtooth caused
+// by the FIFO being filled/drained in blocks.
+#define DRIFT_FILL_TIME_CONSTANT_SEC 1.0
+
+// Controller gains, in terms of the fill error in seconds. Slow on purpose:
+// the fill level we see depends on where the sound card is in its own
+// period, which itself wanders at the drift rate.
+#define DRIFT_KP 0.05
+#define DRIFT_KI 0.001
+
+// Only errors smaller than this are integrated, so that large transients
+// (start up, the FIFO draining during TX) don't wind up the drift estimate.
+// Has to be larger than the error the proportional term alone settles at.
+#define DRIFT_INTEGRATE_SEC (2 * DRIFT_MAX_ESTIMATE / DRIFT_KP)
+
+ClockDriftCorrector::ClockDriftCorrector(int sampleRate, int targetFillSamples)
+    : sampleRate_(sampleRate)
+    , targetFillSamples_(targetFillSamples)
+    , haveFill_(false)
+    , filteredFill_(0)
+    , integral_(0)
+    , ratio_(1.0)
+{
+    assert(sampleRate_ > 0);
+
+    int src_error;
+    resampleState_ = src_new(SRC_SINC_FASTEST, 1, &src_error);
+    assert(resampleState_ != nullptr);
+}
+
+ClockDriftCorrector::~ClockDriftCorrector()
+{
+    src_delete(resampleState_);
+}
+
+void ClockDriftCorrector::reset()
+{
+    haveFill_ = false;
+    ratio_ = 1.0 - integral_;
+    pending_.clear();
+    src_reset(resampleState_);
+}
+
+void ClockDriftCorrector::updateFill(int fillSamples, int fifoSamples)
+{
+    double dt = (double)fifoSamples / sampleRate_;
+    if (!haveFill_)
+    {
+        filteredFill_ = fillSamples;
+        haveFill_ = true;
+    }
+    else
+    {
+        double alpha = dt / (DRIFT_FILL_TIME_CONSTANT_SEC + dt);
+        filteredFill_ += alpha * (fillSamples - filteredFill_);
+    }
+
+    double error = (filteredFill_ - targetFillSamples_) / sampleRate_;
+
+    if (std::abs(error) < DRIFT_INTEGRATE_SEC)
+    {
+        integral_ += DRIFT_KI * error * dt;
+        integral_ = std::min(std::max(integral_, -DRIFT_MAX_ESTIMATE), DRIFT_MAX_ESTIMATE);
+    }
+
+    double correction = DRIFT_KP * error + integral_;
+    correction = std::min(std::max(correction, -DRIFT_MAX_CORRECTION), DRIFT_MAX_CORRECTION);
+    ratio_ = 1.0 - correction;
+}
+
+int ClockDriftCorrector::process(const short* input, int numInputSamples, short* output, int maxOutputSamples)
+{
+    if (numInputSamples <= 0)
+    {
+        return 0;
+    }
+
+    if ((int)floatIn_.size() < numInputSamples)
+    {
+        floatIn_.resize(numInputSamples);
+    }
+    if ((int)floatOut_.size() < maxOutputSamples)
+    {
+        floatOut_.resize(maxOutputSamples);
+    }
+
+    src_short_to_float_array(input, &floatIn_[0], numInputSamples);
+
+    SRC_DATA src_data;
+    src_data.data_in = &floatIn_[0];
+    src_data.data_out = &floatOut_[0];
+    src_data.input_frames = numInputSamples;
+    src_data.output_frames = maxOutputSamples;
+    src_data.end_of_input = 0;
+    src_data.src_ratio = ratio_;
+
+    int ret = src_process(resampleState_, &src_data);
+    if (ret != 0)
+    {
+        fprintf(stderr, "WARNING: drift resampling failed: %s\n", src_strerror(ret));
+        return 0;
+    }
+
+    src_float_to_short_array(&floatOut_[0], output, src_data.output_frames_gen);
+    return src_data.output_frames_gen;
+}
+
+void ClockDriftCorrector::pull(short* output, int numOutputSamples, std::function<void(short*, int)> readFn)
+{
+    while ((int)pending_.size() < numOutputSamples)
+    {
+        // Ask for just enough input for what's missing; the resampler's
+        // own delay means the first few calls come up short.
+        int numNeeded = numOutputSamples - pending_.size();
+        int numInput = std::max(1, (int)std::ceil(numNeeded / ratio_));
+        if ((int)inputBuffer_.size() < numInput)
+        {
+            inputBuffer_.resize(numInput);
+        }
+        readFn(&inputBuffer_[0], numInput);
+
+        int maxOutput = numInput * (ratio_ + DRIFT_MAX_CORRECTION) + 2;
+        size_t offset = pending_.size();
+        pending_.resize(offset + maxOutput);
+        int numOutput = process(&inputBuffer_[0], numInput, &pending_[offset], maxOutput);
+        if (numOutput == 0 && numInput >= numNeeded)
+        {
+            // Resampler failure; pad with silence rather than spin.
+            numOutput = numNeeded;
+            std::fill(pending_.begin() + offset, pending_.begin() + offset + numOutput, 0);
+        }
+        pending_.resize(offset + numOutput);
+    }
+
+    std::copy(pending_.begin(), pending_.begin() + numOutputSamples, output);
+    pending_.erase(pending_.begin(), pending_.begin() + numOutputSamples);
+}
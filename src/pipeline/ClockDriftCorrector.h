@@ -0,0 +1,95 @@
+//=========================================================================
+// Name:            ClockDriftCorrector.h
+// Purpose:         Estimates sound card clock drift from FIFO fill levels
+//                  and resamples to compensate.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__CLOCK_DRIFT_CORRECTOR_H
+#define AUDIO_PIPELINE__CLOCK_DRIFT_CORRECTOR_H
+
+#include <vector>
+#include <functional>
+#include <samplerate.h>
+
+// Largest correction applied while converging on the target fill (0.5%,
+// i.e. a barely audible pitch change).
+#define DRIFT_MAX_CORRECTION 0.005
+
+// Largest drift we expect between two sound cards (1000 ppm).
+#define DRIFT_MAX_ESTIMATE 0.001
+
+// Sits between a FIFO shared with a sound card and the processing thread
+// when the two ends of the pipeline run off different sound card clocks.
+// The FIFO's fill level is low pass filtered and fed to a PI controller
+// whose integral term converges on the relative clock drift; the sum of
+// both terms sets the ratio of a variable rate resampler so the fill
+// level is held at the target instead of slowly draining or overflowing.
+//
+// The FIFO can be on either side:
+// * process(): we write into the FIFO (e.g. RX audio to the headset).
+// * pull(): we read from the FIFO (e.g. TX audio from the microphone).
+// Either way a fill above target slows down the FIFO side.
+class ClockDriftCorrector
+{
+public:
+    ClockDriftCorrector(int sampleRate, int targetFillSamples);
+    virtual ~ClockDriftCorrector();
+
+    // Report the FIFO fill level after moving fifoSamples samples into or
+    // out of it. Updates the estimate and the resampling ratio.
+    void updateFill(int fillSamples, int fifoSamples);
+
+    // Resamples numInputSamples samples into output (at most maxOutputSamples
+    // are written) and returns the number of samples produced.
+    int process(const short* input, int numInputSamples, short* output, int maxOutputSamples);
+
+    // Produces exactly numOutputSamples samples, calling readFn(buffer, n) to
+    // obtain input as needed.
+    void pull(short* output, int numOutputSamples, std::function<void(short*, int)> readFn);
+
+    // Forgets the fill history and resampler state (e.g. after the FIFO has
+    // been flushed); the drift estimate is kept.
+    void reset();
+
+    // Estimated clock drift in parts per million, i.e. the steady state
+    // correction. Positive when the FIFO tends to fill up.
+    double getDriftPpm() const { return integral_ * 1e6; }
+
+    // Current output/input resampling ratio.
+    double getRatio() const { return ratio_; }
+
+private:
+    int sampleRate_;
+    int targetFillSamples_;
+    SRC_STATE* resampleState_;
+
+    bool haveFill_;
+    double filteredFill_;
+    double integral_;
+    double ratio_;
+
+    // Resampler output not yet returned by pull().
+    std::vector<short> pending_;
+    std::vector<short> inputBuffer_;
+    std::vector<float> floatIn_;
+    std::vector<float> floatOut_;
+};
+
+#endif // AUDIO_PIPELINE__CLOCK_DRIFT_CORRECTOR_H
@@ -0,0 +1,187 @@
+//=========================================================================
+// Name:            CodecFrameLog.cpp
+// Purpose:         Compact log of received modem frame payloads, with sync
+//                  and SNR per frame, for later re-synthesis.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "CodecFrameLog.h"
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+static void PutLE_(unsigned char* buf, uint64_t value, int numBytes)
+{
+    for (int index = 0; index < numBytes; index++)
+    {
+        buf[index] = (unsigned char)(value >> (8 * index));
+    }
+}
+
+static uint64_t GetLE_(const unsigned char* buf, int numBytes)
+{
+    uint64_t value = 0;
+    for (int index = 0; index < numBytes; index++)
+    {
+        value |= (uint64_t)buf[index] << (8 * index);
+    }
+    return value;
+}
+
+CodecFrameLogWriter::CodecFrameLogWriter()
+    : file_(nullptr)
+    , numBytesWritten_(0)
+{
+    // empty
+}
+
+CodecFrameLogWriter::~CodecFrameLogWriter()
+{
+    close();
+}
+
+bool CodecFrameLogWriter::open(std::string path, int64_t startTime, std::string* error)
+{
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr)
+    {
+        *error = strerror(errno);
+        return false;
+    }
+
+    unsigned char header[CODEC_FRAME_LOG_HEADER_SIZE];
+    memcpy(header, CODEC_FRAME_LOG_MAGIC, CODEC_FRAME_LOG_MAGIC_SIZE);
+    PutLE_(header + CODEC_FRAME_LOG_MAGIC_SIZE, (uint64_t)startTime, 8);
+    if (fwrite(header, sizeof(header), 1, file_) != 1)
+    {
+        *error = strerror(errno);
+        close();
+        return false;
+    }
+
+    numBytesWritten_ = sizeof(header);
+    return true;
+}
+
+void CodecFrameLogWriter::close()
+{
+    if (file_ != nullptr)
+    {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool CodecFrameLogWriter::write(const CodecFrameLogRecord& record)
+{
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+
+    size_t payloadSize = std::min(record.payload.size(), (size_t)255);
+
+    unsigned char header[CODEC_FRAME_LOG_RECORD_HEADER_SIZE];
+    header[0] = (unsigned char)record.mode;
+    header[1] = record.sync ? CODEC_FRAME_LOG_FLAG_SYNC : 0;
+    header[2] = (unsigned char)(signed char)std::max(-128, std::min(record.snrDb, 127));
+    header[3] = (unsigned char)payloadSize;
+    PutLE_(header + 4, record.timeMs, 4);
+
+    // Buffered by stdio, so this is usually just a copy.
+    bool ok = fwrite(header, sizeof(header), 1, file_) == 1;
+    if (ok && payloadSize > 0)
+    {
+        ok = fwrite(&record.payload[0], payloadSize, 1, file_) == 1;
+    }
+    if (ok)
+    {
+        numBytesWritten_ += sizeof(header) + payloadSize;
+    }
+    return ok;
+}
+
+CodecFrameLogReader::CodecFrameLogReader()
+    : file_(nullptr)
+    , startTime_(0)
+{
+    // empty
+}
+
+CodecFrameLogReader::~CodecFrameLogReader()
+{
+    close();
+}
+
+bool CodecFrameLogReader::open(std::string path, std::string* error)
+{
+    file_ = fopen(path.c_str(), "rb");
+    if (file_ == nullptr)
+    {
+        *error = strerror(errno);
+        return false;
+    }
+
+    unsigned char header[CODEC_FRAME_LOG_HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, file_) != 1 ||
+        memcmp(header, CODEC_FRAME_LOG_MAGIC, CODEC_FRAME_LOG_MAGIC_SIZE) != 0)
+    {
+        *error = "Not a FreeDV codec frame log";
+        close();
+        return false;
+    }
+
+    startTime_ = (int64_t)GetLE_(header + CODEC_FRAME_LOG_MAGIC_SIZE, 8);
+    return true;
+}
+
+void CodecFrameLogReader::close()
+{
+    if (file_ != nullptr)
+    {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool CodecFrameLogReader::read(CodecFrameLogRecord* record)
+{
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+
+    unsigned char header[CODEC_FRAME_LOG_RECORD_HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, file_) != 1)
+    {
+        return false;
+    }
+
+    record->mode = header[0];
+    record->sync = (header[1] & CODEC_FRAME_LOG_FLAG_SYNC) != 0;
+    record->snrDb = (signed char)header[2];
+    record->timeMs = (uint32_t)GetLE_(header + 4, 4);
+    record->payload.resize(header[3]);
+    if (header[3] > 0 && fread(&record->payload[0], header[3], 1, file_) != 1)
+    {
+        return false;
+    }
+    return true;
+}
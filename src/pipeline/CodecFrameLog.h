@@ -0,0 +1,100 @@
+//=========================================================================
+// Name:            CodecFrameLog.h
+// Purpose:         Compact log of received modem frame payloads, with sync
+//                  and SNR per frame, for later re-synthesis.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__CODEC_FRAME_LOG_H
+#define AUDIO_PIPELINE__CODEC_FRAME_LOG_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// File layout (all integers little endian):
+//
+//   header: "FDVFRM01", int64 start time (seconds since the epoch)
+//   record: uint8 mode, uint8 flags, int8 SNR (dB), uint8 payload bytes,
+//           uint32 time since start (ms), payload
+//
+// The payload is the packed modem frame payload as returned by
+// freedv_rawdatarx(), so 8 bytes of overhead per frame on top of the
+// codec's own bit rate. Nothing is written while nothing is decoded.
+#define CODEC_FRAME_LOG_MAGIC "FDVFRM01"
+#define CODEC_FRAME_LOG_MAGIC_SIZE 8
+#define CODEC_FRAME_LOG_HEADER_SIZE 16
+#define CODEC_FRAME_LOG_RECORD_HEADER_SIZE 8
+
+#define CODEC_FRAME_LOG_FLAG_SYNC 0x01
+
+struct CodecFrameLogRecord
+{
+    int mode;       // FREEDV_MODE_*
+    bool sync;
+    int snrDb;
+    uint32_t timeMs;
+
+    // Empty when a mode has just lost sync.
+    std::vector<unsigned char> payload;
+};
+
+class CodecFrameLogWriter
+{
+public:
+    CodecFrameLogWriter();
+    virtual ~CodecFrameLogWriter();
+
+    // Returns false (and sets *error) if the file couldn't be created.
+    bool open(std::string path, int64_t startTime, std::string* error);
+    void close();
+
+    bool write(const CodecFrameLogRecord& record);
+
+    uint64_t getNumBytesWritten() const { return numBytesWritten_; }
+
+private:
+    FILE* file_;
+    uint64_t numBytesWritten_;
+};
+
+class CodecFrameLogReader
+{
+public:
+    CodecFrameLogReader();
+    virtual ~CodecFrameLogReader();
+
+    // Returns false (and sets *error) if the file can't be read or isn't
+    // a codec frame log.
+    bool open(std::string path, std::string* error);
+    void close();
+
+    int64_t getStartTime() const { return startTime_; }
+
+    // Returns false at the end of the log. A partly written last record
+    // (e.g. after a crash) is treated as the end.
+    bool read(CodecFrameLogRecord* record);
+
+private:
+    FILE* file_;
+    int64_t startTime_;
+};
+
+#endif // AUDIO_PIPELINE__CODEC_FRAME_LOG_H
@@ -0,0 +1,43 @@
+//=========================================================================
+// Name:            CodecFrameLogStep.cpp
+// Purpose:         Feeds RX pipeline input to the codec frame logger.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "CodecFrameLogStep.h"
+
+CodecFrameLogStep::CodecFrameLogStep(int sampleRate, std::function<CodecFrameLogger*()> getLoggerFn, std::function<int()> getSyncModeFn)
+    : sampleRate_(sampleRate)
+    , getLoggerFn_(getLoggerFn)
+    , getSyncModeFn_(getSyncModeFn)
+{
+    // empty
+}
+
+std::shared_ptr<short> CodecFrameLogStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
+{
+    auto logger = getLoggerFn_();
+    if (logger != nullptr && logger->getSampleRate() == sampleRate_)
+    {
+        logger->write(inputSamples.get(), numInputSamples, getSyncModeFn_());
+    }
+
+    *numOutputSamples = numInputSamples;
+    return inputSamples;
+}
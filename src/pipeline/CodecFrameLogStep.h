@@ -0,0 +1,49 @@
+//=========================================================================
+// Name:            CodecFrameLogStep.h
+// Purpose:         Feeds RX pipeline input to the codec frame logger.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__CODEC_FRAME_LOG_STEP_H
+#define AUDIO_PIPELINE__CODEC_FRAME_LOG_STEP_H
+
+#include <functional>
+#include "IPipelineStep.h"
+#include "CodecFrameLogger.h"
+
+// Passes its input through unchanged, queueing it for the codec frame
+// logger (if there is one) along with the mode the main receiver is in
+// sync on (see CodecFrameLogger::write()).
+class CodecFrameLogStep : public IPipelineStep
+{
+public:
+    CodecFrameLogStep(int sampleRate, std::function<CodecFrameLogger*()> getLoggerFn, std::function<int()> getSyncModeFn);
+    virtual ~CodecFrameLogStep() = default;
+
+    virtual int getInputSampleRate() const override { return sampleRate_; }
+    virtual int getOutputSampleRate() const override { return sampleRate_; }
+    virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples) override;
+
+private:
+    int sampleRate_;
+    std::function<CodecFrameLogger*()> getLoggerFn_;
+    std::function<int()> getSyncModeFn_;
+};
+
+#endif // AUDIO_PIPELINE__CODEC_FRAME_LOG_STEP_H
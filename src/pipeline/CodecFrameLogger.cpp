@@ -0,0 +1,328 @@
+//=========================================================================
+// Name:            CodecFrameLogger.cpp
+// Purpose:         Demodulates radio audio in the background and logs the
+//                  received codec frames (see CodecFrameLog.h).
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "CodecFrameLogger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+#include "codec2_fifo.h"
+#include "freedv_api.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+// How often the demodulator thread checks for queued audio.
+#define CODEC_FRAME_LOGGER_POLL_MS 100
+
+// Queued audio allowed before samples are dropped.
+#define CODEC_FRAME_LOGGER_BUFFER_SECONDS 10
+
+// Most write() calls queued at once: enough for 5 ms blocks.
+#define CODEC_FRAME_LOGGER_MAX_BLOCKS (CODEC_FRAME_LOGGER_BUFFER_SECONDS * 200)
+
+// Audio demodulated before the main receiver gained sync, so the logger's
+// demodulator has had as long to sync up.
+#define CODEC_FRAME_LOGGER_PREROLL_MS 2000
+
+CodecFrameLogger::CodecFrameLogger(std::string path, int inputSampleRate, std::deque<int> modes)
+    : path_(path)
+    , inputSampleRate_(inputSampleRate)
+    , modes_(modes)
+    , ring_((size_t)inputSampleRate * CODEC_FRAME_LOGGER_BUFFER_SECONDS)
+    , blocks_(CODEC_FRAME_LOGGER_MAX_BLOCKS)
+    , preRollPos_(0)
+    , numSamplesIn_(0)
+    , isRunning_(false)
+    , numFramesWritten_(0)
+    , numBytesWritten_(0)
+    , numSamplesDropped_(0)
+{
+    // empty
+}
+
+CodecFrameLogger::~CodecFrameLogger()
+{
+    close();
+}
+
+bool CodecFrameLogger::open()
+{
+    if (!writer_.open(path_, (int64_t)time(nullptr), &error_))
+    {
+        fprintf(stderr, "Could not create codec frame log %s: %s\n", path_.c_str(), error_.c_str());
+        return false;
+    }
+    numBytesWritten_ = writer_.getNumBytesWritten();
+
+    // Demodulators are only created once there's sync, so find out now
+    // which modes can't be.
+    for (auto iter = modes_.begin(); iter != modes_.end();)
+    {
+        struct freedv* dv = freedv_open(*iter);
+        if (dv == nullptr)
+        {
+            fprintf(stderr, "Codec frame log: can't demodulate mode %d, skipping\n", *iter);
+            iter = modes_.erase(iter);
+            continue;
+        }
+        freedv_close(dv);
+        iter++;
+    }
+
+    preRoll_.assign(std::max(inputSampleRate_ * CODEC_FRAME_LOGGER_PREROLL_MS / 1000, 1), 0);
+    preRollPos_ = 0;
+    numSamplesIn_ = 0;
+
+    isRunning_ = true;
+    demodThread_ = std::thread(std::bind(&CodecFrameLogger::threadEntry_, this));
+    return true;
+}
+
+void CodecFrameLogger::close()
+{
+    if (isRunning_)
+    {
+        {
+            std::unique_lock<std::mutex> lk(threadMutex_);
+            isRunning_ = false;
+        }
+        threadCV_.notify_one();
+        demodThread_.join();
+
+        drain_();
+    }
+
+    stopDemodulator_();
+    writer_.close();
+}
+
+void CodecFrameLogger::write(const short* samples, int numSamples, int syncMode)
+{
+    // All or nothing, so the blocks stay in step with the samples.
+    if (ring_.numFree() < (size_t)numSamples || blocks_.numFree() < 1)
+    {
+        numSamplesDropped_.fetch_add(numSamples, std::memory_order_relaxed);
+        return;
+    }
+
+    Block block;
+    block.syncMode = syncMode;
+    block.numSamples = numSamples;
+    ring_.write(samples, numSamples);
+    blocks_.write(&block, 1);
+}
+
+void CodecFrameLogger::startDemodulator_(int mode)
+{
+    stopDemodulator_();
+
+    if (std::find(modes_.begin(), modes_.end(), mode) == modes_.end())
+    {
+        return;
+    }
+
+    struct freedv* dv = freedv_open(mode);
+    if (dv == nullptr)
+    {
+        return;
+    }
+
+    demod_.reset(new Demodulator);
+    demod_->mode = mode;
+    demod_->dv = dv;
+
+    int modemSampleRate = freedv_get_modem_sample_rate(dv);
+    if (modemSampleRate != inputSampleRate_)
+    {
+        demod_->resampler.reset(new ResampleStep(inputSampleRate_, modemSampleRate));
+    }
+
+    // As FreeDVReceiveStep: 2x the most a frame needs so nothing's lost.
+    demod_->inputFifo = codec2_fifo_create(freedv_get_n_max_modem_samples(dv) * 2);
+    demod_->inputBuf.resize(freedv_get_n_max_modem_samples(dv));
+    demod_->payloadBuf.resize((freedv_get_bits_per_modem_frame(dv) + 7) / 8);
+    demod_->loggedSync = false;
+
+    // Catch up on the pre-roll, oldest first, so the time stamps carry on
+    // from where it starts.
+    int numPreRoll = (int)std::min((uint64_t)preRoll_.size(), numSamplesIn_);
+    demod_->numSamplesIn = (numSamplesIn_ - numPreRoll) * modemSampleRate / inputSampleRate_;
+    if (numPreRoll > 0)
+    {
+        std::shared_ptr<short> preRoll(new short[numPreRoll], std::default_delete<short[]>());
+        size_t pos = (preRollPos_ + preRoll_.size() - numPreRoll) % preRoll_.size();
+        for (int index = 0; index < numPreRoll; index++)
+        {
+            preRoll.get()[index] = preRoll_[pos];
+            pos = (pos + 1) % preRoll_.size();
+        }
+        demodulate_(preRoll, numPreRoll, false);
+    }
+}
+
+void CodecFrameLogger::stopDemodulator_()
+{
+    if (demod_ == nullptr)
+    {
+        return;
+    }
+
+    if (demod_->loggedSync)
+    {
+        writeSyncLost_();
+    }
+
+    codec2_fifo_destroy(demod_->inputFifo);
+    freedv_close(demod_->dv);
+    demod_.reset();
+}
+
+void CodecFrameLogger::writeSyncLost_()
+{
+    CodecFrameLogRecord record;
+    record.mode = demod_->mode;
+    record.sync = false;
+    record.snrDb = 0;
+    record.timeMs = (uint32_t)(demod_->numSamplesIn * 1000 / freedv_get_modem_sample_rate(demod_->dv));
+
+    if (writer_.write(record))
+    {
+        numBytesWritten_.store(writer_.getNumBytesWritten(), std::memory_order_relaxed);
+    }
+    demod_->loggedSync = false;
+}
+
+void CodecFrameLogger::demodulate_(std::shared_ptr<short> input, int numSamples, bool logFrames)
+{
+    Demodulator& demod = *demod_;
+    if (demod.resampler != nullptr)
+    {
+        input = demod.resampler->execute(input, numSamples, &numSamples);
+    }
+
+    // The FIFO is only big enough for two frames, so feed it a bit at a
+    // time.
+    int modemSampleRate = freedv_get_modem_sample_rate(demod.dv);
+    short* inputPtr = input.get();
+    while (numSamples > 0)
+    {
+        int nin = freedv_nin(demod.dv);
+        int count = std::min(numSamples, nin);
+        codec2_fifo_write(demod.inputFifo, inputPtr, count);
+        inputPtr += count;
+        numSamples -= count;
+
+        while (codec2_fifo_read(demod.inputFifo, &demod.inputBuf[0], nin) == 0)
+        {
+            int numBytes = freedv_rawdatarx(demod.dv, &demod.payloadBuf[0], &demod.inputBuf[0]);
+            demod.numSamplesIn += nin;
+
+            int sync = 0;
+            float snr = 0;
+            freedv_get_modem_stats(demod.dv, &sync, &snr);
+
+            // Every decoded frame, plus a marker when sync goes so that
+            // replay knows where the over ended.
+            if (logFrames && (numBytes > 0 || (demod.loggedSync && !sync)))
+            {
+                CodecFrameLogRecord record;
+                record.mode = demod.mode;
+                record.sync = sync != 0;
+                record.snrDb = std::isfinite(snr) ? (int)lroundf(snr) : 0;
+                record.timeMs = (uint32_t)(demod.numSamplesIn * 1000 / modemSampleRate);
+                record.payload.assign(demod.payloadBuf.begin(), demod.payloadBuf.begin() + std::max(numBytes, 0));
+
+                if (writer_.write(record))
+                {
+                    numFramesWritten_.fetch_add(numBytes > 0 ? 1 : 0, std::memory_order_relaxed);
+                    numBytesWritten_.store(writer_.getNumBytesWritten(), std::memory_order_relaxed);
+                }
+                demod.loggedSync = record.sync;
+            }
+
+            nin = freedv_nin(demod.dv);
+        }
+    }
+}
+
+void CodecFrameLogger::drain_()
+{
+    Block block;
+    while (blocks_.read(&block, 1) == 1)
+    {
+        std::shared_ptr<short> input(new short[block.numSamples], std::default_delete<short[]>());
+        ring_.read(input.get(), block.numSamples);
+
+        // Follow the main receiver: only the mode it's in sync on is
+        // demodulated, from a fresh start each time it gains sync.
+        if (demod_ != nullptr && demod_->mode != block.syncMode)
+        {
+            stopDemodulator_();
+        }
+        if (demod_ == nullptr && block.syncMode != NO_SYNC)
+        {
+            startDemodulator_(block.syncMode);
+        }
+
+        if (demod_ != nullptr)
+        {
+            demodulate_(input, block.numSamples, true);
+        }
+
+        // Keep the latest for the next time sync is gained.
+        for (int index = 0; index < block.numSamples; index++)
+        {
+            preRoll_[preRollPos_] = input.get()[index];
+            preRollPos_ = (preRollPos_ + 1) % preRoll_.size();
+        }
+        numSamplesIn_ += block.numSamples;
+    }
+}
+
+void CodecFrameLogger::threadEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV framelog");
+#endif // defined(__linux__)
+
+    std::unique_lock<std::mutex> lk(threadMutex_);
+    while (isRunning_)
+    {
+        threadCV_.wait_for(lk, std::chrono::milliseconds(CODEC_FRAME_LOGGER_POLL_MS));
+        if (!isRunning_)
+        {
+            break;
+        }
+
+        lk.unlock();
+        drain_();
+        lk.lock();
+    }
+}
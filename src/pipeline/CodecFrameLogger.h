@@ -0,0 +1,147 @@
+//=========================================================================
+// Name:            CodecFrameLogger.h
+// Purpose:         Demodulates radio audio in the background and logs the
+//                  received codec frames (see CodecFrameLog.h).
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__CODEC_FRAME_LOGGER_H
+#define AUDIO_PIPELINE__CODEC_FRAME_LOGGER_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "CodecFrameLog.h"
+#include "ResampleStep.h"
+#include "../util/SpscRingBuffer.h"
+
+// Forward declarations of structs implemented by Codec2
+extern "C"
+{
+    struct FIFO;
+    struct freedv;
+}
+
+// Logs the payload of every modem frame the main receiver is in sync on.
+// The main receiver decodes straight to speech, so this runs its own
+// demodulator with freedv_rawdatarx() on a background thread, but only
+// for the mode the main receiver has in sync and only while it does: at
+// most one demodulator, and none when there's no signal. When sync is
+// gained the last CODEC_FRAME_LOGGER_PREROLL_MS of audio is demodulated
+// first (without logging) so the logger's demodulator is in sync too.
+// write() only copies into preallocated rings, so it's safe to call from
+// the RX thread.
+class CodecFrameLogger
+{
+public:
+    // syncMode passed to write() when the main receiver has no sync.
+    static const int NO_SYNC = -1;
+
+    // modes are FREEDV_MODE_* values, as used by FreeDVInterface.
+    CodecFrameLogger(std::string path, int inputSampleRate, std::deque<int> modes);
+    virtual ~CodecFrameLogger();
+
+    // Creates the log and starts the demodulator thread. Returns false
+    // (see getError()) if the log couldn't be created.
+    bool open();
+
+    // Demodulates everything queued so far, then closes the log.
+    void close();
+
+    // Queues radio audio, along with the mode the main receiver was in
+    // sync on when it arrived (or NO_SYNC). Frames are only logged from
+    // audio queued with their own mode. Realtime safe; single producer
+    // only.
+    void write(const short* samples, int numSamples, int syncMode);
+
+    int getSampleRate() const { return inputSampleRate_; }
+    std::string getError() const { return error_; }
+
+    // Statistics, for display/logging. May be called from any thread.
+    uint64_t getNumFramesWritten() const { return numFramesWritten_.load(std::memory_order_relaxed); }
+    uint64_t getNumBytesWritten() const { return numBytesWritten_.load(std::memory_order_relaxed); }
+    uint64_t getNumSamplesDropped() const { return numSamplesDropped_.load(std::memory_order_relaxed); }
+
+private:
+    // One per write(); its samples are next in ring_.
+    struct Block
+    {
+        int syncMode;
+        int numSamples;
+    };
+
+    struct Demodulator
+    {
+        int mode;
+        struct freedv* dv;
+        std::unique_ptr<ResampleStep> resampler; // if the modem rate differs
+        struct FIFO* inputFifo;
+        std::vector<short> inputBuf;
+        std::vector<unsigned char> payloadBuf;
+        uint64_t numSamplesIn; // at the modem rate, for the time stamps
+        bool loggedSync; // sync of the last record logged
+    };
+
+    std::string path_;
+    int inputSampleRate_;
+    std::deque<int> modes_;
+    std::string error_;
+
+    SpscRingBuffer<short> ring_;
+    SpscRingBuffer<Block> blocks_;
+
+    // Only touched by open()/close() and the demodulator thread.
+    CodecFrameLogWriter writer_;
+    std::unique_ptr<Demodulator> demod_;
+    std::vector<short> preRoll_; // circular, preRollPos_ is the oldest
+    size_t preRollPos_;
+    uint64_t numSamplesIn_; // at the input rate
+
+    std::atomic<bool> isRunning_;
+    std::mutex threadMutex_;
+    std::condition_variable threadCV_;
+    std::thread demodThread_;
+
+    std::atomic<uint64_t> numFramesWritten_;
+    std::atomic<uint64_t> numBytesWritten_;
+    std::atomic<uint64_t> numSamplesDropped_;
+
+    // Replaces demod_ with a fresh demodulator for mode that has already
+    // seen the pre-roll. Leaves demod_ empty if mode can't be demodulated.
+    void startDemodulator_(int mode);
+    void stopDemodulator_();
+    void demodulate_(std::shared_ptr<short> input, int numSamples, bool logFrames);
+
+    // Logs a sync change, so that replay knows where the over ended.
+    void writeSyncLost_();
+
+    // Demodulates whatever's queued.
+    void drain_();
+
+    void threadEntry_();
+};
+
+#endif // AUDIO_PIPELINE__CODEC_FRAME_LOGGER_H
@@ -23,11 +23,8 @@
 #include "ComputeRfSpectrumStep.h"
 #include "../defines.h"
 
-ComputeRfSpectrumStep::ComputeRfSpectrumStep(
-    std::function<struct MODEM_STATS*()> modemStatsFn,
-    std::function<float*()> getAvMagFn)
-    : modemStatsFn_(modemStatsFn)
-    , getAvMagFn_(getAvMagFn)
+ComputeRfSpectrumStep::ComputeRfSpectrumStep(std::function<SpectrumEngine*()> getSpectrumEngineFn)
+    : getSpectrumEngineFn_(getSpectrumEngineFn)
 {
     // empty
 }
@@ -49,22 +46,10 @@ int ComputeRfSpectrumStep::getOutputSampleRate() const
 
 std::shared_ptr<short> ComputeRfSpectrumStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
 {
-    COMP  rx_fdm[numInputSamples];
-    float rx_spec[MODEM_STATS_NSPEC];
-    
-    auto inputSamplesPtr = inputSamples.get();
-    for (int i = 0; i < numInputSamples; i++)
-    {
-        rx_fdm[i].real = inputSamplesPtr[i];
-    }
-    
-    modem_stats_get_rx_spectrum(modemStatsFn_(), rx_spec, rx_fdm, numInputSamples);
-    
-    // Average rx spectrum data using a simple IIR low pass filter
-    auto avMagPtr = getAvMagFn_();
-    for(int i = 0; i < MODEM_STATS_NSPEC; i++) 
+    auto engine = getSpectrumEngineFn_();
+    if (engine != nullptr)
     {
-        avMagPtr[i] = BETA * avMagPtr[i] + (1.0 - BETA) * rx_spec[i];
+        engine->addSamples(inputSamples.get(), numInputSamples);
     }
     
     // Tap only, no output.
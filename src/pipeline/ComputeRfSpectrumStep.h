@@ -26,17 +26,16 @@
 #include <memory>
 #include <functional>
 
-#include "modem_stats.h"
 #include "IPipelineStep.h"
+#include "SpectrumEngine.h"
 
 class ComputeRfSpectrumStep : public IPipelineStep
 {
 public:
     // Note: only supports 8 kHz, so needs to be inserted into an AudioPipeline
-    // in order to downconvert properly.
-    ComputeRfSpectrumStep(
-        std::function<struct MODEM_STATS*()> modemStatsFn,
-        std::function<float*()> getAvMagFn);
+    // in order to downconvert properly. The FFTs themselves are done by the
+    // SpectrumEngine's own thread, this step only hands it samples.
+    ComputeRfSpectrumStep(std::function<SpectrumEngine*()> getSpectrumEngineFn);
     virtual ~ComputeRfSpectrumStep();
     
     virtual int getInputSampleRate() const;
@@ -44,8 +43,7 @@ public:
     virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples);
     
 private:
-    std::function<struct MODEM_STATS*()> modemStatsFn_;
-    std::function<float*()> getAvMagFn_;
+    std::function<SpectrumEngine*()> getSpectrumEngineFn_;
 };
 
 #endif // AUDIO_PIPELINE__COMPUTE_RF_SPECTRUM_STEP_H
\ No newline at end of file
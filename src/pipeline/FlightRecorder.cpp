@@ -0,0 +1,179 @@
+//=========================================================================
+// Name:            FlightRecorder.cpp
+// Purpose:         Keeps the last few minutes of radio audio in memory so
+//                  it can be saved or decoded after the fact.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "FlightRecorder.h"
+
+#include <cstring>
+#include <algorithm>
+#include <sndfile.h>
+
+size_t FlightRecording::read(size_t position, short* output, size_t numSamples) const
+{
+    if (position >= numSamples_)
+    {
+        return 0;
+    }
+
+    numSamples = std::min(numSamples, numSamples_ - position);
+    size_t numCopied = 0;
+    while (numCopied < numSamples)
+    {
+        size_t blockPosition = startOffset_ + position + numCopied;
+        size_t blockIndex = blockPosition / blockSize_;
+        size_t blockOffset = blockPosition % blockSize_;
+        size_t count = std::min(numSamples - numCopied, blockSize_ - blockOffset);
+
+        memcpy(output + numCopied, blocks_[blockIndex].get() + blockOffset, count * sizeof(short));
+        numCopied += count;
+    }
+    return numCopied;
+}
+
+bool FlightRecording::save(std::string path, std::string* error) const
+{
+    SF_INFO sfInfo;
+    sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    sfInfo.channels = 1;
+    sfInfo.samplerate = sampleRate_;
+
+    SNDFILE* file = sf_open(path.c_str(), SFM_WRITE, &sfInfo);
+    if (file == nullptr)
+    {
+        *error = sf_strerror(nullptr);
+        return false;
+    }
+
+    // Straight from the blocks, no copying.
+    bool ok = true;
+    size_t position = 0;
+    while (ok && position < numSamples_)
+    {
+        size_t blockPosition = startOffset_ + position;
+        size_t blockOffset = blockPosition % blockSize_;
+        size_t count = std::min(numSamples_ - position, blockSize_ - blockOffset);
+
+        const short* samples = blocks_[blockPosition / blockSize_].get() + blockOffset;
+        ok = sf_write_short(file, samples, count) == (sf_count_t)count;
+        position += count;
+    }
+
+    if (!ok)
+    {
+        *error = sf_strerror(file);
+    }
+    sf_close(file);
+    return ok;
+}
+
+FlightRecorder::FlightRecorder(int sampleRate, int maxSeconds)
+    : sampleRate_(sampleRate)
+    , maxSeconds_(maxSeconds)
+    , blockSize_(std::max(sampleRate, 1))
+    , currentUsed_(0)
+{
+    // empty
+}
+
+size_t FlightRecorder::getSizeBytes()
+{
+    std::unique_lock<std::mutex> lk(mutex_);
+    size_t numBlocks = full_.size() + (current_ != nullptr ? 1 : 0) + (spare_ != nullptr ? 1 : 0);
+    return numBlocks * blockSize_ * sizeof(short);
+}
+
+void FlightRecorder::write(const short* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        if (current_ == nullptr)
+        {
+            auto block = newBlock_();
+            std::unique_lock<std::mutex> lk(mutex_);
+            current_ = block;
+        }
+
+        // Past currentUsed_, so snapshot() won't be looking at it.
+        size_t count = std::min((size_t)numSamples, blockSize_ - currentUsed_);
+        memcpy(current_.get() + currentUsed_, samples, count * sizeof(short));
+        samples += count;
+        numSamples -= count;
+
+        std::unique_lock<std::mutex> lk(mutex_);
+        currentUsed_ += count;
+        if (currentUsed_ == blockSize_)
+        {
+            full_.push_back(current_);
+            current_ = nullptr;
+            currentUsed_ = 0;
+
+            if (full_.size() > (size_t)maxSeconds_)
+            {
+                spare_ = full_.front();
+                full_.pop_front();
+            }
+        }
+    }
+}
+
+std::shared_ptr<FlightRecording> FlightRecorder::snapshot()
+{
+    auto recording = std::make_shared<FlightRecording>();
+    recording->sampleRate_ = sampleRate_;
+    recording->blockSize_ = blockSize_;
+
+    // The current block is still being written to, so the part that's
+    // been filled is copied.
+    std::shared_ptr<short> partial(new short[blockSize_], std::default_delete<short[]>());
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    recording->blocks_.assign(full_.begin(), full_.end());
+    size_t numSamples = full_.size() * blockSize_;
+    if (currentUsed_ > 0)
+    {
+        memcpy(partial.get(), current_.get(), currentUsed_ * sizeof(short));
+        recording->blocks_.push_back(partial);
+        numSamples += currentUsed_;
+    }
+    lk.unlock();
+
+    size_t maxSamples = (size_t)maxSeconds_ * sampleRate_;
+    recording->startOffset_ = numSamples > maxSamples ? numSamples - maxSamples : 0;
+    recording->numSamples_ = numSamples - recording->startOffset_;
+    return recording;
+}
+
+std::shared_ptr<short> FlightRecorder::newBlock_()
+{
+    // Reuse the block that last dropped off the end unless a recording
+    // still has it.
+    std::shared_ptr<short> block;
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        block.swap(spare_);
+    }
+    if (block != nullptr && block.use_count() == 1)
+    {
+        return block;
+    }
+    return std::shared_ptr<short>(new short[blockSize_], std::default_delete<short[]>());
+}
@@ -0,0 +1,98 @@
+//=========================================================================
+// Name:            FlightRecorder.h
+// Purpose:         Keeps the last few minutes of radio audio in memory so
+//                  it can be saved or decoded after the fact.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__FLIGHT_RECORDER_H
+#define AUDIO_PIPELINE__FLIGHT_RECORDER_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <vector>
+
+// A copy of what the flight recorder held at one point in time. Shares
+// the recorder's (immutable) full blocks, so taking one is cheap, and
+// stays valid however long it's kept.
+class FlightRecording
+{
+public:
+    int getSampleRate() const { return sampleRate_; }
+    size_t getNumSamples() const { return numSamples_; }
+
+    // Copies up to numSamples samples starting at position into output,
+    // returning how many were copied.
+    size_t read(size_t position, short* output, size_t numSamples) const;
+
+    // Writes the recording as 16 bit mono WAV. Returns false (and sets
+    // *error) on failure.
+    bool save(std::string path, std::string* error) const;
+
+private:
+    friend class FlightRecorder;
+
+    int sampleRate_;
+    size_t blockSize_;
+    size_t startOffset_;
+    size_t numSamples_;
+    std::vector<std::shared_ptr<short> > blocks_;
+};
+
+// Bounded history of the raw radio input, stored as int16 in one second
+// blocks. write() is called by the RX thread for every frame and only
+// copies into the current block; blocks that drop off the end are
+// reused unless a FlightRecording still refers to them.
+class FlightRecorder
+{
+public:
+    FlightRecorder(int sampleRate, int maxSeconds);
+    virtual ~FlightRecorder() = default;
+
+    int getSampleRate() const { return sampleRate_; }
+    int getMaxSeconds() const { return maxSeconds_; }
+
+    // Memory currently held, in bytes.
+    size_t getSizeBytes();
+
+    // Single producer (the RX thread).
+    void write(const short* samples, int numSamples);
+
+    // Any thread. Returns up to the last maxSeconds of audio.
+    std::shared_ptr<FlightRecording> snapshot();
+
+private:
+    int sampleRate_;
+    int maxSeconds_;
+    size_t blockSize_;
+
+    // full_ and currentUsed_ change under mutex_. The contents of
+    // current_ past currentUsed_ are only touched by write().
+    std::mutex mutex_;
+    std::deque<std::shared_ptr<short> > full_;
+    std::shared_ptr<short> current_;
+    size_t currentUsed_;
+    std::shared_ptr<short> spare_;
+
+    std::shared_ptr<short> newBlock_();
+};
+
+#endif // AUDIO_PIPELINE__FLIGHT_RECORDER_H
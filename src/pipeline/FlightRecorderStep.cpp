@@ -0,0 +1,42 @@
+//=========================================================================
+// Name:            FlightRecorderStep.cpp
+// Purpose:         Adds RX pipeline input to the flight recorder.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "FlightRecorderStep.h"
+
+FlightRecorderStep::FlightRecorderStep(int sampleRate, std::function<FlightRecorder*()> getRecorderFn)
+    : sampleRate_(sampleRate)
+    , getRecorderFn_(getRecorderFn)
+{
+    // empty
+}
+
+std::shared_ptr<short> FlightRecorderStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
+{
+    auto recorder = getRecorderFn_();
+    if (recorder != nullptr && recorder->getSampleRate() == sampleRate_)
+    {
+        recorder->write(inputSamples.get(), numInputSamples);
+    }
+
+    *numOutputSamples = numInputSamples;
+    return inputSamples;
+}
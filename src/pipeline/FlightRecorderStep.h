@@ -0,0 +1,47 @@
+//=========================================================================
+// Name:            FlightRecorderStep.h
+// Purpose:         Adds RX pipeline input to the flight recorder.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__FLIGHT_RECORDER_STEP_H
+#define AUDIO_PIPELINE__FLIGHT_RECORDER_STEP_H
+
+#include <functional>
+#include "IPipelineStep.h"
+#include "FlightRecorder.h"
+
+// Passes its input through unchanged, adding it to the flight recorder
+// (if there is one).
+class FlightRecorderStep : public IPipelineStep
+{
+public:
+    FlightRecorderStep(int sampleRate, std::function<FlightRecorder*()> getRecorderFn);
+    virtual ~FlightRecorderStep() = default;
+
+    virtual int getInputSampleRate() const override { return sampleRate_; }
+    virtual int getOutputSampleRate() const override { return sampleRate_; }
+    virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples) override;
+
+private:
+    int sampleRate_;
+    std::function<FlightRecorder*()> getRecorderFn_;
+};
+
+#endif // AUDIO_PIPELINE__FLIGHT_RECORDER_STEP_H
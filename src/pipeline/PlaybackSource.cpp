@@ -0,0 +1,275 @@
+//=========================================================================
+// Name:            PlaybackSource.cpp
+// Purpose:         Reads audio files for playback without doing file
+//                  I/O on the audio path.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "PlaybackSource.h"
+
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+// Frames per sf_readf_short() call.
+#define PLAYBACK_SOURCE_CHUNK_FRAMES 8192
+
+// How far ahead of playback streamed files are read, and how often the
+// prefetch thread tops that up.
+#define PLAYBACK_SOURCE_READ_AHEAD_SECONDS 4
+#define PLAYBACK_SOURCE_POLL_MS 100
+
+PlaybackSource::PlaybackSource(std::string path, int rawSampleRate, int maxPreloadSeconds)
+    : path_(path)
+    , rawSampleRate_(rawSampleRate)
+    , maxPreloadSeconds_(maxPreloadSeconds)
+    , sampleRate_(0)
+    , loop_(false)
+    , hasCompleted_(false)
+    , numSamples_(0)
+    , position_(0)
+    , file_(nullptr)
+    , numChannels_(1)
+    , isAtEnd_(false)
+    , isRunning_(false)
+{
+    // empty
+}
+
+PlaybackSource::~PlaybackSource()
+{
+    close();
+}
+
+bool PlaybackSource::open()
+{
+    SF_INFO sfInfo;
+    sfInfo.format = 0;
+    if (rawSampleRate_ > 0)
+    {
+        sfInfo.format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+        sfInfo.channels = 1;
+        sfInfo.samplerate = rawSampleRate_;
+    }
+
+    file_ = sf_open(path_.c_str(), SFM_READ, &sfInfo);
+    if (file_ == nullptr)
+    {
+        error_ = sf_strerror(nullptr);
+        return false;
+    }
+
+    sampleRate_ = sfInfo.samplerate;
+    numChannels_ = std::max(sfInfo.channels, 1);
+    frameBuffer_.resize(PLAYBACK_SOURCE_CHUNK_FRAMES * numChannels_);
+
+    if (sfInfo.frames <= (sf_count_t)maxPreloadSeconds_ * sampleRate_)
+    {
+        bool result = preload_(std::max(sfInfo.frames, (sf_count_t)0));
+        sf_close(file_);
+        file_ = nullptr;
+        return result;
+    }
+
+    // Too long to hold in memory; start reading ahead.
+    ring_.reset(new SpscRingBuffer<short>(sampleRate_ * PLAYBACK_SOURCE_READ_AHEAD_SECONDS));
+    fillRing_();
+
+    isRunning_ = true;
+    prefetchThread_ = std::thread(std::bind(&PlaybackSource::threadEntry_, this));
+    return true;
+}
+
+void PlaybackSource::close()
+{
+    if (isRunning_)
+    {
+        {
+            std::unique_lock<std::mutex> lk(threadMutex_);
+            isRunning_ = false;
+        }
+        threadCV_.notify_one();
+        prefetchThread_.join();
+    }
+
+    if (file_ != nullptr)
+    {
+        sf_close(file_);
+        file_ = nullptr;
+    }
+
+    // Blocks already handed out by read() keep this alive as needed.
+    samples_.reset();
+}
+
+std::shared_ptr<short> PlaybackSource::read(int numSamples, bool* isComplete)
+{
+    *isComplete = false;
+
+    if (samples_ != nullptr && position_ + numSamples <= numSamples_)
+    {
+        // Shares ownership of the whole file rather than copying.
+        std::shared_ptr<short> result(samples_, samples_.get() + position_);
+        position_ += numSamples;
+        return result;
+    }
+
+    short* output = new short[numSamples];
+    std::shared_ptr<short> result(output, std::default_delete<short[]>());
+    size_t numRead = 0;
+    bool isAtEnd = false;
+
+    if (samples_ != nullptr)
+    {
+        // Crossing the end of the file.
+        while (numRead < (size_t)numSamples)
+        {
+            size_t count = std::min(numSamples - numRead, numSamples_ - position_);
+            memcpy(output + numRead, samples_.get() + position_, count * sizeof(short));
+            numRead += count;
+            position_ += count;
+
+            if (position_ >= numSamples_)
+            {
+                if (!loop_ || numSamples_ == 0)
+                {
+                    isAtEnd = true;
+                    break;
+                }
+                position_ = 0;
+            }
+        }
+    }
+    else if (ring_ != nullptr)
+    {
+        numRead = ring_->read(output, numSamples);
+
+        // The prefetch thread only sets isAtEnd_ after queueing the last
+        // of the file, so an empty ring after that means we've played it.
+        isAtEnd = numRead < (size_t)numSamples && isAtEnd_ && ring_->numUsed() == 0;
+    }
+
+    if (numRead < (size_t)numSamples)
+    {
+        memset(output + numRead, 0, (numSamples - numRead) * sizeof(short));
+    }
+
+    if (isAtEnd && !hasCompleted_)
+    {
+        hasCompleted_ = true;
+        *isComplete = true;
+    }
+    return result;
+}
+
+bool PlaybackSource::preload_(size_t numFrames)
+{
+    samples_ = std::shared_ptr<short>(new short[std::max(numFrames, (size_t)1)], std::default_delete<short[]>());
+    numSamples_ = 0;
+    position_ = 0;
+
+    while (numSamples_ < numFrames)
+    {
+        sf_count_t count = std::min(numFrames - numSamples_, (size_t)PLAYBACK_SOURCE_CHUNK_FRAMES);
+        count = sf_readf_short(file_, &frameBuffer_[0], count);
+        if (count <= 0)
+        {
+            break;
+        }
+
+        short* dest = samples_.get() + numSamples_;
+        for (sf_count_t index = 0; index < count; index++)
+        {
+            dest[index] = frameBuffer_[index * numChannels_];
+        }
+        numSamples_ += count;
+    }
+
+    if (numSamples_ == 0 && numFrames > 0)
+    {
+        error_ = sf_strerror(file_);
+        samples_.reset();
+        return false;
+    }
+    return true;
+}
+
+void PlaybackSource::fillRing_()
+{
+    bool hasRewound = false;
+    while (!isAtEnd_)
+    {
+        size_t count = std::min(ring_->numFree(), (size_t)PLAYBACK_SOURCE_CHUNK_FRAMES);
+        if (count == 0)
+        {
+            break;
+        }
+
+        sf_count_t numRead = sf_readf_short(file_, &frameBuffer_[0], count);
+        if (numRead <= 0)
+        {
+            // Rewinding twice in a row means there's nothing to play.
+            if (loop_ && !hasRewound)
+            {
+                sf_seek(file_, 0, SEEK_SET);
+                hasRewound = true;
+                continue;
+            }
+
+            isAtEnd_ = true;
+            break;
+        }
+        hasRewound = false;
+
+        if (numChannels_ > 1)
+        {
+            for (sf_count_t index = 0; index < numRead; index++)
+            {
+                frameBuffer_[index] = frameBuffer_[index * numChannels_];
+            }
+        }
+        ring_->write(&frameBuffer_[0], numRead);
+    }
+}
+
+void PlaybackSource::threadEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV playback");
+#endif // defined(__linux__)
+
+    std::unique_lock<std::mutex> lk(threadMutex_);
+    while (isRunning_)
+    {
+        threadCV_.wait_for(lk, std::chrono::milliseconds(PLAYBACK_SOURCE_POLL_MS));
+        if (!isRunning_)
+        {
+            break;
+        }
+
+        lk.unlock();
+        fillRing_();
+        lk.lock();
+    }
+}
@@ -0,0 +1,113 @@
+//=========================================================================
+// Name:            PlaybackSource.h
+// Purpose:         Reads audio files for playback without doing file
+//                  I/O on the audio path.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__PLAYBACK_SOURCE_H
+#define AUDIO_PIPELINE__PLAYBACK_SOURCE_H
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <sndfile.h>
+
+#include "../util/SpscRingBuffer.h"
+
+// Files up to this long are decoded into memory by open(); anything
+// longer is streamed.
+#define PLAYBACK_SOURCE_MAX_PRELOAD_SECONDS 600
+
+// Mono int16 audio from a file, for PlaybackStep. Short files (voice
+// keyer messages, most recordings) are decoded in full by open() and
+// read() hands out blocks that point straight into that buffer. Longer
+// ones are read ahead into a ring by a background thread, so either way
+// read() never touches the disk and is safe to call from the TX/RX
+// threads. Only the first channel of multichannel files is used.
+class PlaybackSource
+{
+public:
+    // rawSampleRate > 0 treats the file as headerless 16 bit mono PCM at
+    // that rate; otherwise the format is taken from the file.
+    PlaybackSource(
+        std::string path, int rawSampleRate = 0,
+        int maxPreloadSeconds = PLAYBACK_SOURCE_MAX_PRELOAD_SECONDS);
+    virtual ~PlaybackSource();
+
+    // Opens (and for short files, decodes) the file. Returns false (see
+    // getError()) if it can't be read.
+    bool open();
+    void close();
+
+    int getSampleRate() const { return sampleRate_; }
+    std::string getError() const { return error_; }
+    bool isPreloaded() const { return samples_ != nullptr; }
+
+    // Length of a preloaded file, in samples (0 if streamed).
+    size_t getNumSamples() const { return isPreloaded() ? numSamples_ : 0; }
+
+    // Whether to go back to the start at the end of the file. May be
+    // changed at any time.
+    void setLoop(bool loop) { loop_ = loop; }
+
+    // Consumer side. Returns exactly numSamples samples, padded with
+    // silence past the end of the file (or if streaming falls behind).
+    // *isComplete is set the first time the end is reached without
+    // looping. The returned buffer must not be modified.
+    std::shared_ptr<short> read(int numSamples, bool* isComplete);
+
+private:
+    std::string path_;
+    int rawSampleRate_;
+    int maxPreloadSeconds_;
+    int sampleRate_;
+    std::string error_;
+    std::atomic<bool> loop_;
+    bool hasCompleted_;
+
+    // Preloaded: the whole file and the next sample to read.
+    std::shared_ptr<short> samples_;
+    size_t numSamples_;
+    size_t position_;
+
+    // Streamed: file_ is only touched by the prefetch thread once
+    // started.
+    SNDFILE* file_;
+    int numChannels_;
+    std::unique_ptr<SpscRingBuffer<short> > ring_;
+    std::vector<short> frameBuffer_;
+    std::atomic<bool> isAtEnd_;
+    std::atomic<bool> isRunning_;
+    std::mutex threadMutex_;
+    std::condition_variable threadCV_;
+    std::thread prefetchThread_;
+
+    bool preload_(size_t numFrames);
+
+    // Reads from the file into the ring until it's full or the file ends.
+    void fillRing_();
+    void threadEntry_();
+};
+
+#endif // AUDIO_PIPELINE__PLAYBACK_SOURCE_H
@@ -23,14 +23,12 @@
 #include "PlaybackStep.h"
 #include <cassert>
 
-#include <cassert>
-
 PlaybackStep::PlaybackStep(
     int inputSampleRate, std::function<int()> fileSampleRateFn, 
-    std::function<SNDFILE*()> getSndFileFn, std::function<void()> fileCompleteFn)
+    std::function<PlaybackSource*()> getSourceFn, std::function<void()> fileCompleteFn)
 : inputSampleRate_(inputSampleRate)
 , fileSampleRateFn_(fileSampleRateFn)
-, getSndFileFn_(getSndFileFn)
+, getSourceFn_(getSourceFn)
 , fileCompleteFn_(fileCompleteFn)
 {
     // empty
@@ -53,21 +51,19 @@ int PlaybackStep::getOutputSampleRate() const
 
 std::shared_ptr<short> PlaybackStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
 {
-    auto playFile = getSndFileFn_();
-    assert(playFile != nullptr);
+    auto playSource = getSourceFn_();
+    assert(playSource != nullptr);
 
     unsigned int nsf = numInputSamples * getOutputSampleRate()/getInputSampleRate();
     assert(nsf > 0);
 
-    short* outputSamples = new short[nsf];
-    assert(outputSamples != nullptr);
-    
-    *numOutputSamples = sf_read_short(playFile, outputSamples, nsf);
-    if ((unsigned)*numOutputSamples < nsf)
+    bool isComplete = false;
+    auto outputSamples = playSource->read(nsf, &isComplete);
+    if (isComplete)
     {
         fileCompleteFn_();
     }
     *numOutputSamples = nsf;
 
-    return std::shared_ptr<short>(outputSamples, std::default_delete<short[]>());
+    return outputSamples;
 }
@@ -25,14 +25,16 @@
 
 #include "IPipelineStep.h"
 #include <functional>
-#include <sndfile.h>
+#include "PlaybackSource.h"
 
+// Replaces its input with audio from a PlaybackSource. fileCompleteFn is
+// called once when a non-looping source reaches the end.
 class PlaybackStep : public IPipelineStep
 {
 public:
     PlaybackStep(
         int inputSampleRate, std::function<int()> fileSampleRateFn, 
-        std::function<SNDFILE*()> getSndFileFn, std::function<void()> fileCompleteFn);
+        std::function<PlaybackSource*()> getSourceFn, std::function<void()> fileCompleteFn);
     virtual ~PlaybackStep();
     
     virtual int getInputSampleRate() const;
@@ -42,7 +44,7 @@ public:
 private:
     int inputSampleRate_;
     std::function<int()> fileSampleRateFn_;
-    std::function<SNDFILE*()> getSndFileFn_;
+    std::function<PlaybackSource*()> getSourceFn_;
     std::function<void()> fileCompleteFn_;
 };
 
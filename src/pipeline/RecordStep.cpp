@@ -23,10 +23,10 @@
 #include "RecordStep.h"
 
 RecordStep::RecordStep(
-    int inputSampleRate, std::function<SNDFILE*()> getSndFileFn, 
+    int inputSampleRate, std::function<RecordingWriter*()> getWriterFn, 
     std::function<void(int)> isFileCompleteFn)
 : inputSampleRate_(inputSampleRate)
-, getSndFileFn_(getSndFileFn)
+, getWriterFn_(getWriterFn)
 , isFileCompleteFn_(isFileCompleteFn)
 {
     // empty
@@ -49,8 +49,8 @@ int RecordStep::getOutputSampleRate() const
 
 std::shared_ptr<short> RecordStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
 {
-    auto recordFile = getSndFileFn_();
-    sf_write_short(recordFile, inputSamples.get(), numInputSamples);
+    auto writer = getWriterFn_();
+    writer->write(inputSamples.get(), numInputSamples);
     
     isFileCompleteFn_(numInputSamples);
     
@@ -25,13 +25,15 @@
 
 #include "IPipelineStep.h"
 #include <functional>
-#include <sndfile.h>
+#include "RecordingWriter.h"
 
+// Queues its input to a RecordingWriter, which does the actual file I/O
+// on its own thread.
 class RecordStep : public IPipelineStep
 {
 public:
     RecordStep(
-        int inputSampleRate, std::function<SNDFILE*()> getSndFileFn, std::function<void(int)> isFileCompleteFn);
+        int inputSampleRate, std::function<RecordingWriter*()> getWriterFn, std::function<void(int)> isFileCompleteFn);
     virtual ~RecordStep();
     
     virtual int getInputSampleRate() const;
@@ -40,8 +42,7 @@ public:
     
 private:
     int inputSampleRate_;
-    std::function<int()> fileSampleRateFn_;
-    std::function<SNDFILE*()> getSndFileFn_;
+    std::function<RecordingWriter*()> getWriterFn_;
     std::function<void(int)> isFileCompleteFn_;
 };
 
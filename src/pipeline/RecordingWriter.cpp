@@ -0,0 +1,326 @@
+//=========================================================================
+// Name:            RecordingWriter.cpp
+// Purpose:         Writes recordings to disk on a background thread.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "RecordingWriter.h"
+
+#include <cstdio>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+// How often the writer thread checks for queued audio. Well under the
+// ring size so that it's only ever a fraction full.
+#define RECORDING_WRITER_POLL_MS 250
+
+static size_t GetRingSize_(int sampleRate, int bufferSeconds)
+{
+    size_t size = (size_t)sampleRate * std::max(bufferSeconds, 1);
+    size_t numBlocks = (size + RECORDING_WRITER_BLOCK_SAMPLES - 1) / RECORDING_WRITER_BLOCK_SAMPLES;
+    return std::max(numBlocks, (size_t)4) * RECORDING_WRITER_BLOCK_SAMPLES;
+}
+
+RecordingWriter::RecordingWriter(
+    std::string path, int sampleRate, int format,
+    int rotateSeconds, int64_t rotateBytes, int bufferSeconds)
+    : path_(path)
+    , sampleRate_(sampleRate)
+    , format_(format)
+    , rotateSamples_(0)
+    , isCompressed_(false)
+    , rotateBytes_(rotateBytes)
+    , ring_(GetRingSize_(sampleRate, bufferSeconds))
+    , file_(nullptr)
+    , numSamplesInFile_(0)
+    , isRunning_(false)
+    , hasFailed_(false)
+    , numSamplesWritten_(0)
+    , numSamplesDropped_(0)
+    , numFiles_(0)
+    , encodeTimeUs_(0)
+    , numBytesWritten_(0)
+{
+    int type = format & SF_FORMAT_TYPEMASK;
+    isCompressed_ = type == SF_FORMAT_FLAC || type == SF_FORMAT_OGG;
+
+    if (rotateSeconds > 0)
+    {
+        rotateSamples_ = (uint64_t)rotateSeconds * sampleRate;
+    }
+    if (rotateBytes > 0 && !isCompressed_)
+    {
+        // Ignores the header, which is negligible at any sensible size.
+        uint64_t samples = std::max((uint64_t)rotateBytes / sizeof(short), (uint64_t)RECORDING_WRITER_BLOCK_SAMPLES);
+        rotateSamples_ = rotateSamples_ > 0 ? std::min(rotateSamples_, samples) : samples;
+    }
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    close();
+}
+
+bool RecordingWriter::open()
+{
+    if (!openFile_())
+    {
+        return false;
+    }
+
+    isRunning_ = true;
+    writerThread_ = std::thread(std::bind(&RecordingWriter::threadEntry_, this));
+    return true;
+}
+
+void RecordingWriter::close()
+{
+    if (isRunning_)
+    {
+        {
+            std::unique_lock<std::mutex> lk(threadMutex_);
+            isRunning_ = false;
+        }
+        threadCV_.notify_one();
+        writerThread_.join();
+    }
+
+    if (file_ != nullptr)
+    {
+        drain_(true);
+        closeFile_();
+    }
+}
+
+void RecordingWriter::write(const short* samples, int numSamples)
+{
+    size_t written = 0;
+    if (!hasFailed_.load(std::memory_order_relaxed))
+    {
+        written = ring_.write(samples, numSamples);
+    }
+
+    if (written < (size_t)numSamples)
+    {
+        numSamplesDropped_.fetch_add(numSamples - written, std::memory_order_relaxed);
+    }
+}
+
+bool RecordingWriter::IsFormatSupported(int format, int sampleRate)
+{
+    if ((format & SF_FORMAT_SUBMASK) == RECORDING_WRITER_FORMAT_OPUS &&
+        sampleRate != 8000 && sampleRate != 12000 && sampleRate != 16000 &&
+        sampleRate != 24000 && sampleRate != 48000)
+    {
+        return false;
+    }
+
+    SF_INFO sfInfo;
+    sfInfo.format = format;
+    sfInfo.channels = 1;
+    sfInfo.samplerate = sampleRate;
+    return sf_format_check(&sfInfo) != 0;
+}
+
+std::string RecordingWriter::getError() const
+{
+    std::unique_lock<std::mutex> lk(errorMutex_);
+    return error_;
+}
+
+bool RecordingWriter::openFile_()
+{
+    std::string path = getFilePath_(numFiles_);
+    if (!IsFormatSupported(format_, sampleRate_))
+    {
+        setError_("This format can't be written at " + std::to_string(sampleRate_) + " Hz by this build of libsndfile");
+        fprintf(stderr, "Could not create recording %s: %s\n", path.c_str(), getError().c_str());
+        hasFailed_ = true;
+        return false;
+    }
+
+    SF_INFO sfInfo;
+    sfInfo.format = format_;
+    sfInfo.channels = 1;
+    sfInfo.samplerate = sampleRate_;
+
+    auto startTime = std::chrono::steady_clock::now();
+    file_ = sf_open(path.c_str(), SFM_WRITE, &sfInfo);
+    addEncodeTime_(startTime);
+    if (file_ == nullptr)
+    {
+        setError_(sf_strerror(nullptr));
+        fprintf(stderr, "Could not create recording %s: %s\n", path.c_str(), getError().c_str());
+        hasFailed_ = true;
+        return false;
+    }
+
+    filePath_ = path;
+    numSamplesInFile_ = 0;
+    numFiles_++;
+    return true;
+}
+
+void RecordingWriter::closeFile_()
+{
+    if (file_ != nullptr)
+    {
+        // Compressed formats may still have a partial frame to encode.
+        auto startTime = std::chrono::steady_clock::now();
+        sf_close(file_);
+        addEncodeTime_(startTime);
+        file_ = nullptr;
+
+        struct stat fileInfo;
+        if (stat(filePath_.c_str(), &fileInfo) == 0)
+        {
+            numBytesWritten_.fetch_add(fileInfo.st_size, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool RecordingWriter::isFileFull_() const
+{
+    if (rotateSamples_ > 0 && numSamplesInFile_ >= rotateSamples_)
+    {
+        return true;
+    }
+
+    if (isCompressed_ && rotateBytes_ > 0)
+    {
+        // Lags a little behind what's been written as the encoder
+        // buffers, which is close enough.
+        struct stat fileInfo;
+        return stat(filePath_.c_str(), &fileInfo) == 0 && fileInfo.st_size >= rotateBytes_;
+    }
+    return false;
+}
+
+void RecordingWriter::addEncodeTime_(std::chrono::steady_clock::time_point startTime)
+{
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    encodeTimeUs_.fetch_add(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+        std::memory_order_relaxed);
+}
+
+std::string RecordingWriter::getFilePath_(int fileIndex) const
+{
+    if (fileIndex == 0)
+    {
+        return path_;
+    }
+
+    // name.wav -> name-001.wav
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "-%03d", fileIndex);
+
+    size_t dirEnd = path_.find_last_of("/\\");
+    size_t extStart = path_.find_last_of('.');
+    if (extStart == std::string::npos || (dirEnd != std::string::npos && extStart < dirEnd))
+    {
+        return path_ + suffix;
+    }
+    return path_.substr(0, extStart) + suffix + path_.substr(extStart);
+}
+
+void RecordingWriter::setError_(std::string error)
+{
+    std::unique_lock<std::mutex> lk(errorMutex_);
+    error_ = error;
+}
+
+void RecordingWriter::drain_(bool flush)
+{
+    while (!hasFailed_)
+    {
+        const short* ptr;
+        size_t count = std::min(ring_.getReadSpan(&ptr), (size_t)RECORDING_WRITER_BLOCK_SAMPLES);
+
+        // The span is only less than a block at the end of the ring if a
+        // rotation left the read position mid-block.
+        if (count == 0 || (!flush && ring_.numUsed() < RECORDING_WRITER_BLOCK_SAMPLES))
+        {
+            break;
+        }
+
+        if (isFileFull_())
+        {
+            closeFile_();
+            if (!openFile_())
+            {
+                break;
+            }
+        }
+        if (rotateSamples_ > 0)
+        {
+            count = std::min(count, (size_t)(rotateSamples_ - numSamplesInFile_));
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        sf_count_t written = sf_write_short(file_, ptr, count);
+        addEncodeTime_(startTime);
+        ring_.commitRead(count);
+        numSamplesInFile_ += count;
+        numSamplesWritten_.fetch_add(std::max(written, (sf_count_t)0), std::memory_order_relaxed);
+
+        if (written != (sf_count_t)count)
+        {
+            setError_(sf_strerror(file_));
+            fprintf(stderr, "Could not write recording: %s\n", getError().c_str());
+            numSamplesDropped_.fetch_add(count - std::max(written, (sf_count_t)0), std::memory_order_relaxed);
+            hasFailed_ = true;
+        }
+    }
+
+    if (hasFailed_)
+    {
+        // Nowhere to put it.
+        size_t numQueued = ring_.numUsed();
+        ring_.clear();
+        numSamplesDropped_.fetch_add(numQueued, std::memory_order_relaxed);
+    }
+}
+
+void RecordingWriter::threadEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV recorder");
+#endif // defined(__linux__)
+
+    std::unique_lock<std::mutex> lk(threadMutex_);
+    while (isRunning_)
+    {
+        threadCV_.wait_for(lk, std::chrono::milliseconds(RECORDING_WRITER_POLL_MS));
+        if (!isRunning_)
+        {
+            break;
+        }
+
+        lk.unlock();
+        drain_(false);
+        lk.lock();
+    }
+}
@@ -0,0 +1,144 @@
+//=========================================================================
+// Name:            RecordingWriter.h
+// Purpose:         Writes recordings to disk on a background thread.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__RECORDING_WRITER_H
+#define AUDIO_PIPELINE__RECORDING_WRITER_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <chrono>
+#include <sndfile.h>
+
+#include "../util/SpscRingBuffer.h"
+
+// libsndfile's SF_FORMAT_OPUS (use with SF_FORMAT_OGG). Not in the
+// 1.0.28 headers used for static builds, hence our own name for it.
+#define RECORDING_WRITER_FORMAT_OPUS 0x0064
+
+// Samples per write to disk (16 KiB of int16). The ring is a multiple of
+// this, so apart from the end of a file every write is a whole block.
+#define RECORDING_WRITER_BLOCK_SAMPLES 8192
+
+// Mono int16 recording fed from the audio pipeline. write() only copies
+// into a preallocated ring, so it's safe to call from realtime threads;
+// a background thread drains the ring to disk in large blocks. If the
+// disk can't keep up for longer than the ring holds, the excess is
+// dropped and counted rather than stalling the caller.
+//
+// Any format libsndfile can write works, including FLAC and Ogg/Opus;
+// encoding happens on the background thread too.
+//
+// Optionally starts a new file (name-001.wav, name-002.wav, ...) after a
+// given amount of audio or file size, e.g. for unattended recording.
+class RecordingWriter
+{
+public:
+    // format is the libsndfile format (e.g. SF_FORMAT_WAV | SF_FORMAT_PCM_16).
+    // rotateSeconds/rotateBytes of 0 disable that limit.
+    RecordingWriter(
+        std::string path, int sampleRate, int format,
+        int rotateSeconds = 0, int64_t rotateBytes = 0, int bufferSeconds = 10);
+    virtual ~RecordingWriter();
+
+    // Creates the first file and starts the writer thread. Returns false
+    // (see getError()) if the file couldn't be created.
+    bool open();
+
+    // Writes out everything queued so far, then closes the file.
+    void close();
+
+    // Queues samples for writing. Realtime safe; single producer only.
+    void write(const short* samples, int numSamples);
+
+    int getSampleRate() const { return sampleRate_; }
+    int getFormat() const { return format_; }
+    std::string getError() const;
+
+    // Whether this libsndfile can write mono int16 audio in format at
+    // sampleRate (e.g. Opus only does 8/12/16/24/48 kHz, and builds
+    // without external libraries have neither FLAC nor Opus).
+    static bool IsFormatSupported(int format, int sampleRate);
+
+    // Statistics, for display/logging. May be called from any thread.
+    uint64_t getNumSamplesWritten() const { return numSamplesWritten_.load(std::memory_order_relaxed); }
+    uint64_t getNumSamplesDropped() const { return numSamplesDropped_.load(std::memory_order_relaxed); }
+    int getNumFiles() const { return numFiles_.load(std::memory_order_relaxed); }
+
+    // Time the writer thread has spent encoding and writing, for working
+    // out the CPU cost of a format.
+    double getEncodeSeconds() const { return encodeTimeUs_.load(std::memory_order_relaxed) / 1e6; }
+
+    // Size on disk of the files written so far (the current file isn't
+    // counted until it's closed).
+    uint64_t getNumBytesWritten() const { return numBytesWritten_.load(std::memory_order_relaxed); }
+
+private:
+    std::string path_;
+    int sampleRate_;
+    int format_;
+    uint64_t rotateSamples_;
+
+    // Compressed files are rotated on their actual size rather than
+    // rotateSamples_.
+    bool isCompressed_;
+    int64_t rotateBytes_;
+
+    SpscRingBuffer<short> ring_;
+
+    // Only touched by open()/close() and the writer thread.
+    SNDFILE* file_;
+    std::string filePath_;
+    uint64_t numSamplesInFile_;
+
+    std::atomic<bool> isRunning_;
+    std::atomic<bool> hasFailed_;
+    std::mutex threadMutex_;
+    std::condition_variable threadCV_;
+    std::thread writerThread_;
+
+    mutable std::mutex errorMutex_;
+    std::string error_;
+
+    std::atomic<uint64_t> numSamplesWritten_;
+    std::atomic<uint64_t> numSamplesDropped_;
+    std::atomic<int> numFiles_;
+    std::atomic<uint64_t> encodeTimeUs_;
+    std::atomic<uint64_t> numBytesWritten_;
+
+    bool openFile_();
+    void closeFile_();
+    std::string getFilePath_(int fileIndex) const;
+    void setError_(std::string error);
+    bool isFileFull_() const;
+    void addEncodeTime_(std::chrono::steady_clock::time_point startTime);
+
+    // Writes queued samples to disk: whole blocks only unless flushing.
+    void drain_(bool flush);
+
+    void threadEntry_();
+};
+
+#endif // AUDIO_PIPELINE__RECORDING_WRITER_H
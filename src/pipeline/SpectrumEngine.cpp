@@ -0,0 +1,274 @@
+//=========================================================================
+// Name:            SpectrumEngine.cpp
+// Purpose:         Computes the displayed RF spectrum on a background
+//                  thread, independently of the modem.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "SpectrumEngine.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <assert.h>
+
+#include "codec2_fdmdv.h" // for FDMDV_SCALE
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+// Large enough to hold a full maximum size FFT plus one update interval
+// worth of new samples at any sample rate we run at. Must be a power of two.
+#define SPECTRUM_ENGINE_RING_SIZE (4 * SPECTRUM_ENGINE_MAX_FFT_SIZE)
+
+// The old display averaged each 20 ms block into g_avmag with a 0.95
+// IIR filter. Keep the same time constant regardless of update rate.
+#define SPECTRUM_ENGINE_LEGACY_BETA 0.95
+#define SPECTRUM_ENGINE_LEGACY_BLOCK_SEC 0.02
+
+SpectrumEngine::SpectrumEngine(int sampleRate, int fftSize, int updateIntervalMs)
+    : sampleRate_(sampleRate)
+    , updateIntervalMs_(updateIntervalMs)
+    , fftSize_(SPECTRUM_ENGINE_DEFAULT_FFT_SIZE)
+    , ring_(SPECTRUM_ENGINE_RING_SIZE, 0.0f)
+    , numSamplesWritten_(0)
+    , numSamplesAnalyzed_(0)
+    , currentFftSize_(0)
+    , fftCfg_(nullptr)
+    , avMagValid_(false)
+    , hasNewOutput_(false)
+    , isRunning_(false)
+{
+    assert(updateIntervalMs_ > 0);
+
+    beta_ = powf(
+        SPECTRUM_ENGINE_LEGACY_BETA,
+        (updateIntervalMs_ / 1000.0) / SPECTRUM_ENGINE_LEGACY_BLOCK_SEC);
+
+    setFftSize(fftSize);
+}
+
+SpectrumEngine::~SpectrumEngine()
+{
+    stop();
+
+    if (fftCfg_ != nullptr)
+    {
+        free(fftCfg_);
+    }
+}
+
+void SpectrumEngine::start()
+{
+    if (!isRunning_)
+    {
+        isRunning_ = true;
+        updateThread_ = std::thread(std::bind(&SpectrumEngine::threadEntry_, this));
+    }
+}
+
+void SpectrumEngine::stop()
+{
+    if (isRunning_)
+    {
+        {
+            std::unique_lock<std::mutex> lk(threadMutex_);
+            isRunning_ = false;
+        }
+        threadCV_.notify_one();
+        updateThread_.join();
+    }
+}
+
+void SpectrumEngine::addSamples(const short* samples, int numSamples)
+{
+    std::unique_lock<std::mutex> lk(ringMutex_);
+
+    const uint64_t mask = SPECTRUM_ENGINE_RING_SIZE - 1;
+    for (int index = 0; index < numSamples; index++)
+    {
+        ring_[(numSamplesWritten_ + index) & mask] = samples[index];
+    }
+    numSamplesWritten_ += numSamples;
+}
+
+void SpectrumEngine::setFftSize(int fftSize)
+{
+    int size = SPECTRUM_ENGINE_MIN_FFT_SIZE;
+    while (size < SPECTRUM_ENGINE_MAX_FFT_SIZE && (size << 1) <= fftSize)
+    {
+        size <<= 1;
+    }
+    fftSize_ = size;
+}
+
+bool SpectrumEngine::getSpectrum(std::vector<float>& magDb)
+{
+    std::unique_lock<std::mutex> lk(outputMutex_);
+    if (!hasNewOutput_)
+    {
+        return false;
+    }
+
+    magDb = outputMagDb_;
+    hasNewOutput_ = false;
+    return true;
+}
+
+void SpectrumEngine::reconfigure_(int fftSize)
+{
+    if (fftCfg_ != nullptr)
+    {
+        free(fftCfg_);
+    }
+    fftCfg_ = kiss_fft_alloc(fftSize, 0, nullptr, nullptr);
+    assert(fftCfg_ != nullptr);
+
+    // Periodic Hann window, same as modem_stats_get_rx_spectrum().
+    window_.resize(fftSize);
+    for (int index = 0; index < fftSize; index++)
+    {
+        window_[index] = 0.5 - 0.5 * cos(index * 2.0 * M_PI / fftSize);
+    }
+
+    fftIn_.resize(fftSize);
+    fftOut_.resize(fftSize);
+    powerSum_.resize(fftSize / 2);
+    avMagDb_.resize(fftSize / 2);
+
+    // The old average is for a different bin layout, start again.
+    avMagValid_ = false;
+    currentFftSize_ = fftSize;
+}
+
+void SpectrumEngine::update()
+{
+    int fftSize = fftSize_.load();
+    if (fftSize != currentFftSize_)
+    {
+        reconfigure_(fftSize);
+    }
+
+    int hopSize = fftSize / 4;
+    int numFrames = 0;
+    {
+        std::unique_lock<std::mutex> lk(ringMutex_);
+
+        uint64_t numNewSamples = numSamplesWritten_ - numSamplesAnalyzed_;
+        if (numSamplesWritten_ < (uint64_t)fftSize || numNewSamples == 0)
+        {
+            // Not enough input yet (or no new input, e.g. while stopped).
+            return;
+        }
+
+        // Enough frames to cover everything that arrived since the last
+        // update, ending at the newest sample.
+        uint64_t maxSpan = std::min((uint64_t)SPECTRUM_ENGINE_RING_SIZE, numSamplesWritten_);
+        numFrames = (numNewSamples + hopSize - 1) / hopSize;
+        numFrames = std::min(numFrames, (int)((maxSpan - fftSize) / hopSize) + 1);
+        numFrames = std::max(numFrames, 1);
+
+        int span = (numFrames - 1) * hopSize + fftSize;
+        frame_.resize(span);
+
+        const uint64_t mask = SPECTRUM_ENGINE_RING_SIZE - 1;
+        uint64_t start = numSamplesWritten_ - span;
+        for (int index = 0; index < span; index++)
+        {
+            frame_[index] = ring_[(start + index) & mask];
+        }
+
+        numSamplesAnalyzed_ = numSamplesWritten_;
+    }
+
+    int numBins = fftSize / 2;
+    std::fill(powerSum_.begin(), powerSum_.end(), 0.0f);
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        const float* in = &frame_[frame * hopSize];
+        for (int index = 0; index < fftSize; index++)
+        {
+            fftIn_[index].r = in[index] * window_[index];
+            fftIn_[index].i = 0;
+        }
+
+        kiss_fft(fftCfg_, &fftIn_[0], &fftOut_[0]);
+
+        for (int index = 0; index < numBins; index++)
+        {
+            powerSum_[index] += fftOut_[index].r * fftOut_[index].r + fftOut_[index].i * fftOut_[index].i;
+        }
+    }
+
+    // Same scaling as modem_stats_get_rx_spectrum() so existing dB ranges
+    // and waterfall contrast still apply, independent of FFT size.
+    float fullScaleDb = 20 * log10f(numBins * FDMDV_SCALE);
+    for (int index = 0; index < numBins; index++)
+    {
+        float magDb = 10.0f * log10f(powerSum_[index] / numFrames + 1E-12) - fullScaleDb;
+        if (avMagValid_)
+        {
+            avMagDb_[index] = beta_ * avMagDb_[index] + (1.0f - beta_) * magDb;
+        }
+        else
+        {
+            avMagDb_[index] = magDb;
+        }
+    }
+    avMagValid_ = true;
+
+    std::unique_lock<std::mutex> lk(outputMutex_);
+    outputMagDb_ = avMagDb_;
+    hasNewOutput_ = true;
+
+    if (listenerFn_)
+    {
+        listenerFn_(&avMagDb_[0], numBins);
+    }
+}
+
+void SpectrumEngine::setSpectrumListener(std::function<void(const float*, int)> fn)
+{
+    std::unique_lock<std::mutex> lk(outputMutex_);
+    listenerFn_ = fn;
+}
+
+void SpectrumEngine::threadEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV spectrum");
+#endif // defined(__linux__)
+
+    std::unique_lock<std::mutex> lk(threadMutex_);
+    while (isRunning_)
+    {
+        threadCV_.wait_for(lk, std::chrono::milliseconds(updateIntervalMs_));
+        if (!isRunning_)
+        {
+            break;
+        }
+
+        lk.unlock();
+        update();
+        lk.lock();
+    }
+}
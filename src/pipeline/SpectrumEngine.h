@@ -0,0 +1,122 @@
+//=========================================================================
+// Name:            SpectrumEngine.h
+// Purpose:         Computes the displayed RF spectrum on a background
+//                  thread, independently of the modem.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__SPECTRUM_ENGINE_H
+#define AUDIO_PIPELINE__SPECTRUM_ENGINE_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+
+#include "kiss_fft.h"
+
+// The sizes offered in the UI; anything else is rounded into this range.
+#define SPECTRUM_ENGINE_MIN_FFT_SIZE 512
+#define SPECTRUM_ENGINE_MAX_FFT_SIZE 8192
+#define SPECTRUM_ENGINE_DEFAULT_FFT_SIZE 1024
+
+// Collects raw RX samples into a ring and, once per update interval,
+// computes a Hann windowed magnitude spectrum (dB) over the samples that
+// arrived since the last update. Consecutive FFT frames overlap by 75%
+// and are power averaged (Welch), then the result is smoothed over time
+// the same way the old per-block g_avmag IIR filter did.
+//
+// Output bin i covers i * sampleRate / fftSize Hz, so there are always
+// fftSize / 2 bins spanning 0 ... sampleRate / 2.
+class SpectrumEngine
+{
+public:
+    SpectrumEngine(int sampleRate, int fftSize = SPECTRUM_ENGINE_DEFAULT_FFT_SIZE, int updateIntervalMs = 100);
+    virtual ~SpectrumEngine();
+
+    // Starts/stops the background update thread. Without it, update()
+    // must be called explicitly.
+    void start();
+    void stop();
+
+    // Producer side. Not realtime safe (takes a lock), so should be fed from
+    // an AsyncTapStep rather than directly from the audio thread.
+    void addSamples(const short* samples, int numSamples);
+
+    // Rounded down to a power of two and clamped to the supported range.
+    // Takes effect on the next update.
+    void setFftSize(int fftSize);
+    int getFftSize() const { return fftSize_.load(); }
+
+    int getSampleRate() const { return sampleRate_; }
+
+    // Copies the most recent spectrum into magDb (resizing as needed).
+    // Returns false and leaves magDb untouched if nothing has been computed
+    // since the last call.
+    bool getSpectrum(std::vector<float>& magDb);
+
+    // Computes a new spectrum from the samples currently in the ring.
+    void update();
+
+    // Called on the engine's thread with every new spectrum (same data as
+    // getSpectrum()). Must be quick and must not call back into the engine.
+    void setSpectrumListener(std::function<void(const float*, int)> fn);
+
+private:
+    int sampleRate_;
+    int updateIntervalMs_;
+    std::atomic<int> fftSize_;
+
+    // Raw samples, written by addSamples() and read by update().
+    std::mutex ringMutex_;
+    std::vector<float> ring_;
+    uint64_t numSamplesWritten_;
+    uint64_t numSamplesAnalyzed_;
+
+    // Only touched by update().
+    int currentFftSize_;
+    kiss_fft_cfg fftCfg_;
+    std::vector<float> window_;
+    std::vector<float> frame_;
+    std::vector<kiss_fft_cpx> fftIn_;
+    std::vector<kiss_fft_cpx> fftOut_;
+    std::vector<float> powerSum_;
+    std::vector<float> avMagDb_;
+    bool avMagValid_;
+    float beta_;
+
+    // Most recent result, handed to getSpectrum().
+    std::mutex outputMutex_;
+    std::vector<float> outputMagDb_;
+    bool hasNewOutput_;
+    std::function<void(const float*, int)> listenerFn_;
+
+    std::atomic<bool> isRunning_;
+    std::mutex threadMutex_;
+    std::condition_variable threadCV_;
+    std::thread updateThread_;
+
+    void reconfigure_(int fftSize);
+    void threadEntry_();
+};
+
+#endif // AUDIO_PIPELINE__SPECTRUM_ENGINE_H
@@ -0,0 +1,257 @@
+//=========================================================================
+// Name:            SpectrumExporter.cpp
+// Purpose:         Writes the RX spectrum to disk as waterfall image
+//                  tiles and/or raw data for unattended monitoring.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "SpectrumExporter.h"
+
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+#include <wx/datetime.h>
+#include <wx/filename.h>
+#include <wx/imagpng.h>
+
+#include "../defines.h"
+#include "../util/WaterfallColourMap.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif // defined(__linux__)
+
+// Rows waiting to be written before we start dropping them (i.e. the disk
+// has stalled for this many row intervals).
+#define SPECTRUM_EXPORT_MAX_QUEUED_ROWS 64
+
+SpectrumExporter::SpectrumExporter(const std::string& directory, int formats, int rowIntervalMs, int colour, int sampleRate)
+    : directory_(directory)
+    , formats_(formats)
+    , rowIntervalMs_(rowIntervalMs)
+    , colour_(colour)
+    , sampleRate_(sampleRate)
+    , pendingValid_(false)
+    , isExiting_(false)
+    , rawFile_(nullptr)
+    , rawNumBins_(0)
+    , tileRows_(0)
+    , tileStartMs_(0)
+    , maxMag_(MAX_MAG_DB)
+{
+    // Image handlers are global, so register PNG here on the main thread
+    // rather than from the worker.
+    if ((formats_ & SPECTRUM_EXPORT_PNG) && wxImage::FindHandler(wxBITMAP_TYPE_PNG) == nullptr)
+    {
+        wxImage::AddHandler(new wxPNGHandler);
+    }
+
+    workerThread_ = std::thread(std::bind(&SpectrumExporter::workerEntry_, this));
+}
+
+SpectrumExporter::~SpectrumExporter()
+{
+    {
+        std::unique_lock<std::mutex> lk(queueMutex_);
+        isExiting_ = true;
+    }
+    queueCV_.notify_one();
+    workerThread_.join();
+
+    finishTile_();
+    if (rawFile_ != nullptr)
+    {
+        fclose(rawFile_);
+        rawFile_ = nullptr;
+    }
+}
+
+void SpectrumExporter::addSpectrum(const float* magDb, int numBins)
+{
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    bool rowDone = pendingValid_ &&
+        (now - pendingRow_.timestampMs >= rowIntervalMs_ || (int)pendingRow_.magDb.size() != numBins);
+    if (rowDone)
+    {
+        {
+            std::unique_lock<std::mutex> lk(queueMutex_);
+            if (queue_.size() < SPECTRUM_EXPORT_MAX_QUEUED_ROWS)
+            {
+                queue_.push_back(std::move(pendingRow_));
+            }
+        }
+        queueCV_.notify_one();
+        pendingValid_ = false;
+    }
+
+    if (!pendingValid_)
+    {
+        pendingRow_.timestampMs = now;
+        pendingRow_.magDb.assign(magDb, magDb + numBins);
+        pendingValid_ = true;
+    }
+    else
+    {
+        for (int index = 0; index < numBins; index++)
+        {
+            pendingRow_.magDb[index] = std::max(pendingRow_.magDb[index], magDb[index]);
+        }
+    }
+}
+
+void SpectrumExporter::workerEntry_()
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), "FreeDV export");
+#endif // defined(__linux__)
+
+    std::unique_lock<std::mutex> lk(queueMutex_);
+    for (;;)
+    {
+        queueCV_.wait(lk, [&]() { return isExiting_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+            // Only get here when exiting.
+            break;
+        }
+
+        Row row = std::move(queue_.front());
+        queue_.pop_front();
+
+        // Do the actual (potentially slow) writing without holding the lock.
+        lk.unlock();
+        if (formats_ & SPECTRUM_EXPORT_RAW)
+        {
+            writeRaw_(row);
+        }
+        if (formats_ & SPECTRUM_EXPORT_PNG)
+        {
+            writePng_(row);
+        }
+        lk.lock();
+    }
+}
+
+void SpectrumExporter::writeRaw_(const Row& row)
+{
+    int numBins = row.magDb.size();
+    if (rawFile_ != nullptr && rawNumBins_ != numBins)
+    {
+        fclose(rawFile_);
+        rawFile_ = nullptr;
+    }
+
+    if (rawFile_ == nullptr)
+    {
+        std::string path = fileName_("spectrum", row.timestampMs, "bin");
+        rawFile_ = fopen(path.c_str(), "wb");
+        if (rawFile_ == nullptr)
+        {
+            fprintf(stderr, "SpectrumExporter: could not create %s\n", path.c_str());
+            formats_ &= ~SPECTRUM_EXPORT_RAW;
+            return;
+        }
+
+        uint32_t headerBins = numBins;
+        float headerMaxFreqHz = sampleRate_ / 2;
+        fwrite("FDVSPEC1", 1, 8, rawFile_);
+        fwrite(&headerBins, sizeof(headerBins), 1, rawFile_);
+        fwrite(&headerMaxFreqHz, sizeof(headerMaxFreqHz), 1, rawFile_);
+        rawNumBins_ = numBins;
+    }
+
+    fwrite(&row.timestampMs, sizeof(row.timestampMs), 1, rawFile_);
+    fwrite(&row.magDb[0], sizeof(float), numBins, rawFile_);
+    fflush(rawFile_);
+}
+
+void SpectrumExporter::writePng_(const Row& row)
+{
+    int numBins = row.magDb.size();
+    if (tileRows_ > 0 && tile_.GetWidth() != numBins)
+    {
+        finishTile_();
+    }
+
+    if (tileRows_ == 0)
+    {
+        if (!tile_.IsOk() || tile_.GetWidth() != numBins)
+        {
+            tile_.Create(numBins, SPECTRUM_EXPORT_TILE_ROWS, true);
+        }
+        tileStartMs_ = row.timestampMs;
+    }
+
+    // Same automatic contrast as PlotWaterfall::plotPixelData().
+    float binsPerHz = (float)numBins / (sampleRate_ / 2);
+    int minBin = std::min(numBins, (int)(200 * binsPerHz));
+    int maxBin = std::min(numBins, (int)(2800 * binsPerHz));
+    float rowMax = MIN_MAG_DB;
+    for (int index = minBin; index < maxBin; index++)
+    {
+        rowMax = std::max(rowMax, row.magDb[index]);
+    }
+    maxMag_ = BETA * maxMag_ + (1 - BETA) * rowMax;
+    float minMag = maxMag_ - 20.0;
+    float intensityPerDb = (float)256 / (maxMag_ - minMag);
+
+    const unsigned char (*lut)[3] = WaterfallColourMap(colour_);
+    unsigned char* out = tile_.GetData() + 3 * numBins * tileRows_;
+    for (int index = 0; index < numBins; index++)
+    {
+        float val = intensityPerDb * (row.magDb[index] - minMag);
+        val = std::min(std::max(val, 0.0f), 255.0f);
+        memcpy(out + 3 * index, lut[(int)val], 3);
+    }
+
+    if (++tileRows_ == SPECTRUM_EXPORT_TILE_ROWS)
+    {
+        finishTile_();
+    }
+}
+
+void SpectrumExporter::finishTile_()
+{
+    if (tileRows_ == 0)
+    {
+        return;
+    }
+
+    std::string path = fileName_("waterfall", tileStartMs_, "png");
+    wxImage image = tileRows_ < tile_.GetHeight() ?
+        tile_.GetSubImage(wxRect(0, 0, tile_.GetWidth(), tileRows_)) : tile_;
+    if (!image.SaveFile(wxString::FromUTF8(path.c_str()), wxBITMAP_TYPE_PNG))
+    {
+        fprintf(stderr, "SpectrumExporter: could not write %s\n", path.c_str());
+    }
+
+    tileRows_ = 0;
+}
+
+std::string SpectrumExporter::fileName_(const char* prefix, int64_t timestampMs, const char* extension)
+{
+    wxDateTime time((time_t)(timestampMs / 1000));
+    wxString name = wxString::Format(
+        "%s-%s.%s", prefix, time.Format("%Y%m%d-%H%M%S", wxDateTime::UTC), extension);
+    return (const char*)wxFileName(wxString::FromUTF8(directory_.c_str()), name).GetFullPath().ToUTF8();
+}
@@ -0,0 +1,106 @@
+//=========================================================================
+// Name:            SpectrumExporter.h
+// Purpose:         Writes the RX spectrum to disk as waterfall image
+//                  tiles and/or raw data for unattended monitoring.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__SPECTRUM_EXPORTER_H
+#define AUDIO_PIPELINE__SPECTRUM_EXPORTER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+
+#include <wx/image.h>
+
+#define SPECTRUM_EXPORT_PNG 0x1
+#define SPECTRUM_EXPORT_RAW 0x2
+
+// Number of rows in each exported PNG tile.
+#define SPECTRUM_EXPORT_TILE_ROWS 600
+
+// Receives spectra from SpectrumEngine (see setSpectrumListener()),
+// peak-holds them into one row every rowIntervalMs and writes each row out
+// exactly once on a background thread:
+//
+// * PNG: rows are coloured with the waterfall colour maps and collected
+//   into tiles of SPECTRUM_EXPORT_TILE_ROWS rows (oldest at the top). Each
+//   tile is encoded once when full (or on shutdown), named after the time
+//   of its first row: waterfall-YYYYMMDD-HHMMSS.png.
+//
+// * Raw: spectrum-YYYYMMDD-HHMMSS.bin, a 16 byte header ("FDVSPEC1",
+//   uint32 number of bins, float32 Hz covered by the bins) followed by one
+//   record per row: int64 UTC milliseconds then float32 dB per bin, all
+//   native byte order. Records are appended and flushed as they arrive.
+//
+// A new tile/file is started whenever the number of bins changes.
+class SpectrumExporter
+{
+public:
+    SpectrumExporter(const std::string& directory, int formats, int rowIntervalMs, int colour, int sampleRate);
+    virtual ~SpectrumExporter();
+
+    // Called from the SpectrumEngine thread; numBins span 0 ... sampleRate/2.
+    void addSpectrum(const float* magDb, int numBins);
+
+private:
+    struct Row
+    {
+        int64_t timestampMs;
+        std::vector<float> magDb;
+    };
+
+    std::string directory_;
+    int formats_;
+    int rowIntervalMs_;
+    int colour_;
+    int sampleRate_;
+
+    // Peak hold for the row currently being collected (engine thread only).
+    Row pendingRow_;
+    bool pendingValid_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCV_;
+    std::deque<Row> queue_;
+    bool isExiting_;
+    std::thread workerThread_;
+
+    // Only touched by the worker thread.
+    FILE* rawFile_;
+    int rawNumBins_;
+    wxImage tile_;
+    int tileRows_;
+    int64_t tileStartMs_;
+    float maxMag_;
+
+    void workerEntry_();
+    void writeRaw_(const Row& row);
+    void writePng_(const Row& row);
+    void finishTile_();
+    std::string fileName_(const char* prefix, int64_t timestampMs, const char* extension);
+};
+
+#endif // AUDIO_PIPELINE__SPECTRUM_EXPORTER_H
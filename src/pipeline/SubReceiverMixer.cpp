@@ -0,0 +1,57 @@
+//=========================================================================
+// Name:            SubReceiverMixer.cpp
+// Purpose:         Mixes the sub receiver's decoded audio into the main
+//                  receiver's.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "SubReceiverMixer.h"
+
+#include <algorithm>
+
+SubReceiverMixer::SubReceiverMixer(int maxPending)
+    : maxPending_(maxPending)
+{
+    pending_.reserve(maxPending_ * 2);
+}
+
+const short* SubReceiverMixer::mix(const short* output, int nout, const short* subOutput, int nsub)
+{
+    pending_.insert(pending_.end(), subOutput, subOutput + nsub);
+    if ((int)pending_.size() > maxPending_)
+    {
+        pending_.erase(pending_.begin(), pending_.end() - maxPending_);
+    }
+    
+    if (nout == 0)
+    {
+        return output;
+    }
+
+    int nmix = std::min(nout, (int)pending_.size());
+    mixed_.assign(output, output + nout);
+    for (int index = 0; index < nmix; index++)
+    {
+        int sample = mixed_[index] + pending_[index];
+        mixed_[index] = std::min(std::max(sample, -32768), 32767);
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + nmix);
+    
+    return &mixed_[0];
+}
@@ -0,0 +1,55 @@
+//=========================================================================
+// Name:            SubReceiverMixer.h
+// Purpose:         Mixes the sub receiver's decoded audio into the main
+//                  receiver's.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__SUB_RECEIVER_MIXER_H
+#define AUDIO_PIPELINE__SUB_RECEIVER_MIXER_H
+
+#include <vector>
+
+// The two demodulators don't produce audio in lockstep (e.g. one may be
+// in sync and the other not), so the sub receiver's audio waits here
+// until there's main receiver audio to mix it into. Only maxPending
+// samples are kept, so a sub receiver that gets ahead doesn't add delay.
+class SubReceiverMixer
+{
+public:
+    SubReceiverMixer(int maxPending);
+    virtual ~SubReceiverMixer() = default;
+
+    // Returns nout samples of output with as much of the pending sub
+    // receiver audio (including subOutput) as there is added, clipped to
+    // 16 bits. output itself isn't changed, as the main pipeline's taps
+    // may still be using it; the result is valid until the next call.
+    const short* mix(const short* output, int nout, const short* subOutput, int nsub);
+
+    void clear() { pending_.clear(); }
+
+    int getNumPending() const { return (int)pending_.size(); }
+
+private:
+    int maxPending_;
+    std::vector<short> pending_;
+    std::vector<short> mixed_;
+};
+
+#endif // AUDIO_PIPELINE__SUB_RECEIVER_MIXER_H
@@ -34,6 +34,7 @@
 #include "ResamplePlotStep.h"
 #include "ResampleStep.h"
 #include "TapStep.h"
+#include "AsyncTapStep.h"
 #include "LevelAdjustStep.h"
 #include "FreeDVTransmitStep.h"
 #include "RecordStep.h"
@@ -43,8 +44,13 @@
 #include "ExclusiveAccessStep.h"
 #include "MuteStep.h"
 #include "LinkStep.h"
+#include "VoiceKeyerCaptureStep.h"
+#include "VoiceKeyerReplayStep.h"
+#include "FlightRecorderStep.h"
+#include "CodecFrameLogStep.h"
 
 #include <wx/stopwatch.h>
+#include <algorithm>
 
 // External globals
 // TBD -- work on fully removing the need for these.
@@ -58,7 +64,6 @@ extern int g_verbose;
 extern bool endingTx;
 extern bool g_playFileToMicIn;
 extern int g_sfTxFs;
-extern bool g_loopPlayFileToMicIn;
 extern float g_TxFreqOffsetHz;
 extern struct FIFO* g_plotSpeechInFifo;
 extern struct FIFO* g_plotDemodInFifo;
@@ -73,21 +78,28 @@ extern bool g_recFileFromRadio;
 extern unsigned int g_recFromRadioSamples;
 extern bool g_playFileFromRadio;
 extern int g_sfFs;
-extern bool g_loopPlayFileFromRadio;
 extern int g_SquelchActive;
 extern float g_SquelchLevel;
 extern float g_tone_phase;
-extern float g_avmag[MODEM_STATS_NSPEC];
+extern SpectrumEngine* g_spectrumEngine;
+extern SpectrumEngine* g_spectrumEngineSub;
+extern int g_StateSub;
+extern float g_sig_pwr_avSub;
 extern int g_State;
 extern int g_channel_noise;
 extern float g_RxFreqOffsetHz;
 extern float g_sig_pwr_av;
 extern bool g_voice_keyer_tx;
+extern float g_rxDriftPpm;
+extern float g_txDriftPpm;
+extern float g_rxLatencyMs;
+extern float g_txLatencyMs;
 
 #include <speex/speex_preprocess.h>
 
 #include "../freedv_interface.h"
 extern FreeDVInterface freedvInterface;
+extern FreeDVInterface freedvInterfaceSub;
 
 #include <wx/wx.h>
 #include "../main.h"
@@ -96,11 +108,14 @@ extern wxMutex g_mutexProtectingCallbackData;
 extern wxWindow* g_parent;
 
 #include <sndfile.h>
-extern SNDFILE* g_sfPlayFile;
-extern SNDFILE* g_sfRecFileFromModulator;
-extern SNDFILE* g_sfRecFile;
-extern SNDFILE* g_sfRecMicFile;
-extern SNDFILE* g_sfPlayFileFromRadio;
+extern PlaybackSource* g_playSource;
+extern RecordingWriter* g_recWriterFromModulator;
+extern RecordingWriter* g_recWriter;
+extern RecordingWriter* g_recMicWriter;
+extern PlaybackSource* g_playSourceFromRadio;
+extern VoiceKeyerCache g_voiceKeyerCache;
+extern FlightRecorder* g_flightRecorder;
+extern CodecFrameLogger* g_codecFrameLogger;
 
 extern bool g_recFileFromMic;
 extern bool g_recVoiceKeyerFile;
@@ -134,7 +149,7 @@ void TxRxThread::initializePipeline_()
         // Record from mic step (optional)
         auto recordMicStep = new RecordStep(
             inputSampleRate_, 
-            []() { return g_sfRecMicFile; }, 
+            []() { return g_recMicWriter; }, 
             [](int numSamples) {
                 // Recording stops when the user explicitly tells us to,
                 // no action required here.
@@ -147,37 +162,39 @@ void TxRxThread::initializePipeline_()
         auto bypassRecordMic = new AudioPipeline(inputSampleRate_, inputSampleRate_);
         
         auto eitherOrRecordMic = new EitherOrStep(
-            []() { return (g_recVoiceKeyerFile || g_recFileFromMic) && (g_sfRecMicFile != NULL); },
+            []() { return (g_recVoiceKeyerFile || g_recFileFromMic) && (g_recMicWriter != NULL); },
             std::shared_ptr<IPipelineStep>(recordMicTap),
             std::shared_ptr<IPipelineStep>(bypassRecordMic)
         );
         auto recordMicLockStep = new ExclusiveAccessStep(eitherOrRecordMic, callbackLockFn, callbackUnlockFn);
         pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(recordMicLockStep));
         
+        // Everything from here to the modulator is skipped while the voice
+        // keyer replays a cached transmission (see VoiceKeyerCache).
+        auto txLivePipeline = new AudioPipeline(inputSampleRate_, outputSampleRate_);
+        
         // Mic In playback step (optional)
         auto eitherOrBypassPlay = new AudioPipeline(inputSampleRate_, inputSampleRate_);
         auto eitherOrPlayMicIn = new AudioPipeline(inputSampleRate_, inputSampleRate_);
         auto playMicIn = new PlaybackStep(
             inputSampleRate_, 
             []() { return g_sfTxFs; },
-            []() { return g_sfPlayFile; },
+            []() { return g_playSource; },
             []() {
-                if (g_loopPlayFileToMicIn)
-                    sf_seek(g_sfPlayFile, 0, SEEK_SET);
-                else {
-                    printf("playFileFromRadio finished, issuing event!\n");
-                    g_parent->CallAfter(&MainFrame::StopPlayFileToMicIn);
-                }
+                // Looping is handled by the source.
+                printf("playFileFromRadio finished, issuing event!\n");
+                g_voiceKeyerCache.markComplete();
+                g_parent->CallAfter(&MainFrame::StopPlayFileToMicIn);
             }
             );
         eitherOrPlayMicIn->appendPipelineStep(std::shared_ptr<IPipelineStep>(playMicIn));
         
         auto eitherOrPlayStep = new EitherOrStep(
-            []() { return g_playFileToMicIn && (g_sfPlayFile != NULL); },
+            []() { return g_playFileToMicIn && (g_playSource != NULL); },
             std::shared_ptr<IPipelineStep>(eitherOrPlayMicIn),
             std::shared_ptr<IPipelineStep>(eitherOrBypassPlay));
         auto playMicLockStep = new ExclusiveAccessStep(eitherOrPlayStep, callbackLockFn, callbackUnlockFn);
-        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(playMicLockStep));
+        txLivePipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(playMicLockStep));
         
         // Speex step (optional)
         auto eitherOrProcessSpeex = new AudioPipeline(inputSampleRate_, inputSampleRate_);
@@ -191,7 +208,7 @@ void TxRxThread::initializePipeline_()
             std::shared_ptr<IPipelineStep>(eitherOrProcessSpeex),
             std::shared_ptr<IPipelineStep>(eitherOrBypassSpeex));
         auto speexLockStep = new ExclusiveAccessStep(eitherOrSpeexStep, callbackLockFn, callbackUnlockFn);
-        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(speexLockStep));
+        txLivePipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(speexLockStep));
         
         // Equalizer step (optional based on filter state)
         auto equalizerStep = new EqualizerStep(
@@ -202,7 +219,7 @@ void TxRxThread::initializePipeline_()
             &g_rxUserdata->sbqMicInTreble,
             &g_rxUserdata->sbqMicInVol);
         auto equalizerLockStep = new ExclusiveAccessStep(equalizerStep, callbackLockFn, callbackUnlockFn);
-        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(equalizerLockStep));
+        txLivePipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(equalizerLockStep));
         
         // Take TX audio post-equalizer and send it to RX for possible monitoring use.
         if (equalizedMicAudioLink_ != nullptr)
@@ -211,7 +228,7 @@ void TxRxThread::initializePipeline_()
             micAudioPipeline->appendPipelineStep(equalizedMicAudioLink_->getInputPipelineStep());
         
             auto micAudioTap = std::make_shared<TapStep>(inputSampleRate_, micAudioPipeline);
-            pipeline_->appendPipelineStep(micAudioTap);
+            txLivePipeline->appendPipelineStep(micAudioTap);
         }
                 
         // Resample for plot step
@@ -219,8 +236,8 @@ void TxRxThread::initializePipeline_()
         auto resampleForPlotPipeline = new AudioPipeline(inputSampleRate_, resampleForPlotStep->getOutputSampleRate());
         resampleForPlotPipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotStep));
 
-        auto resampleForPlotTap = new TapStep(inputSampleRate_, resampleForPlotPipeline);
-        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotTap));
+        auto resampleForPlotTap = new AsyncTapStep(inputSampleRate_, resampleForPlotPipeline);
+        txLivePipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotTap));
         
         // FreeDV TX step (analog leg)
         auto doubleLevelStep = new LevelAdjustStep(inputSampleRate_, []() { return 2.0; });
@@ -235,12 +252,38 @@ void TxRxThread::initializePipeline_()
             []() { return g_analog; },
             std::shared_ptr<IPipelineStep>(analogTxPipeline),
             std::shared_ptr<IPipelineStep>(digitalTxPipeline));
-        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(eitherOrDigitalAnalog));
+        txLivePipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(eitherOrDigitalAnalog));
+        
+        // Keep the modulator output while the voice keyer cache is capturing.
+        auto vkCaptureStep = new VoiceKeyerCaptureStep(outputSampleRate_, &g_voiceKeyerCache);
+        auto vkCaptureLockStep = new ExclusiveAccessStep(vkCaptureStep, callbackLockFn, callbackUnlockFn);
+        txLivePipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(vkCaptureLockStep));
+        
+        // Voice keyer replay (optional)
+        auto vkReplayStep = new VoiceKeyerReplayStep(
+            inputSampleRate_, outputSampleRate_, &g_voiceKeyerCache,
+            []() {
+                g_parent->CallAfter(&MainFrame::StopPlayFileToMicIn);
+            });
+        auto vkReplayLockStep = new ExclusiveAccessStep(vkReplayStep, callbackLockFn, callbackUnlockFn);
+        auto vkReplayPipeline = new AudioPipeline(inputSampleRate_, outputSampleRate_);
+        vkReplayPipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(vkReplayLockStep));
+        
+        auto eitherOrReplayStep = new EitherOrStep(
+            []() {
+                g_mutexProtectingCallbackData.Lock();
+                auto result = g_playFileToMicIn && g_voiceKeyerCache.isReplaying();
+                g_mutexProtectingCallbackData.Unlock();
+                return result;
+            },
+            std::shared_ptr<IPipelineStep>(vkReplayPipeline),
+            std::shared_ptr<IPipelineStep>(txLivePipeline));
+        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(eitherOrReplayStep));
         
         // Record modulated output (optional)
         auto recordModulatedStep = new RecordStep(
             outputSampleRate_, 
-            []() { return g_sfRecFileFromModulator; }, 
+            []() { return g_recWriterFromModulator; }, 
             [](int numSamples) {
                 // empty
             });
@@ -254,7 +297,7 @@ void TxRxThread::initializePipeline_()
         auto bypassRecordModulated = new AudioPipeline(outputSampleRate_, outputSampleRate_);
         
         auto eitherOrRecordModulated = new EitherOrStep(
-            []() { return g_recFileFromModulator && (g_sfRecFileFromModulator != NULL); },
+            []() { return g_recFileFromModulator && (g_recWriterFromModulator != NULL); },
             std::shared_ptr<IPipelineStep>(recordModulatedTapPipeline),
             std::shared_ptr<IPipelineStep>(bypassRecordModulated));
         auto recordModulatedLockStep = new ExclusiveAccessStep(eitherOrRecordModulated, callbackLockFn, callbackUnlockFn);
@@ -272,10 +315,26 @@ void TxRxThread::initializePipeline_()
     {
         pipeline_ = std::shared_ptr<AudioPipeline>(new AudioPipeline(inputSampleRate_, outputSampleRate_));
         
+        // Flight recorder step (always on unless disabled in Options). The
+        // recorder is only replaced while this thread isn't running.
+        auto flightRecorderStep = new FlightRecorderStep(
+            inputSampleRate_,
+            []() { return g_flightRecorder; });
+        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(flightRecorderStep));
+        
+        // Codec frame log step (optional). Only queues the audio; the
+        // logger demodulates on its own thread, and only while the
+        // receiver below is in sync (as of the previous block).
+        auto codecFrameLogStep = new CodecFrameLogStep(
+            inputSampleRate_,
+            []() { return g_codecFrameLogger; },
+            []() { return g_State ? freedvInterface.getCurrentMode() : CodecFrameLogger::NO_SYNC; });
+        pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(codecFrameLogStep));
+        
         // Record from radio step (optional)
         auto recordRadioStep = new RecordStep(
             inputSampleRate_, 
-            []() { return g_sfRecFile; }, 
+            []() { return g_recWriter; }, 
             [](int numSamples) {
                 g_recFromRadioSamples -= numSamples;
                 if (g_recFromRadioSamples <= 0)
@@ -292,7 +351,7 @@ void TxRxThread::initializePipeline_()
         auto bypassRecordRadio = new AudioPipeline(inputSampleRate_, inputSampleRate_);
         
         auto eitherOrRecordRadio = new EitherOrStep(
-            []() { return g_recFileFromRadio && (g_sfRecFile != NULL); },
+            []() { return g_recFileFromRadio && (g_recWriter != NULL); },
             std::shared_ptr<IPipelineStep>(recordRadioTap),
             std::shared_ptr<IPipelineStep>(bypassRecordRadio)
         );
@@ -305,14 +364,11 @@ void TxRxThread::initializePipeline_()
         auto playRadio = new PlaybackStep(
             inputSampleRate_, 
             []() { return g_sfFs; },
-            []() { return g_sfPlayFileFromRadio; },
+            []() { return g_playSourceFromRadio; },
             []() {
-                if (g_loopPlayFileFromRadio)
-                    sf_seek(g_sfPlayFileFromRadio, 0, SEEK_SET);
-                else {
-                    printf("playFileFromRadio finished, issuing event!\n");
-                    g_parent->CallAfter(&MainFrame::StopPlaybackFileFromRadio);
-                }
+                // Looping is handled by the source.
+                printf("playFileFromRadio finished, issuing event!\n");
+                g_parent->CallAfter(&MainFrame::StopPlaybackFileFromRadio);
             }
         );
         eitherOrPlayRadio->appendPipelineStep(std::shared_ptr<IPipelineStep>(playRadio));
@@ -320,7 +376,7 @@ void TxRxThread::initializePipeline_()
         auto eitherOrPlayRadioStep = new EitherOrStep(
             []() { 
                 g_mutexProtectingCallbackData.Lock();
-                auto result = g_playFileFromRadio && (g_sfPlayFileFromRadio != NULL);
+                auto result = g_playFileFromRadio && (g_playSourceFromRadio != NULL);
                 g_mutexProtectingCallbackData.Unlock();
                 return result;
             },
@@ -334,7 +390,7 @@ void TxRxThread::initializePipeline_()
         auto resampleForPlotPipeline = new AudioPipeline(inputSampleRate_, resampleForPlotStep->getOutputSampleRate());
         resampleForPlotPipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotStep));
 
-        auto resampleForPlotTap = new TapStep(inputSampleRate_, resampleForPlotPipeline);
+        auto resampleForPlotTap = new AsyncTapStep(inputSampleRate_, resampleForPlotPipeline);
         pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotTap));
         
         // Tone interferer step (optional)
@@ -354,14 +410,13 @@ void TxRxThread::initializePipeline_()
         
         // RF spectrum computation step
         auto computeRfSpectrumStep = new ComputeRfSpectrumStep(
-            []() { return freedvInterface.getCurrentRxModemStats(); },
-            []() { return &g_avmag[0]; }
+            []() { return g_spectrumEngine; }
         );
         auto computeRfSpectrumPipeline = new AudioPipeline(
             inputSampleRate_, computeRfSpectrumStep->getOutputSampleRate());
         computeRfSpectrumPipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(computeRfSpectrumStep));
         
-        auto computeRfSpectrumTap = new TapStep(inputSampleRate_, computeRfSpectrumPipeline);
+        auto computeRfSpectrumTap = new AsyncTapStep(inputSampleRate_, computeRfSpectrumPipeline);
         pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(computeRfSpectrumTap));
         
         // RX demodulation step
@@ -450,41 +505,107 @@ void TxRxThread::initializePipeline_()
         auto resampleForPlotOutPipeline = new AudioPipeline(outputSampleRate_, resampleForPlotOutStep->getOutputSampleRate());
         resampleForPlotOutPipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotOutStep));
 
-        auto resampleForPlotOutTap = new TapStep(outputSampleRate_, resampleForPlotOutPipeline);
+        auto resampleForPlotOutTap = new AsyncTapStep(outputSampleRate_, resampleForPlotOutPipeline);
         pipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(resampleForPlotOutTap));
         
+        // Sub receiver: just the spectrum and demodulation.
+        if (g_rxUserdata->infifo1Sub)
+        {
+            subPipeline_ = std::shared_ptr<AudioPipeline>(new AudioPipeline(inputSampleRate_, outputSampleRate_));
+            
+            auto computeSubSpectrumStep = new ComputeRfSpectrumStep(
+                []() { return g_spectrumEngineSub; }
+            );
+            auto computeSubSpectrumPipeline = new AudioPipeline(
+                inputSampleRate_, computeSubSpectrumStep->getOutputSampleRate());
+            computeSubSpectrumPipeline->appendPipelineStep(std::shared_ptr<IPipelineStep>(computeSubSpectrumStep));
+            
+            auto computeSubSpectrumTap = new AsyncTapStep(inputSampleRate_, computeSubSpectrumPipeline);
+            subPipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(computeSubSpectrumTap));
+            
+            auto subDemodulationStep = freedvInterfaceSub.createReceivePipeline(
+                inputSampleRate_, outputSampleRate_,
+                []() { return &g_StateSub; },
+                []() { return g_channel_noise; },
+                []() { return wxGetApp().appConfiguration.noiseSNR; },
+                []() { return 0.0f; },
+                []() { return &g_sig_pwr_avSub; }
+            );
+            subPipeline_->appendPipelineStep(std::shared_ptr<IPipelineStep>(subDemodulationStep));
+            
+            // Only a few frames are kept, see SubReceiverMixer.
+            subMixer_.reset(new SubReceiverMixer(outputSampleRate_ * FRAME_DURATION * 4));
+        }
+        
         // Clear anything in the FIFO before resuming decode.
         clearFifos_();
     }
 }
 
+void TxRxThread::createDriftCorrector_()
+{
+    if (g_nSoundCards != 2 || !wxGetApp().appConfiguration.audioConfiguration.driftCorrectionEnable)
+    {
+        return;
+    }
+
+    // The headset side FIFO: RX writes into outfifo2, TX reads from infifo2.
+    // Leave at least half of the FIFO as headroom.
+    int sampleRate = m_tx ? inputSampleRate_ : outputSampleRate_;
+    int targetMs = std::min(
+        (int)wxGetApp().appConfiguration.audioConfiguration.driftCorrectionTargetMs,
+        wxGetApp().appConfiguration.fifoSizeMs / 2);
+    driftCorrector_ = std::unique_ptr<ClockDriftCorrector>(
+        new ClockDriftCorrector(sampleRate, targetMs * sampleRate / 1000));
+}
+
 void* TxRxThread::Entry()
 {
+#if defined(__linux__)
+    const char* threadName = nullptr;
+    if (m_tx) threadName = "FreeDV txThread";
+    else threadName = "FreeDV rxThread";
+    pthread_setname_np(pthread_self(), threadName);
+#endif // defined(__linux__)
+
+    createDriftCorrector_();
     initializePipeline_();
+
+    // RX always processes in whole frames; TX updates this once it knows
+    // the modem frame size.
+    if (!m_tx)
+    {
+        wakeupThreshold_ = (int)(inputSampleRate_ * FRAME_DURATION);
+    }
+
+    wxStopWatch wakeupTimer;
+    int numWakeups = 0;
     
     while (m_run)
     {
-#if defined(__linux__)
-        const char* threadName = nullptr;
-        if (m_tx) threadName = "FreeDV txThread";
-        else threadName = "FreeDV rxThread";
-        pthread_setname_np(pthread_self(), threadName);
-#endif // defined(__linux__)
-
         {
+            // No timeout: the audio callbacks wake us when there's work to do
+            // and terminateThread() when it's time to go.
             std::unique_lock<std::mutex> lk(m_processingMutex);
-            if (m_processingCondVar.wait_for(lk, std::chrono::milliseconds(100)) == std::cv_status::timeout)
-            {
-                fprintf(stderr, "txRxThread: timeout while waiting for CV, tx = %d\n", m_tx);
-            }
+            m_processingCondVar.wait(lk, [&]() { return notified_ || !m_run; });
+            notified_ = false;
         }
         if (!m_run) break;
         if (m_tx) txProcessing_();
         else rxProcessing_();
+
+        numWakeups++;
+        if (g_dump_timing && wakeupTimer.Time() >= 1000)
+        {
+            fprintf(stderr, "txRxThread: %d wakeups/s, tx = %d, latency = %.0f ms\n", numWakeups, m_tx, m_tx ? g_txLatencyMs : g_rxLatencyMs);
+            numWakeups = 0;
+            wakeupTimer.Start();
+        }
     }
     
     // Force pipeline to delete itself when we're done with the thread.
     pipeline_ = nullptr;
+    driftCorrector_ = nullptr;
     
     return NULL;
 }
@@ -502,7 +623,13 @@ void TxRxThread::terminateThread()
 
 void TxRxThread::notify()
 {
-    std::unique_lock<std::mutex> lk(m_processingMutex);
+    {
+        std::unique_lock<std::mutex> lk(m_processingMutex);
+        notified_ = true;
+    }
+
+    // Not under the lock, so the thread doesn't wake up only to block on
+    // it again (an extra context switch per wakeup).
     m_processingCondVar.notify_all();
 }
 
@@ -514,47 +641,33 @@ void TxRxThread::clearFifos_()
     {
         equalizedMicAudioLink_->clearFifo();
     }
+
+    if (driftCorrector_ != nullptr)
+    {
+        driftCorrector_->reset();
+    }
     
+    // outfifo1 (TX) and outfifo2/outfifo1 (RX) are read by the audio
+    // callbacks, so only they can actually discard the contents.
     if (m_tx)
     {
-        auto used = codec2_fifo_used(cbData->outfifo1);
-        if (used > 0)
-        {
-            short* temp = new short[used];
-            assert(temp != nullptr);
-            codec2_fifo_read(cbData->outfifo1, temp, used);
-            delete[] temp;
-        }
-        
-        used = codec2_fifo_used(cbData->infifo2);
-        if (used > 0)
-        {
-            short* temp = new short[used];
-            assert(temp != nullptr);
-            codec2_fifo_read(cbData->infifo2, temp, used);
-            delete[] temp;
-        }
+        cbData->outfifo1->requestClear();
+        cbData->infifo2->clear();
     }
     else
     {
-        auto used = codec2_fifo_used(cbData->infifo1);
-        if (used > 0)
+        cbData->infifo1->clear();
+        if (cbData->infifo1Sub)
         {
-            short* temp = new short[used];
-            assert(temp != nullptr);
-            codec2_fifo_read(cbData->infifo1, temp, used);
-            delete[] temp;
+            cbData->infifo1Sub->clear();
         }
-        
-        auto outFifo = (g_nSoundCards == 1) ? cbData->outfifo1 : cbData->outfifo2;
-        used = codec2_fifo_used(outFifo);
-        if (used > 0)
+        if (subMixer_)
         {
-            short* temp = new short[used];
-            assert(temp != nullptr);
-            codec2_fifo_read(outFifo, temp, used);
-            delete[] temp;
+            subMixer_->clear();
         }
+        
+        auto& outFifo = (g_nSoundCards == 1) ? cbData->outfifo1 : cbData->outfifo2;
+        outFifo->requestClear();
     }
 }
 
@@ -596,22 +709,23 @@ void TxRxThread::txProcessing_()
         // signal.
 
         unsigned int nsam_one_modem_frame = freedvInterface.getTxNNomModemSamples() * ((float)outputSampleRate_ / (float)freedvInterface.getTxModemSampleRate());
+        wakeupThreshold_ = nsam_one_modem_frame;
 
      	if (g_dump_fifo_state) {
     	  // If this drops to zero we have a problem as we will run out of output samples
     	  // to send to the sound driver
     	  if (g_verbose) fprintf(stderr, "outfifo1 used: %6d free: %6d nsam_one_modem_frame: %d\n",
-                      codec2_fifo_used(cbData->outfifo1), codec2_fifo_free(cbData->outfifo1), nsam_one_modem_frame);
+                      (int)(cbData->outfifo1->capacity() - cbData->outfifo1->numFree()), (int)cbData->outfifo1->numFree(), nsam_one_modem_frame);
     	}
 
         int nsam_in_48 = freedvInterface.getTxNumSpeechSamples() * ((float)inputSampleRate_ / (float)freedvInterface.getTxSpeechSampleRate());
         assert(nsam_in_48 > 0);
 
-        short           insound_card[nsam_in_48];
         int             nout;
 
         
-        while((unsigned)codec2_fifo_free(cbData->outfifo1) >= nsam_one_modem_frame) {        
+        size_t lastReadPosition = cbData->infifo2->getReadPosition();
+        while(cbData->outfifo1->numFree() >= nsam_one_modem_frame) {        
             // OK to generate a frame of modem output samples we need
             // an input frame of speech samples from the microphone.
 
@@ -621,25 +735,60 @@ void TxRxThread::txProcessing_()
             // to codec2_enc, possibly making a click every now and
             // again in the decoded audio at the other end.
 
+            // Read straight into the buffer given to the pipeline (which
+            // may hold on to it, see AsyncTapStep).
+            short* inputSamples = new short[nsam_in_48];
+            auto inputSamplesPtr = std::shared_ptr<short>(inputSamples, std::default_delete<short[]>());
+
             // zero speech input just in case infifo2 underflows
-            memset(insound_card, 0, nsam_in_48*sizeof(short));
+            memset(inputSamples, 0, nsam_in_48*sizeof(short));
             
-            // There may be recorded audio left to encode while ending TX. To handle this,
-            // we keep reading from the FIFO until we have less than nsam_in_48 samples available.
-            int nread = codec2_fifo_read(cbData->infifo2, insound_card, nsam_in_48);            
-            if (nread != 0 && endingTx) break;
-            
-            short* inputSamples = new short[nsam_in_48];
-            memcpy(inputSamples, insound_card, nsam_in_48 * sizeof(short));
+            if (driftCorrector_ != nullptr && !endingTx)
+            {
+                // Consume the mic audio at whatever rate keeps infifo2 at
+                // its target fill.
+                driftCorrector_->pull(inputSamples, nsam_in_48, [&](short* buf, int n) {
+                    if (cbData->infifo2->numUsed() < (size_t)n)
+                    {
+                        memset(buf, 0, n * sizeof(short));
+                    }
+                    else
+                    {
+                        cbData->infifo2->read(buf, n);
+                    }
+                });
+                driftCorrector_->updateFill(cbData->infifo2->numUsed(), nsam_in_48);
+                g_txDriftPpm = driftCorrector_->getDriftPpm();
+            }
+            else
+            {
+                // There may be recorded audio left to encode while ending TX. To handle this,
+                // we keep reading from the FIFO until we have less than nsam_in_48 samples available.
+                bool underflow = cbData->infifo2->numUsed() < (size_t)nsam_in_48;
+                if (underflow && endingTx) break;
+                if (!underflow)
+                {
+                    cbData->infifo2->read(inputSamples, nsam_in_48);
+                }
+            }
             
-            auto inputSamplesPtr = std::shared_ptr<short>(inputSamples, std::default_delete<short[]>());
             auto outputSamples = pipeline_->execute(inputSamplesPtr, nsam_in_48, &nout);
             
             if (g_dump_fifo_state) {
                 fprintf(stderr, "  nout: %d\n", nout);
             }
             
-            codec2_fifo_write(cbData->outfifo1, outputSamples.get(), nout);
+            cbData->outfifo1->write(outputSamples.get(), nout);
+
+            // The last modem sample goes with the last mic sample read.
+            int64_t captureTimeUs;
+            size_t readPosition = cbData->infifo2->getReadPosition();
+            if (nout > 0 && readPosition != lastReadPosition &&
+                cbData->infifo2Time.getTimeOf(readPosition - 1, inputSampleRate_, &captureTimeUs))
+            {
+                cbData->outfifo1Time.set(cbData->outfifo1->getWritePosition() - 1, captureTimeUs);
+            }
+            lastReadPosition = readPosition;
         }
         
         txModeChangeMutex.Unlock();
@@ -686,9 +835,9 @@ void TxRxThread::rxProcessing_()
     int nsam = (int)(inputSampleRate_ * FRAME_DURATION);
     assert(nsam > 0);
 
-    short           insound_card[nsam];
     int             nout;
 
+    std::vector<short> corrected;
 
     bool processInputFifo = 
         (g_voice_keyer_tx && wxGetApp().appConfiguration.monitorVoiceKeyerAudio) ||
@@ -696,21 +845,62 @@ void TxRxThread::rxProcessing_()
         (!g_voice_keyer_tx && ((g_half_duplex && !g_tx) || !g_half_duplex));
     
     // while we have enough input samples available ... 
-    while (codec2_fifo_read(cbData->infifo1, insound_card, nsam) == 0 && processInputFifo) {
+    while (cbData->infifo1->numUsed() >= (size_t)nsam) {
+        // Read straight into the buffer given to the pipeline (which may
+        // hold on to it, see AsyncTapStep).
+        short* inputSamples = new short[nsam];
+        auto inputSamplesPtr = std::shared_ptr<short>(inputSamples, std::default_delete<short[]>());
+        size_t readPosition = cbData->infifo1->getReadPosition();
+        cbData->infifo1->read(inputSamples, nsam);
+
+        // Written together with infifo1, so always has as much.
+        std::shared_ptr<short> subInputSamplesPtr;
+        if (subPipeline_ != nullptr)
+        {
+            subInputSamplesPtr = std::shared_ptr<short>(new short[nsam], std::default_delete<short[]>());
+            cbData->infifo1Sub->read(subInputSamplesPtr.get(), nsam);
+        }
+        if (!processInputFifo) break;
 
         // send latest squelch level to FreeDV API, as it handles squelch internally
         freedvInterface.setSquelch(g_SquelchActive, g_SquelchLevel);
 
-        short* inputSamples = new short[nsam];
-        memcpy(inputSamples, insound_card, nsam * sizeof(short));
-        
-        auto inputSamplesPtr = std::shared_ptr<short>(inputSamples, std::default_delete<short[]>());
         auto outputSamples = pipeline_->execute(inputSamplesPtr, nsam, &nout);
-        auto outFifo = (g_nSoundCards == 1) ? cbData->outfifo1 : cbData->outfifo2;
+        auto outFifo = (g_nSoundCards == 1) ? cbData->outfifo1.get() : cbData->outfifo2.get();
+        
+        const short* output = outputSamples.get();
+        if (subPipeline_ != nullptr)
+        {
+            freedvInterfaceSub.setSquelch(g_SquelchActive, g_SquelchLevel);
+            
+            int nsub = 0;
+            auto subOutputSamples = subPipeline_->execute(subInputSamplesPtr, nsam, &nsub);
+            output = subMixer_->mix(output, nout, subOutputSamples.get(), nsub);
+        }
         
-        if (nout > 0)
+        if (nout > 0 && driftCorrector_ != nullptr)
+        {
+            // Play the decoded audio at whatever rate keeps outfifo2 at
+            // its target fill.
+            int maxCorrected = nout * (1 + DRIFT_MAX_CORRECTION) + 16;
+            corrected.resize(maxCorrected);
+            int ncorrected = driftCorrector_->process(output, nout, &corrected[0], maxCorrected);
+            outFifo->write(&corrected[0], ncorrected);
+            // numUsed() is the consumer's; we're the producer here.
+            driftCorrector_->updateFill(outFifo->capacity() - outFifo->numFree(), nout);
+            g_rxDriftPpm = driftCorrector_->getDriftPpm();
+        }
+        else if (nout > 0)
+        {
+            outFifo->write(output, nout);
+        }
+
+        // The last decoded sample goes with the last radio sample read.
+        int64_t captureTimeUs;
+        if (nout > 0 && cbData->infifo1Time.getTimeOf(readPosition + nsam - 1, inputSampleRate_, &captureTimeUs))
         {
-            codec2_fifo_write(outFifo, outputSamples.get(), nout);
+            auto& outTime = (g_nSoundCards == 1) ? cbData->outfifo1Time : cbData->outfifo2Time;
+            outTime.set(outFifo->getWritePosition() - 1, captureTimeUs);
         }
         
         processInputFifo = 
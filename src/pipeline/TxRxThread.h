@@ -26,9 +26,14 @@
 #include <assert.h>
 #include <wx/thread.h>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <condition_variable>
 
 #include "AudioPipeline.h"
+#include "ClockDriftCorrector.h"
+#include "SubReceiverMixer.h"
 
 // Forward declarations
 class LinkStep;
@@ -47,6 +52,8 @@ public:
         , inputSampleRate_(inputSampleRate)
         , outputSampleRate_(outputSampleRate)
         , equalizedMicAudioLink_(micAudioLink)
+        , wakeupThreshold_(0)
+        , notified_(false)
     { 
         assert(inputSampleRate_ > 0);
         assert(outputSampleRate_ > 0);
@@ -62,6 +69,17 @@ public:
     void terminateThread();
     void notify();
 
+    // Called from the audio callbacks with the number of samples queued in
+    // infifo1 (RX) or free in outfifo1 (TX). Only wakes the thread once
+    // there's enough for it to process a frame.
+    void notifyIfReady(int numSamples)
+    {
+        if (numSamples >= wakeupThreshold_.load(std::memory_order_relaxed))
+        {
+            notify();
+        }
+    }
+
     std::mutex m_processingMutex;
     std::condition_variable m_processingCondVar;
 
@@ -72,7 +90,22 @@ private:
     int inputSampleRate_;
     int outputSampleRate_;
     LinkStep* equalizedMicAudioLink_;
+
+    // Only used with two sound cards; sits on outfifo2 (RX) or infifo2 (TX).
+    std::unique_ptr<ClockDriftCorrector> driftCorrector_;
+
+    // RX only, if the sub receiver is enabled (see subreceiver.cpp).
+    std::shared_ptr<AudioPipeline> subPipeline_;
+    std::unique_ptr<SubReceiverMixer> subMixer_;
+
+    // Samples needed by the next processing pass (see notifyIfReady()).
+    std::atomic<int> wakeupThreshold_;
+
+    // Set by notify(), protected by m_processingMutex. Lets a wakeup that
+    // arrives mid processing carry over to the next wait.
+    bool notified_;
     
+    void createDriftCorrector_();
     void initializePipeline_();
     void txProcessing_();
     void rxProcessing_();
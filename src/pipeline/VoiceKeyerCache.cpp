@@ -0,0 +1,132 @@
+//=========================================================================
+// Name:            VoiceKeyerCache.cpp
+// Purpose:         Holds the modem output for a voice keyer file so it
+//                  doesn't have to be encoded again on every repeat.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "VoiceKeyerCache.h"
+
+#include <cstring>
+#include <algorithm>
+
+VoiceKeyerCache::VoiceKeyerCache()
+    : state_(IDLE)
+    , isValid_(false)
+    , isComplete_(false)
+    , hasOverflowed_(false)
+    , capacity_(0)
+    , numSamples_(0)
+    , position_(0)
+{
+    // empty
+}
+
+void VoiceKeyerCache::start(std::string key, size_t maxSamples)
+{
+    isComplete_ = false;
+    position_ = 0;
+
+    if (isValid_ && key == key_)
+    {
+        state_ = REPLAYING;
+        return;
+    }
+
+    // Anything handed out by replay() keeps the old buffer alive.
+    key_ = key;
+    isValid_ = false;
+    hasOverflowed_ = false;
+    capacity_ = maxSamples;
+    numSamples_ = 0;
+    samples_ = std::shared_ptr<short>(new short[std::max(maxSamples, (size_t)1)], std::default_delete<short[]>());
+    state_ = CAPTURING;
+}
+
+void VoiceKeyerCache::stop()
+{
+    if (state_ == CAPTURING)
+    {
+        isValid_ = isComplete_ && !hasOverflowed_ && numSamples_ > 0;
+        if (!isValid_)
+        {
+            clear();
+        }
+    }
+    state_ = IDLE;
+}
+
+void VoiceKeyerCache::markComplete()
+{
+    isComplete_ = true;
+}
+
+void VoiceKeyerCache::clear()
+{
+    state_ = IDLE;
+    key_ = "";
+    isValid_ = false;
+    samples_.reset();
+    capacity_ = 0;
+    numSamples_ = 0;
+}
+
+void VoiceKeyerCache::capture(const short* samples, int numSamples)
+{
+    if (state_ != CAPTURING || hasOverflowed_)
+    {
+        return;
+    }
+
+    if (numSamples_ + numSamples > capacity_)
+    {
+        hasOverflowed_ = true;
+        return;
+    }
+
+    memcpy(samples_.get() + numSamples_, samples, numSamples * sizeof(short));
+    numSamples_ += numSamples;
+}
+
+std::shared_ptr<short> VoiceKeyerCache::replay(int numSamples, bool* isComplete)
+{
+    *isComplete = false;
+
+    if (state_ == REPLAYING && position_ + numSamples <= numSamples_)
+    {
+        std::shared_ptr<short> result(samples_, samples_.get() + position_);
+        position_ += numSamples;
+        return result;
+    }
+
+    short* output = new short[numSamples];
+    memset(output, 0, numSamples * sizeof(short));
+
+    if (state_ == REPLAYING && !isComplete_)
+    {
+        size_t count = numSamples_ - position_;
+        memcpy(output, samples_.get() + position_, count * sizeof(short));
+        position_ += count;
+
+        isComplete_ = true;
+        *isComplete = true;
+    }
+
+    return std::shared_ptr<short>(output, std::default_delete<short[]>());
+}
@@ -0,0 +1,87 @@
+//=========================================================================
+// Name:            VoiceKeyerCache.h
+// Purpose:         Holds the modem output for a voice keyer file so it
+//                  doesn't have to be encoded again on every repeat.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__VOICE_KEYER_CACHE_H
+#define AUDIO_PIPELINE__VOICE_KEYER_CACHE_H
+
+#include <string>
+#include <memory>
+
+// The first time a voice keyer file is sent, the TX pipeline's output is
+// captured (VoiceKeyerCaptureStep). If the file played to the end, later
+// transmissions with the same key -- which identifies the file contents
+// and every TX setting that affects the output -- replay that instead
+// (VoiceKeyerReplayStep) and skip Speex, the equalizer and the modem.
+//
+// Not thread safe; the UI thread and TX thread must serialize access
+// (g_mutexProtectingCallbackData in FreeDV).
+class VoiceKeyerCache
+{
+public:
+    VoiceKeyerCache();
+    virtual ~VoiceKeyerCache() = default;
+
+    // Starts a transmission. Replays if there's a complete capture for
+    // key, otherwise captures up to maxSamples of TX pipeline output.
+    void start(std::string key, size_t maxSamples);
+
+    // Ends the transmission, keeping a new capture only if
+    // markComplete() was called and it all fit.
+    void stop();
+
+    // The whole file has gone through the TX pipeline.
+    void markComplete();
+
+    // Discards any capture.
+    void clear();
+
+    bool isCapturing() const { return state_ == CAPTURING; }
+    bool isReplaying() const { return state_ == REPLAYING; }
+
+    // Memory currently used, in bytes.
+    size_t getSizeBytes() const { return samples_ != nullptr ? capacity_ * sizeof(short) : 0; }
+
+    // TX thread side.
+    void capture(const short* samples, int numSamples);
+
+    // Returns exactly numSamples samples (silence past the end or when
+    // not replaying). *isComplete is set the first time the end is
+    // reached. The returned buffer must not be modified.
+    std::shared_ptr<short> replay(int numSamples, bool* isComplete);
+
+private:
+    enum State { IDLE, CAPTURING, REPLAYING };
+
+    State state_;
+    std::string key_;
+    bool isValid_;
+    bool isComplete_;
+    bool hasOverflowed_;
+
+    std::shared_ptr<short> samples_;
+    size_t capacity_;
+    size_t numSamples_;
+    size_t position_;
+};
+
+#endif // AUDIO_PIPELINE__VOICE_KEYER_CACHE_H
@@ -0,0 +1,41 @@
+//=========================================================================
+// Name:            VoiceKeyerCaptureStep.cpp
+// Purpose:         Captures TX pipeline output for the voice keyer cache.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "VoiceKeyerCaptureStep.h"
+
+VoiceKeyerCaptureStep::VoiceKeyerCaptureStep(int sampleRate, VoiceKeyerCache* cache)
+    : sampleRate_(sampleRate)
+    , cache_(cache)
+{
+    // empty
+}
+
+std::shared_ptr<short> VoiceKeyerCaptureStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
+{
+    if (numInputSamples > 0)
+    {
+        cache_->capture(inputSamples.get(), numInputSamples);
+    }
+
+    *numOutputSamples = numInputSamples;
+    return inputSamples;
+}
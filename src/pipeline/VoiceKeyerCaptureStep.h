@@ -0,0 +1,46 @@
+//=========================================================================
+// Name:            VoiceKeyerCaptureStep.h
+// Purpose:         Captures TX pipeline output for the voice keyer cache.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__VOICE_KEYER_CAPTURE_STEP_H
+#define AUDIO_PIPELINE__VOICE_KEYER_CAPTURE_STEP_H
+
+#include "IPipelineStep.h"
+#include "VoiceKeyerCache.h"
+
+// Passes its input through unchanged, adding it to the cache if it's
+// capturing.
+class VoiceKeyerCaptureStep : public IPipelineStep
+{
+public:
+    VoiceKeyerCaptureStep(int sampleRate, VoiceKeyerCache* cache);
+    virtual ~VoiceKeyerCaptureStep() = default;
+
+    virtual int getInputSampleRate() const override { return sampleRate_; }
+    virtual int getOutputSampleRate() const override { return sampleRate_; }
+    virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples) override;
+
+private:
+    int sampleRate_;
+    VoiceKeyerCache* cache_;
+};
+
+#endif // AUDIO_PIPELINE__VOICE_KEYER_CAPTURE_STEP_H
@@ -0,0 +1,51 @@
+//=========================================================================
+// Name:            VoiceKeyerReplayStep.cpp
+// Purpose:         Plays back cached voice keyer modem output.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#include "VoiceKeyerReplayStep.h"
+
+VoiceKeyerReplayStep::VoiceKeyerReplayStep(
+    int inputSampleRate, int outputSampleRate, VoiceKeyerCache* cache,
+    std::function<void()> fileCompleteFn)
+    : inputSampleRate_(inputSampleRate)
+    , outputSampleRate_(outputSampleRate)
+    , cache_(cache)
+    , fileCompleteFn_(fileCompleteFn)
+{
+    // empty
+}
+
+std::shared_ptr<short> VoiceKeyerReplayStep::execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
+{
+    *numOutputSamples = numInputSamples * outputSampleRate_ / inputSampleRate_;
+    if (*numOutputSamples <= 0)
+    {
+        return nullptr;
+    }
+
+    bool isComplete = false;
+    auto outputSamples = cache_->replay(*numOutputSamples, &isComplete);
+    if (isComplete)
+    {
+        fileCompleteFn_();
+    }
+    return outputSamples;
+}
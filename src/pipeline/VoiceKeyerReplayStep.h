@@ -0,0 +1,52 @@
+//=========================================================================
+// Name:            VoiceKeyerReplayStep.h
+// Purpose:         Plays back cached voice keyer modem output.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef AUDIO_PIPELINE__VOICE_KEYER_REPLAY_STEP_H
+#define AUDIO_PIPELINE__VOICE_KEYER_REPLAY_STEP_H
+
+#include <functional>
+#include "IPipelineStep.h"
+#include "VoiceKeyerCache.h"
+
+// Stands in for the TX pipeline while the cache is replaying: discards
+// its (mic rate) input and outputs the same duration of cached modem
+// output. fileCompleteFn is called once at the end of the cache.
+class VoiceKeyerReplayStep : public IPipelineStep
+{
+public:
+    VoiceKeyerReplayStep(
+        int inputSampleRate, int outputSampleRate, VoiceKeyerCache* cache,
+        std::function<void()> fileCompleteFn);
+    virtual ~VoiceKeyerReplayStep() = default;
+
+    virtual int getInputSampleRate() const override { return inputSampleRate_; }
+    virtual int getOutputSampleRate() const override { return outputSampleRate_; }
+    virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples) override;
+
+private:
+    int inputSampleRate_;
+    int outputSampleRate_;
+    VoiceKeyerCache* cache_;
+    std::function<void()> fileCompleteFn_;
+};
+
+#endif // AUDIO_PIPELINE__VOICE_KEYER_REPLAY_STEP_H
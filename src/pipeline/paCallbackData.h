@@ -1,8 +1,11 @@
 #ifndef AUDIO_PIPELINE_PA_CALLBACK_DATA_H
 #define AUDIO_PIPELINE_PA_CALLBACK_DATA_H
 
+#include <memory>
 #include <samplerate.h>
 #include "codec2_fifo.h"
+#include "../util/SpscRingBuffer.h"
+#include "../util/StreamTimestamp.h"
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=
 // paCallBackData
@@ -10,13 +13,7 @@
 typedef struct paCallBackData
 {
     paCallBackData()
-        : infifo1(nullptr)
-        , outfifo1(nullptr)
-        , infifo2(nullptr)
-        , outfifo2(nullptr)
-        , rxinfifo(nullptr)
-        , rxoutfifo(nullptr)
-        , sbqMicInBass(nullptr)
+        : sbqMicInBass(nullptr)
         , sbqMicInTreble(nullptr)
         , sbqMicInMid(nullptr)
         , sbqMicInVol(nullptr)
@@ -32,17 +29,48 @@ typedef struct paCallBackData
         // empty
     }
 
+    // FIFOs between the audio callbacks and TxRxThread. The callback is
+    // the producer for the in FIFOs and the consumer for the out FIFOs.
+
     // FIFOs attached to first sound card
-    struct FIFO    *infifo1;
-    struct FIFO    *outfifo1;
+    std::unique_ptr<SpscRingBuffer<short>> infifo1;
+    std::unique_ptr<SpscRingBuffer<short>> outfifo1;
+
+    // Right channel of the first sound card, for the sub receiver. Only
+    // created if it's enabled and filled in step with infifo1.
+    std::unique_ptr<SpscRingBuffer<short>> infifo1Sub;
+
+    // The radio input callback's side of infifo1/infifo1Sub. data holds
+    // size frames of mono or, with the sub receiver, size frames of the
+    // left channel followed by size of the right (see main.cpp). Both are
+    // written or neither; returns false if there wasn't room.
+    bool writeRadioInput(const short* data, size_t size, int64_t bufferTimeUs)
+    {
+        if (infifo1->numFree() < size || (infifo1Sub && infifo1Sub->numFree() < size))
+        {
+            return false;
+        }
+
+        infifo1Time.set(infifo1->getWritePosition(), bufferTimeUs);
+        infifo1->write(data, size);
+        if (infifo1Sub)
+        {
+            infifo1Sub->write(data + size, size);
+        }
+        return true;
+    }
 
     // FIFOs attached to second sound card
-    struct FIFO    *infifo2;
-    struct FIFO    *outfifo2;
+    std::unique_ptr<SpscRingBuffer<short>> infifo2;
+    std::unique_ptr<SpscRingBuffer<short>> outfifo2;
 
-    // FIFOs for rx process
-    struct FIFO    *rxinfifo;
-    struct FIFO    *rxoutfifo;
+    // Capture times of the audio in the above, set by their producers.
+    // The out FIFOs carry the time the corresponding input was captured,
+    // so their consumers can measure the latency through the whole chain.
+    StreamTimestamp infifo1Time;
+    StreamTimestamp outfifo1Time;
+    StreamTimestamp infifo2Time;
+    StreamTimestamp outfifo2Time;
 
     // EQ filter states
     void           *sbqMicInBass;
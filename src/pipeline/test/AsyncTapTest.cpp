@@ -0,0 +1,167 @@
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include "AsyncTapStep.h"
+#include "PipelineTestCommon.h"
+
+class CountingStep : public IPipelineStep
+{
+public:
+    CountingStep()
+        : numSamplesSeen(0)
+        , blocked(false)
+    {
+        // empty
+    }
+    
+    virtual int getInputSampleRate() const { return 8000; }
+    virtual int getOutputSampleRate() const { return 8000; }
+    virtual std::shared_ptr<short> execute(std::shared_ptr<short> inputSamples, int numInputSamples, int* numOutputSamples)
+    {
+        while (blocked)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        
+        lastInputSamples = inputSamples;
+        numSamplesSeen += numInputSamples;
+        *numOutputSamples = numInputSamples;
+        return inputSamples;
+    }
+    
+    std::shared_ptr<short> lastInputSamples;
+    std::atomic<int> numSamplesSeen;
+    std::atomic<bool> blocked;
+};
+
+static bool waitForProcessed(AsyncTapStep& step, uint64_t count)
+{
+    for (int i = 0; i < 1000 && step.getNumProcessedBlocks() < count; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return step.getNumProcessedBlocks() == count;
+}
+
+bool asyncTapDataEqual()
+{
+    CountingStep* step = new CountingStep;
+    AsyncTapStep tapStep(8000, step);
+    
+    int outputSamples = 0;
+    short* pData = new short[1];
+    pData[0] = 10000;
+    
+    std::shared_ptr<short> input(pData, std::default_delete<short[]>());
+    auto result = tapStep.execute(input, 1, &outputSamples);
+    if (outputSamples != 1)
+    {
+        std::cerr << "[outputSamples[" << outputSamples << "] != 1]...";
+        return false;
+    } 
+    
+    if (result != input)
+    {
+        std::cerr << "[result != input]...";
+        return false;
+    }
+    
+    if (!waitForProcessed(tapStep, 1))
+    {
+        std::cerr << "[block not processed]...";
+        return false;
+    }
+    
+    if (step->lastInputSamples != input)
+    {
+        std::cerr << "[input was copied]...";
+        return false;
+    }
+    
+    return true;
+}
+
+bool asyncTapDropsOnOverflow()
+{
+    const int queueSize = 4;
+    const int numBlocks = 10;
+    
+    CountingStep* step = new CountingStep;
+    step->blocked = true;
+    AsyncTapStep tapStep(8000, step, queueSize);
+    
+    for (int i = 0; i < numBlocks; i++)
+    {
+        int outputSamples = 0;
+        std::shared_ptr<short> input(new short[160](), std::default_delete<short[]>());
+        tapStep.execute(input, 160, &outputSamples);
+    }
+    
+    // The worker may have already dequeued (and be stuck on) one block.
+    auto numDropped = tapStep.getNumDroppedBlocks();
+    auto numQueued = tapStep.getNumQueuedBlocks();
+    if (numDropped + numQueued != numBlocks || numQueued < queueSize || numQueued > queueSize + 1)
+    {
+        std::cerr << "[queued " << numQueued << ", dropped " << numDropped << "]...";
+        return false;
+    }
+    
+    step->blocked = false;
+    if (!waitForProcessed(tapStep, numQueued))
+    {
+        std::cerr << "[processed " << tapStep.getNumProcessedBlocks() << "]...";
+        return false;
+    }
+    
+    if (step->numSamplesSeen != (int)numQueued * 160)
+    {
+        std::cerr << "[numSamplesSeen = " << step->numSamplesSeen << "]...";
+        return false;
+    }
+    
+    return true;
+}
+
+bool asyncTapNoLostWakeups()
+{
+    // The worker waits without a timeout, so every block (and the stop
+    // request) has to wake it by itself. One block at a time, each of
+    // which must be processed well within what the old 10 ms polling
+    // would have needed in total.
+    const int numBlocks = 20000;
+    
+    CountingStep* step = new CountingStep;
+    AsyncTapStep tapStep(8000, step);
+    std::shared_ptr<short> input(new short[1](), std::default_delete<short[]>());
+    for (int i = 0; i < numBlocks; i++)
+    {
+        int outputSamples = 0;
+        tapStep.execute(input, 1, &outputSamples);
+        
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (tapStep.getNumProcessedBlocks() < (uint64_t)i + 1 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+        if (tapStep.getNumProcessedBlocks() < (uint64_t)i + 1)
+        {
+            std::cerr << "[block " << i << " never processed]...";
+            return false;
+        }
+    }
+    
+    // Likewise the stop request; a lost one would hang here.
+    for (int i = 0; i < 1000; i++)
+    {
+        AsyncTapStep idleStep(8000, new CountingStep);
+    }
+    return true;
+}
+
+int main()
+{
+    TEST_CASE(asyncTapDataEqual);
+    TEST_CASE(asyncTapDropsOnOverflow);
+    TEST_CASE(asyncTapNoLostWakeups);
+    return 0;
+}
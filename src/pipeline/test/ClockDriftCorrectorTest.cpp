@@ -0,0 +1,124 @@
+#include "ClockDriftCorrector.h"
+#include "PipelineTestCommon.h"
+
+#include <cstring>
+
+#define TEST_SAMPLE_RATE 48000
+#define TEST_TARGET_FILL (TEST_SAMPLE_RATE / 10)
+#define TEST_DRIFT 0.0002
+#define TEST_DURATION_SEC 300
+
+// Simulates writing 20ms blocks into a FIFO that a sound card with a
+// slightly different clock drains 10ms at a time.
+bool driftCorrectorWriting(double drift)
+{
+    ClockDriftCorrector corrector(TEST_SAMPLE_RATE, TEST_TARGET_FILL);
+
+    int blockSize = TEST_SAMPLE_RATE / 50;
+    int drainSize = TEST_SAMPLE_RATE / 100;
+    short* input = generateOneSecondSineWave(2000, TEST_SAMPLE_RATE);
+    short output[2 * blockSize];
+
+    double drainAccum = 0;
+    int fill = 0;
+    int underflows = 0;
+    for (int block = 0; block < TEST_DURATION_SEC * 50; block++)
+    {
+        int numOut = corrector.process(input + (block % 50) * blockSize, blockSize, output, 2 * blockSize);
+        fill += numOut;
+
+        // The sound card's idea of 20ms.
+        drainAccum += blockSize * (1.0 + drift);
+        while (drainAccum >= drainSize)
+        {
+            drainAccum -= drainSize;
+            if (fill >= drainSize) fill -= drainSize;
+            else if (block > TEST_DURATION_SEC * 25) underflows++;
+        }
+
+        corrector.updateFill(fill, numOut);
+    }
+    delete[] input;
+
+    // Draining faster than we write means the FIFO would empty, so the
+    // estimate should come out negative.
+    double expectedPpm = -drift * 1e6;
+    if (underflows > 0 || std::abs(fill - TEST_TARGET_FILL) > TEST_TARGET_FILL / 2 ||
+        std::abs(corrector.getDriftPpm() - expectedPpm) > std::abs(expectedPpm) * 0.2)
+    {
+        std::cerr << "[underflows = " << underflows << ", fill = " << fill << ", drift = " << corrector.getDriftPpm() << " ppm, expected " << expectedPpm << "]...";
+        return false;
+    }
+    return true;
+}
+
+// Simulates a sound card with a slightly different clock filling a FIFO
+// that we read 20ms blocks from.
+bool driftCorrectorReading(double drift)
+{
+    ClockDriftCorrector corrector(TEST_SAMPLE_RATE, TEST_TARGET_FILL);
+
+    int blockSize = TEST_SAMPLE_RATE / 50;
+    int writeSize = TEST_SAMPLE_RATE / 100;
+    short output[blockSize];
+
+    double writeAccum = 0;
+    int fill = TEST_TARGET_FILL;
+    int underflows = 0;
+    for (int block = 0; block < TEST_DURATION_SEC * 50; block++)
+    {
+        writeAccum += blockSize * (1.0 + drift);
+        while (writeAccum >= writeSize)
+        {
+            writeAccum -= writeSize;
+            fill += writeSize;
+        }
+
+        int numRead = 0;
+        corrector.pull(output, blockSize, [&](short* buf, int n) {
+            memset(buf, 0, n * sizeof(short));
+            if (fill >= n) fill -= n;
+            else if (block > TEST_DURATION_SEC * 25) underflows++;
+            numRead += n;
+        });
+        corrector.updateFill(fill, numRead);
+    }
+
+    double expectedPpm = drift * 1e6;
+    if (underflows > 0 || std::abs(fill - TEST_TARGET_FILL) > TEST_TARGET_FILL / 2 ||
+        std::abs(corrector.getDriftPpm() - expectedPpm) > std::abs(expectedPpm) * 0.2)
+    {
+        std::cerr << "[underflows = " << underflows << ", fill = " << fill << ", drift = " << corrector.getDriftPpm() << " ppm, expected " << expectedPpm << "]...";
+        return false;
+    }
+    return true;
+}
+
+bool driftWritingFastSoundCard()
+{
+    return driftCorrectorWriting(TEST_DRIFT);
+}
+
+bool driftWritingSlowSoundCard()
+{
+    return driftCorrectorWriting(-TEST_DRIFT);
+}
+
+bool driftReadingFastSoundCard()
+{
+    return driftCorrectorReading(TEST_DRIFT);
+}
+
+bool driftReadingSlowSoundCard()
+{
+    return driftCorrectorReading(-TEST_DRIFT);
+}
+
+int main()
+{
+    TEST_CASE(driftWritingFastSoundCard);
+    TEST_CASE(driftWritingSlowSoundCard);
+    TEST_CASE(driftReadingFastSoundCard);
+    TEST_CASE(driftReadingSlowSoundCard);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include "CodecFrameLog.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_NUM_RECORDS 100
+#define TEST_START_TIME 1700000000
+
+static std::string testPath(const char* name)
+{
+    const char* tmpDir = getenv("TMPDIR");
+    return std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/" + name;
+}
+
+// Record n: 14 byte payload (as 700D) in sync, except every tenth which is
+// an empty sync lost marker.
+static CodecFrameLogRecord makeRecord(int n)
+{
+    CodecFrameLogRecord record;
+    record.mode = n % 3;
+    record.sync = n % 10 != 9;
+    record.snrDb = n - 50;
+    record.timeMs = 160 * n + 70000;
+    if (record.sync)
+    {
+        for (int index = 0; index < 14; index++)
+        {
+            record.payload.push_back((unsigned char)(n + index));
+        }
+    }
+    return record;
+}
+
+static bool sameRecord(const CodecFrameLogRecord& a, const CodecFrameLogRecord& b)
+{
+    return a.mode == b.mode && a.sync == b.sync && a.snrDb == b.snrDb &&
+        a.timeMs == b.timeMs && a.payload == b.payload;
+}
+
+bool codecFrameLogRoundTrip()
+{
+    std::string path = testPath("CodecFrameLogTest.fdvlog");
+    std::string error;
+
+    CodecFrameLogWriter writer;
+    if (!writer.open(path, TEST_START_TIME, &error))
+    {
+        std::cerr << "[could not open " << path << ": " << error << "]...";
+        return false;
+    }
+    size_t expectedBytes = CODEC_FRAME_LOG_HEADER_SIZE;
+    for (int n = 0; n < TEST_NUM_RECORDS; n++)
+    {
+        auto record = makeRecord(n);
+        writer.write(record);
+        expectedBytes += CODEC_FRAME_LOG_RECORD_HEADER_SIZE + record.payload.size();
+    }
+    writer.close();
+    if (writer.getNumBytesWritten() != expectedBytes)
+    {
+        std::cerr << "[wrote " << writer.getNumBytesWritten() << " bytes]...";
+        return false;
+    }
+
+    // The start of another record, as if we'd crashed part way through it.
+    FILE* file = fopen(path.c_str(), "ab");
+    fputs("\x01\x01\x05", file);
+    fclose(file);
+
+    CodecFrameLogReader reader;
+    if (!reader.open(path, &error) || reader.getStartTime() != TEST_START_TIME)
+    {
+        std::cerr << "[could not read back: " << error << "]...";
+        return false;
+    }
+
+    int numRead = 0;
+    CodecFrameLogRecord record;
+    while (reader.read(&record))
+    {
+        if (!sameRecord(record, makeRecord(numRead)))
+        {
+            std::cerr << "[record " << numRead << " differs]...";
+            return false;
+        }
+        numRead++;
+    }
+    reader.close();
+    remove(path.c_str());
+
+    return numRead == TEST_NUM_RECORDS;
+}
+
+bool codecFrameLogRejectsOtherFiles()
+{
+    std::string path = testPath("CodecFrameLogTest.wav");
+    FILE* file = fopen(path.c_str(), "wb");
+    fputs("RIFF....WAVEfmt data", file);
+    fclose(file);
+
+    std::string error;
+    CodecFrameLogReader reader;
+    bool opened = reader.open(path, &error);
+    remove(path.c_str());
+    return !opened && error != "";
+}
+
+int main()
+{
+    TEST_CASE(codecFrameLogRoundTrip);
+    TEST_CASE(codecFrameLogRejectsOtherFiles);
+    return 0;
+}
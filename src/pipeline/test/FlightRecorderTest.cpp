@@ -0,0 +1,100 @@
+#include <vector>
+#include <algorithm>
+#include "FlightRecorder.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_SAMPLE_RATE 8000
+#define TEST_MAX_SECONDS 3
+#define TEST_BLOCK_SIZE (TEST_SAMPLE_RATE / 50)
+
+// Writes numSamples samples where sample n is (short)(start + n).
+static void writeSamples(FlightRecorder& recorder, int start, int numSamples)
+{
+    short block[TEST_BLOCK_SIZE];
+    for (int position = 0; position < numSamples; position += TEST_BLOCK_SIZE)
+    {
+        int count = std::min(TEST_BLOCK_SIZE, numSamples - position);
+        for (int index = 0; index < count; index++)
+        {
+            block[index] = (short)(start + position + index);
+        }
+        recorder.write(block, count);
+    }
+}
+
+// Checks that recording holds the numSamples samples ending at end.
+static bool checkRecording(const FlightRecording& recording, int end, int numSamples)
+{
+    if (recording.getNumSamples() != (size_t)numSamples)
+    {
+        std::cerr << "[holds " << recording.getNumSamples() << " samples]...";
+        return false;
+    }
+
+    std::vector<short> samples(numSamples);
+    if (recording.read(0, &samples[0], numSamples) != (size_t)numSamples)
+    {
+        std::cerr << "[short read]...";
+        return false;
+    }
+    for (int index = 0; index < numSamples; index++)
+    {
+        short expected = (short)(end - numSamples + index);
+        if (samples[index] != expected)
+        {
+            std::cerr << "[sample " << index << " is " << samples[index] << "]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool flightRecorderKeepsLatest()
+{
+    FlightRecorder recorder(TEST_SAMPLE_RATE, TEST_MAX_SECONDS);
+
+    // Less than the limit, ending part way through a block.
+    int written = TEST_SAMPLE_RATE * 3 / 2 + 7;
+    writeSamples(recorder, 0, written);
+    if (!checkRecording(*recorder.snapshot(), written, written))
+    {
+        return false;
+    }
+
+    // Well past the limit.
+    writeSamples(recorder, written, TEST_SAMPLE_RATE * 10);
+    written += TEST_SAMPLE_RATE * 10;
+    if (!checkRecording(*recorder.snapshot(), written, TEST_SAMPLE_RATE * TEST_MAX_SECONDS))
+    {
+        return false;
+    }
+
+    // Full blocks, plus the current one and a spare.
+    size_t maxBytes = (TEST_MAX_SECONDS + 2) * TEST_SAMPLE_RATE * sizeof(short);
+    if (recorder.getSizeBytes() > maxBytes)
+    {
+        std::cerr << "[using " << recorder.getSizeBytes() << " bytes]...";
+        return false;
+    }
+    return true;
+}
+
+bool flightRecorderSnapshotUnaffectedByWrites()
+{
+    FlightRecorder recorder(TEST_SAMPLE_RATE, TEST_MAX_SECONDS);
+
+    int written = TEST_SAMPLE_RATE * 5;
+    writeSamples(recorder, 0, written);
+    auto recording = recorder.snapshot();
+
+    // Enough to cycle through every block the snapshot refers to.
+    writeSamples(recorder, written, TEST_SAMPLE_RATE * 10);
+    return checkRecording(*recording, written, TEST_SAMPLE_RATE * TEST_MAX_SECONDS);
+}
+
+int main()
+{
+    TEST_CASE(flightRecorderKeepsLatest);
+    TEST_CASE(flightRecorderSnapshotUnaffectedByWrites);
+    return 0;
+}
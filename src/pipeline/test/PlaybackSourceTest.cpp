@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "PlaybackSource.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_SAMPLE_RATE 8000
+#define TEST_FILE_SECONDS 10
+#define TEST_BLOCK_SIZE (TEST_SAMPLE_RATE / 50)
+
+static std::string testPath()
+{
+    const char* tmpDir = getenv("TMPDIR");
+    return std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/PlaybackSourceTest.raw";
+}
+
+// Sample n of the test file is (short)n.
+static bool createTestFile()
+{
+    SF_INFO sfInfo;
+    sfInfo.format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+    sfInfo.channels = 1;
+    sfInfo.samplerate = TEST_SAMPLE_RATE;
+
+    SNDFILE* file = sf_open(testPath().c_str(), SFM_WRITE, &sfInfo);
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<short> samples(TEST_FILE_SECONDS * TEST_SAMPLE_RATE);
+    for (size_t index = 0; index < samples.size(); index++)
+    {
+        samples[index] = (short)index;
+    }
+    sf_write_short(file, &samples[0], samples.size());
+    sf_close(file);
+    return true;
+}
+
+// Plays the test file in 20ms blocks (twice if looping) and checks that
+// the samples come out in order, followed by silence.
+static bool playTestFile(int maxPreloadSeconds, bool loop)
+{
+    if (!createTestFile())
+    {
+        std::cerr << "[could not create " << testPath() << "]...";
+        return false;
+    }
+
+    PlaybackSource source(testPath(), TEST_SAMPLE_RATE, maxPreloadSeconds);
+    if (!source.open())
+    {
+        std::cerr << "[could not open: " << source.getError() << "]...";
+        return false;
+    }
+    source.setLoop(loop);
+    if (source.isPreloaded() != (maxPreloadSeconds >= TEST_FILE_SECONDS))
+    {
+        std::cerr << "[preloaded = " << source.isPreloaded() << "]...";
+        return false;
+    }
+
+    int fileSamples = TEST_FILE_SECONDS * TEST_SAMPLE_RATE;
+    int totalSamples = (loop ? 2 : 1) * fileSamples + TEST_SAMPLE_RATE;
+    int numCompletions = 0;
+    for (int position = 0; position < totalSamples; position += TEST_BLOCK_SIZE)
+    {
+        bool isComplete;
+        auto block = source.read(TEST_BLOCK_SIZE, &isComplete);
+        numCompletions += isComplete;
+
+        for (int index = 0; index < TEST_BLOCK_SIZE; index++)
+        {
+            int samplePosition = position + index;
+            short expected = 0;
+            if (loop || samplePosition < fileSamples)
+            {
+                expected = (short)(samplePosition % fileSamples);
+            }
+            if (block.get()[index] != expected)
+            {
+                std::cerr << "[sample " << samplePosition << " is " << block.get()[index] << "]...";
+                return false;
+            }
+        }
+
+        if (!source.isPreloaded())
+        {
+            // Give the prefetch thread a chance, at 20x realtime.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    source.close();
+    remove(testPath().c_str());
+
+    if (numCompletions != (loop ? 0 : 1))
+    {
+        std::cerr << "[completed " << numCompletions << " times]...";
+        return false;
+    }
+    return true;
+}
+
+bool playbackPreloaded()
+{
+    return playTestFile(PLAYBACK_SOURCE_MAX_PRELOAD_SECONDS, false);
+}
+
+bool playbackPreloadedLoop()
+{
+    return playTestFile(PLAYBACK_SOURCE_MAX_PRELOAD_SECONDS, true);
+}
+
+bool playbackStreamed()
+{
+    return playTestFile(1, false);
+}
+
+bool playbackStreamedLoop()
+{
+    return playTestFile(1, true);
+}
+
+int main()
+{
+    TEST_CASE(playbackPreloaded);
+    TEST_CASE(playbackPreloadedLoop);
+    TEST_CASE(playbackStreamed);
+    TEST_CASE(playbackStreamedLoop);
+    return 0;
+}
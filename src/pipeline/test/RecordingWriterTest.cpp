@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "RecordingWriter.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_SAMPLE_RATE 8000
+#define TEST_ROTATE_SECONDS 3
+#define TEST_DURATION_SEC 10
+
+static std::string testPath(const char* name)
+{
+    const char* tmpDir = getenv("TMPDIR");
+    return std::string(tmpDir != nullptr ? tmpDir : "/tmp") + "/" + name;
+}
+
+// Appends the samples in path to result. False if it can't be opened.
+static bool readFile(std::string path, std::vector<short>& result)
+{
+    SF_INFO sfInfo;
+    sfInfo.format = 0;
+    SNDFILE* file = sf_open(path.c_str(), SFM_READ, &sfInfo);
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    short buffer[1024];
+    sf_count_t numRead;
+    while ((numRead = sf_read_short(file, buffer, 1024)) > 0)
+    {
+        result.insert(result.end(), buffer, buffer + numRead);
+    }
+    sf_close(file);
+    remove(path.c_str());
+    return true;
+}
+
+// Feeds 20ms blocks in roughly realtime (sped up 10x) and checks that
+// every sample ends up on disk in order, split across files of the
+// requested length.
+bool recordingWriterRotation()
+{
+    std::string path = testPath("RecordingWriterTest.wav");
+    RecordingWriter writer(path, TEST_SAMPLE_RATE, SF_FORMAT_WAV | SF_FORMAT_PCM_16, TEST_ROTATE_SECONDS);
+    if (!writer.open())
+    {
+        std::cerr << "[could not open " << path << "]...";
+        return false;
+    }
+
+    int blockSize = TEST_SAMPLE_RATE / 50;
+    short block[TEST_SAMPLE_RATE / 50];
+    short next = 0;
+    for (int index = 0; index < TEST_DURATION_SEC * 50; index++)
+    {
+        for (int sample = 0; sample < blockSize; sample++)
+        {
+            block[sample] = next++;
+        }
+        writer.write(block, blockSize);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    writer.close();
+
+    int expectedFiles = (TEST_DURATION_SEC + TEST_ROTATE_SECONDS - 1) / TEST_ROTATE_SECONDS;
+    if (writer.getNumFiles() != expectedFiles || writer.getNumSamplesDropped() != 0)
+    {
+        std::cerr << "[" << writer.getNumFiles() << " files, " << writer.getNumSamplesDropped() << " dropped]...";
+        return false;
+    }
+
+    std::vector<short> result;
+    for (int file = 0; file < expectedFiles; file++)
+    {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "-%03d", file);
+        std::string filePath = file == 0 ? path : testPath("RecordingWriterTest") + suffix + ".wav";
+
+        size_t previousSize = result.size();
+        if (!readFile(filePath, result))
+        {
+            std::cerr << "[could not read " << filePath << "]...";
+            return false;
+        }
+
+        size_t fileSize = result.size() - previousSize;
+        if (file < expectedFiles - 1 && fileSize != TEST_ROTATE_SECONDS * TEST_SAMPLE_RATE)
+        {
+            std::cerr << "[" << filePath << " has " << fileSize << " samples]...";
+            return false;
+        }
+    }
+
+    if (result.size() != (size_t)TEST_DURATION_SEC * TEST_SAMPLE_RATE)
+    {
+        std::cerr << "[" << result.size() << " samples written]...";
+        return false;
+    }
+    for (size_t index = 0; index < result.size(); index++)
+    {
+        if (result[index] != (short)index)
+        {
+            std::cerr << "[sample " << index << " is " << result[index] << "]...";
+            return false;
+        }
+    }
+    return true;
+}
+
+// With nothing draining the ring, anything past its capacity must be
+// dropped and counted rather than block the caller.
+bool recordingWriterDrops()
+{
+    std::string path = testPath("RecordingWriterDropTest.wav");
+    RecordingWriter writer(path, TEST_SAMPLE_RATE, SF_FORMAT_WAV | SF_FORMAT_PCM_16, 0, 0, 1);
+
+    std::vector<short> input(TEST_SAMPLE_RATE * 10, 0);
+    writer.write(&input[0], input.size());
+    uint64_t numDropped = writer.getNumSamplesDropped();
+    if (numDropped == 0 || numDropped >= input.size())
+    {
+        std::cerr << "[" << numDropped << " dropped]...";
+        return false;
+    }
+
+    if (!writer.open())
+    {
+        std::cerr << "[could not open " << path << "]...";
+        return false;
+    }
+    writer.close();
+
+    std::vector<short> result;
+    if (!readFile(path, result) || result.size() + numDropped != input.size() || writer.getNumSamplesWritten() != result.size())
+    {
+        std::cerr << "[" << result.size() << " written, " << numDropped << " dropped]...";
+        return false;
+    }
+    return true;
+}
+
+// FLAC must round trip exactly and come out smaller than the PCM would
+// be. Skipped if libsndfile was built without it.
+bool recordingWriterFlac()
+{
+    if (RecordingWriter::IsFormatSupported(SF_FORMAT_OGG | RECORDING_WRITER_FORMAT_OPUS, 44100))
+    {
+        std::cerr << "[Opus accepted at 44.1 kHz]...";
+        return false;
+    }
+
+    int format = SF_FORMAT_FLAC | SF_FORMAT_PCM_16;
+    if (!RecordingWriter::IsFormatSupported(format, TEST_SAMPLE_RATE))
+    {
+        std::cerr << "[no FLAC support, skipping]...";
+        return true;
+    }
+
+    std::string path = testPath("RecordingWriterTest.flac");
+    RecordingWriter writer(path, TEST_SAMPLE_RATE, format);
+    if (!writer.open())
+    {
+        std::cerr << "[could not open " << path << ": " << writer.getError() << "]...";
+        return false;
+    }
+
+    std::vector<short> input(TEST_SAMPLE_RATE * TEST_DURATION_SEC);
+    for (size_t index = 0; index < input.size(); index++)
+    {
+        input[index] = (short)(1000 * sin(index * 0.05));
+    }
+    writer.write(&input[0], input.size());
+    writer.close();
+
+    uint64_t numBytes = writer.getNumBytesWritten();
+    std::vector<short> result;
+    if (!readFile(path, result) || result != input)
+    {
+        std::cerr << "[read back " << result.size() << " samples]...";
+        return false;
+    }
+    if (numBytes == 0 || numBytes >= input.size() * sizeof(short))
+    {
+        std::cerr << "[" << numBytes << " bytes]...";
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    TEST_CASE(recordingWriterRotation);
+    TEST_CASE(recordingWriterDrops);
+    TEST_CASE(recordingWriterFlac);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <vector>
+#include <cmath>
+#include <thread>
+#include <chrono>
+#include "SpectrumEngine.h"
+#include "PipelineTestCommon.h"
+
+static void addTone(SpectrumEngine& engine, float freqHz, int numSamples)
+{
+    std::vector<short> samples(numSamples);
+    for (int n = 0; n < numSamples; n++)
+    {
+        samples[n] = 8000 * cos(2 * M_PI * freqHz * n / engine.getSampleRate());
+    }
+    engine.addSamples(&samples[0], numSamples);
+}
+
+static int peakBin(const std::vector<float>& magDb)
+{
+    int peak = 0;
+    for (int index = 1; index < (int)magDb.size(); index++)
+    {
+        if (magDb[index] > magDb[peak]) peak = index;
+    }
+    return peak;
+}
+
+bool spectrumEngineFindsTone()
+{
+    SpectrumEngine engine(8000, 1024);
+    std::vector<float> magDb;
+
+    engine.update();
+    if (engine.getSpectrum(magDb))
+    {
+        std::cerr << "[spectrum before enough input]...";
+        return false;
+    }
+
+    // 1000 Hz is exactly bin 128 at 7.8125 Hz/bin.
+    addTone(engine, 1000, 2000);
+    engine.update();
+    if (!engine.getSpectrum(magDb) || magDb.size() != 512)
+    {
+        std::cerr << "[no spectrum, size " << magDb.size() << "]...";
+        return false;
+    }
+
+    if (peakBin(magDb) != 128)
+    {
+        std::cerr << "[peak at bin " << peakBin(magDb) << "]...";
+        return false;
+    }
+
+    // Nothing new since the last read.
+    if (engine.getSpectrum(magDb))
+    {
+        std::cerr << "[stale spectrum reported as new]...";
+        return false;
+    }
+
+    return true;
+}
+
+bool spectrumEngineFftSizeChange()
+{
+    SpectrumEngine engine(8000, 1024);
+    std::vector<float> magDb;
+
+    engine.setFftSize(5000);
+    if (engine.getFftSize() != 4096)
+    {
+        std::cerr << "[fft size " << engine.getFftSize() << "]...";
+        return false;
+    }
+
+    // Clamped to the sizes offered in the UI.
+    engine.setFftSize(100);
+    int minSize = engine.getFftSize();
+    engine.setFftSize(1 << 20);
+    int maxSize = engine.getFftSize();
+    if (minSize != 512 || maxSize != 8192)
+    {
+        std::cerr << "[fft sizes " << minSize << " ... " << maxSize << "]...";
+        return false;
+    }
+
+    engine.setFftSize(4096);
+    addTone(engine, 1000, 8000);
+    engine.update();
+    if (!engine.getSpectrum(magDb) || magDb.size() != 2048 || peakBin(magDb) != 512)
+    {
+        std::cerr << "[size " << magDb.size() << ", peak at bin " << peakBin(magDb) << "]...";
+        return false;
+    }
+
+    return true;
+}
+
+bool spectrumEngineBackgroundUpdate()
+{
+    SpectrumEngine engine(8000, 1024, 10);
+    std::vector<float> magDb;
+
+    engine.start();
+    addTone(engine, 1000, 2000);
+
+    bool gotSpectrum = false;
+    for (int i = 0; i < 1000 && !gotSpectrum; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        gotSpectrum = engine.getSpectrum(magDb);
+    }
+    engine.stop();
+
+    if (!gotSpectrum || peakBin(magDb) != 128)
+    {
+        std::cerr << "[got " << gotSpectrum << ", peak at bin " << peakBin(magDb) << "]...";
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    TEST_CASE(spectrumEngineFindsTone);
+    TEST_CASE(spectrumEngineFftSizeChange);
+    TEST_CASE(spectrumEngineBackgroundUpdate);
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <wx/init.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/image.h>
+#include "SpectrumExporter.h"
+#include "../defines.h"
+#include "../util/WaterfallColourMap.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_SAMPLE_RATE 8000
+#define TEST_NUM_BINS 64
+#define TEST_NUM_ROWS 5
+#define TEST_COLOUR WATERFALL_COLOUR_HEATMAP
+
+static float testMagDb(int row, int bin)
+{
+    return -40.0f + (bin % 41) - row;
+}
+
+static int64_t nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// The only file matching pattern in directory, or "" if there isn't
+// exactly one.
+static std::string findFile(const wxString& directory, const wxString& pattern)
+{
+    wxArrayString files;
+    wxDir::GetAllFiles(directory, &files, pattern, wxDIR_FILES);
+    return files.GetCount() == 1 ? (const char*)files[0].ToUTF8() : "";
+}
+
+// Exports TEST_NUM_ROWS rows into a fresh directory and returns it.
+static wxString exportRows(int formats, int64_t* startMs, int64_t* endMs)
+{
+    const char* tmpDir = getenv("TMPDIR");
+    wxString directory = wxFileName(
+        wxString(tmpDir != nullptr ? tmpDir : "/tmp"),
+        wxString::Format("SpectrumExporterTest-%d", (int)(nowMs() % 1000000))).GetFullPath();
+    wxFileName::Rmdir(directory, wxPATH_RMDIR_RECURSIVE);
+    wxFileName::Mkdir(directory);
+
+    *startMs = nowMs();
+    {
+        // A zero interval, so each spectrum finishes the row before it.
+        SpectrumExporter exporter((const char*)directory.ToUTF8(), formats, 0, TEST_COLOUR, TEST_SAMPLE_RATE);
+        float magDb[TEST_NUM_BINS];
+        for (int row = 0; row <= TEST_NUM_ROWS; row++)
+        {
+            for (int bin = 0; bin < TEST_NUM_BINS; bin++)
+            {
+                magDb[bin] = testMagDb(row, bin);
+            }
+            exporter.addSpectrum(magDb, TEST_NUM_BINS);
+        }
+    }
+    *endMs = nowMs();
+    return directory;
+}
+
+bool spectrumExporterRaw()
+{
+    int64_t startMs, endMs;
+    wxString directory = exportRows(SPECTRUM_EXPORT_RAW, &startMs, &endMs);
+    std::string path = findFile(directory, "spectrum-*.bin");
+    bool ok = path != "" && findFile(directory, "*.png") == "";
+
+    FILE* file = ok ? fopen(path.c_str(), "rb") : nullptr;
+    if (file == nullptr)
+    {
+        std::cerr << "[no raw file]...";
+        ok = false;
+    }
+    else
+    {
+        char magic[8];
+        uint32_t numBins = 0;
+        float maxFreqHz = 0;
+        ok = fread(magic, 1, 8, file) == 8 && memcmp(magic, "FDVSPEC1", 8) == 0 &&
+            fread(&numBins, sizeof(numBins), 1, file) == 1 && numBins == TEST_NUM_BINS &&
+            fread(&maxFreqHz, sizeof(maxFreqHz), 1, file) == 1 && maxFreqHz == TEST_SAMPLE_RATE / 2;
+        if (!ok)
+        {
+            std::cerr << "[bad header]...";
+        }
+
+        int64_t lastMs = startMs;
+        int row = 0;
+        int64_t timestampMs;
+        float magDb[TEST_NUM_BINS];
+        while (ok && fread(&timestampMs, sizeof(timestampMs), 1, file) == 1)
+        {
+            ok = fread(magDb, sizeof(float), TEST_NUM_BINS, file) == TEST_NUM_BINS &&
+                timestampMs >= lastMs && timestampMs <= endMs;
+            for (int bin = 0; ok && bin < TEST_NUM_BINS; bin++)
+            {
+                ok = magDb[bin] == testMagDb(row, bin);
+            }
+            if (!ok)
+            {
+                std::cerr << "[row " << row << " differs]...";
+            }
+            lastMs = timestampMs;
+            row++;
+        }
+        fclose(file);
+
+        // The last spectrum is still being collected when we stop.
+        if (ok && row != TEST_NUM_ROWS)
+        {
+            std::cerr << "[" << row << " rows]...";
+            ok = false;
+        }
+    }
+
+    wxFileName::Rmdir(directory, wxPATH_RMDIR_RECURSIVE);
+    return ok;
+}
+
+bool spectrumExporterPng()
+{
+    int64_t startMs, endMs;
+    wxString directory = exportRows(SPECTRUM_EXPORT_PNG, &startMs, &endMs);
+    std::string path = findFile(directory, "waterfall-*.png");
+    bool ok = path != "" && findFile(directory, "*.bin") == "";
+
+    wxImage image;
+    if (!ok || !image.LoadFile(wxString::FromUTF8(path.c_str()), wxBITMAP_TYPE_PNG))
+    {
+        std::cerr << "[no tile]...";
+        ok = false;
+    }
+    else if (image.GetWidth() != TEST_NUM_BINS || image.GetHeight() != TEST_NUM_ROWS)
+    {
+        std::cerr << "[tile is " << image.GetWidth() << "x" << image.GetHeight() << "]...";
+        ok = false;
+    }
+
+    // Oldest row at the top, with the waterfall's automatic contrast:
+    // the 20 dB below a slowly tracked peak of 200 ... 2800 Hz.
+    const unsigned char (*lut)[3] = WaterfallColourMap(TEST_COLOUR);
+    float binsPerHz = (float)TEST_NUM_BINS / (TEST_SAMPLE_RATE / 2);
+    float maxMag = MAX_MAG_DB;
+    for (int row = 0; ok && row < TEST_NUM_ROWS; row++)
+    {
+        float rowMax = MIN_MAG_DB;
+        for (int bin = (int)(200 * binsPerHz); bin < (int)(2800 * binsPerHz); bin++)
+        {
+            rowMax = std::max(rowMax, testMagDb(row, bin));
+        }
+        maxMag = BETA * maxMag + (1 - BETA) * rowMax;
+        float minMag = maxMag - 20.0;
+
+        for (int bin = 0; ok && bin < TEST_NUM_BINS; bin++)
+        {
+            float val = (float)256 / (maxMag - minMag) * (testMagDb(row, bin) - minMag);
+            int index = (int)std::min(std::max(val, 0.0f), 255.0f);
+            ok = image.GetRed(bin, row) == lut[index][0] &&
+                image.GetGreen(bin, row) == lut[index][1] &&
+                image.GetBlue(bin, row) == lut[index][2];
+            if (!ok)
+            {
+                std::cerr << "[pixel " << bin << "," << row << " differs]...";
+            }
+        }
+    }
+
+    wxFileName::Rmdir(directory, wxPATH_RMDIR_RECURSIVE);
+    return ok;
+}
+
+int main()
+{
+    wxInitializer initializer;
+
+    TEST_CASE(spectrumExporterRaw);
+    TEST_CASE(spectrumExporterPng);
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "../util/SpscRingBuffer.h"
+#include "PipelineTestCommon.h"
+
+// Deliberately not a power of two and not a multiple of any of the block
+// sizes below, so the spans wrap at every possible offset.
+#define TEST_CAPACITY 1000
+#define TEST_NUM_VALUES 1000000
+
+// Mixes copying and in place access on both sides. Run under
+// ThreadSanitizer (cmake -DSANITIZE_THREAD=1 -DUNITTEST=1) to check the ordering.
+static void producerEntry(SpscRingBuffer<uint32_t>* ring, uint32_t numValues, bool clearing)
+{
+    uint32_t next = 0;
+    uint32_t blockSize = 1;
+    uint32_t buffer[TEST_CAPACITY];
+    while (next < numValues)
+    {
+        blockSize = (blockSize * 7 + 3) % 97 + 1;
+        if (blockSize & 1)
+        {
+            uint32_t* ptr;
+            size_t span = std::min((size_t)std::min(blockSize, numValues - next), ring->getWriteSpan(&ptr));
+            for (size_t i = 0; i < span; i++)
+            {
+                ptr[i] = next++;
+            }
+            ring->commitWrite(span);
+        }
+        else
+        {
+            uint32_t count = std::min(blockSize, numValues - next);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                buffer[i] = next + i;
+            }
+            next += ring->write(buffer, count);
+        }
+
+        // Never after the last value, so the consumer knows when to stop.
+        if (clearing && next < numValues && (next % 10007) < blockSize)
+        {
+            ring->requestClear();
+        }
+    }
+}
+
+static bool consumeAll(SpscRingBuffer<uint32_t>& ring, uint32_t numValues, bool allowGaps)
+{
+    uint32_t expected = 0;
+    uint32_t blockSize = 1;
+    uint32_t buffer[TEST_CAPACITY];
+    while (expected < numValues)
+    {
+        if (ring.numUsed() > ring.capacity())
+        {
+            std::cerr << "[used " << ring.numUsed() << " > capacity]...";
+            return false;
+        }
+
+        blockSize = (blockSize * 5 + 1) % 89 + 1;
+        const uint32_t* data;
+        size_t count;
+        if (blockSize & 1)
+        {
+            count = std::min((size_t)blockSize, ring.getReadSpan(&data));
+        }
+        else
+        {
+            count = ring.read(buffer, blockSize);
+            data = buffer;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            bool ok = allowGaps ? data[i] >= expected : data[i] == expected;
+            if (!ok)
+            {
+                std::cerr << "[got " << data[i] << ", expected " << expected << "]...";
+                return false;
+            }
+            expected = data[i] + 1;
+        }
+
+        if (blockSize & 1)
+        {
+            ring.commitRead(count);
+        }
+        if (count == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    return true;
+}
+
+bool ringBufferCapacity()
+{
+    SpscRingBuffer<uint32_t> ring(TEST_CAPACITY);
+    uint32_t buffer[TEST_CAPACITY + 100] = {0};
+
+    if (ring.numFree() != TEST_CAPACITY || ring.write(buffer, TEST_CAPACITY + 100) != TEST_CAPACITY)
+    {
+        std::cerr << "[could write more than the capacity]...";
+        return false;
+    }
+
+    ring.requestClear();
+    if (ring.numUsed() != 0)
+    {
+        std::cerr << "[requestClear() didn't empty the ring]...";
+        return false;
+    }
+
+    const uint32_t* data;
+    if (ring.getReadSpan(&data) != 0 || ring.numFree() != TEST_CAPACITY)
+    {
+        std::cerr << "[space not freed after requestClear()]...";
+        return false;
+    }
+    return true;
+}
+
+bool ringBufferStress()
+{
+    SpscRingBuffer<uint32_t> ring(TEST_CAPACITY);
+    std::thread producer(producerEntry, &ring, TEST_NUM_VALUES, false);
+    bool result = consumeAll(ring, TEST_NUM_VALUES, false);
+    producer.join();
+    return result && ring.numUsed() == 0;
+}
+
+bool ringBufferStressWithClears()
+{
+    SpscRingBuffer<uint32_t> ring(TEST_CAPACITY);
+    std::thread producer(producerEntry, &ring, TEST_NUM_VALUES, true);
+    bool result = consumeAll(ring, TEST_NUM_VALUES, true);
+    producer.join();
+    return result;
+}
+
+// As TxRxThread and the audio callbacks use the output FIFOs: the producer
+// writes whole frames while numFree() says there's room, and the consumer
+// only reads once a whole buffer is queued.
+#define TEST_FRAME_SIZE 10
+#define TEST_CALLBACK_SIZE 100
+
+static void frameProducerEntry(SpscRingBuffer<uint32_t>* ring, uint32_t numValues,
+    std::atomic<size_t>* numShortWrites, std::atomic<bool>* stalled, std::atomic<bool>* done)
+{
+    uint32_t buffer[TEST_FRAME_SIZE] = {0};
+    uint32_t written = 0;
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (written < numValues)
+    {
+        if (ring->numFree() >= TEST_FRAME_SIZE)
+        {
+            size_t count = ring->write(buffer, TEST_FRAME_SIZE);
+            if (count != TEST_FRAME_SIZE)
+            {
+                (*numShortWrites)++;
+            }
+            written += count;
+            if (count > 0)
+            {
+                lastProgress = std::chrono::steady_clock::now();
+            }
+            if ((written / TEST_FRAME_SIZE) % 53 == 0)
+            {
+                ring->requestClear();
+            }
+        }
+        else if (std::chrono::steady_clock::now() - lastProgress > std::chrono::seconds(2))
+        {
+            *stalled = true;
+            break;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    *done = true;
+}
+
+bool ringBufferAllOrNothingConsumer()
+{
+    SpscRingBuffer<uint32_t> ring(TEST_CAPACITY);
+    uint32_t buffer[TEST_CAPACITY] = {0};
+
+    // Nearly full when the producer asks for a clear, then a frame more.
+    ring.write(buffer, TEST_CAPACITY - TEST_FRAME_SIZE);
+    ring.requestClear();
+    if (ring.numFree() != TEST_FRAME_SIZE || ring.write(buffer, TEST_FRAME_SIZE) != TEST_FRAME_SIZE)
+    {
+        std::cerr << "[numFree() " << ring.numFree() << " doesn't match what write() takes]...";
+        return false;
+    }
+
+    // Not enough for the consumer to read, but it still frees the space.
+    if (ring.numUsed() != TEST_FRAME_SIZE || ring.numFree() != TEST_CAPACITY - TEST_FRAME_SIZE)
+    {
+        std::cerr << "[clear not applied by the consumer: used " << ring.numUsed()
+            << ", free " << ring.numFree() << "]...";
+        return false;
+    }
+
+    std::atomic<size_t> numShortWrites(0);
+    std::atomic<bool> stalled(false);
+    std::atomic<bool> done(false);
+    std::thread producer(frameProducerEntry, &ring, TEST_NUM_VALUES, &numShortWrites, &stalled, &done);
+    while (!done)
+    {
+        if (ring.numUsed() >= TEST_CALLBACK_SIZE)
+        {
+            ring.read(buffer, TEST_CALLBACK_SIZE);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    if (stalled || numShortWrites > 0)
+    {
+        std::cerr << "[stalled: " << stalled << ", short writes: " << numShortWrites << "]...";
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    TEST_CASE(ringBufferCapacity);
+    TEST_CASE(ringBufferStress);
+    TEST_CASE(ringBufferStressWithClears);
+    TEST_CASE(ringBufferAllOrNothingConsumer);
+    return 0;
+}
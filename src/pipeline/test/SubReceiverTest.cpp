@@ -0,0 +1,193 @@
+#include <vector>
+#include "paCallbackData.h"
+#include "SubReceiverMixer.h"
+#include "../audio/test/TestAudioDevice.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_FIFO_SIZE 1000
+#define TEST_BLOCK_SIZE 128
+#define TEST_FRAME_SIZE 160
+#define TEST_MAX_PENDING (TEST_FRAME_SIZE * 4)
+
+static short leftSample(int n) { return (short)(n % 30000); }
+static short rightSample(int n) { return (short)(-1 - n % 30000); }
+
+// The radio input device and callback as main.cpp sets them up with the
+// sub receiver enabled.
+struct DualRxInput
+{
+    DualRxInput()
+        : device(2)
+        , numFull(0)
+    {
+        cbData.infifo1.reset(new SpscRingBuffer<short>(TEST_FIFO_SIZE));
+        cbData.infifo1Sub.reset(new SpscRingBuffer<short>(TEST_FIFO_SIZE));
+
+        IAudioDevice::AudioDataFormat format;
+        format.numChannels = 2;
+        format.planar = true;
+        device.setAudioDataFormat(format);
+        device.setOnAudioData([&](IAudioDevice& dev, void* data, size_t size, void* state) {
+            paCallBackData* cbData = static_cast<paCallBackData*>(state);
+            if (!cbData->writeRadioInput(static_cast<short*>(data), size, dev.getCallbackTiming().bufferTimeUs))
+            {
+                numFull++;
+            }
+        }, &cbData);
+    }
+
+    // Interleaved stereo from the sound card, starting at frame first.
+    void capture(int first, int numFrames)
+    {
+        std::vector<short> buffer(numFrames * 2);
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            buffer[frame * 2] = leftSample(first + frame);
+            buffer[frame * 2 + 1] = rightSample(first + frame);
+        }
+        device.input(&buffer[0], numFrames);
+    }
+
+    TestAudioDevice device;
+    paCallBackData cbData;
+    int numFull;
+};
+
+bool subReceiverSplitsChannels()
+{
+    DualRxInput input;
+    int captured = 0;
+    int read = 0;
+    std::vector<short> main(TEST_FRAME_SIZE);
+    std::vector<short> sub(TEST_FRAME_SIZE);
+    for (int block = 0; block < 50; block++)
+    {
+        input.capture(captured, TEST_BLOCK_SIZE);
+        captured += TEST_BLOCK_SIZE;
+
+        // As TxRxThread: the sub FIFO is read in step with the main one.
+        while (input.cbData.infifo1->numUsed() >= TEST_FRAME_SIZE)
+        {
+            if (input.cbData.infifo1Sub->numUsed() < TEST_FRAME_SIZE)
+            {
+                std::cerr << "[infifo1Sub behind infifo1]...";
+                return false;
+            }
+            input.cbData.infifo1->read(&main[0], TEST_FRAME_SIZE);
+            input.cbData.infifo1Sub->read(&sub[0], TEST_FRAME_SIZE);
+            for (int index = 0; index < TEST_FRAME_SIZE; index++)
+            {
+                if (main[index] != leftSample(read + index) || sub[index] != rightSample(read + index))
+                {
+                    std::cerr << "[sample " << read + index << ": got " << main[index] << "/" << sub[index] << "]...";
+                    return false;
+                }
+            }
+            read += TEST_FRAME_SIZE;
+        }
+    }
+    return input.numFull == 0 && read > 0;
+}
+
+bool subReceiverFullFifoDropsBoth()
+{
+    DualRxInput input;
+
+    // Nearly fill the sub FIFO only, so the next block fits in infifo1
+    // but not infifo1Sub.
+    std::vector<short> filler(TEST_FIFO_SIZE - TEST_BLOCK_SIZE / 2);
+    input.cbData.infifo1Sub->write(&filler[0], filler.size());
+    input.capture(0, TEST_BLOCK_SIZE);
+
+    return input.numFull == 1 && input.cbData.infifo1->numUsed() == 0 &&
+        input.cbData.infifo1Sub->numUsed() == filler.size();
+}
+
+bool subReceiverMixes()
+{
+    SubReceiverMixer mixer(TEST_MAX_PENDING);
+    std::vector<short> main(TEST_FRAME_SIZE, 1000);
+    std::vector<short> sub(TEST_FRAME_SIZE * 2, 0);
+    for (size_t index = 0; index < sub.size(); index++)
+    {
+        sub[index] = (short)index;
+    }
+
+    // The sub receiver gets two frames ahead; they're played in order.
+    const short* output = mixer.mix(&main[0], TEST_FRAME_SIZE, &sub[0], sub.size());
+    for (int index = 0; index < TEST_FRAME_SIZE; index++)
+    {
+        if (output[index] != 1000 + index || main[index] != 1000)
+        {
+            std::cerr << "[first frame, sample " << index << " is " << output[index] << "]...";
+            return false;
+        }
+    }
+    output = mixer.mix(&main[0], TEST_FRAME_SIZE, nullptr, 0);
+    for (int index = 0; index < TEST_FRAME_SIZE; index++)
+    {
+        if (output[index] != 1000 + TEST_FRAME_SIZE + index)
+        {
+            std::cerr << "[second frame, sample " << index << " is " << output[index] << "]...";
+            return false;
+        }
+    }
+
+    // Nothing pending: the main receiver's audio as is.
+    output = mixer.mix(&main[0], TEST_FRAME_SIZE, nullptr, 0);
+    for (int index = 0; index < TEST_FRAME_SIZE; index++)
+    {
+        if (output[index] != 1000)
+        {
+            std::cerr << "[unmixed sample " << index << " is " << output[index] << "]...";
+            return false;
+        }
+    }
+    return mixer.getNumPending() == 0;
+}
+
+bool subReceiverMixLimits()
+{
+    SubReceiverMixer mixer(TEST_MAX_PENDING);
+
+    // No main receiver audio for a while: only the newest is kept.
+    std::vector<short> sub(TEST_FRAME_SIZE, 0);
+    for (int frame = 0; frame < 10; frame++)
+    {
+        std::fill(sub.begin(), sub.end(), (short)frame);
+        mixer.mix(nullptr, 0, &sub[0], TEST_FRAME_SIZE);
+    }
+    if (mixer.getNumPending() != TEST_MAX_PENDING)
+    {
+        std::cerr << "[" << mixer.getNumPending() << " pending]...";
+        return false;
+    }
+
+    std::vector<short> main(TEST_FRAME_SIZE, 32767);
+    const short* output = mixer.mix(&main[0], TEST_FRAME_SIZE, nullptr, 0);
+    if (output[0] != 32767)
+    {
+        std::cerr << "[not clipped: " << output[0] << "]...";
+        return false;
+    }
+
+    std::fill(main.begin(), main.end(), 0);
+    output = mixer.mix(&main[0], TEST_FRAME_SIZE, nullptr, 0);
+    if (output[0] != 10 - TEST_MAX_PENDING / TEST_FRAME_SIZE + 1)
+    {
+        std::cerr << "[oldest kept frame is " << output[0] << "]...";
+        return false;
+    }
+
+    mixer.clear();
+    return mixer.getNumPending() == 0;
+}
+
+int main()
+{
+    TEST_CASE(subReceiverSplitsChannels);
+    TEST_CASE(subReceiverFullFifoDropsBoth);
+    TEST_CASE(subReceiverMixes);
+    TEST_CASE(subReceiverMixLimits);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <vector>
+#include "VoiceKeyerCache.h"
+#include "PipelineTestCommon.h"
+
+#define TEST_BLOCK_SIZE 960
+#define TEST_NUM_BLOCKS 50
+
+// Captures TEST_NUM_BLOCKS blocks where sample n is (short)n.
+static void captureBlocks(VoiceKeyerCache& cache, bool complete)
+{
+    short block[TEST_BLOCK_SIZE];
+    for (int blockIndex = 0; blockIndex < TEST_NUM_BLOCKS; blockIndex++)
+    {
+        for (int index = 0; index < TEST_BLOCK_SIZE; index++)
+        {
+            block[index] = (short)(blockIndex * TEST_BLOCK_SIZE + index);
+        }
+        cache.capture(block, TEST_BLOCK_SIZE);
+    }
+
+    if (complete)
+    {
+        cache.markComplete();
+    }
+    cache.stop();
+}
+
+bool voiceKeyerCacheReplay()
+{
+    VoiceKeyerCache cache;
+    cache.start("key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS);
+    if (!cache.isCapturing())
+    {
+        std::cerr << "[not capturing]...";
+        return false;
+    }
+    captureBlocks(cache, true);
+
+    cache.start("key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS);
+    if (!cache.isReplaying())
+    {
+        std::cerr << "[not replaying]...";
+        return false;
+    }
+
+    // Different block size to the capture, plus a bit past the end.
+    int replayBlockSize = 700;
+    int numCompletions = 0;
+    for (int position = 0; position < (TEST_NUM_BLOCKS + 2) * TEST_BLOCK_SIZE; position += replayBlockSize)
+    {
+        bool isComplete;
+        auto block = cache.replay(replayBlockSize, &isComplete);
+        numCompletions += isComplete;
+
+        for (int index = 0; index < replayBlockSize; index++)
+        {
+            int samplePosition = position + index;
+            short expected = samplePosition < TEST_NUM_BLOCKS * TEST_BLOCK_SIZE ? (short)samplePosition : 0;
+            if (block.get()[index] != expected)
+            {
+                std::cerr << "[sample " << samplePosition << " is " << block.get()[index] << "]...";
+                return false;
+            }
+        }
+    }
+    cache.stop();
+
+    return numCompletions == 1;
+}
+
+bool voiceKeyerCacheInvalidation()
+{
+    VoiceKeyerCache cache;
+
+    // Interrupted transmissions aren't kept.
+    cache.start("key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS);
+    captureBlocks(cache, false);
+    cache.start("key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS);
+    if (!cache.isCapturing())
+    {
+        std::cerr << "[kept incomplete capture]...";
+        return false;
+    }
+
+    // Nor ones that didn't fit.
+    cache.stop();
+    cache.start("key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS - 1);
+    captureBlocks(cache, true);
+    cache.start("key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS);
+    if (!cache.isCapturing())
+    {
+        std::cerr << "[kept overflowed capture]...";
+        return false;
+    }
+
+    // A different key (e.g. changed TX settings) means starting over.
+    captureBlocks(cache, true);
+    cache.start("other key", TEST_BLOCK_SIZE * TEST_NUM_BLOCKS);
+    if (!cache.isCapturing())
+    {
+        std::cerr << "[replayed for a different key]...";
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    TEST_CASE(voiceKeyerCacheReplay);
+    TEST_CASE(voiceKeyerCacheInvalidation);
+    return 0;
+}
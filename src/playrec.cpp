@@ -8,33 +8,34 @@
 #include "main.h"
 
 extern wxMutex g_mutexProtectingCallbackData;
-SNDFILE            *g_sfPlayFile;
+PlaybackSource     *g_playSource;
 bool                g_playFileToMicIn;
 bool                g_loopPlayFileToMicIn;
 int                 g_playFileToMicInEventId;
 
-SNDFILE            *g_sfRecFile;
+RecordingWriter    *g_recWriter;
 bool                g_recFileFromRadio;
 unsigned int        g_recFromRadioSamples;
 int                 g_recFileFromRadioEventId;
 
-SNDFILE            *g_sfRecMicFile;
+RecordingWriter    *g_recMicWriter;
 bool                g_recFileFromMic;
 
-SNDFILE            *g_sfPlayFileFromRadio;
+PlaybackSource     *g_playSourceFromRadio;
 bool                g_playFileFromRadio;
 int                 g_sfFs;
 int                 g_sfTxFs;
 bool                g_loopPlayFileFromRadio;
 int                 g_playFileFromRadioEventId;
 
-SNDFILE            *g_sfRecFileFromModulator;
+RecordingWriter    *g_recWriterFromModulator;
 bool                g_recFileFromModulator = false;
 int                 g_recFromModulatorSamples;
 int                 g_recFileFromModulatorEventId;
 
 extern FreeDVInterface freedvInterface;
 extern bool g_tx;
+extern VoiceKeyerCache g_voiceKeyerCache;
 
 // extra panel added to file open dialog to add loop checkbox
 MyExtraPlayFilePanel::MyExtraPlayFilePanel(wxWindow *parent): wxPanel(parent)
@@ -56,27 +57,39 @@ static wxWindow* createMyExtraPlayFilePanel(wxWindow *parent)
 
 void MainFrame::StopPlayFileToMicIn(void)
 {
+    PlaybackSource* source = nullptr;
     g_mutexProtectingCallbackData.Lock();
     if (g_playFileToMicIn)
     {
         g_playFileToMicIn = false;
-        sf_close(g_sfPlayFile);
-        g_sfPlayFile = nullptr;
+        source = g_playSource;
+        g_playSource = nullptr;
+        
+        // Keeps the voice keyer capture if the file went out in full.
+        g_voiceKeyerCache.stop();
+    }
+    g_mutexProtectingCallbackData.Unlock();
+
+    if (source != nullptr)
+    {
+        // Not under the lock as it may need to wait for the prefetch thread.
+        delete source;
         SetStatusText(wxT(""));
         VoiceKeyerProcessEvent(VK_PLAY_FINISHED);
     }
-    g_mutexProtectingCallbackData.Unlock();
 }
 
 void MainFrame::StopPlaybackFileFromRadio()
 {
     g_mutexProtectingCallbackData.Lock();
     g_playFileFromRadio = false;
-    sf_close(g_sfPlayFileFromRadio);
-    g_sfPlayFileFromRadio = nullptr;
+    PlaybackSource* source = g_playSourceFromRadio;
+    g_playSourceFromRadio = nullptr;
+    g_mutexProtectingCallbackData.Unlock();
+
+    delete source;
     SetStatusText(wxT(""));
     m_menuItemPlayFileFromRadio->SetItemLabel(wxString(_("Start Play File - From Radio...")));
-    g_mutexProtectingCallbackData.Unlock();
 }
 
 //-------------------------------------------------------------------------
@@ -97,14 +110,14 @@ void MainFrame::OnPlayFileFromRadio(wxCommandEvent& event)
     else
     {
         wxString    soundFile;
-        SF_INFO     sfInfo;
+        int         rawSampleRate = 0;
 
         wxFileDialog openFileDialog(
                                     this,
                                     wxT("Play File - From Radio"),
                                     wxGetApp().appConfiguration.playFileFromRadioPath,
                                     wxEmptyString,
-                                    wxT("WAV and RAW files (*.wav;*.raw)|*.wav;*.raw|")
+                                    wxT("Sound files (*.wav;*.raw;*.flac;*.opus;*.ogg)|*.wav;*.raw;*.flac;*.opus;*.ogg|")
                                     wxT("All files (*.*)|*.*"),
                                     wxFD_OPEN | wxFD_FILE_MUST_EXIST
                                     );
@@ -121,26 +134,26 @@ void MainFrame::OnPlayFileFromRadio(wxCommandEvent& event)
         soundFile = openFileDialog.GetPath();
         wxString tmpString = wxGetApp().appConfiguration.playFileFromRadioPath;
         wxFileName::SplitPath(soundFile, &tmpString, &fileName, &extension);
-        sfInfo.format = 0;
 
         if(!extension.IsEmpty())
         {
             extension.LowerCase();
             if(extension == wxT("raw"))
             {
-                sfInfo.format     = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
-                sfInfo.channels   = 1;
-                sfInfo.samplerate = freedvInterface.getRxModemSampleRate();
+                rawSampleRate = freedvInterface.getRxModemSampleRate();
             }
         }
-        g_sfPlayFileFromRadio = sf_open(soundFile.c_str(), SFM_READ, &sfInfo);
-        g_sfFs = sfInfo.samplerate;
-        if(g_sfPlayFileFromRadio == NULL)
+
+        // Decoded up front (or read ahead for long files) so the RX
+        // thread never waits on the disk.
+        PlaybackSource* source = new PlaybackSource(soundFile.ToStdString(), rawSampleRate);
+        if (!source->open())
         {
-            wxString strErr = sf_strerror(NULL);
-            wxMessageBox(strErr, wxT("Couldn't open sound file"), wxOK);
+            wxMessageBox(source->getError(), wxT("Couldn't open sound file"), wxOK);
+            delete source;
             return;
         }
+        g_sfFs = source->getSampleRate();
         
         // Save path for future use
         wxGetApp().appConfiguration.playFileFromRadioPath = tmpString;
@@ -149,17 +162,19 @@ void MainFrame::OnPlayFileFromRadio(wxCommandEvent& event)
 
         // Huh?! I just copied wxWidgets-2.9.4/samples/dialogs ....
         g_loopPlayFileFromRadio = static_cast<MyExtraPlayFilePanel*>(ctrl)->getLoopPlayFileToMicIn();
+        source->setLoop(g_loopPlayFileFromRadio);
+        g_playSourceFromRadio = source;
 
         wxString statusText = "";
         if(extension == wxT("raw")) {
-            statusText = wxString::Format(wxT("Playing raw file %s as radio input (assuming Fs=%d)"), soundFile, (int)sfInfo.samplerate);
+            statusText = wxString::Format(wxT("Playing raw file %s as radio input (assuming Fs=%d)"), soundFile, g_sfFs);
         }
         else
         {
             statusText = wxString::Format(wxT("Playing file %s as radio input"), soundFile);
         }
         SetStatusText(statusText, 0);
-        if (g_verbose) fprintf(stderr, "OnPlayFileFromRadio:: Playing File Fs = %d\n", (int)sfInfo.samplerate);
+        if (g_verbose) fprintf(stderr, "OnPlayFileFromRadio:: Playing File Fs = %d\n", g_sfFs);
         m_menuItemPlayFileFromRadio->SetItemLabel(wxString(_("Stop Play File - From Radio...")));
         g_playFileFromRadio = true;
     }
@@ -186,22 +201,75 @@ static wxWindow* createMyExtraRecFilePanel(wxWindow *parent)
     return new MyExtraRecFilePanel(parent);
 }
 
+// Format and file extension for quick recordings (recordingFormat).
+static int getQuickRecordFormat(wxString* extension)
+{
+    switch (wxGetApp().appConfiguration.recordingFormat)
+    {
+        case 1:
+            *extension = wxT("flac");
+            return SF_FORMAT_FLAC | SF_FORMAT_PCM_16;
+        case 2:
+            *extension = wxT("opus");
+            return SF_FORMAT_OGG | RECORDING_WRITER_FORMAT_OPUS;
+        default:
+            *extension = wxT("wav");
+            return SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    }
+}
+
+// Radio recordings start a new file every so often if configured.
+static RecordingWriter* createRadioRecording(wxString soundFile, int sampleRate, int format)
+{
+    return new RecordingWriter(
+        soundFile.ToStdString(), sampleRate, format,
+        wxGetApp().appConfiguration.recordingRotateMinutes * 60,
+        (int64_t)wxGetApp().appConfiguration.recordingRotateMegabytes * 1024 * 1024);
+}
+
 void MainFrame::StopRecFileFromRadio()
 {
-    if (g_sfRecFile != nullptr)
+    if (g_recWriter != nullptr)
     {
         if (g_verbose) fprintf(stderr, "Stopping Record....\n");
         g_mutexProtectingCallbackData.Lock();
         g_recFileFromRadio = false;
         g_recFileFromModulator = false;
-        sf_close(g_sfRecFile);
-        g_sfRecFile = nullptr;
-        g_sfRecFileFromModulator = nullptr;
-        SetStatusText(wxT(""));
+        RecordingWriter* writer = g_recWriter;
+        g_recWriter = nullptr;
+        g_recWriterFromModulator = nullptr;
         
         m_menuItemRecFileFromRadio->SetItemLabel(wxString(_("Start Record File - From Radio...")));
         g_mutexProtectingCallbackData.Unlock();
         
+        // Not under the lock, as this waits for the rest of the audio
+        // to be written.
+        writer->close();
+
+        // Size and encoder load, so the formats can be compared.
+        double seconds = (double)writer->getNumSamplesWritten() / writer->getSampleRate();
+        double megabytes = writer->getNumBytesWritten() / 1e6;
+        double kbps = seconds > 0 ? writer->getNumBytesWritten() * 8 / seconds / 1000 : 0;
+        double cpuPercent = seconds > 0 ? 100 * writer->getEncodeSeconds() / seconds : 0;
+        fprintf(stderr, "Recording stopped: %llu samples written to %d file(s) (format 0x%x), %llu dropped, "
+            "%.2f MB (%.0f kbit/s), %.2f s encoding (%.2f%% of one CPU)\n",
+            (unsigned long long)writer->getNumSamplesWritten(), writer->getNumFiles(), writer->getFormat(),
+            (unsigned long long)writer->getNumSamplesDropped(), megabytes, kbps,
+            writer->getEncodeSeconds(), cpuPercent);
+        if (writer->getNumSamplesDropped() > 0)
+        {
+            SetStatusText(wxString::Format(
+                wxT("Recording stopped: %.1f seconds of audio dropped (disk too slow)"),
+                (double)writer->getNumSamplesDropped() / writer->getSampleRate()));
+        }
+        else
+        {
+            SetStatusText(wxString::Format(
+                wxT("Recording stopped: %.0f s, %.1f MB (%.0f kbit/s), encoding used %.1f%% CPU"),
+                seconds, megabytes, kbps, cpuPercent));
+        }
+        delete writer;
+        
         m_audioRecord->SetValue(false);
         m_audioRecord->SetBackgroundColour(wxNullColour);
     }
@@ -214,7 +282,7 @@ void MainFrame::OnRecFileFromRadio(wxCommandEvent& event)
 {
     wxUnusedVar(event);
 
-    if (g_sfRecFile != nullptr) {
+    if (g_recWriter != nullptr) {
         StopRecFileFromRadio();
     }
     else {
@@ -228,6 +296,8 @@ void MainFrame::OnRecFileFromRadio(wxCommandEvent& event)
                                     wxGetApp().appConfiguration.recFileFromRadioPath,
                                     wxT("Untitled.wav"),
                                     wxT("WAV and RAW files (*.wav;*.raw)|*.wav;*.raw|")
+                                    wxT("FLAC files (*.flac)|*.flac|")
+                                    wxT("Opus files (*.opus;*.ogg)|*.opus;*.ogg|")
                                     wxT("All files (*.*)|*.*"),
                                     wxFD_SAVE
                                     );
@@ -267,6 +337,18 @@ void MainFrame::OnRecFileFromRadio(wxCommandEvent& event)
                 sfInfo.format     = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
                 sfInfo.channels   = 1;
                 sfInfo.samplerate = sample_rate;
+            }
+            else if(extension == wxT("flac"))
+            {
+                sfInfo.format     = SF_FORMAT_FLAC | SF_FORMAT_PCM_16;
+                sfInfo.channels   = 1;
+                sfInfo.samplerate = sample_rate;
+            }
+            else if(extension == wxT("opus") || extension == wxT("ogg"))
+            {
+                sfInfo.format     = SF_FORMAT_OGG | RECORDING_WRITER_FORMAT_OPUS;
+                sfInfo.channels   = 1;
+                sfInfo.samplerate = sample_rate;
             } else {
                 wxMessageBox(wxT("Invalid file format"), wxT("Record File From Radio"), wxOK);
                 return;
@@ -301,20 +383,21 @@ void MainFrame::OnRecFileFromRadio(wxCommandEvent& event)
         }
 #endif
 
-        g_sfRecFile = sf_open(soundFile.c_str(), SFM_WRITE, &sfInfo);
-        if(g_sfRecFile == NULL)
+        RecordingWriter* writer = createRadioRecording(soundFile, sample_rate, sfInfo.format);
+        if (!writer->open())
         {
-            wxString strErr = sf_strerror(NULL);
-            wxMessageBox(strErr, wxT("Couldn't open sound file"), wxOK);
+            wxMessageBox(writer->getError(), wxT("Couldn't open sound file"), wxOK);
+            delete writer;
             return;
         }
+        g_recWriter = writer;
         
         // Save path for future use
         wxGetApp().appConfiguration.recFileFromRadioPath = tmpString;
 
         SetStatusText(wxT("Recording file ") + fileName + wxT(" from radio") , 0);
         m_menuItemRecFileFromRadio->SetItemLabel(wxString(_("Stop Record File - From Radio...")));
-        g_sfRecFileFromModulator = g_sfRecFile;
+        g_recWriterFromModulator = g_recWriter;
         
         if (!g_tx)
         {
@@ -334,34 +417,35 @@ void MainFrame::OnRecFileFromRadio(wxCommandEvent& event)
 
 void MainFrame::OnTogBtnRecord( wxCommandEvent& event )
 {
-    if (g_sfRecFile != nullptr) 
+    if (g_recWriter != nullptr) 
     {
         StopRecFileFromRadio();
     }
     else
     {
+        wxString extension;
+        int format = getQuickRecordFormat(&extension);
         auto currentTime = wxDateTime::Now().Format(_("%Y%m%d-%H%M%S"));
-        wxFileName filePath(wxGetApp().appConfiguration.quickRecordPath, wxString::Format(_("FreeDV_FromRadio_%s.wav"), currentTime));
+        wxFileName filePath(wxGetApp().appConfiguration.quickRecordPath, wxString::Format(_("FreeDV_FromRadio_%s.%s"), currentTime, extension));
         wxString    soundFile = filePath.GetFullPath();
-        SF_INFO     sfInfo;
-    
-        sfInfo.format     = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
-        sfInfo.channels   = 1;
-        sfInfo.samplerate = wxGetApp().appConfiguration.audioConfiguration.soundCard1In.sampleRate;
     
         g_recFromRadioSamples = UINT32_MAX; // record until stopped
     
-        g_sfRecFile = sf_open(soundFile.c_str(), SFM_WRITE, &sfInfo);
-        if(g_sfRecFile == NULL)
+        RecordingWriter* writer = createRadioRecording(
+            soundFile, 
+            wxGetApp().appConfiguration.audioConfiguration.soundCard1In.sampleRate,
+            format);
+        if (!writer->open())
         {
-            wxString strErr = sf_strerror(NULL);
-            wxMessageBox(strErr, wxT("Couldn't open sound file"), wxOK);
+            wxMessageBox(writer->getError(), wxT("Couldn't open sound file"), wxOK);
+            delete writer;
             return;
         }
+        g_recWriter = writer;
 
         SetStatusText(wxT("Recording file ") + soundFile + wxT(" from radio"), 0);
         m_menuItemRecFileFromRadio->SetItemLabel(wxString(_("Stop Record File - From Radio...")));
-        g_sfRecFileFromModulator = g_sfRecFile;
+        g_recWriterFromModulator = g_recWriter;
         
         if (!g_tx)
         {
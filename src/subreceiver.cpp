@@ -0,0 +1,205 @@
+/*
+   subreceiver.cpp
+
+   Sub receiver: decodes the right channel of the radio sound card
+   alongside the main receiver on the left (see dualReceiverEnabled).
+*/
+
+#include "main.h"
+#include "codec2_fdmdv.h"
+#include "pipeline/SpectrumEngine.h"
+
+// Sub receiver counterparts of freedvInterface, g_spectrumEngine, g_State
+// and g_sig_pwr_av. g_spectrumEngineSub is only non-null while the sub
+// receiver is running, which is how TxRxThread knows to decode it.
+FreeDVInterface     freedvInterfaceSub;
+SpectrumEngine*     g_spectrumEngineSub = nullptr;
+int                 g_StateSub;
+float               g_sig_pwr_avSub = 0.0;
+
+// Received text, if not using reliable text.
+static struct FIFO* g_rxDataOutFifoSub = nullptr;
+
+extern FreeDVInterface freedvInterface;
+extern int          g_mode;
+extern int          g_freedv_verbose;
+
+// Maximum characters of received text shown.
+#define SUB_RX_TEXT_LENGTH 40
+
+static void putNextRxCharSub(void *callback_state, char c)
+{
+    short ch = (short)((unsigned char)c);
+    codec2_fifo_write(g_rxDataOutFifoSub, &ch, 1);
+}
+
+static char getNextTxCharSub(void *callback_state)
+{
+    // Never transmits.
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// startSubReceiver_(): after freedvInterface has been started
+//-------------------------------------------------------------------------
+void MainFrame::startSubReceiver_()
+{
+    if (!wxGetApp().appConfiguration.dualReceiverEnabled)
+    {
+        return;
+    }
+
+    // Same modes and options as the main receiver.
+    for (auto mode : freedvInterface.getRxModes())
+    {
+        freedvInterfaceSub.addRxMode(mode);
+    }
+
+    bool usingReliableText = wxGetApp().appConfiguration.reportingConfiguration.reportingEnabled;
+    freedvInterfaceSub.start(
+        g_mode,
+        wxGetApp().appConfiguration.fifoSizeMs,
+        !wxGetApp().appConfiguration.multipleReceiveEnabled || wxGetApp().appConfiguration.multipleReceiveOnSingleThread,
+        usingReliableText);
+    freedvInterfaceSub.setEq(wxGetApp().appConfiguration.filterConfiguration.enable700CEqualizer);
+    freedvInterfaceSub.setVerbose(g_freedv_verbose);
+    freedvInterfaceSub.setLpcPostFilter(
+        wxGetApp().appConfiguration.filterConfiguration.codec2LPCPostFilterEnable,
+        wxGetApp().appConfiguration.filterConfiguration.codec2LPCPostFilterBassBoost,
+        wxGetApp().appConfiguration.filterConfiguration.codec2LPCPostFilterBeta,
+        wxGetApp().appConfiguration.filterConfiguration.codec2LPCPostFilterGamma);
+
+    if (!usingReliableText)
+    {
+        if (g_rxDataOutFifoSub == nullptr)
+        {
+            g_rxDataOutFifoSub = codec2_fifo_create(MAX_CALLSIGN*FREEDV_VARICODE_MAX_BITS);
+        }
+        freedvInterfaceSub.setTextCallbackFn(&putNextRxCharSub, &getNextTxCharSub);
+        freedvInterfaceSub.setTextVaricodeNum(1);
+    }
+
+    g_StateSub = 0;
+    g_sig_pwr_avSub = 0.0;
+    m_subRxText = wxT("");
+
+    g_spectrumEngineSub = new SpectrumEngine(FS, g_spectrumEngine->getFftSize(), (int)(DT * 1000));
+    g_spectrumEngineSub->start();
+
+    executeOnUiThreadAndWait_([&]()
+    {
+        if (m_panelSpectrumSub == nullptr)
+        {
+            // Created on first use so it doesn't clutter the notebook
+            // for everyone else.
+            wxPanel* subRxPanel = new wxPanel(m_auiNbookCtrl);
+            wxFlexGridSizer* subRxPanelSizer = new wxFlexGridSizer(2, 1, 5, 5);
+            subRxPanelSizer->AddGrowableRow(0);
+            subRxPanelSizer->AddGrowableCol(0);
+
+            m_spectrumMagDBSub.resize(g_spectrumEngineSub->getFftSize() / 2, MIN_MAG_DB);
+            m_panelSpectrumSub = new PlotSpectrum(subRxPanel, &m_spectrumMagDBSub[0],
+                                                  m_spectrumMagDBSub.size()*((float)MAX_F_HZ/(FS/2)),
+                                                  MIN_MAG_DB, MAX_MAG_DB, false);
+            subRxPanelSizer->Add(m_panelSpectrumSub, 0, wxALL | wxEXPAND, 5);
+
+            m_textSubRx = new wxStaticText(subRxPanel, wxID_ANY, wxT(""), wxDefaultPosition, wxDefaultSize, 0);
+            subRxPanelSizer->Add(m_textSubRx, 0, wxALL | wxEXPAND, 5);
+            subRxPanel->SetSizerAndFit(subRxPanelSizer);
+
+            m_auiNbookCtrl->AddPage(subRxPanel, _("Sub RX"), false, wxNullBitmap);
+            m_scheduledPlots.push_back(m_panelSpectrumSub);
+        }
+        m_textSubRx->SetLabel(wxT(""));
+    });
+}
+
+//-------------------------------------------------------------------------
+// stopSubReceiver_(): after the RX thread has stopped
+//-------------------------------------------------------------------------
+void MainFrame::stopSubReceiver_()
+{
+    if (freedvInterfaceSub.isRunning())
+    {
+        freedvInterfaceSub.stop();
+    }
+
+    delete g_spectrumEngineSub;
+    g_spectrumEngineSub = nullptr;
+
+    if (g_rxDataOutFifoSub != nullptr)
+    {
+        codec2_fifo_destroy(g_rxDataOutFifoSub);
+        g_rxDataOutFifoSub = nullptr;
+    }
+}
+
+//-------------------------------------------------------------------------
+// updateSubReceiver_(): from OnTimer()
+//-------------------------------------------------------------------------
+void MainFrame::updateSubReceiver_()
+{
+    if (g_spectrumEngineSub == nullptr || m_panelSpectrumSub == nullptr)
+    {
+        return;
+    }
+
+    if (g_spectrumEngineSub->getSpectrum(m_spectrumMagDBSub))
+    {
+        m_panelSpectrumSub->setSpectrum(
+            &m_spectrumMagDBSub[0],
+            m_spectrumMagDBSub.size()*((float)MAX_F_HZ/(g_spectrumEngineSub->getSampleRate()/2)));
+        m_panelSpectrumSub->markDirty();
+    }
+
+    auto stats = freedvInterfaceSub.getCurrentRxModemStats();
+    if (m_panelSpectrumSub->isOnScreen())
+    {
+        m_panelSpectrumSub->setRxFreq(FDMDV_FCENTRE);
+        m_panelSpectrumSub->setNumAveraging(m_cbxNumSpectrumAveraging->GetSelection() + 1);
+        m_panelSpectrumSub->addOffset(stats->foff);
+        m_panelSpectrumSub->setSync(g_StateSub ? true : false);
+        m_panelSpectrumSub->m_newdata = true;
+    }
+
+    // Latest text, same handling as the main receiver's.
+    if (g_rxDataOutFifoSub != nullptr)
+    {
+        short ashort;
+        while (codec2_fifo_read(g_rxDataOutFifoSub, &ashort, 1) == 0)
+        {
+            char incomingChar = (char)ashort;
+            if (incomingChar == '\r' || incomingChar == '\n' || incomingChar == 0)
+            {
+                m_subRxText = wxT("");
+            }
+            else
+            {
+                m_subRxText += incomingChar;
+            }
+        }
+    }
+    else
+    {
+        const char* text = freedvInterfaceSub.getReliableText();
+        assert(text != nullptr);
+        if (strlen(text) > 0)
+        {
+            m_subRxText = text;
+            freedvInterfaceSub.resetReliableText();
+        }
+        delete[] text;
+    }
+    m_subRxText = m_subRxText.Right(SUB_RX_TEXT_LENGTH);
+
+    wxString status = wxString::Format(
+        "Mode: %s  %s  SNR: %4.1f dB  Text: %s",
+        freedvInterfaceSub.getCurrentModeStr(),
+        g_StateSub ? "Sync" : "No sync",
+        stats->snr_est,
+        m_subRxText);
+    if (status != m_textSubRx->GetLabel())
+    {
+        m_textSubRx->SetLabel(status);
+    }
+}
@@ -384,6 +384,15 @@ TopFrame::TopFrame(wxWindow* parent, wxWindowID id, const wxString& title, const
     m_menuItemPlayFileFromRadio = new wxMenuItem(tools, wxID_ANY, wxString(_("Start &Play File - From Radio...")) , _("Pipes radio sound input from file"), wxITEM_NORMAL);
     g_playFileFromRadioEventId = m_menuItemPlayFileFromRadio->GetId();
     tools->Append(m_menuItemPlayFileFromRadio);
+
+    m_menuItemSaveFlightRecording = new wxMenuItem(tools, wxID_ANY, wxString(_("Save &Last Minutes - From Radio")) , _("Saves the radio audio kept in memory to the Quick Record location"), wxITEM_NORMAL);
+    tools->Append(m_menuItemSaveFlightRecording);
+
+    m_menuItemDecodeFlightRecording = new wxMenuItem(tools, wxID_ANY, wxString(_("&Decode Last Minutes - From Radio")) , _("Decodes the radio audio kept in memory to a file in the Quick Record location"), wxITEM_NORMAL);
+    tools->Append(m_menuItemDecodeFlightRecording);
+
+    m_menuItemReplayCodecFrameLog = new wxMenuItem(tools, wxID_ANY, wxString(_("Replay &Codec Frame Log...")) , _("Re-synthesizes the speech in a codec frame log to a WAV file"), wxITEM_NORMAL);
+    tools->Append(m_menuItemReplayCodecFrameLog);
     
     m_menubarMain->Append(tools, _("&Tools"));
 
@@ -817,6 +826,9 @@ TopFrame::TopFrame(wxWindow* parent, wxWindowID id, const wxString& title, const
 
     this->Connect(m_menuItemRecFileFromRadio->GetId(), wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnRecFileFromRadio));
     this->Connect(m_menuItemPlayFileFromRadio->GetId(), wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnPlayFileFromRadio));
+    this->Connect(m_menuItemSaveFlightRecording->GetId(), wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnSaveFlightRecording));
+    this->Connect(m_menuItemDecodeFlightRecording->GetId(), wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnDecodeFlightRecording));
+    this->Connect(m_menuItemReplayCodecFrameLog->GetId(), wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnReplayCodecFrameLog));
 
     this->Connect(m_menuItemHelpUpdates->GetId(), wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnHelpCheckUpdates));
     this->Connect(m_menuItemHelpUpdates->GetId(), wxEVT_UPDATE_UI, wxUpdateUIEventHandler(TopFrame::OnHelpCheckUpdatesUI));
@@ -904,6 +916,9 @@ TopFrame::~TopFrame()
 
     this->Disconnect(wxID_ANY, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnRecFileFromRadio));
     this->Disconnect(wxID_ANY, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnPlayFileFromRadio));
+    this->Disconnect(wxID_ANY, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnSaveFlightRecording));
+    this->Disconnect(wxID_ANY, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnDecodeFlightRecording));
+    this->Disconnect(wxID_ANY, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnReplayCodecFrameLog));
     
     this->Disconnect(wxID_ANY, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(TopFrame::OnHelpCheckUpdates));
     this->Disconnect(wxID_ANY, wxEVT_UPDATE_UI, wxUpdateUIEventHandler(TopFrame::OnHelpCheckUpdatesUI));
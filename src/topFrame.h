@@ -152,6 +152,9 @@ class TopFrame : public wxFrame
         
         wxMenuItem* m_menuItemRecFileFromRadio;
         wxMenuItem* m_menuItemPlayFileFromRadio;
+        wxMenuItem* m_menuItemSaveFlightRecording;
+        wxMenuItem* m_menuItemDecodeFlightRecording;
+        wxMenuItem* m_menuItemReplayCodecFrameLog;
     
         // Virtual event handlers, override them in your derived class
         virtual void topFrame_OnClose( wxCloseEvent& event ) { event.Skip(); }
@@ -178,6 +181,9 @@ class TopFrame : public wxFrame
         virtual void OnToolsComCfgUI( wxUpdateUIEvent& event ) { event.Skip(); }
         virtual void OnRecFileFromRadio( wxCommandEvent& event ) { event.Skip(); }
         virtual void OnPlayFileFromRadio( wxCommandEvent& event ) { event.Skip(); }
+        virtual void OnSaveFlightRecording( wxCommandEvent& event ) { event.Skip(); }
+        virtual void OnDecodeFlightRecording( wxCommandEvent& event ) { event.Skip(); }
+        virtual void OnReplayCodecFrameLog( wxCommandEvent& event ) { event.Skip(); }
 
         virtual void OnHelpCheckUpdates( wxCommandEvent& event ) { event.Skip(); }
         virtual void OnHelpCheckUpdatesUI( wxUpdateUIEvent& event ) { event.Skip(); }
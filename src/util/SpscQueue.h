@@ -0,0 +1,119 @@
+//=========================================================================
+// Name:            SpscQueue.h
+// Purpose:         Fixed-capacity lock-free single producer/single
+//                  consumer queue.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <cassert>
+
+// Queue of objects passed from exactly one producer thread to exactly one
+// consumer thread. Neither side ever blocks or allocates after construction,
+// which makes it safe to push from realtime audio threads.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity);
+    virtual ~SpscQueue() = default;
+
+    // Producer side. Returns false (and leaves item untouched) if full.
+    bool push(T&& item);
+
+    // Consumer side. Returns false if empty.
+    bool pop(T& item);
+
+    // Approximate when called from a thread other than producer/consumer.
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return numSlots_ - 1; }
+
+private:
+    // One slot is always left empty to distinguish full from empty.
+    size_t numSlots_;
+    std::unique_ptr<T[]> slots_;
+
+    // Read index, only written by the consumer.
+    std::atomic<size_t> head_;
+
+    // Avoids the producer and consumer indices sharing a cache line.
+    char padding_[64];
+
+    // Write index, only written by the producer.
+    std::atomic<size_t> tail_;
+};
+
+template<typename T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+    : numSlots_(capacity + 1)
+    , slots_(new T[capacity + 1])
+    , head_(0)
+    , tail_(0)
+{
+    assert(capacity > 0);
+}
+
+template<typename T>
+bool SpscQueue<T>::push(T&& item)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t nextTail = (tail + 1) % numSlots_;
+    if (nextTail == head_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    slots_[tail] = std::move(item);
+    tail_.store(nextTail, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+bool SpscQueue<T>::pop(T& item)
+{
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    item = std::move(slots_[head]);
+
+    // Make sure the slot doesn't keep resources alive (e.g. shared_ptr)
+    // until the producer wraps back around to it.
+    slots_[head] = T();
+
+    head_.store((head + 1) % numSlots_, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+size_t SpscQueue<T>::size() const
+{
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return (tail + numSlots_ - head) % numSlots_;
+}
+
+#endif // SPSC_QUEUE_H
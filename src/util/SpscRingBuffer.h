@@ -0,0 +1,258 @@
+//=========================================================================
+// Name:            SpscRingBuffer.h
+// Purpose:         Fixed-capacity lock-free single producer/single
+//                  consumer ring of samples.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+
+// Bulk counterpart of SpscQueue for trivially copyable elements (i.e.
+// audio samples). Besides copying reads/writes, either side can work in
+// place on the contiguous part of the ring via the span functions, e.g.
+// to have a device callback render straight into the ring.
+//
+// Storage is rounded up to a power of two but no more than the requested
+// capacity is ever queued, so it can bound latency like a codec2 FIFO.
+template<typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(size_t capacity);
+    virtual ~SpscRingBuffer() = default;
+
+    size_t capacity() const { return capacity_; }
+
+    // What the consumer can read. Called by the consumer this also
+    // applies any pending requestClear(), so a consumer that only reads
+    // once enough is queued still frees the discarded space. Approximate
+    // from other threads, and the producer should use numFree() instead.
+    size_t numUsed() const;
+
+    // What the producer can write. Counts anything discarded by
+    // requestClear() as used until the consumer has caught up, so this
+    // is never more than write() will accept.
+    size_t numFree() const;
+
+    // Producer side. write() copies as much of src as fits and returns
+    // the number of elements written. getWriteSpan() returns the number of
+    // free elements available contiguously at *ptr (less than numFree()
+    // when the free region wraps); commitWrite() publishes n of them.
+    size_t write(const T* src, size_t n);
+    size_t getWriteSpan(T** ptr);
+    void commitWrite(size_t n);
+
+    // Consumer side, mirroring the above.
+    size_t read(T* dest, size_t n);
+    size_t getReadSpan(const T** ptr);
+    void commitRead(size_t n);
+
+    // Consumer side. Discards everything currently queued.
+    void clear();
+
+    // Producer side. Has the consumer discard everything written so far
+    // (i.e. the producer's equivalent of clear()); takes effect at its
+    // next numUsed()/getReadSpan(), and only then frees the space.
+    void requestClear();
+
+    // Total elements ever written/read (including any cleared), i.e. the
+    // stream position of the next element written/read. Wraps. Only
+    // exact on the producer/consumer side respectively.
+    size_t getWritePosition() const { return tail_.load(std::memory_order_acquire); }
+    size_t getReadPosition() const { return effectiveHead_(); }
+
+private:
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<T[]> buf_;
+
+    // Total elements ever read, only written by the consumer (including
+    // from numUsed()). Indices are masked on access so the full capacity
+    // can be used.
+    mutable std::atomic<size_t> head_;
+
+    // Avoids the producer and consumer indices sharing a cache line.
+    char padding_[64];
+
+    // Total elements ever written, only written by the producer.
+    std::atomic<size_t> tail_;
+
+    // Value of tail_ at the last requestClear(); the consumer skips ahead
+    // to it.
+    std::atomic<size_t> clearTo_;
+
+    // head_, moved past anything the producer has asked to discard.
+    size_t effectiveHead_() const;
+};
+
+template<typename T>
+SpscRingBuffer<T>::SpscRingBuffer(size_t capacity)
+    : capacity_(capacity)
+    , head_(0)
+    , tail_(0)
+    , clearTo_(0)
+{
+    assert(capacity > 0);
+
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    mask_ = size - 1;
+    buf_.reset(new T[size]);
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::effectiveHead_() const
+{
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t clearTo = clearTo_.load(std::memory_order_acquire);
+    return (ptrdiff_t)(clearTo - head) > 0 ? clearTo : head;
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::numUsed() const
+{
+    size_t head = effectiveHead_();
+    if (head != head_.load(std::memory_order_relaxed))
+    {
+        // Producer asked for a clear; free the space. Only ever happens
+        // on the consumer, as other threads don't see a pending clear on
+        // rings they use numUsed() on.
+        head_.store(head, std::memory_order_release);
+    }
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail - head;
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::numFree() const
+{
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t head = head_.load(std::memory_order_acquire);
+    return capacity() - (tail - head);
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::getWriteSpan(T** ptr)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t free = capacity() - (tail - head);
+    size_t offset = tail & mask_;
+
+    *ptr = &buf_[offset];
+    return std::min(free, mask_ + 1 - offset);
+}
+
+template<typename T>
+void SpscRingBuffer<T>::commitWrite(size_t n)
+{
+    assert(n <= numFree());
+    tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::write(const T* src, size_t n)
+{
+    size_t written = 0;
+    while (written < n)
+    {
+        T* ptr;
+        size_t span = std::min(getWriteSpan(&ptr), n - written);
+        if (span == 0)
+        {
+            break;
+        }
+
+        memcpy(ptr, src + written, span * sizeof(T));
+        commitWrite(span);
+        written += span;
+    }
+    return written;
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::getReadSpan(const T** ptr)
+{
+    size_t head = effectiveHead_();
+    if (head != head_.load(std::memory_order_relaxed))
+    {
+        // Producer asked for a clear; free the space.
+        head_.store(head, std::memory_order_release);
+    }
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t used = tail - head;
+    size_t offset = head & mask_;
+
+    *ptr = &buf_[offset];
+    return std::min(used, mask_ + 1 - offset);
+}
+
+template<typename T>
+void SpscRingBuffer<T>::commitRead(size_t n)
+{
+    // Not numUsed(): a requestClear() since getReadSpan() doesn't affect
+    // what's already been read.
+    assert(n <= tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed));
+    head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+template<typename T>
+size_t SpscRingBuffer<T>::read(T* dest, size_t n)
+{
+    size_t numRead = 0;
+    while (numRead < n)
+    {
+        const T* ptr;
+        size_t span = std::min(getReadSpan(&ptr), n - numRead);
+        if (span == 0)
+        {
+            break;
+        }
+
+        memcpy(dest + numRead, ptr, span * sizeof(T));
+        commitRead(span);
+        numRead += span;
+    }
+    return numRead;
+}
+
+template<typename T>
+void SpscRingBuffer<T>::clear()
+{
+    head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+template<typename T>
+void SpscRingBuffer<T>::requestClear()
+{
+    clearTo_.store(tail_.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+#endif // SPSC_RING_BUFFER_H
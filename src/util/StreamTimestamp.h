@@ -0,0 +1,113 @@
+//=========================================================================
+// Name:            StreamTimestamp.h
+// Purpose:         Lock-free association of a position in a sample
+//                  stream with the time that sample was captured.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef STREAM_TIMESTAMP_H
+#define STREAM_TIMESTAMP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Travels alongside an SpscRingBuffer: the producer records which of its
+// write positions (see SpscRingBuffer::getWritePosition()) holds audio
+// captured at a given time, and the consumer extrapolates from that to the
+// samples it reads. Comparing with the time they're played gives the end
+// to end latency.
+//
+// Single writer, any number of readers. Readers never block; they give up
+// if they keep catching the writer mid-update, which makes this safe to
+// use from realtime audio threads.
+class StreamTimestamp
+{
+public:
+    StreamTimestamp()
+        : sequence_(0)
+        , position_(0)
+        , timeUs_(0)
+    {
+    }
+
+    // Writer side. timeUs is in IAudioDevice::GetTimeUs() time.
+    void set(size_t position, int64_t timeUs)
+    {
+        unsigned seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        position_.store(position, std::memory_order_relaxed);
+        timeUs_.store(timeUs, std::memory_order_relaxed);
+
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Capture time of the sample at position, given the stream's sample
+    // rate. False if set() hasn't been called yet.
+    bool getTimeOf(size_t position, int sampleRate, int64_t* timeUs) const
+    {
+        size_t anchorPosition;
+        int64_t anchorTimeUs;
+        if (!get_(&anchorPosition, &anchorTimeUs))
+        {
+            return false;
+        }
+
+        // Positions wrap like SpscRingBuffer's.
+        ptrdiff_t offset = position - anchorPosition;
+        *timeUs = anchorTimeUs + (int64_t)offset * 1000000 / sampleRate;
+        return true;
+    }
+
+private:
+    // Odd while set() is in progress, 0 until the first set().
+    std::atomic<unsigned> sequence_;
+    std::atomic<size_t> position_;
+    std::atomic<int64_t> timeUs_;
+
+    bool get_(size_t* position, int64_t* timeUs) const
+    {
+        for (int attempt = 0; attempt < 4; attempt++)
+        {
+            unsigned seq = sequence_.load(std::memory_order_acquire);
+            if (seq == 0)
+            {
+                return false;
+            }
+            if (seq & 1)
+            {
+                continue;
+            }
+
+            *position = position_.load(std::memory_order_relaxed);
+            *timeUs = timeUs_.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == seq)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // STREAM_TIMESTAMP_H
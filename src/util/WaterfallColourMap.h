@@ -0,0 +1,106 @@
+//=========================================================================
+// Name:            WaterfallColourMap.h
+// Purpose:         Colour schemes for the waterfall, shared by the GUI
+//                  and the spectrum exporter.
+//
+// Authors:         Mooneer Salem
+// License:
+//
+//  All rights reserved.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.1,
+//  as published by the Free Software Foundation.  This program is
+//  distributed in the hope that it will be useful, but WITHOUT ANY
+//  WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+//  License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+//=========================================================================
+
+#ifndef WATERFALL_COLOUR_MAP_H
+#define WATERFALL_COLOUR_MAP_H
+
+#include <algorithm>
+
+// Colour schemes for WaterfallColourMap().
+#define WATERFALL_COLOUR_HEATMAP 0
+#define WATERFALL_COLOUR_GREYSCALE 1
+#define WATERFALL_COLOUR_BLUE 2
+
+//----------------------------------------------------------------
+// WaterfallHeatmap()
+// map val to a rgb colour
+// from http://eddiema.ca/2011/01/21/c-sharp-heatmaps/
+//----------------------------------------------------------------
+inline unsigned WaterfallHeatmap(float val, float min, float max)
+{
+    unsigned r = 0;
+    unsigned g = 0;
+    unsigned b = 0;
+
+    val = (val - min) / (max - min);
+    if(val <= 0.2)
+    {
+        b = (unsigned)((val / 0.2) * 255);
+    }
+    else if(val >  0.2 &&  val <= 0.7)
+    {
+        b = (unsigned)((1.0 - ((val - 0.2) / 0.5)) * 255);
+    }
+    if(val >= 0.2 &&  val <= 0.6)
+    {
+        g = (unsigned)(((val - 0.2) / 0.4) * 255);
+    }
+    else if(val >  0.6 &&  val <= 0.9)
+    {
+        g = (unsigned)((1.0 - ((val - 0.6) / 0.3)) * 255);
+    }
+    if(val >= 0.5)
+    {
+        r = (unsigned)(((val - 0.5) / 0.5) * 255);
+    }
+    return  (b << 16) + (g << 8) + r;
+}
+
+//----------------------------------------------------------------
+// WaterfallColourMap()
+// RGB triplets for each of the 256 intensities of the given colour
+// scheme (WATERFALL_COLOUR_*; anything else is clamped to those).
+//----------------------------------------------------------------
+inline const unsigned char (*WaterfallColourMap(int colour))[3]
+{
+    struct ColourMaps
+    {
+        unsigned char rgb[3][256][3];
+        
+        ColourMaps()
+        {
+            for(int i = 0; i < 256; i++)
+            {
+                unsigned heatmap_lut = WaterfallHeatmap((float)i, 0.0, 255.0);
+                
+                rgb[WATERFALL_COLOUR_HEATMAP][i][0] = heatmap_lut & 0xff;
+                rgb[WATERFALL_COLOUR_HEATMAP][i][1] = (heatmap_lut >> 8) & 0xff;
+                rgb[WATERFALL_COLOUR_HEATMAP][i][2] = (heatmap_lut >> 16) & 0xff;
+                
+                rgb[WATERFALL_COLOUR_GREYSCALE][i][0] = i;
+                rgb[WATERFALL_COLOUR_GREYSCALE][i][1] = i;
+                rgb[WATERFALL_COLOUR_GREYSCALE][i][2] = i;
+                
+                rgb[WATERFALL_COLOUR_BLUE][i][0] = i;
+                rgb[WATERFALL_COLOUR_BLUE][i][1] = i;
+                rgb[WATERFALL_COLOUR_BLUE][i][2] = (i < 127) ? i*2 : 255;
+            }
+        }
+    };
+    
+    // Built once, on first use, and shared by all users.
+    static const ColourMaps maps;
+    return maps.rgb[std::min(std::max(colour, WATERFALL_COLOUR_HEATMAP), WATERFALL_COLOUR_BLUE)];
+}
+
+#endif // WATERFALL_COLOUR_MAP_H
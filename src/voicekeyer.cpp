@@ -4,13 +4,60 @@
    Voice Keyer implementation
 */
 
+#include <fstream>
+#include <sstream>
+
 #include "main.h"
 #include "gui/dialogs/monitor_volume_adj.h"
 
-extern SNDFILE            *g_sfRecMicFile;
+extern RecordingWriter    *g_recMicWriter;
 bool                g_recVoiceKeyerFile;
 extern bool g_voice_keyer_tx;
 extern wxMutex g_mutexProtectingCallbackData;
+extern int g_mode;
+extern int g_analog;
+extern float g_TxFreqOffsetHz;
+
+// Longest voice keyer file whose modem output we'll keep in memory.
+#define VK_CACHE_MAX_SECONDS 120
+
+VoiceKeyerCache g_voiceKeyerCache;
+
+// Identifies the file contents plus everything in the TX pipeline that
+// changes what goes out, so a cached transmission is only replayed if
+// sending the file again would produce the same audio.
+static std::string VoiceKeyerCacheKey(wxString fileName)
+{
+    // FNV-1a over the file.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    std::ifstream file(fileName.ToStdString(), std::ios::binary);
+    char buf[4096];
+    while (file.read(buf, sizeof(buf)) || file.gcount() > 0)
+    {
+        for (std::streamsize index = 0; index < file.gcount(); index++)
+        {
+            hash = (hash ^ (unsigned char)buf[index]) * 0x100000001b3ULL;
+        }
+    }
+    
+    auto& config = wxGetApp().appConfiguration;
+    auto& micIn = config.filterConfiguration.micInChannel;
+    std::stringstream key;
+    key << std::hex << hash << std::dec
+        << "/" << g_mode << "/" << g_analog << "/" << g_TxFreqOffsetHz
+        << "/" << (bool)config.filterConfiguration.speexppEnable
+        << "/" << (bool)micIn.eqEnable
+        << "/" << (float)micIn.bassFreqHz << "/" << (float)micIn.bassGaindB
+        << "/" << (float)micIn.midFreqHz << "/" << (float)micIn.midGainDB << "/" << (float)micIn.midQ
+        << "/" << (float)micIn.trebleFreqHz << "/" << (float)micIn.trebleGaindB
+        << "/" << (float)micIn.volInDB
+        << "/" << (bool)config.freedv700Clip << "/" << (bool)config.freedv700TxBPF
+        << "/" << wxGetApp().m_testFrames
+        << "/" << (int)config.audioConfiguration.soundCard2In.sampleRate
+        << "/" << (int)config.audioConfiguration.soundCard1Out.sampleRate
+        << "/" << config.reportingConfiguration.reportingCallsign->ToStdString();
+    return key.str();
+}
 
 void MainFrame::OnTogBtnVoiceKeyerClick (wxCommandEvent& event)
 {
@@ -19,11 +66,18 @@ void MainFrame::OnTogBtnVoiceKeyerClick (wxCommandEvent& event)
     {       
         g_mutexProtectingCallbackData.Lock();
         g_recVoiceKeyerFile = false;
-        sf_close(g_sfRecMicFile);
-        g_sfRecMicFile = nullptr;
+        RecordingWriter* writer = g_recMicWriter;
+        g_recMicWriter = nullptr;
         SetStatusText(wxT(""));
         g_mutexProtectingCallbackData.Unlock();
         
+        writer->close();
+        if (writer->getNumSamplesDropped() > 0)
+        {
+            fprintf(stderr, "Voice keyer recording dropped %llu samples\n", (unsigned long long)writer->getNumSamplesDropped());
+        }
+        delete writer;
+        
         m_togBtnAnalog->Enable(true);
         m_togBtnVoiceKeyer->SetValue(false);
         m_togBtnVoiceKeyer->SetBackgroundColour(wxNullColour);
@@ -82,19 +136,16 @@ void MainFrame::OnRecordNewVoiceKeyerFile( wxCommandEvent& event )
     wxGetApp().appConfiguration.voiceKeyerWaveFile = fileName;
     
     int sample_rate = wxGetApp().appConfiguration.audioConfiguration.soundCard2In.sampleRate;
-    SF_INFO     sfInfo;
-    
-    sfInfo.format     = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
-    sfInfo.channels   = 1;
-    sfInfo.samplerate = sample_rate;
 
-    g_sfRecMicFile = sf_open(soundFile.c_str(), SFM_WRITE, &sfInfo);
-    if(g_sfRecMicFile == NULL)
+    // Never rotated: the voice keyer needs the whole thing in one file.
+    RecordingWriter* writer = new RecordingWriter(soundFile.ToStdString(), sample_rate, SF_FORMAT_WAV | SF_FORMAT_PCM_16);
+    if (!writer->open())
     {
-        wxString strErr = sf_strerror(NULL);
-        wxMessageBox(strErr, wxT("Couldn't open sound file"), wxOK);
+        wxMessageBox(writer->getError(), wxT("Couldn't open sound file"), wxOK);
+        delete writer;
         return;
     }
+    g_recMicWriter = writer;
 
     SetStatusText(wxT("Recording file ") + soundFile + wxT(" from microphone") , 0);
     g_recVoiceKeyerFile = true;
@@ -120,7 +171,7 @@ void MainFrame::OnChooseAlternateVoiceKeyerFile( wxCommandEvent& event )
         wxT("Select Voice Keyer File"),
         wxGetApp().appConfiguration.voiceKeyerWaveFilePath,
         wxEmptyString,
-        wxT("WAV files (*.wav)|*.wav|")
+        wxT("Sound files (*.wav;*.flac;*.opus;*.ogg)|*.wav;*.flac;*.opus;*.ogg|")
         wxT("All files (*.*)|*.*"),
         wxFD_OPEN | wxFD_FILE_MUST_EXIST
         );
@@ -182,7 +233,7 @@ void MainFrame::OnSetMonitorVKAudioVol( wxCommandEvent& event )
     popup->Popup();
 }
 
-extern SNDFILE *g_sfPlayFile;
+extern PlaybackSource *g_playSource;
 extern bool g_playFileToMicIn;
 extern bool g_loopPlayFileToMicIn;
 extern FreeDVInterface freedvInterface;
@@ -211,20 +262,40 @@ int MainFrame::VoiceKeyerStartTx(void)
 
     // start playing wave file or die trying
 
-    SF_INFO sfInfo;
-    sfInfo.format = 0;
-
-    SNDFILE* tmpPlayFile = sf_open(vkFileName_.c_str(), SFM_READ, &sfInfo);
-    if(tmpPlayFile == NULL) {
-        wxString strErr = sf_strerror(NULL);
-        wxMessageBox(strErr, wxT("Couldn't open:") + vkFileName_, wxOK);
+    PlaybackSource* tmpPlaySource = new PlaybackSource(vkFileName_.ToStdString());
+    if(!tmpPlaySource->open()) {
+        wxMessageBox(tmpPlaySource->getError(), wxT("Couldn't open:") + vkFileName_, wxOK);
+        delete tmpPlaySource;
         next_state = VK_IDLE;
         m_togBtnVoiceKeyer->SetBackgroundColour(wxNullColour);
         m_togBtnVoiceKeyer->SetValue(false);
     }
     else {
-        g_sfTxFs = sfInfo.samplerate;
-        g_sfPlayFile = tmpPlayFile;
+        g_sfTxFs = tmpPlaySource->getSampleRate();
+        g_playSource = tmpPlaySource;
+        
+        // Repeats of the same file with the same settings replay what the
+        // modem produced the first time. Monitoring needs the live mic
+        // path, so skip the cache then.
+        int txSampleRate = wxGetApp().appConfiguration.audioConfiguration.soundCard1Out.sampleRate;
+        if (!wxGetApp().appConfiguration.monitorVoiceKeyerAudio &&
+            tmpPlaySource->isPreloaded() && txSampleRate > 0 &&
+            tmpPlaySource->getNumSamples() <= (size_t)g_sfTxFs * VK_CACHE_MAX_SECONDS)
+        {
+            // Room for the whole file plus a couple of seconds of modem
+            // latency and however long it takes to stop.
+            size_t maxSamples =
+                tmpPlaySource->getNumSamples() * txSampleRate / g_sfTxFs + 2 * txSampleRate;
+            std::string key = VoiceKeyerCacheKey(vkFileName_);
+            
+            g_mutexProtectingCallbackData.Lock();
+            g_voiceKeyerCache.start(key, maxSamples);
+            bool isReplaying = g_voiceKeyerCache.isReplaying();
+            size_t cacheBytes = g_voiceKeyerCache.getSizeBytes();
+            g_mutexProtectingCallbackData.Unlock();
+            
+            if (g_verbose) fprintf(stderr, "Voice keyer: %s cached transmission (%zu bytes)\n", isReplaying ? "replaying" : "capturing", cacheBytes);
+        }
         
         SetStatusText(wxT("Voice Keyer: Playing file ") + vkFileName_ + wxT(" to mic input") , 0);
         g_loopPlayFileToMicIn = false;